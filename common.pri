@@ -2,10 +2,6 @@ INCLUDEPATH *= $$PWD/common
 Debug: LIBS += -L$$PWD/common/lib/debug/ -lcommon
 Release: LIBS += -L$$PWD/common/lib/release/ -lcommon
 
-# Matlab
-INCLUDEPATH *= "C:/Program Files/MATLAB/R2017b/extern/include"
-LIBS += -L"C:/Program Files/MATLAB/R2017b/extern/lib/win64/microsoft" -llibmx -llibeng -llibmex
-
 # Opcode lib
 INCLUDEPATH *= $$PWD/common/third_party/opcode/include
 win32 {
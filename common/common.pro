@@ -23,19 +23,25 @@ DEPENDPATH += utilities
 INCLUDEPATH += geometry
 INCLUDEPATH += utilities
 
-INCLUDEPATH *= "C:/Program Files/MATLAB/R2016b/extern/include"
-LIBS += -L"C:/Program Files/MATLAB/R2016b/extern/lib/win64/microsoft" -llibmx -llibeng -libmex
-
 HEADERS += \
 	geometry/Scene.h \
 	geometry/CModel.h \
 	geometry/CMesh.h \
 	geometry/IO_3DS.h \
 	geometry/AABB.h \
+	geometry/AABBBroadPhase.h \
 	geometry/OBB.h \
+	geometry/OBBBatch.h \
 	geometry/OBBEstimator.h \
 	geometry/BestFit.h \
 	geometry/TriTriIntersect.h \
+	geometry/MeshBVH.h \
+	geometry/RayBVH.h \
+	geometry/ScenePicker.h \
+	geometry/SceneRasterizer.h \
+	geometry/VertexStore.h \
+	geometry/MeshRenderBuffer.h \
+	geometry/RelPosFile.h \
 	geometry/RelationGraph.h \
 	geometry/UDGraph.h \
 	geometry/SuppPlane.h \
@@ -43,8 +49,7 @@ HEADERS += \
 	third_party/clustering/Kmeans.h \
 	utilities/utility.h \
 	utilities/mathlib.h \
-	utilities/Eigen3x3.h \
-	utilities/eigenMat.h
+	utilities/Eigen3x3.h
 
 	
 SOURCES += \
@@ -53,10 +58,19 @@ SOURCES += \
 	geometry/CMesh.cpp \
 	geometry/IO_3DS.cpp \
 	geometry/AABB.cpp \
+	geometry/AABBBroadPhase.cpp \
 	geometry/OBB.cpp \
+	geometry/OBBBatch.cpp \
 	geometry/OBBEstimator.cpp \
 	geometry/BestFit.cpp \
 	geometry/TriTriIntersect.cpp \
+	geometry/MeshBVH.cpp \
+	geometry/RayBVH.cpp \
+	geometry/ScenePicker.cpp \
+	geometry/SceneRasterizer.cpp \
+	geometry/VertexStore.cpp \
+	geometry/MeshRenderBuffer.cpp \
+	geometry/RelPosFile.cpp \
 	geometry/RelationGraph.cpp \
 	geometry/UDGraph.cpp \
 	geometry/SuppPlane.cpp	\
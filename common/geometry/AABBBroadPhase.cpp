@@ -0,0 +1,162 @@
+#include "AABBBroadPhase.h"
+
+// extra inflation so rounding never drops a pair that passes CAABB::IsIntersect
+const double BroadPhaseSlack = 1e-9;
+
+CAABBBroadPhase::CAABBBroadPhase()
+	:m_axis(0), m_margin(0)
+{
+}
+
+CAABBBroadPhase::~CAABBBroadPhase()
+{
+}
+
+void CAABBBroadPhase::clear()
+{
+	m_boxes.clear();
+	m_sortedIds.clear();
+}
+
+void CAABBBroadPhase::build(const std::vector<CAABB> &boxes, double margin)
+{
+	clear();
+
+	m_margin = margin;
+	m_boxes.resize(6 * boxes.size());
+
+	for (int i = 0; i < boxes.size(); i++)
+	{
+		setBox(i, boxes[i]);
+	}
+
+	// sweep along the axis where box centers spread most
+	double minC[3] = { MAX_VALUE, MAX_VALUE, MAX_VALUE };
+	double maxC[3] = { -MAX_VALUE, -MAX_VALUE, -MAX_VALUE };
+
+	for (int i = 0; i < boxes.size(); i++)
+	{
+		for (int d = 0; d < 3; d++)
+		{
+			minC[d] = std::min(minC[d], boxes[i].cent[d]);
+			maxC[d] = std::max(maxC[d], boxes[i].cent[d]);
+		}
+	}
+
+	m_axis = 0;
+	for (int d = 1; d < 3; d++)
+	{
+		if (maxC[d] - minC[d] > maxC[m_axis] - minC[m_axis])
+		{
+			m_axis = d;
+		}
+	}
+
+	m_sortedIds.resize(boxes.size());
+	for (int i = 0; i < boxes.size(); i++)
+	{
+		m_sortedIds[i] = i;
+	}
+
+	std::sort(m_sortedIds.begin(), m_sortedIds.end(), [this](int a, int b) { return sweepMin(a) < sweepMin(b); });
+}
+
+void CAABBBroadPhase::setBox(int id, const CAABB &box)
+{
+	for (int d = 0; d < 3; d++)
+	{
+		double inflate = box.hsize[d] + m_margin + BroadPhaseSlack*(MathLib::Abs(box.cent[d]) + box.hsize[d] + m_margin + 1.0);
+
+		m_boxes[6 * id + d] = box.cent[d] - inflate;
+		m_boxes[6 * id + 3 + d] = box.cent[d] + inflate;
+	}
+}
+
+void CAABBBroadPhase::updateBox(int id, const CAABB &box)
+{
+	if (id == getBoxNum())
+	{
+		m_boxes.resize(6 * (id + 1));
+	}
+	else
+	{
+		m_sortedIds.erase(std::find(m_sortedIds.begin(), m_sortedIds.end(), id));
+	}
+
+	setBox(id, box);
+
+	auto pos = std::lower_bound(m_sortedIds.begin(), m_sortedIds.end(), id, [this](int a, int b) { return sweepMin(a) < sweepMin(b); });
+	m_sortedIds.insert(pos, id);
+}
+
+bool CAABBBroadPhase::isOverlap(int i, int j) const
+{
+	for (int d = 0; d < 3; d++)
+	{
+		if (m_boxes[6 * i + d] > m_boxes[6 * j + 3 + d] || m_boxes[6 * j + d] > m_boxes[6 * i + 3 + d])
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+void CAABBBroadPhase::findOverlapPairs(std::vector<std::pair<int, int>> &pairs) const
+{
+	pairs.clear();
+
+	// boxes whose sweep interval still covers the current sweep position
+	std::vector<int> activeIds;
+
+	for (int k = 0; k < m_sortedIds.size(); k++)
+	{
+		int currId = m_sortedIds[k];
+		double currMin = sweepMin(currId);
+
+		int activeNum = 0;
+		for (int a = 0; a < activeIds.size(); a++)
+		{
+			int activeId = activeIds[a];
+			if (sweepMax(activeId) < currMin)
+			{
+				continue;
+			}
+
+			activeIds[activeNum++] = activeId;
+
+			if (isOverlap(activeId, currId))
+			{
+				pairs.push_back(std::make_pair(std::min(activeId, currId), std::max(activeId, currId)));
+			}
+		}
+
+		activeIds.resize(activeNum);
+		activeIds.push_back(currId);
+	}
+
+	std::sort(pairs.begin(), pairs.end());
+}
+
+void CAABBBroadPhase::findOverlaps(int id, std::vector<int> &ids) const
+{
+	ids.clear();
+
+	double queryMax = sweepMax(id);
+
+	for (int k = 0; k < m_sortedIds.size(); k++)
+	{
+		int currId = m_sortedIds[k];
+		if (sweepMin(currId) > queryMax)
+		{
+			break;
+		}
+
+		if (currId != id && isOverlap(id, currId))
+		{
+			ids.push_back(currId);
+		}
+	}
+
+	std::sort(ids.begin(), ids.end());
+}
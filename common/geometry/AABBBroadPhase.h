@@ -0,0 +1,41 @@
+#pragma once
+
+#include "AABB.h"
+#include <vector>
+
+// sweep and prune over model AABBs inflated by a margin
+// two boxes are reported when their gap along every axis is within twice the margin,
+// which matches the CAABB::IsIntersect(aabb, 2*margin) test used before the exact tests
+
+class CAABBBroadPhase
+{
+public:
+	CAABBBroadPhase();
+	~CAABBBroadPhase();
+
+	void build(const std::vector<CAABB> &boxes, double margin);
+	void clear();
+
+	// update box of an existing id after the model moved, or append a box with id == getBoxNum()
+	void updateBox(int id, const CAABB &box);
+
+	int getBoxNum() const { return m_boxes.size() / 6; };
+	double getMargin() const { return m_margin; };
+
+	// all overlapping pairs (i < j), sorted by i then j
+	void findOverlapPairs(std::vector<std::pair<int, int>> &pairs) const;
+
+	// ids overlapping the box of id, sorted ascending
+	void findOverlaps(int id, std::vector<int> &ids) const;
+
+private:
+	void setBox(int id, const CAABB &box);
+	bool isOverlap(int i, int j) const;
+	double sweepMin(int id) const { return m_boxes[6 * id + m_axis]; };
+	double sweepMax(int id) const { return m_boxes[6 * id + 3 + m_axis]; };
+
+	std::vector<double> m_boxes;  // 6 doubles per id: inflated min, max
+	std::vector<int> m_sortedIds;  // ids sorted by min along sweep axis
+	int m_axis;
+	double m_margin;
+};
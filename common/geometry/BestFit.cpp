@@ -4,6 +4,8 @@
 #include <assert.h>
 #include <math.h>
 #include <float.h>
+#include <vector>
+#include <algorithm>
 #include "../utilities/mathlib.h"
 
 /*!
@@ -852,6 +854,290 @@ void computeBestFitOBB_FixY(size_t vcount, const REAL *points, size_t pstride, R
 	}
 }
 
+// drop points strictly inside the polygon of the extreme points along 8 directions (Akl-Toussaint),
+// they cannot be on the hull and most of them never reach the sort
+static void discardInteriorPoints2D(std::vector<std::pair<REAL, REAL>> &pts)
+{
+	if (pts.size() < 16)
+	{
+		return;
+	}
+
+	// directions in ccw order: x, x+y, y, y-x, -x, -x-y, -y, x-y
+	const REAL dirs[8][2] = { { 1, 0 }, { 1, 1 }, { 0, 1 }, { -1, 1 }, { -1, 0 }, { -1, -1 }, { 0, -1 }, { 1, -1 } };
+	int extremeIds[8] = { 0, 0, 0, 0, 0, 0, 0, 0 };
+	REAL extremeVals[8];
+
+	for (int d = 0; d < 8; d++)
+	{
+		extremeVals[d] = dirs[d][0] * pts[0].first + dirs[d][1] * pts[0].second;
+	}
+
+	for (int i = 1; i < (int)pts.size(); i++)
+	{
+		for (int d = 0; d < 8; d++)
+		{
+			REAL val = dirs[d][0] * pts[i].first + dirs[d][1] * pts[i].second;
+			if (val > extremeVals[d])
+			{
+				extremeVals[d] = val;
+				extremeIds[d] = i;
+			}
+		}
+	}
+
+	std::vector<std::pair<REAL, REAL>> poly;
+	for (int d = 0; d < 8; d++)
+	{
+		const std::pair<REAL, REAL> &p = pts[extremeIds[d]];
+		if (poly.empty() || (p != poly.back() && p != poly.front()))
+		{
+			poly.push_back(p);
+		}
+	}
+
+	if (poly.size() < 3)
+	{
+		return;
+	}
+
+	int keepNum = 0;
+	for (int i = 0; i < (int)pts.size(); i++)
+	{
+		bool isInside = true;
+		for (int e = 0; e < (int)poly.size() && isInside; e++)
+		{
+			const std::pair<REAL, REAL> &a = poly[e];
+			const std::pair<REAL, REAL> &b = poly[(e + 1) % poly.size()];
+
+			isInside = (b.first - a.first)*(pts[i].second - a.second) - (b.second - a.second)*(pts[i].first - a.first) > 0;
+		}
+
+		if (!isInside)
+		{
+			pts[keepNum++] = pts[i];
+		}
+	}
+
+	pts.resize(keepNum);
+}
+
+// 2d convex hull by monotone chain, counter clockwise without collinear points
+static void computeConvexHull2D(std::vector<std::pair<REAL, REAL>> &pts, std::vector<std::pair<REAL, REAL>> &hull)
+{
+	hull.clear();
+
+	discardInteriorPoints2D(pts);
+
+	std::sort(pts.begin(), pts.end());
+	pts.erase(std::unique(pts.begin(), pts.end()), pts.end());
+
+	if (pts.size() < 3)
+	{
+		hull = pts;
+		return;
+	}
+
+	hull.resize(2 * pts.size());
+	int k = 0;
+
+	// lower chain, then upper chain
+	for (int i = 0; i < (int)pts.size(); i++)
+	{
+		while (k >= 2 && (hull[k - 1].first - hull[k - 2].first)*(pts[i].second - hull[k - 2].second)
+			- (hull[k - 1].second - hull[k - 2].second)*(pts[i].first - hull[k - 2].first) <= 0)
+		{
+			k--;
+		}
+		hull[k++] = pts[i];
+	}
+
+	for (int i = (int)pts.size() - 2, lowerNum = k + 1; i >= 0; i--)
+	{
+		while (k >= lowerNum && (hull[k - 1].first - hull[k - 2].first)*(pts[i].second - hull[k - 2].second)
+			- (hull[k - 1].second - hull[k - 2].second)*(pts[i].first - hull[k - 2].first) <= 0)
+		{
+			k--;
+		}
+		hull[k++] = pts[i];
+	}
+
+	hull.resize(k - 1);  // last point is the first one
+}
+
+// minimum area rectangle of a ccw convex polygon by rotating calipers
+// returns unit edge direction u, extents along u and along its left normal (-u.y, u.x)
+static REAL computeMinAreaRect2D(const std::vector<std::pair<REAL, REAL>> &hull, REAL u[2], REAL uRange[2], REAL vRange[2])
+{
+	int m = hull.size();
+
+	u[0] = 1; u[1] = 0;
+	uRange[0] = uRange[1] = vRange[0] = vRange[1] = 0;
+
+	if (m == 0)
+	{
+		return 0;
+	}
+
+	if (m < 3)
+	{
+		REAL dx = hull[m - 1].first - hull[0].first;
+		REAL dy = hull[m - 1].second - hull[0].second;
+		REAL len = sqrt(dx*dx + dy*dy);
+
+		if (len > 0)
+		{
+			u[0] = dx / len; u[1] = dy / len;
+		}
+
+		uRange[0] = uRange[1] = hull[0].first*u[0] + hull[0].second*u[1];
+		uRange[1] += len;
+		vRange[0] = vRange[1] = -hull[0].first*u[1] + hull[0].second*u[0];
+		return 0;
+	}
+
+	REAL bestArea = DBL_MAX;
+	int r = 1, t = 1, l = 1;
+
+	for (int i = 0; i < m; i++)
+	{
+		const std::pair<REAL, REAL> &p0 = hull[i];
+		const std::pair<REAL, REAL> &p1 = hull[(i + 1) % m];
+
+		REAL ex = p1.first - p0.first;
+		REAL ey = p1.second - p0.second;
+		REAL len = sqrt(ex*ex + ey*ey);
+		ex /= len; ey /= len;
+
+		// hull lies on the left of the edge, so the normal points inside
+		auto projU = [&](int k) { return hull[k % m].first*ex + hull[k % m].second*ey; };
+		auto projV = [&](int k) { return -hull[k % m].first*ey + hull[k % m].second*ex; };
+
+		// each caliper only moves forward, at most once around the hull in total
+		if (i == 0)
+		{
+			r = 1;
+		}
+		for (int step = 0; step < m && projU(r + 1) > projU(r); step++) r = (r + 1) % m;
+
+		if (i == 0)
+		{
+			t = r;
+		}
+		for (int step = 0; step < m && projV(t + 1) > projV(t); step++) t = (t + 1) % m;
+
+		if (i == 0)
+		{
+			l = t;
+		}
+		for (int step = 0; step < m && projU(l + 1) < projU(l); step++) l = (l + 1) % m;
+
+		REAL minU = projU(l), maxU = projU(r);
+		REAL minV = projV(i), maxV = projV(t);
+
+		REAL area = (maxU - minU)*(maxV - minV);
+		if (area < bestArea)
+		{
+			bestArea = area;
+			u[0] = ex; u[1] = ey;
+			uRange[0] = minU; uRange[1] = maxU;
+			vRange[0] = minV; vRange[1] = maxV;
+		}
+	}
+
+	return bestArea;
+}
+
+void computeBestFitOBB_FixAxisByHull(size_t vcount, const REAL *points, size_t pstride, int fixAxis, REAL *sides, REAL matrix[16])
+{
+	// in-plane axes, ordered so that the result has the same layout as computeBestFitOBB_FixZ / FixY:
+	// FixZ: axis0 = (cos a, sin a, 0), axis1 = (-sin a, cos a, 0), axis2 = z
+	// FixY: axis0 = (cos a, 0, -sin a), axis1 = y, axis2 = (sin a, 0, cos a)
+	int pa = 0, pb = (fixAxis == 2) ? 1 : 2;
+	REAL orient = (fixAxis == 2) ? 1 : -1;  // sign of b in axis0 for a in [0, 90)
+
+	std::vector<std::pair<REAL, REAL>> pts(vcount), hull;
+	REAL fixMin = DBL_MAX, fixMax = -DBL_MAX;
+	REAL bmin[2] = { DBL_MAX, DBL_MAX }, bmax[2] = { -DBL_MAX, -DBL_MAX };
+
+	const char *src = (const char *)points;
+	for (size_t i = 0; i < vcount; i++)
+	{
+		const REAL *p = (const REAL *)src;
+		pts[i] = std::make_pair(p[pa], p[pb]);
+
+		fixMin = std::min(fixMin, p[fixAxis]);
+		fixMax = std::max(fixMax, p[fixAxis]);
+		bmin[0] = std::min(bmin[0], p[pa]); bmax[0] = std::max(bmax[0], p[pa]);
+		bmin[1] = std::min(bmin[1], p[pb]); bmax[1] = std::max(bmax[1], p[pb]);
+
+		src += pstride;
+	}
+
+	computeConvexHull2D(pts, hull);
+
+	REAL u[2], uRange[2], vRange[2];
+	REAL area = computeMinAreaRect2D(hull, u, uRange, vRange);
+
+	// keep the axis aligned box unless the rectangle is really smaller, as the rotation sweep does
+	REAL aabbArea = (bmax[0] - bmin[0])*(bmax[1] - bmin[1]);
+
+	REAL dirA[2] = { 1, 0 }, dirB[2] = { 0, 1 };
+	REAL sizeA = bmax[0] - bmin[0], sizeB = bmax[1] - bmin[1];
+	REAL cent[2] = { (bmin[0] + bmax[0])*0.5, (bmin[1] + bmax[1])*0.5 };
+
+	if (vcount > 0 && area < aabbArea*(1 - 1e-9))
+	{
+		REAL v[2] = { -u[1], u[0] };
+
+		cent[0] = u[0] * (uRange[0] + uRange[1])*0.5 + v[0] * (vRange[0] + vRange[1])*0.5;
+		cent[1] = u[1] * (uRange[0] + uRange[1])*0.5 + v[1] * (vRange[0] + vRange[1])*0.5;
+
+		// pick the rectangle axis at angle a in [0, 90) as axis0
+		REAL cands[4][2] = { { u[0], u[1] }, { v[0], v[1] }, { -u[0], -u[1] }, { -v[0], -v[1] } };
+		REAL candSizes[4] = { uRange[1] - uRange[0], vRange[1] - vRange[0], uRange[1] - uRange[0], vRange[1] - vRange[0] };
+
+		int best = 0;
+		for (int c = 0; c < 4; c++)
+		{
+			if (cands[c][0] > 0 && orient*cands[c][1] >= 0)
+			{
+				best = c;
+				break;
+			}
+		}
+
+		dirA[0] = cands[best][0]; dirA[1] = cands[best][1];
+		dirB[0] = -dirA[1]; dirB[1] = dirA[0];
+		sizeA = candSizes[best];
+		sizeB = candSizes[(best + 1) % 4];
+	}
+
+	fm_identity(matrix);
+
+	if (fixAxis == 2)
+	{
+		matrix[0] = dirA[0]; matrix[1] = dirA[1]; matrix[2] = 0;
+		matrix[4] = dirB[0]; matrix[5] = dirB[1]; matrix[6] = 0;
+		matrix[8] = 0; matrix[9] = 0; matrix[10] = 1;
+
+		sides[0] = sizeA; sides[1] = sizeB; sides[2] = fixMax - fixMin;
+
+		matrix[12] = cent[0]; matrix[13] = cent[1]; matrix[14] = (fixMin + fixMax)*0.5;
+	}
+	else
+	{
+		// dirB is axis2 in the xz plane
+		matrix[0] = dirA[0]; matrix[1] = 0; matrix[2] = dirA[1];
+		matrix[4] = 0; matrix[5] = 1; matrix[6] = 0;
+		matrix[8] = dirB[0]; matrix[9] = 0; matrix[10] = dirB[1];
+
+		sides[0] = sizeA; sides[1] = fixMax - fixMin; sides[2] = sizeB;
+
+		matrix[12] = cent[0]; matrix[13] = (fixMin + fixMax)*0.5; matrix[14] = cent[1];
+	}
+}
+
 void computeBestFitOBB(size_t vcount,const REAL *points,size_t pstride,REAL *sides,REAL *matrix,FitStrategy strategy)
 {
   fm_identity(matrix);
@@ -66,6 +66,10 @@ void   computeBestFitOBB_FixZ(size_t vcount,const REAL *points,size_t pstride,RE
 void   computeBestFitCapsule(size_t vcount,const REAL *points,size_t pstride,REAL &radius,REAL &height,REAL matrix[16],FitStrategy strategy=FS_MEDIUM_FIT);
 
 void   computeBestFitOBB_FixY(size_t vcount, const REAL *points, size_t pstride, REAL *sides, REAL matrix[16], FitStrategy strategy = FS_MEDIUM_FIT);
+
+// exact minimum volume OBB with one axis fixed to y (fixAxis = 1) or z (fixAxis = 2):
+// 2d convex hull of the points projected along the fixed axis, then rotating calipers for the minimum area rectangle
+void   computeBestFitOBB_FixAxisByHull(size_t vcount, const REAL *points, size_t pstride, int fixAxis, REAL *sides, REAL matrix[16]);
 };
 
 #endif
@@ -2,20 +2,173 @@
 #include "../utilities/utility.h"
 #include <qgl.h>
 #include <QFile>
+#include <QFileInfo>
+#include <QDirIterator>
 #include "IO_3DS.h"
+#include <thread>
+#include <atomic>
+
+// header of the binary mesh cache, followed by vertices (3 doubles each), faces (3 ints each) and face normals (3 doubles each)
+struct BinaryMeshHeader
+{
+	char magic[4];
+	int version;
+	int vertNum;
+	int faceNum;
+	double metric;
+	double minVert[3];
+	double maxVert[3];
+};
+
+const char BinaryMeshMagic[4] = { 'B', 'M', 'S', 'H' };
+const int BinaryMeshVersion = 1;
+
+std::shared_ptr<const CMeshAsset> MeshDatabase::getOrLoadAsset(const QString &name, const AssetLoader &loader)
+{
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+
+		while (m_loadingNames.count(name))
+		{
+			m_loadedCond.wait(lock);
+		}
+
+		auto it = m_assets.find(name);
+		if (it != m_assets.end())
+		{
+			return it->second;
+		}
+
+		m_loadingNames.insert(name);
+	}
+
+	// load outside the lock so different meshes are loaded in parallel
+	std::shared_ptr<const CMeshAsset> asset = loader();
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		if (asset != nullptr)
+		{
+			m_assets[name] = asset;
+		}
+
+		m_loadingNames.erase(name);
+	}
+
+	m_loadedCond.notify_all();
+
+	return asset;
+}
+
+std::shared_ptr<const CMeshAsset> MeshDatabase::getAsset(const QString &name)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	auto it = m_assets.find(name);
+	if (it != m_assets.end())
+	{
+		return it->second;
+	}
+
+	return nullptr;
+}
+
+void MeshDatabase::addAsset(const QString &name, std::shared_ptr<const CMeshAsset> asset)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_assets[name] = asset;
+}
+
+bool MeshDatabase::writeFileOnce(const QString &fileName, const FileWriter &writer)
+{
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+
+		while (m_writingFileNames.count(fileName))
+		{
+			m_loadedCond.wait(lock);
+		}
+
+		if (m_writtenFileNames.count(fileName))
+		{
+			return false;
+		}
+
+		m_writingFileNames.insert(fileName);
+	}
+
+	// write outside the lock so files of different models are written in parallel
+	writer();
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		m_writtenFileNames.insert(fileName);
+		m_writingFileNames.erase(fileName);
+	}
+
+	m_loadedCond.notify_all();
+
+	return true;
+}
+
+void MeshDatabase::clearWrittenFiles()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_writtenFileNames.clear();
+}
+
+int MeshDatabase::size()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_assets.size();
+}
+
+void MeshDatabase::clear()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_assets.clear();
+}
+
+CMesh::CMesh()
+{
+	m_asset = std::make_shared<CMeshAsset>();
+
+	m_transMat.setidentity();
+	m_hasTransform = false;
+	m_worldVertsValid = false;
+
+	m_opcodeValid = false;
+	updateQueryTransform();
+
+	m_suppBVHAngle = 0;
+	m_suppBVHValid = false;
+}
 
 CMesh::CMesh(QString path, QString name)
+	:CMesh()
+{
+	m_name = name;
+}
+
+CMesh::CMesh(std::shared_ptr<const CMeshAsset> asset, QString name)
+	:CMesh()
 {
 	m_name = name;
+	setAsset(asset);
 }
 
-// make a deep copy of the input mesh
+// share the asset of the input mesh and copy its instance transformation
 CMesh::CMesh(CMesh &inputMesh)
+	:CMesh()
 {
 	m_name = inputMesh.m_name;
-	m_vertices = inputMesh.getVertices();
-	m_faces = inputMesh.getFaces();
-	m_faceNormals = inputMesh.getfaceNormals();
+	m_asset = inputMesh.getAsset();
+
+	m_transMat = inputMesh.m_transMat;
+	m_hasTransform = inputMesh.m_hasTransform;
+	updateQueryTransform();
 
 	m_minVert = inputMesh.getMinVert();
 	m_maxVert = inputMesh.getMaxVert();
@@ -23,15 +176,36 @@ CMesh::CMesh(CMesh &inputMesh)
 
 CMesh::~CMesh()
 {
-	m_vertices.clear();
-	m_faces.clear();
-	m_faceNormals.clear();
+	m_worldVertices.clear();
+}
+
+void CMesh::setAsset(std::shared_ptr<const CMeshAsset> asset)
+{
+	m_asset = asset;
+
+	m_transMat.setidentity();
+	m_hasTransform = false;
+	m_worldVertices.clear();
+	m_worldVertsValid = false;
+
+	m_minVert = m_asset->m_minVert;
+	m_maxVert = m_asset->m_maxVert;
+
+	updateQueryTransform();
+	m_worldOpcodeTree.clear();
+	m_opcodeValid = false;
+
+	m_suppBVHValid = false;
 }
 
 bool CMesh::readObjFile(const std::string &filename, const double metric /*= 1.0*/)
 {	
 	MathLib::Vector3 currMetric(metric, metric, metric);
 
+	std::shared_ptr<CMeshAsset> asset = std::make_shared<CMeshAsset>();
+	std::vector<MathLib::Vector3> &meshVerts = asset->m_vertices;
+	std::vector<std::vector<int>> &meshFaces = asset->m_faces;
+
 	char   s[200];
 	float  x, y, z;
 	//std::vector<Surface_mesh::Vertex>  vertices;
@@ -43,9 +217,8 @@ bool CMesh::readObjFile(const std::string &filename, const double metric /*= 1.0
 	if (!in) return false;
 
 
-	// if mesh is not empty we need an offset for vertex indices
-	// also take into accout that OBJ indices start at 1 (not 0)
-	const int voffset = m_vertices.size() - 1;
+	// OBJ indices start at 1 (not 0)
+	const int voffset = -1;
 
 
 	// clear line once
@@ -66,7 +239,7 @@ bool CMesh::readObjFile(const std::string &filename, const double metric /*= 1.0
 				//this->add_vertex(MathLib::Vector3(x*m_metric, y*m_metric, z*m_metric));
 				//this->add_vertex(Surface_mesh::Point(x, y, z));
 
-				m_vertices.push_back(MathLib::Vector3(x*currMetric[0], y*currMetric[1], z*currMetric[2]));
+				meshVerts.push_back(MathLib::Vector3(x*currMetric[0], y*currMetric[1], z*currMetric[2]));
 			}
 		}
 
@@ -145,7 +318,7 @@ bool CMesh::readObjFile(const std::string &filename, const double metric /*= 1.0
 
 				if (!(v0 == v1 | v1 == v2 | v0 == v2))
 					//this->add_face(vertices);
-					m_faces.push_back(vertices);
+					meshFaces.push_back(vertices);
 			}
 			else if(vertices.size() == 4)
 			{
@@ -158,8 +331,8 @@ bool CMesh::readObjFile(const std::string &filename, const double metric /*= 1.0
 				secondTri[1] = vertices[3];
 				secondTri[2] = vertices[0];
 
-				m_faces.push_back(firstTri);
-				m_faces.push_back(secondTri);
+				meshFaces.push_back(firstTri);
+				meshFaces.push_back(secondTri);
 			}
 
 		}
@@ -172,31 +345,232 @@ bool CMesh::readObjFile(const std::string &filename, const double metric /*= 1.0
 
 	fclose(in);
 
-	computeMinMaxVerts();
-	computeFaceNormal();
+	asset->computeMinMaxVerts();
+	asset->computeFaceNormal();
+
+	setAsset(asset);
 
 	return true;
 }
 
 bool CMesh::read3DSFile(const std::string &filename, const double metric /*= 1.0*/)
 {
-	CIO_3DS* io_3DS = new CIO_3DS(this);
+	std::shared_ptr<CMeshAsset> asset = std::make_shared<CMeshAsset>();
+	CIO_3DS* io_3DS = new CIO_3DS(asset.get());
 
 	io_3DS->read3DS(toQString(filename));
 	
-	computeMinMaxVerts();
-	computeFaceNormal();
+	asset->computeMinMaxVerts();
+	asset->computeFaceNormal();
+
+	setAsset(asset);
 
 	delete io_3DS;
 	return true;
 }
 
+bool CMesh::readBinaryMeshFile(const std::string &filename, const double metric /*= 1.0*/)
+{
+	QFile inFile(toQString(filename));
+
+	if (!inFile.open(QIODevice::ReadOnly)) return false;
+
+	qint64 fileSize = inFile.size();
+	if (fileSize < (qint64)sizeof(BinaryMeshHeader))
+	{
+		inFile.close();
+		return false;
+	}
+
+	uchar *data = inFile.map(0, fileSize);
+	if (data == NULL)
+	{
+		inFile.close();
+		return false;
+	}
+
+	BinaryMeshHeader header;
+	memcpy(&header, data, sizeof(BinaryMeshHeader));
+
+	qint64 expectedSize = sizeof(BinaryMeshHeader) + (qint64)header.vertNum * 3 * sizeof(double)
+		+ (qint64)header.faceNum * 3 * (sizeof(int) + sizeof(double));
+
+	// reject cache written with different version or metric, or truncated
+	if (memcmp(header.magic, BinaryMeshMagic, 4) != 0 || header.version != BinaryMeshVersion
+		|| header.metric != metric || header.vertNum < 0 || header.faceNum < 0 || expectedSize != fileSize)
+	{
+		inFile.unmap(data);
+		inFile.close();
+		return false;
+	}
+
+	const double *vertData = (const double*)(data + sizeof(BinaryMeshHeader));
+	const int *faceData = (const int*)(vertData + 3 * header.vertNum);
+	const double *normalData = (const double*)(faceData + 3 * header.faceNum);
+
+	std::shared_ptr<CMeshAsset> asset = std::make_shared<CMeshAsset>();
+
+	asset->m_vertices.resize(header.vertNum);
+	for (int i = 0; i < header.vertNum; i++)
+	{
+		asset->m_vertices[i] = MathLib::Vector3(vertData + 3 * i);
+	}
+
+	asset->m_faces.resize(header.faceNum);
+	asset->m_faceNormals.resize(header.faceNum);
+	for (int i = 0; i < header.faceNum; i++)
+	{
+		asset->m_faces[i].assign(faceData + 3 * i, faceData + 3 * i + 3);
+		asset->m_faceNormals[i] = MathLib::Vector3(normalData + 3 * i);
+	}
+
+	asset->m_minVert = MathLib::Vector3(header.minVert);
+	asset->m_maxVert = MathLib::Vector3(header.maxVert);
+	asset->buildVertexStore();
+
+	inFile.unmap(data);
+	inFile.close();
+
+	setAsset(asset);
+
+	return true;
+}
+
+bool CMesh::saveBinaryMeshFile(const std::string &filename, const double metric /*= 1.0*/)
+{
+	// write to a temp file first, so a crashed write never leaves a valid-looking cache
+	QString tempFileName = toQString(filename) + ".tmp";
+	QFile outFile(tempFileName);
+
+	if (!outFile.open(QIODevice::WriteOnly | QIODevice::Truncate)) return false;
+
+	BinaryMeshHeader header;
+	memcpy(header.magic, BinaryMeshMagic, 4);
+	header.version = BinaryMeshVersion;
+	const std::vector<MathLib::Vector3> &meshVerts = m_asset->m_vertices;
+	const std::vector<std::vector<int>> &meshFaces = m_asset->m_faces;
+	const std::vector<MathLib::Vector3> &meshNormals = m_asset->m_faceNormals;
+
+	header.vertNum = meshVerts.size();
+	header.faceNum = meshFaces.size();
+	header.metric = metric;
+	for (int i = 0; i < 3; i++)
+	{
+		header.minVert[i] = m_asset->m_minVert[i];
+		header.maxVert[i] = m_asset->m_maxVert[i];
+	}
+
+	std::vector<double> vertData(3 * header.vertNum);
+	for (int i = 0; i < header.vertNum; i++)
+	{
+		memcpy(&vertData[3 * i], meshVerts[i].v, 3 * sizeof(double));
+	}
+
+	std::vector<int> faceData(3 * header.faceNum);
+	std::vector<double> normalData(3 * header.faceNum);
+	for (int i = 0; i < header.faceNum; i++)
+	{
+		for (int j = 0; j < 3; j++)
+		{
+			faceData[3 * i + j] = meshFaces[i][j];
+		}
+
+		memcpy(&normalData[3 * i], meshNormals[i].v, 3 * sizeof(double));
+	}
+
+	outFile.write((const char*)&header, sizeof(BinaryMeshHeader));
+	outFile.write((const char*)vertData.data(), vertData.size() * sizeof(double));
+	outFile.write((const char*)faceData.data(), faceData.size() * sizeof(int));
+	outFile.write((const char*)normalData.data(), normalData.size() * sizeof(double));
+	outFile.close();
+
+	if (outFile.error() != QFileDevice::NoError)
+	{
+		QFile::remove(tempFileName);
+		return false;
+	}
+
+	QFile::remove(toQString(filename));
+	return QFile::rename(tempFileName, toQString(filename));
+}
+
+QString CMesh::getBinaryMeshFileName(const QString &modelFileName)
+{
+	int cutPos = modelFileName.lastIndexOf(".");
+	return modelFileName.left(cutPos) + ".bmesh";
+}
+
+bool CMesh::isBinaryMeshFileUpToDate(const QString &modelFileName)
+{
+	QFileInfo binFileInfo(getBinaryMeshFileName(modelFileName));
+
+	if (!binFileInfo.exists()) return false;
+
+	// cache is stale if the source model was modified after the cache was written
+	QFileInfo modelFileInfo(modelFileName);
+	return binFileInfo.lastModified() >= modelFileInfo.lastModified();
+}
+
+int CMesh::buildBinaryMeshCacheForFolder(const QString &folderPath, const double metric /*= 1.0*/)
+{
+	int convertedNum = 0;
+	int skippedNum = 0;
+
+	QDirIterator it(folderPath, QStringList() << "*.obj", QDir::Files, QDirIterator::Subdirectories);
+
+	while (it.hasNext())
+	{
+		QString modelFileName = it.next();
+
+		if (isBinaryMeshFileUpToDate(modelFileName))
+		{
+			skippedNum++;
+			continue;
+		}
+
+		CMesh mesh;
+		if (!mesh.readObjFile(modelFileName.toStdString(), metric))
+		{
+			std::cout << "	 cannot read " << modelFileName.toStdString() << "\n";
+			continue;
+		}
+
+		if (mesh.saveBinaryMeshFile(getBinaryMeshFileName(modelFileName).toStdString(), metric))
+		{
+			convertedNum++;
+		}
+		else
+		{
+			std::cout << "	 cannot write mesh cache for " << modelFileName.toStdString() << "\n";
+		}
+
+		if (convertedNum % 500 == 0 && convertedNum > 0)
+		{
+			std::cout << "	 " << convertedNum << " meshes converted\n";
+		}
+	}
+
+	std::cout << "	 mesh cache for " << folderPath.toStdString() << ": " << convertedNum << " converted, " << skippedNum << " up to date\n";
+
+	return convertedNum;
+}
+
 void CMesh::draw(QColor c)
 {
-	Eigen::Matrix4d displayTransMat = Eigen::Matrix4d::Identity();
+	const std::vector<MathLib::Vector3> &meshVerts = m_asset->m_vertices;
+	const std::vector<std::vector<int>> &meshFaces = m_asset->m_faces;
+	const std::vector<MathLib::Vector3> &meshNormals = m_asset->m_faceNormals;
 
 	glPushAttrib(GL_LIGHTING_BIT | GL_ENABLE_BIT | GL_HINT_BIT | GL_LINE_BIT | GL_CURRENT_BIT);
 
+	// draw shared model space data with the instance transformation
+	glPushMatrix();
+	if (m_hasTransform)
+	{
+		glMultMatrixd(m_transMat.M);
+		glEnable(GL_NORMALIZE);
+	}
+
 	glEnable(GL_BLEND);
 	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 	glEnable(GL_LIGHTING);
@@ -204,158 +578,222 @@ void CMesh::draw(QColor c)
 
 	glColor4d(c.redF(), c.greenF(), c.blueF(), c.alphaF());
 
-	if (displayTransMat == Eigen::Matrix4d::Identity())
-	{
-		// draw front face
-		glCullFace(GL_BACK);
-		glBegin(GL_TRIANGLES);
+	// draw front face
+	glCullFace(GL_BACK);
 
-		for (unsigned int f_id = 0; f_id < m_faces.size(); f_id++)
-		{
-			glNormal3dv(m_faceNormals[f_id].v);
-
-			std::vector<int> vert_ids = m_faces[f_id];			
-			for (int i = 0; i < 3; i++)
-			{
-				int v_id = vert_ids[i];
-				glVertex3dv(m_vertices[v_id].v);
-			}			
-		}
+	CMeshRenderBuffer *renderBuffer = m_asset->getRenderBuffer();
+	if (renderBuffer != NULL)
+	{
+		// front and back faces are both in the buffer
+		renderBuffer->bind();
+		renderBuffer->drawFaces();
+		renderBuffer->release();
+
+		glPopMatrix();
+		glPopAttrib();
+		return;
+	}
 
-		glEnd();
+	glBegin(GL_TRIANGLES);
 
+	for (unsigned int f_id = 0; f_id < meshFaces.size(); f_id++)
+	{
+		glNormal3dv(meshNormals[f_id].v);
 
-		// draw back face
-		//glCullFace(GL_FRONT);
-		glBegin(GL_TRIANGLES);
-		for (unsigned int f_id = 0; f_id < m_faces.size(); f_id++)
+		std::vector<int> vert_ids = meshFaces[f_id];			
+		for (int i = 0; i < 3; i++)
 		{
-			double* faceNormal = m_faceNormals[f_id].v;
-			glNormal3d(-faceNormal[0], -faceNormal[1], -faceNormal[2]);
+			int v_id = vert_ids[i];
+			glVertex3dv(meshVerts[v_id].v);
+		}			
+	}
 
-			std::vector<int> vert_ids = m_faces[f_id];
-			//for (int i = 3; i < 3; i++)
-			for (int i = 2; i >=0; i--)
-			{
-				int v_id = vert_ids[i];
-				glVertex3dv(m_vertices[v_id].v);
-			}
-		}
-		glEnd();
+	glEnd();
 
-	}
-	else
+
+	// draw back face
+	//glCullFace(GL_FRONT);
+	glBegin(GL_TRIANGLES);
+	for (unsigned int f_id = 0; f_id < meshFaces.size(); f_id++)
 	{
+		const double* faceNormal = meshNormals[f_id].v;
+		glNormal3d(-faceNormal[0], -faceNormal[1], -faceNormal[2]);
 
+		std::vector<int> vert_ids = meshFaces[f_id];
+		//for (int i = 3; i < 3; i++)
+		for (int i = 2; i >=0; i--)
+		{
+			int v_id = vert_ids[i];
+			glVertex3dv(meshVerts[v_id].v);
+		}
 	}
+	glEnd();
 
+	glPopMatrix();
 	glPopAttrib();
 }
 
-void CMesh::draw(const std::vector<int> &faceIndicators)
+void CMesh::drawInstances(const std::vector<CMesh*> &meshes, const std::vector<QColor> &colors)
 {
-	Eigen::Matrix4d displayTransMat = Eigen::Matrix4d::Identity();
+	// group instances by asset, in order of first appearance
+	std::vector<const CMeshAsset*> assets;
+	std::map<const CMeshAsset*, std::vector<int>> assetInstances;
+
+	for (int i = 0; i < meshes.size(); i++)
+	{
+		const CMeshAsset *asset = meshes[i]->m_asset.get();
+
+		std::vector<int> &instanceIds = assetInstances[asset];
+		if (instanceIds.empty())
+		{
+			assets.push_back(asset);
+		}
+
+		instanceIds.push_back(i);
+	}
 
 	glPushAttrib(GL_LIGHTING_BIT | GL_ENABLE_BIT | GL_HINT_BIT | GL_LINE_BIT | GL_CURRENT_BIT);
 
+	glEnable(GL_NORMALIZE);
 	glEnable(GL_BLEND);
 	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 	glEnable(GL_LIGHTING);
 	glEnable(GL_CULL_FACE);
+	glCullFace(GL_BACK);
 
-	if (displayTransMat == Eigen::Matrix4d::Identity())
+	for (int a = 0; a < assets.size(); a++)
 	{
-		// draw front face
-		glCullFace(GL_BACK);
-		glBegin(GL_TRIANGLES);
+		const std::vector<int> &instanceIds = assetInstances[assets[a]];
 
-		for (unsigned int f_id = 0; f_id < m_faces.size(); f_id++)
+		CMeshRenderBuffer *renderBuffer = assets[a]->getRenderBuffer();
+		if (renderBuffer == NULL)
 		{
-			QColor c;
-			if (faceIndicators[f_id] < 0)
-			{ 
-				c = QColor(180, 180, 180, 255);
-			}
-			else
-				c = GetColorFromSet(faceIndicators[f_id]);					
-			
-			glColor4d(c.redF(), c.greenF(), c.blueF(), c.alphaF());
-
-			glNormal3dv(m_faceNormals[f_id].v);
-
-			std::vector<int> vert_ids = m_faces[f_id];
-			for (int i = 0; i < 3; i++)
+			for (int i = 0; i < instanceIds.size(); i++)
 			{
-				int v_id = vert_ids[i];
-				glVertex3dv(m_vertices[v_id].v);
+				meshes[instanceIds[i]]->draw(colors[instanceIds[i]]);
 			}
-		}
 
-		glEnd();
+			continue;
+		}
 
+		renderBuffer->bind();
 
-		// draw back face
-		glCullFace(GL_FRONT);
-		glBegin(GL_TRIANGLES);
-		for (unsigned int f_id = 0; f_id < m_faces.size(); f_id++)
+		for (int i = 0; i < instanceIds.size(); i++)
 		{
-			QColor c;
-			if (faceIndicators[f_id] < 0)
+			CMesh *mesh = meshes[instanceIds[i]];
+			const QColor &c = colors[instanceIds[i]];
+
+			glPushMatrix();
+			if (mesh->m_hasTransform)
 			{
-				c = QColor(180, 180, 180, 255);
+				glMultMatrixd(mesh->m_transMat.M);
 			}
-			else
-				c = GetColorFromSet(faceIndicators[f_id]);
 
 			glColor4d(c.redF(), c.greenF(), c.blueF(), c.alphaF());
+			renderBuffer->drawFaces();
 
-			double* faceNormal = m_faceNormals[f_id].v;
-			glNormal3d(-faceNormal[0], -faceNormal[1], -faceNormal[2]);
-
-			std::vector<int> vert_ids = m_faces[f_id];
-			for (int i = 0; i < 3; i++)
-			{
-				int v_id = vert_ids[i];
-				glVertex3dv(m_vertices[v_id].v);
-			}
+			glPopMatrix();
 		}
-		glEnd();
-
-	}
-	else
-	{
 
+		renderBuffer->release();
 	}
 
 	glPopAttrib();
 }
 
-void CMesh::computeMinMaxVerts()
+void CMesh::draw(const std::vector<int> &faceIndicators)
 {
-	MathLib::Vector3 minVert(MAX_VALUE, MAX_VALUE, MAX_VALUE);
-	MathLib::Vector3 maxVert(-MAX_VALUE, -MAX_VALUE, -MAX_VALUE);
+	const std::vector<MathLib::Vector3> &meshVerts = m_asset->m_vertices;
+	const std::vector<std::vector<int>> &meshFaces = m_asset->m_faces;
+	const std::vector<MathLib::Vector3> &meshNormals = m_asset->m_faceNormals;
+
+	glPushAttrib(GL_LIGHTING_BIT | GL_ENABLE_BIT | GL_HINT_BIT | GL_LINE_BIT | GL_CURRENT_BIT);
+
+	// draw shared model space data with the instance transformation
+	glPushMatrix();
+	if (m_hasTransform)
+	{
+		glMultMatrixd(m_transMat.M);
+		glEnable(GL_NORMALIZE);
+	}
+
+	glEnable(GL_BLEND);
+	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	glEnable(GL_LIGHTING);
+	glEnable(GL_CULL_FACE);
+
+	// draw front face
+	glCullFace(GL_BACK);
+	glBegin(GL_TRIANGLES);
 
-	for (unsigned int v_id = 0; v_id < m_vertices.size(); v_id++)
+	for (unsigned int f_id = 0; f_id < meshFaces.size(); f_id++)
 	{
+		QColor c;
+		if (faceIndicators[f_id] < 0)
+		{ 
+			c = QColor(180, 180, 180, 255);
+		}
+		else
+			c = GetColorFromSet(faceIndicators[f_id]);					
+		
+		glColor4d(c.redF(), c.greenF(), c.blueF(), c.alphaF());
+
+		glNormal3dv(meshNormals[f_id].v);
+
+		std::vector<int> vert_ids = meshFaces[f_id];
 		for (int i = 0; i < 3; i++)
 		{
-			if (m_vertices[v_id][i] < minVert[i])
-			{
-				minVert[i] = m_vertices[v_id][i];
-			}
+			int v_id = vert_ids[i];
+			glVertex3dv(meshVerts[v_id].v);
+		}
+	}
 
-			if (m_vertices[v_id][i] > maxVert[i])
-			{
-				maxVert[i] = m_vertices[v_id][i];
-			}
+	glEnd();
+
+
+	// draw back face
+	glCullFace(GL_FRONT);
+	glBegin(GL_TRIANGLES);
+	for (unsigned int f_id = 0; f_id < meshFaces.size(); f_id++)
+	{
+		QColor c;
+		if (faceIndicators[f_id] < 0)
+		{
+			c = QColor(180, 180, 180, 255);
+		}
+		else
+			c = GetColorFromSet(faceIndicators[f_id]);
+
+		glColor4d(c.redF(), c.greenF(), c.blueF(), c.alphaF());
+
+		const double* faceNormal = meshNormals[f_id].v;
+		glNormal3d(-faceNormal[0], -faceNormal[1], -faceNormal[2]);
+
+		std::vector<int> vert_ids = meshFaces[f_id];
+		for (int i = 0; i < 3; i++)
+		{
+			int v_id = vert_ids[i];
+			glVertex3dv(meshVerts[v_id].v);
 		}
 	}
+	glEnd();
 
-	m_minVert = minVert;
-	m_maxVert = maxVert;
+	glPopMatrix();
+	glPopAttrib();
+}
+
+void CMeshAsset::computeMinMaxVerts()
+{
+	buildVertexStore();
+	m_vertStore.computeMinMax(m_minVert, m_maxVert);
+}
+
+void CMeshAsset::buildVertexStore()
+{
+	m_vertStore.build(m_vertices);
 }
 
-void CMesh::computeFaceNormal()
+void CMeshAsset::computeFaceNormal()
 {
 	m_faceNormals.resize(m_faces.size());
 
@@ -375,14 +813,119 @@ void CMesh::computeFaceNormal()
 
 void CMesh::transformMesh(const MathLib::Matrix4d &transMat)
 {
-	// transform verts
-	for (unsigned int v_id = 0; v_id < m_vertices.size(); v_id++)
+	// only accumulate the transformation, world space verts are materialized on request
+	m_transMat = transMat * m_transMat;
+	m_hasTransform = true;
+
+	m_worldVertsValid = false;
+	m_opcodeValid = false;
+	m_suppBVHValid = false;
+
+	updateQueryTransform();
+
+	// transform min max verts for aabb
+	updateWorldMinMaxVerts();
+}
+
+void CMesh::transformMeshes(const std::vector<CMesh*> &meshes, const std::vector<MathLib::Matrix4d> &transMats)
+{
+	// accumulate all transformations first, a mesh listed several times gets its bounds updated only once
+	std::vector<CMesh*> updateMeshes;
+	std::set<CMesh*> meshSet;
+
+	int totalVertNum = 0;
+
+	for (int i = 0; i < meshes.size(); i++)
+	{
+		CMesh *mesh = meshes[i];
+
+		mesh->m_transMat = transMats[i] * mesh->m_transMat;
+		mesh->m_hasTransform = true;
+
+		mesh->m_worldVertsValid = false;
+		mesh->m_opcodeValid = false;
+		mesh->m_suppBVHValid = false;
+
+		if (meshSet.insert(mesh).second)
+		{
+			updateMeshes.push_back(mesh);
+			totalVertNum += mesh->getVertsNum();
+		}
+	}
+
+	for (int i = 0; i < updateMeshes.size(); i++)
 	{
-		m_vertices[v_id] = transformVert(m_vertices[v_id], transMat);
+		updateMeshes[i]->updateQueryTransform();
 	}
 
-	// transform min max verts for aabb
-	computeMinMaxVerts();
+	// small batches are not worth the thread start up
+	const int minVertNumPerThread = 100000;
+	int threadNum = std::min((int)std::thread::hardware_concurrency(), totalVertNum / minVertNumPerThread);
+	threadNum = std::min(threadNum, (int)updateMeshes.size());
+
+	// scenes loaded by batch workers run in parallel already
+	if (IsBatchWorkerThread())
+	{
+		threadNum = 1;
+	}
+
+	if (threadNum <= 1)
+	{
+		for (int i = 0; i < updateMeshes.size(); i++)
+		{
+			updateMeshes[i]->updateWorldMinMaxVerts();
+		}
+
+		return;
+	}
+
+	std::atomic<int> nextMeshId(0);
+	std::vector<std::thread> workers;
+
+	for (int t = 0; t < threadNum; t++)
+	{
+		workers.push_back(std::thread([&updateMeshes, &nextMeshId]()
+		{
+			int meshId;
+			while ((meshId = nextMeshId++) < updateMeshes.size())
+			{
+				updateMeshes[meshId]->updateWorldMinMaxVerts();
+			}
+		}));
+	}
+
+	for (int t = 0; t < threadNum; t++)
+	{
+		workers[t].join();
+	}
+}
+
+void CMesh::updateWorldMinMaxVerts()
+{
+	m_asset->m_vertStore.transformMinMax(m_transMat, m_minVert, m_maxVert);
+}
+
+const std::vector<MathLib::Vector3>& CMesh::getVertices()
+{
+	if (!m_hasTransform)
+	{
+		return m_asset->m_vertices;
+	}
+
+	if (!m_worldVertsValid)
+	{
+		// bounds come out of the same pass and are identical to the current ones
+		m_asset->m_vertStore.transformMinMax(m_transMat, m_minVert, m_maxVert, &m_worldVertices);
+		m_worldVertsValid = true;
+	}
+
+	return m_worldVertices;
+}
+
+void CMesh::releaseWorldVertices()
+{
+	std::vector<MathLib::Vector3>().swap(m_worldVertices);
+	m_worldVertsValid = false;
 }
 
 MathLib::Vector3 CMesh::transformVert(const MathLib::Vector3 &vert, const MathLib::Matrix4d &transMat)
@@ -395,6 +938,23 @@ bool CMesh::isSegIntersect(const MathLib::Vector3 &startPt, const MathLib::Vecto
 	// if test with Ray
 	if (radius == 0)
 	{
+		// segment as start + t*(end - start), t in [0, 1]; back faces are culled as in the opcode ray query
+		if (useLocalOpcodeQuery(false))
+		{
+			MathLib::Vector3 segDir = endPt - startPt;
+			double t;
+			int faceId;
+
+			if (intersectRay(startPt, segDir, 1.0, true, t, faceId))
+			{
+				intersectPoint = startPt + segDir*t;
+				return true;
+			}
+
+			return false;
+		}
+
+		// singular transformation, query the world space tree
 		MathLib::Vector3 segDir = endPt - startPt;
 		double segLength = segDir.magnitude();
 		segDir.normalize();
@@ -407,14 +967,13 @@ bool CMesh::isSegIntersect(const MathLib::Vector3 &startPt, const MathLib::Vecto
 		Opcode::CollisionFace closest_contact;
 		Opcode::SetupClosestHit(rayCollider, closest_contact);
 
-		bool testStatus = rayCollider.Collide(segRay, *m_OpcodeModel);
+		bool testStatus = rayCollider.Collide(segRay, getWorldOpcodeModel());
 
 		if (testStatus)
 		{
 			if (rayCollider.GetContactStatus())
 			{
-				double d = closest_contact.mDistance;
-				intersectPoint = startPt + segDir*d;
+				intersectPoint = startPt + segDir*closest_contact.mDistance;
 				return true;
 			}
 		}
@@ -425,15 +984,20 @@ bool CMesh::isSegIntersect(const MathLib::Vector3 &startPt, const MathLib::Vecto
 	// test with Capsule
 	else
 	{
+		bool isLocal = useLocalOpcodeQuery(true);
+		MathLib::Vector3 queryStart = isLocal ? m_invTransMat.transform(startPt) : startPt;
+		MathLib::Vector3 queryEnd = isLocal ? m_invTransMat.transform(endPt) : endPt;
+
 		IceMaths::LSS capsule;
-		capsule.mP0 = IceMaths::Point(startPt[0], startPt[1], startPt[2]);
-		capsule.mP1 = IceMaths::Point(endPt[0], endPt[1], endPt[2]);
-		capsule.mRadius = radius;
+		capsule.mP0 = IceMaths::Point(queryStart[0], queryStart[1], queryStart[2]);
+		capsule.mP1 = IceMaths::Point(queryEnd[0], queryEnd[1], queryEnd[2]);
+		capsule.mRadius = isLocal ? radius / m_transScale : radius;
 
 		Opcode::LSSCollider capsuleCollider;
 		Opcode::LSSCache capsuleCache;
 
-		bool testStatus = capsuleCollider.Collide(capsuleCache, capsule, *m_OpcodeModel, null, null);
+		const Opcode::Model &opModel = isLocal ? m_asset->getOpcodeModel() : getWorldOpcodeModel();
+		bool testStatus = capsuleCollider.Collide(capsuleCache, capsule, opModel, null, null);
 
 		if (testStatus)
 		{
@@ -448,59 +1012,220 @@ bool CMesh::isSegIntersect(const MathLib::Vector3 &startPt, const MathLib::Vecto
 
 }
 
-void CMesh::buildOpcodeModel()
+// moller-trumbore; det > 0 when dir points against the face normal (v1 - v0) x (v2 - v0)
+// cullSign 1 keeps only such front face hits, -1 only back face hits, 0 both
+static bool IntersectRayTriangle(const MathLib::Vector3 &orig, const MathLib::Vector3 &dir,
+	const MathLib::Vector3 &v0, const MathLib::Vector3 &v1, const MathLib::Vector3 &v2, int cullSign, double &t)
 {
-	// Opcode mesh interface
-	m_opFaces = new unsigned int[m_faces.size()*3];
-	int k = 0;
-	for (int i = 0; i < m_faces.size(); i++)
+	MathLib::Vector3 edge1 = v1 - v0;
+	MathLib::Vector3 edge2 = v2 - v0;
+	MathLib::Vector3 pvec = dir.cross(edge2);
+
+	double det = edge1.dot(pvec);
+	if (det == 0 || det*cullSign < 0)
 	{
-		m_opFaces[k++] = m_faces[i][0];
-		m_opFaces[k++] = m_faces[i][1];
-		m_opFaces[k++] = m_faces[i][2];
+		return false;
 	}
 
-	IceMaths::Point *opVerts = new IceMaths::Point[m_vertices.size()];
-	for (int i = 0; i < m_vertices.size(); i++)
+	double invDet = 1.0 / det;
+	MathLib::Vector3 tvec = orig - v0;
+
+	double u = tvec.dot(pvec) * invDet;
+	if (u < 0 || u > 1)
 	{
-		opVerts[i] = IceMaths::Point(m_vertices[i][0], m_vertices[i][1], m_vertices[i][2]);
+		return false;
 	}
 
-	m_meshIterface = new Opcode::MeshInterface();
-	m_meshIterface->SetNbTriangles(m_faces.size());
-	m_meshIterface->SetNbVertices(m_vertices.size());
-	m_meshIterface->SetPointers((const IndexedTriangle*)m_opFaces, opVerts);
+	MathLib::Vector3 qvec = tvec.cross(edge1);
+	double v = dir.dot(qvec) * invDet;
+	if (v < 0 || u + v > 1)
+	{
+		return false;
+	}
 
-	Opcode::OPCODECREATE opCreate;
-	opCreate.mIMesh = m_meshIterface;
-	opCreate.mSettings.mLimit = 1;
-	opCreate.mSettings.mRules = Opcode::SPLIT_SPLATTER_POINTS | Opcode::SPLIT_GEOM_CENTER;
-	opCreate.mNoLeaf = true;
-	opCreate.mQuantized = true;
-	opCreate.mKeepOriginal = false;
-	opCreate.mCanRemap = false;
+	t = edge2.dot(qvec) * invDet;
+	return t >= 0;
+}
+
+bool CMesh::intersectRay(const MathLib::Vector3 &orig, const MathLib::Vector3 &dir, double maxT, bool cullBackFaces, double &t, int &faceId)
+{
+	if (!m_isInvertibleTrans)
+	{
+		return false;
+	}
+
+	// affine map keeps the ray parameter, so the query runs on the shared model space tree
+	MathLib::Vector3 localOrig = m_invTransMat.transform(orig);
+	MathLib::Vector3 localDir = m_invTransMat.transformVec(dir);
+	int cullSign = cullBackFaces ? (m_isMirrorTrans ? -1 : 1) : 0;
+
+	const std::vector<MathLib::Vector3> &verts = m_asset->m_vertices;
+	const std::vector<std::vector<int>> &faces = m_asset->m_faces;
+
+	auto faceTest = [&](int fid, double &tMax)
+	{
+		const std::vector<int> &f = faces[fid];
+		double faceT;
+
+		if (IntersectRayTriangle(localOrig, localDir, verts[f[0]], verts[f[1]], verts[f[2]], cullSign, faceT) && faceT <= tMax)
+		{
+			tMax = faceT;
+			t = faceT;
+			faceId = fid;
+			return true;
+		}
+
+		return false;
+	};
 
-	m_OpcodeModel = new Opcode::Model();
-	m_OpcodeModel->Build(opCreate);
+	return m_asset->getRayBVH().intersectRay(localOrig, localDir, maxT, faceTest);
+}
+
+void CMesh::buildOpcodeModel()
+{
+	// the shared model space tree is built on first query, only the world space fallback depends on the transformation
+	m_opcodeValid = false;
 }
 
 void CMesh::updateOpcodeModel()
 {
-	IceMaths::Point *opVerts = new IceMaths::Point[m_vertices.size()];
-	for (int i = 0; i < m_vertices.size(); i++)
+	m_opcodeValid = false;
+}
+
+void CMesh::updateQueryTransform()
+{
+	const double *M = m_transMat.M;
+
+	double det = m_transMat.det();
+	m_isInvertibleTrans = MathLib::Abs(det) > 1e-12;
+
+	if (m_isInvertibleTrans)
+	{
+		m_invTransMat.invert(m_transMat);
+	}
+	else
+	{
+		m_invTransMat.setidentity();
+	}
+
+	// similarity: orthogonal columns of equal length
+	MathLib::Vector3 cols[3] = { MathLib::Vector3(M[0], M[1], M[2]), MathLib::Vector3(M[4], M[5], M[6]), MathLib::Vector3(M[8], M[9], M[10]) };
+	double sqScale = cols[0].dot(cols[0]);
+	double tol = 1e-6 * sqScale;
+
+	m_isSimilarTrans = m_isInvertibleTrans
+		&& MathLib::Abs(cols[1].dot(cols[1]) - sqScale) < tol && MathLib::Abs(cols[2].dot(cols[2]) - sqScale) < tol
+		&& MathLib::Abs(cols[0].dot(cols[1])) < tol && MathLib::Abs(cols[0].dot(cols[2])) < tol && MathLib::Abs(cols[1].dot(cols[2])) < tol;
+
+	m_transScale = sqrt(sqScale);
+	m_isMirrorTrans = det < 0;
+}
+
+bool CMesh::useLocalOpcodeQuery(bool needSimilarity)
+{
+	return m_isInvertibleTrans && (!needSimilarity || m_isSimilarTrans);
+}
+
+const Opcode::Model& CMesh::getWorldOpcodeModel()
+{
+	if (!m_opcodeValid || m_worldOpcodeTree.isEmpty())
 	{
-		opVerts[i] = IceMaths::Point(m_vertices[i][0], m_vertices[i][1], m_vertices[i][2]);
+		m_worldOpcodeTree.build(getVertices(), m_asset->m_faces);
+		m_opcodeValid = true;
 	}
 
-	m_meshIterface->SetPointers((const IndexedTriangle*)m_opFaces, opVerts);
+	return m_worldOpcodeTree.getModel();
+}
+
+const Opcode::Model& CMeshAsset::getOpcodeModel() const
+{
+	std::call_once(m_opcodeOnce, [this]() { m_opcodeTree.build(m_vertices, m_faces); });
+
+	return m_opcodeTree.getModel();
+}
+
+const CRayBVH& CMeshAsset::getRayBVH() const
+{
+	std::call_once(m_rayBVHOnce, [this]()
+	{
+		std::vector<double> faceBoxes(6 * m_faces.size());
+
+		for (int i = 0; i < m_faces.size(); i++)
+		{
+			const std::vector<int> &f = m_faces[i];
+			for (int d = 0; d < 3; d++)
+			{
+				faceBoxes[6 * i + d] = std::min(m_vertices[f[0]][d], std::min(m_vertices[f[1]][d], m_vertices[f[2]][d]));
+				faceBoxes[6 * i + 3 + d] = std::max(m_vertices[f[0]][d], std::max(m_vertices[f[1]][d], m_vertices[f[2]][d]));
+			}
+		}
+
+		m_rayBVH.build(faceBoxes);
+	});
+
+	return m_rayBVH;
+}
 
-	if (m_OpcodeModel != NULL)
+CMeshRenderBuffer* CMeshAsset::getRenderBuffer() const
+{
+	if (m_renderBuffer != nullptr && m_renderBuffer->isValidInCurrentContext())
 	{
-		delete m_OpcodeModel;
+		return m_renderBuffer.get();
 	}
 
+	if (m_renderBuffer == nullptr)
+	{
+		m_renderBuffer.reset(new CMeshRenderBuffer());
+	}
+
+	if (!m_renderBuffer->create(*this))
+	{
+		return NULL;
+	}
+
+	return m_renderBuffer.get();
+}
+
+COpcodeTree::COpcodeTree()
+{
+	m_model = NULL;
+	m_meshInterface = NULL;
+	m_faces = NULL;
+	m_verts = NULL;
+}
+
+COpcodeTree::~COpcodeTree()
+{
+	clear();
+}
+
+void COpcodeTree::build(const std::vector<MathLib::Vector3> &verts, const std::vector<std::vector<int>> &faces)
+{
+	clear();
+
+	// Opcode mesh interface
+	m_faces = new unsigned int[faces.size()*3];
+	int k = 0;
+	for (int i = 0; i < faces.size(); i++)
+	{
+		m_faces[k++] = faces[i][0];
+		m_faces[k++] = faces[i][1];
+		m_faces[k++] = faces[i][2];
+	}
+
+	m_verts = new IceMaths::Point[verts.size()];
+	for (int i = 0; i < verts.size(); i++)
+	{
+		m_verts[i] = IceMaths::Point(verts[i][0], verts[i][1], verts[i][2]);
+	}
+
+	m_meshInterface = new Opcode::MeshInterface();
+	m_meshInterface->SetNbTriangles(faces.size());
+	m_meshInterface->SetNbVertices(verts.size());
+	m_meshInterface->SetPointers((const IndexedTriangle*)m_faces, m_verts);
+
 	Opcode::OPCODECREATE opCreate;
-	opCreate.mIMesh = m_meshIterface;
+	opCreate.mIMesh = m_meshInterface;
 	opCreate.mSettings.mLimit = 1;
 	opCreate.mSettings.mRules = Opcode::SPLIT_SPLATTER_POINTS | Opcode::SPLIT_GEOM_CENTER;
 	opCreate.mNoLeaf = true;
@@ -508,29 +1233,103 @@ void CMesh::updateOpcodeModel()
 	opCreate.mKeepOriginal = false;
 	opCreate.mCanRemap = false;
 
-	m_OpcodeModel = new Opcode::Model();
-	m_OpcodeModel->Build(opCreate);
+	m_model = new Opcode::Model();
+	m_model->Build(opCreate);
+}
+
+void COpcodeTree::clear()
+{
+	SAFE_DELETE(m_model);
+	SAFE_DELETE(m_meshInterface);
+	SAFE_DELETE_ARRAY(m_faces);
+	SAFE_DELETE_ARRAY(m_verts);
+}
+
+const CMeshBVH& CMesh::getSupportFaceBVH(const MathLib::Vector3 &upright, double angleT, bool isUpward)
+{
+	if (!m_suppBVHValid || m_suppBVHAngle != angleT
+		|| m_suppBVHUpright[0] != upright[0] || m_suppBVHUpright[1] != upright[1] || m_suppBVHUpright[2] != upright[2])
+	{
+		const std::vector<MathLib::Vector3> &verts = getVertices();
+		const std::vector<std::vector<int>> &faces = m_asset->m_faces;
+		const std::vector<MathLib::Vector3> &faceNormals = m_asset->m_faceNormals;
+
+		// same face mask as the all-pairs test in CModel::IsSupport
+		std::vector<int> upFaceIds, downFaceIds;
+		for (unsigned int f_id = 0; f_id < faces.size(); f_id++)
+		{
+			double d = faceNormals[f_id].dot(upright);
+			if (MathLib::Acos(MathLib::Abs(d)) > angleT)
+			{
+				continue;
+			}
+
+			if (d > 0)
+			{
+				upFaceIds.push_back(f_id);
+			}
+			else
+			{
+				downFaceIds.push_back(f_id);
+			}
+		}
+
+		m_suppFaceBVH[0].build(verts, faces, faceNormals, upFaceIds);
+		m_suppFaceBVH[1].build(verts, faces, faceNormals, downFaceIds);
+
+		m_suppBVHUpright = upright;
+		m_suppBVHAngle = angleT;
+		m_suppBVHValid = true;
+	}
+
+	return isUpward ? m_suppFaceBVH[0] : m_suppFaceBVH[1];
 }
 
 bool CMesh::isOBBIntersect(const COBB &testOBB)
 {
-	IceMaths::Matrix3x3 rotMat = IceMaths::Matrix3x3(testOBB.axis[0][0], testOBB.axis[0][1], testOBB.axis[0][2],
-		testOBB.axis[1][0], testOBB.axis[1][1], testOBB.axis[1][2],
-		testOBB.axis[2][0], testOBB.axis[2][1], testOBB.axis[2][2]);
+	bool isLocal = useLocalOpcodeQuery(true);
+
+	MathLib::Vector3 cent = testOBB.cent;
+	MathLib::Vector3 hsize = testOBB.hsize;
+	MathLib::Vector3 axis[3] = { testOBB.axis[0], testOBB.axis[1], testOBB.axis[2] };
+
+	// a box stays a box under the inverse of a similarity transform
+	if (isLocal)
+	{
+		cent = m_invTransMat.transform(cent);
+		hsize = hsize / m_transScale;
+
+		for (int i = 0; i < 3; i++)
+		{
+			axis[i] = m_invTransMat.transformVec(axis[i]);
+			axis[i].normalize();
+		}
+
+		// keep the box frame right handed under mirroring
+		if (axis[0].cross(axis[1]).dot(axis[2]) < 0)
+		{
+			axis[2] = -axis[2];
+		}
+	}
+
+	IceMaths::Matrix3x3 rotMat = IceMaths::Matrix3x3(axis[0][0], axis[0][1], axis[0][2],
+		axis[1][0], axis[1][1], axis[1][2],
+		axis[2][0], axis[2][1], axis[2][2]);
 
 	// old submission
 	//IceMaths::Matrix3x3 rotMat = IceMaths::Matrix3x3(testOBB.axis[0][0], testOBB.axis[1][0], testOBB.axis[2][0],
 	//	testOBB.axis[0][1], testOBB.axis[1][1], testOBB.axis[2][1],
 	//	testOBB.axis[0][2], testOBB.axis[1][2], testOBB.axis[2][2]);
 
-	IceMaths::OBB iceOBB = IceMaths::OBB(IceMaths::Point(testOBB.cent[0], testOBB.cent[1], testOBB.cent[2]),
-		IceMaths::Point(testOBB.hsize[0], testOBB.hsize[1], testOBB.hsize[2]),
+	IceMaths::OBB iceOBB = IceMaths::OBB(IceMaths::Point(cent[0], cent[1], cent[2]),
+		IceMaths::Point(hsize[0], hsize[1], hsize[2]),
 		rotMat);
 
 	Opcode::OBBCollider obbCollider;
 	Opcode::OBBCache obbCache;
 
-	bool testStatus = obbCollider.Collide(obbCache, iceOBB, *m_OpcodeModel, null, null);
+	const Opcode::Model &opModel = isLocal ? m_asset->getOpcodeModel() : getWorldOpcodeModel();
+	bool testStatus = obbCollider.Collide(obbCache, iceOBB, opModel, null, null);
 
 	if (testStatus)
 	{
@@ -550,14 +1349,17 @@ void CMesh::saveObjFile(const std::string &filename)
 
 	if (!outFile.open(QIODevice::ReadWrite | QIODevice::Text)) return;
 
-	for (int i = 0; i < m_vertices.size(); i++)
+	const std::vector<MathLib::Vector3> &worldVerts = getVertices();
+	const std::vector<std::vector<int>> &meshFaces = m_asset->m_faces;
+
+	for (int i = 0; i < worldVerts.size(); i++)
 	{
-		ofs << "v " << m_vertices[i][0] << " " << m_vertices[i][1] << " " << m_vertices[i][2] << "\n";
+		ofs << "v " << worldVerts[i][0] << " " << worldVerts[i][1] << " " << worldVerts[i][2] << "\n";
 	}
 
-	for (int i = 0; i < m_faces.size(); i++)
+	for (int i = 0; i < meshFaces.size(); i++)
 	{
-		ofs << "f " << m_faces[i][0] + 1 << " " << m_faces[i][1] + 1 << " " << m_faces[i][2] + 1 << "\n";
+		ofs << "f " << meshFaces[i][0] + 1 << " " << meshFaces[i][1] + 1 << " " << meshFaces[i][2] + 1 << "\n";
 	}
 
 	outFile.close();
@@ -570,7 +1372,7 @@ MathLib::Vector3 CMesh::getFaceCenter(int fid)
 	MathLib::Vector3 faceCent;
 	for (int i = 0; i < 3; i++)
 	{
-		faceCent += m_vertices[m_faces[fid][0]];
+		faceCent += m_transMat.transform(m_asset->m_vertices[m_asset->m_faces[fid][0]]);
 	}
 	
 	faceCent = faceCent / 3;
@@ -584,7 +1386,7 @@ std::vector<MathLib::Vector3> CMesh::getVerts(const std::vector<int> &ids)
 
 	for (int i = 0; i < ids.size(); i++)
 	{
-		verts[i] = m_vertices[ids[i]];
+		verts[i] = m_transMat.transform(m_asset->m_vertices[ids[i]]);
 	}
 
 	return verts;
@@ -3,21 +3,127 @@
 //#include "SurfaceMeshHelper.h"
 #include "../utilities/mathlib.h"
 #include "OBB.h"
+#include "MeshBVH.h"
+#include "RayBVH.h"
+#include "VertexStore.h"
+#include "MeshRenderBuffer.h"
 
 #include <Opcode.h>
+#include <QString>
+#include <memory>
+#include <map>
+#include <set>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
 
 // simple triangle mesh structure
 
-class CIO_3DS;
+// opcode collision tree with the face and vertex arrays it points to
+class COpcodeTree
+{
+public:
+	COpcodeTree();
+	~COpcodeTree();
+
+	void build(const std::vector<MathLib::Vector3> &verts, const std::vector<std::vector<int>> &faces);
+	void clear();
+
+	bool isEmpty() const { return m_model == NULL; };
+	const Opcode::Model& getModel() const { return *m_model; };
+
+private:
+	COpcodeTree(const COpcodeTree&);
+	COpcodeTree& operator=(const COpcodeTree&);
+
+	Opcode::Model *m_model;
+	Opcode::MeshInterface *m_meshInterface;
+	unsigned int *m_faces;
+	IceMaths::Point *m_verts;
+};
+
+// immutable mesh data in model space, shared by all instances of the same model
+class CMeshAsset
+{
+public:
+	// collision tree over model space faces, built once on first use and shared by all instances
+	const Opcode::Model& getOpcodeModel() const;
+
+	// ray query tree over model space face boxes, built once on first use and shared by all instances
+	const CRayBVH& getRayBVH() const;
+
+	// gpu buffers, created on first draw in the current GL context; NULL if buffers are not supported
+	// only used from the rendering thread
+	CMeshRenderBuffer* getRenderBuffer() const;
+
+	void computeFaceNormal();
+	void computeMinMaxVerts();  // also builds the vertex store
+	void buildVertexStore();
+
+	std::vector<MathLib::Vector3> m_vertices;
+	std::vector<std::vector<int>> m_faces;
+	std::vector<MathLib::Vector3> m_faceNormals;
+
+	CVertexStore m_vertStore;  // soa copy of m_vertices for batch transformation
+
+	MathLib::Vector3 m_minVert;
+	MathLib::Vector3 m_maxVert;
+
+private:
+	mutable COpcodeTree m_opcodeTree;
+	mutable std::once_flag m_opcodeOnce;
+
+	mutable CRayBVH m_rayBVH;
+	mutable std::once_flag m_rayBVHOnce;
+
+	mutable std::unique_ptr<CMeshRenderBuffer> m_renderBuffer;
+};
 
+// database of loaded mesh assets, indexed by model file name and metric
+// safe to share between scene loading threads, each asset is loaded only once
+class MeshDatabase
+{
+public:
+	typedef std::function<std::shared_ptr<const CMeshAsset>()> AssetLoader;
+
+	// return the stored asset, or run loader and store its result; threads asking for an asset
+	// that is being loaded wait for it; a failed load (null asset) is not stored
+	std::shared_ptr<const CMeshAsset> getOrLoadAsset(const QString &name, const AssetLoader &loader);
+
+	std::shared_ptr<const CMeshAsset> getAsset(const QString &name);
+	void addAsset(const QString &name, std::shared_ptr<const CMeshAsset> asset);
+
+	// per-model files (.obb, .bbtop) are shared by every scene using the model; writer only runs for the first
+	// caller of a file name, threads asking for a file that is being written wait for it
+	// return true if writer ran in this call
+	typedef std::function<void()> FileWriter;
+	bool writeFileOnce(const QString &fileName, const FileWriter &writer);
+	void clearWrittenFiles();  // files are written again on the next request, e.g. by a new stage
+
+	int size();
+	void clear();
+
+private:
+	std::map<QString, std::shared_ptr<const CMeshAsset>> m_assets;
+	std::set<QString> m_loadingNames;
+
+	std::set<QString> m_writtenFileNames;
+	std::set<QString> m_writingFileNames;
+
+	std::mutex m_mutex;
+	std::condition_variable m_loadedCond;
+};
+
+// mesh instance: a shared asset plus the instance transformation
 class CMesh
 {
 
 public:
-	CMesh() {};
-	CMesh(QString path, QString name); 
+	CMesh();
+	CMesh(QString path, QString name);
+	CMesh(std::shared_ptr<const CMeshAsset> asset, QString name);
 
-	CMesh(CMesh &inputMesh);
+	CMesh(CMesh &inputMesh);  // shares the asset of input mesh
 	~CMesh();
 
 	bool readObjFile(const std::string &filename, const double metric = 1.0);
@@ -25,49 +131,96 @@ public:
 
 	bool read3DSFile(const std::string &filename, const double metric = 1.0);
 
+	// binary mesh cache (.bmesh next to the model file)
+	bool readBinaryMeshFile(const std::string &filename, const double metric = 1.0);
+	bool saveBinaryMeshFile(const std::string &filename, const double metric = 1.0);
+	static QString getBinaryMeshFileName(const QString &modelFileName);
+	static bool isBinaryMeshFileUpToDate(const QString &modelFileName);
+	static int buildBinaryMeshCacheForFolder(const QString &folderPath, const double metric = 1.0);
+
 	void draw(QColor c);
 	void draw(const std::vector<int> &faceIndicators);
 
-	void computeFaceNormal();
-	void computeMinMaxVerts();
+	// draw meshes[i] with colors[i], instances of the same asset are drawn with one buffer bind
+	static void drawInstances(const std::vector<CMesh*> &meshes, const std::vector<QColor> &colors);
+
+	std::shared_ptr<const CMeshAsset> getAsset() { return m_asset; };
+	void setAsset(std::shared_ptr<const CMeshAsset> asset);
+
 	MathLib::Vector3 getMinVert() { return m_minVert; };
 	MathLib::Vector3 getMaxVert() { return m_maxVert; };
 
-	std::vector<MathLib::Vector3>& getfaceNormals() { return m_faceNormals; };
-	std::vector<MathLib::Vector3>& getVertices() { return m_vertices; };
-	std::vector<std::vector<int>>& getFaces() { return m_faces; };
+	// world space vertices are materialized on first request after a transformation
+	const std::vector<MathLib::Vector3>& getVertices();
+	void releaseWorldVertices();
+
+	// face normals are kept as loaded, they are not affected by instance transformation
+	const std::vector<MathLib::Vector3>& getfaceNormals() { return m_asset->m_faceNormals; };
+	const std::vector<std::vector<int>>& getFaces() { return m_asset->m_faces; };
 	MathLib::Vector3 getFaceCenter(int fid);
-	MathLib::Vector3 getFaceNormal(int fid){ return m_faceNormals[fid]; };
+	MathLib::Vector3 getFaceNormal(int fid){ return m_asset->m_faceNormals[fid]; };
 
-	int getVertsNum() { return m_vertices.size(); };
+	int getVertsNum() { return m_asset->m_vertices.size(); };
+	int getFaceNum() { return m_asset->m_faces.size(); };
 	std::vector<MathLib::Vector3> getVerts(const std::vector<int> &ids);
 
-
 	void transformMesh(const MathLib::Matrix4d &transMat);
+
+	// apply transMats[i] to meshes[i] in order, then update the bounds of each distinct mesh once, in parallel
+	static void transformMeshes(const std::vector<CMesh*> &meshes, const std::vector<MathLib::Matrix4d> &transMats);
 	MathLib::Vector3 transformVert(const MathLib::Vector3 &vert, const MathLib::Matrix4d &transMat);
+	const MathLib::Matrix4d& getTransMat() { return m_transMat; };
 
 	// collision
 	bool isSegIntersect(const MathLib::Vector3 &startPt, const MathLib::Vector3 &endPt, const double radius = 0, MathLib::Vector3 &intersectPoint = MathLib::Vector3(0, 0, 0));
 	bool isOBBIntersect(const COBB &testOBB);
 
+	// closest face hit by orig + t*dir for t in [0, maxT], orig and dir in world space
+	// t is the same in model space, so it is the world space distance in units of |dir|
+	bool intersectRay(const MathLib::Vector3 &orig, const MathLib::Vector3 &dir, double maxT, bool cullBackFaces, double &t, int &faceId);
+
 	void buildOpcodeModel();
 	void updateOpcodeModel();
 
-	friend CIO_3DS;
+	// face trees for support contact test, over faces within angleT of the upright
+	// isUpward selects faces pointing along upright, otherwise faces pointing against it
+	const CMeshBVH& getSupportFaceBVH(const MathLib::Vector3 &upright, double angleT, bool isUpward);
 
 	QString m_name;
 
 private:
+	void updateWorldMinMaxVerts();
+	void updateQueryTransform();
 
-	std::vector<MathLib::Vector3> m_vertices;
-	std::vector<std::vector<int>> m_faces;
-	std::vector<MathLib::Vector3> m_faceNormals;
+	// queries run in model space against the asset tree; capsule and box queries need a similarity transform,
+	// otherwise they use a world space tree of this instance
+	bool useLocalOpcodeQuery(bool needSimilarity);
+	const Opcode::Model& getWorldOpcodeModel();
 
-	MathLib::Vector3 m_minVert;
+	std::shared_ptr<const CMeshAsset> m_asset;
+
+	MathLib::Matrix4d m_transMat;  // accumulated transformation from model space to world space
+	bool m_hasTransform;
+
+	std::vector<MathLib::Vector3> m_worldVertices;
+	bool m_worldVertsValid;
+
+	MathLib::Vector3 m_minVert;  // world space
 	MathLib::Vector3 m_maxVert;
 
-	//
-	Opcode::Model *m_OpcodeModel;
-	Opcode::MeshInterface *m_meshIterface;
-	unsigned int *m_opFaces;
-};
\ No newline at end of file
+	// world to model space for collision queries
+	MathLib::Matrix4d m_invTransMat;
+	double m_transScale;     // uniform scale of a similarity transform
+	bool m_isInvertibleTrans;
+	bool m_isSimilarTrans;
+	bool m_isMirrorTrans;    // negative determinant, front faces in world space are back faces in model space
+
+	COpcodeTree m_worldOpcodeTree;  // only built for non-similarity transforms
+	bool m_opcodeValid;
+
+	// support face trees in world space, rebuilt when upright or angle changes
+	CMeshBVH m_suppFaceBVH[2];
+	MathLib::Vector3 m_suppBVHUpright;
+	double m_suppBVHAngle;
+	bool m_suppBVHValid;
+};
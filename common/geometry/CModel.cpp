@@ -7,9 +7,15 @@
 #include "qgl.h"
 #include <QFile>
 
-CModel::CModel(std::map<QString, CMesh> &meshDB)
+CModel::CModel(MeshDatabase *meshDB)
 	:m_meshDatabase(meshDB)
 {
+	if (m_meshDatabase == NULL)
+	{
+		m_ownMeshDatabase.reset(new MeshDatabase());
+		m_meshDatabase = m_ownMeshDatabase.get();
+	}
+
 	m_catName = QString("unknown");
 	m_mesh = NULL;
 
@@ -34,6 +40,8 @@ CModel::CModel(std::map<QString, CMesh> &meshDB)
 	m_hasSuppPlane = false;
 	m_showDiffColor = true;
 	m_showFaceClusters = false;
+	m_displayListID = 0;
+	m_displayListValid = false;
 
 	m_readyForInterTest = false;
 
@@ -131,70 +139,68 @@ bool CModel::loadModel(QString filename, double metric, int metaDataOnly, int ob
 
 		if (flag == -1)
 		{
-			std::cout << "\t OBB does not exist, please compute OBB first\n";
+			ThreadLog() << "\t OBB does not exist, please compute OBB first\n";
 			return false;
 		}
 	}
 	else
 	{
-		// load or copy mesh data first
-		if (!m_meshDatabase.empty() && m_meshDatabase.count(m_nameStr))
-		{
-			m_mesh = new CMesh(m_meshDatabase[m_nameStr]);  // make a copy of mesh data in meshDB
+		// load mesh data or share the mesh asset in meshDB
+		bool isLoadedHere = false;
+		// keyed by file, models of different folders may have the same name string
+		QString assetName = QString("%1|%2").arg(filename).arg(metric);
+		std::shared_ptr<const CMeshAsset> asset = m_meshDatabase->getOrLoadAsset(assetName, [&]() {
+			isLoadedHere = true;
 
-			std::cout << "\t \t mesh data copied from meshDB: " << m_nameStr.toStdString() << "\n";
-		}
-		else
-		{
 			bool isLoaded = loadMeshData(filename, metric);
-			std::cout << "\t \t loading mesh for " << m_nameStr.toStdString() << "\n";
+			ThreadLog() << "\t \t loading mesh for " << m_nameStr.toStdString() << "\n";
 
-			m_meshDatabase[m_nameStr] = CMesh(*m_mesh);  // save copy of mesh data to meshDB
+			return isLoaded ? m_mesh->getAsset() : std::shared_ptr<const CMeshAsset>();
+		});
 
-			if (!isLoaded)
-			{
-				std::cout << "\t \t mesh not loaded: " << m_nameStr.toStdString() << "\n";
-				return false;
-			}
+		if (asset == nullptr)
+		{
+			ThreadLog() << "\t \t mesh not loaded: " << m_nameStr.toStdString() << "\n";
+			return false;
+		}
+
+		if (!isLoadedHere)
+		{
+			m_mesh->setAsset(asset);
+
+			ThreadLog() << "\t \t mesh data shared from meshDB: " << m_nameStr.toStdString() << "\n";
 		}
 
 		computeAABB();
 		m_initAABB = m_AABB;
 
+		// scenes sharing the model build its per-model files once, the others read the written files
 		if (!loadBBTopPlane())
 		{
-			builBBTopPlane();
-		}
+			QString bbTopFileName = m_filePath + "/" + m_nameStr + ".bbtop";
 
-		buildDisplayList(1, 0);
-
-		if (reComputeOBB)  // load both obb and mesh, if obb not exist, compute obb
-		{
-			if (m_sceneUpVec == MathLib::Vector3(0, 0, 1))
-			{
-				computeOBB(2); // fix Z
-			}
-			else if (m_sceneUpVec == MathLib::Vector3(0, 1, 0))
+			if (!m_meshDatabase->writeFileOnce(bbTopFileName, [this]() { builBBTopPlane(); }) && !loadBBTopPlane())
 			{
-				computeOBB(1); // fix Y
+				computeBBTopPlane();
 			}
-
-			saveOBB();
 		}
-		else
+
+		// display list is built on first draw, so scenes can be loaded without a GL context
+		invalidateDisplayList(1, 0);
+
+		// load both obb and mesh, if obb not exist, compute obb
+		if (reComputeOBB || loadOBB() == -1)
 		{
-			if (loadOBB() == -1)
-			{
-				if (m_sceneUpVec == MathLib::Vector3(0, 0, 1))
-				{
-					computeOBB(2); // fix Z
-				}
-				else if (m_sceneUpVec == MathLib::Vector3(0, 1, 0))
-				{
-					computeOBB(1); // fix Y
-				}
+			QString obbFileName = m_filePath + "/" + m_fileName + ".obb";
 
+			bool isComputedHere = m_meshDatabase->writeFileOnce(obbFileName, [this]() {
+				computeOBBForSceneUp();
 				saveOBB();
+			});
+
+			if (!isComputedHere && loadOBB() == -1)
+			{
+				computeOBBForSceneUp();
 			}
 		}
 	}
@@ -209,11 +215,26 @@ void CModel::saveModel(QString filename)
 
 bool CModel::loadMeshData(QString filename, double metric /*= 1.0*/)
 {
-	bool isLoaded;
+	bool isLoaded = false;
 
 	if (m_modelFormat == "obj")
 	{
-		isLoaded = m_mesh->readObjFile(qPrintable(filename), metric);
+		// use binary mesh cache if it is up to date, otherwise parse obj and write the cache
+		QString binFileName = CMesh::getBinaryMeshFileName(filename);
+
+		if (CMesh::isBinaryMeshFileUpToDate(filename) && m_mesh->readBinaryMeshFile(binFileName.toStdString(), metric))
+		{
+			isLoaded = true;
+		}
+		else
+		{
+			isLoaded = m_mesh->readObjFile(qPrintable(filename), metric);
+
+			if (isLoaded)
+			{
+				m_mesh->saveBinaryMeshFile(binFileName.toStdString(), metric);
+			}
+		}
 	}
 	else if (m_modelFormat == "3ds")
 	{
@@ -291,7 +312,19 @@ void CModel::draw(bool showModel, bool showOBB, bool showSuppPlane, bool showFro
 
 	if (showModel)
 	{
-		glCallList(m_displayListID);
+		if (isDrawnByInstance())
+		{
+			m_mesh->draw(getMeshColor());
+		}
+		else
+		{
+			if (!m_displayListValid)
+			{
+				buildDisplayList(m_showDiffColor, m_showFaceClusters);
+			}
+
+			glCallList(m_displayListID);
+		}
 	}
 
 	if (showSuppPlane && m_hasSuppPlane)
@@ -302,63 +335,101 @@ void CModel::draw(bool showModel, bool showOBB, bool showSuppPlane, bool showFro
 	//m_AABB.DrawBox(0, 1, 0, 0, 0);
 }
 
+void CModel::invalidateDisplayList(int showDiffColor /*= 1*/, int showFaceCluster /*= 0*/)
+{
+	m_showDiffColor = showDiffColor;
+	m_showFaceClusters = showFaceCluster;
+	m_displayListValid = false;
+}
+
+// the plain color view draws the shared mesh buffers directly, only the face cluster view is compiled to a display list
 void CModel::buildDisplayList(int showDiffColor /*= 1*/, int showFaceCluster /*= 0*/)
 {
 	if (glIsList(m_displayListID))
 	{
 		glDeleteLists(m_displayListID, 1);
+		m_displayListID = 0;
 	}
 
 	m_showDiffColor = showDiffColor;
 	m_showFaceClusters = showFaceCluster;
+	m_displayListValid = true;
+
+	if (isDrawnByInstance())
+	{
+		return;
+	}
 
 	m_displayListID = glGenLists(1);
 
+	glNewList(m_displayListID, GL_COMPILE);
+	m_mesh->draw(m_faceIndicators);
+	glEndList();
+}
+
+bool CModel::isDrawnByInstance()
+{
+	return !(m_showFaceClusters && !m_faceIndicators.empty());
+}
+
+QColor CModel::getMeshColor()
+{
 	QColor c;
 
 	// draw model with same color
-	if (showFaceCluster && !m_faceIndicators.empty())
+	if (!m_showDiffColor)
 	{
-		glNewList(m_displayListID, GL_COMPILE);
-		m_mesh->draw(m_faceIndicators);
-		glEndList();
+		//if (m_status == 1)
+		//{
+		//	c = GetColorFromSet(1);
+		//}
+		//else if (m_status == 2)  // re-arranged
+		//{
+		//	c = GetColorFromSet(3);
+		//}
+		//else if (m_status == 3) // inserted
+		//{
+		//	c = GetColorFromSet(5);
+		//}
+		//else
+		//{
+		//	c = QColor(180, 180, 180, 255);
+		//}
+
+		c = QColor(150, 150, 150, 255);
 	}
 	else
-	{
-		if (!showDiffColor)
-		{
-			//if (m_status == 1)
-			//{
-			//	c = GetColorFromSet(1);
-			//}
-			//else if (m_status == 2)  // re-arranged
-			//{
-			//	c = GetColorFromSet(3);
-			//}
-			//else if (m_status == 3) // inserted
-			//{
-			//	c = GetColorFromSet(5);
-			//}
-			//else
-			//{
-			//	c = QColor(180, 180, 180, 255);
-			//}
-
-			c = QColor(150, 150, 150, 255);
-		}
-		else
-			c = GetColorFromSet(m_id);
+		c = GetColorFromSet(m_id);
 
-		glNewList(m_displayListID, GL_COMPILE);
-		m_mesh->draw(c);
-		glEndList();
-	}
+	return c;
 }
 
 void CModel::transformModel(const MathLib::Matrix4d &transMat, bool reOrientOBB)
 {
 	m_mesh->transformMesh(transMat);
 
+	transformModelData(transMat, reOrientOBB);
+}
+
+void CModel::transformModels(const std::vector<CModel*> &models, const std::vector<MathLib::Matrix4d> &transMats, const std::vector<bool> &reOrientOBBs)
+{
+	std::vector<CMesh*> meshes(models.size());
+	for (int i = 0; i < models.size(); i++)
+	{
+		meshes[i] = models[i]->m_mesh;
+	}
+
+	CMesh::transformMeshes(meshes, transMats);
+
+	for (int i = 0; i < models.size(); i++)
+	{
+		bool reOrientOBB = !reOrientOBBs.empty() && reOrientOBBs[i];
+		models[i]->transformModelData(transMats[i], reOrientOBB);
+	}
+}
+
+void CModel::transformModelData(const MathLib::Matrix4d &transMat, bool reOrientOBB)
+{
 	computeAABB(); // update
 	
 	if (m_suppPlaneManager != NULL && m_suppPlaneManager->hasSuppPlane())
@@ -418,7 +489,7 @@ void CModel::transformModel(const MathLib::Matrix4d &transMat, bool reOrientOBB)
 	m_currFrontDir.normalize();
 	m_currFrontDir = m_currFrontDir / m_sceneMetric;
 
-	buildDisplayList();
+	invalidateDisplayList();
 
 	if (m_readyForInterTest)
 	{
@@ -492,7 +563,7 @@ void CModel::prepareForIntersect()
 
 void CModel::buildSuppPlane()
 {
-	std::cout << "SuppPlaneManager: start computing support plane ...\n";
+	ThreadLog() << "SuppPlaneManager: start computing support plane ...\n";
 	m_faceIndicators = m_suppPlaneManager->clusteringMeshFacesSuppPlane();
 		//m_suppPlaneManager->pruneSuppPlanes();  // DEBUG: just keep the largest supplane
 
@@ -507,6 +578,12 @@ void CModel::buildSuppPlane()
 }
 
 void CModel::builBBTopPlane()
+{
+	computeBBTopPlane();
+	saveBBTopPlane();
+}
+
+void CModel::computeBBTopPlane()
 {
 	// support plane should have consistent vertex order, w.r.t to the model front
 	std::vector<MathLib::Vector3> corners(4); // need to delete after use to release memory
@@ -523,7 +600,7 @@ void CModel::builBBTopPlane()
 	//}
 	//else
 	{
-		std::cout << "SuppPlaneManager: start extracting support plane from AABB top for "<< m_nameStr.toStdString() <<"\n";
+		ThreadLog() << "SuppPlaneManager: start extracting support plane from AABB top for "<< m_nameStr.toStdString() <<"\n";
 
 		corners[0] = m_AABB.vp[0];
 		corners[1] = m_AABB.vp[4];
@@ -581,22 +658,49 @@ void CModel::builBBTopPlane()
 	p->setSuppPlaneID(0);
 
 	m_bbTopPlane = p;
+}
+
+bool CModel::saveBBTopPlane()
+{
+	if (m_bbTopPlane == NULL)
+	{
+		return false;
+	}
 
+	// write to a temp file first, scenes loaded on other threads may read the file meanwhile
 	QString suppPlaneFilename = m_filePath + "/" + m_nameStr + ".bbtop";
-	QFile suppFile(suppPlaneFilename);
+	QString tempFileName = suppPlaneFilename + ".tmp";
+	QFile suppFile(tempFileName);
 
 	QTextStream ofs(&suppFile);
-	if (suppFile.open(QIODevice::ReadWrite | QIODevice::Text | QIODevice::Truncate))
+	if (!suppFile.open(QIODevice::WriteOnly | QIODevice::Text | QIODevice::Truncate))
 	{
-		std::vector<MathLib::Vector3> corners = m_bbTopPlane->GetCorners();
-		for (int c = 0; c < 4; c++)
-		{
-			ofs << corners[c][0] << " " << corners[c][1] << " " << corners[c][2] << "\n";
-		}
-		suppFile.close();
-		std::cout << "\t bb top plane saved to " << suppPlaneFilename.toStdString() << "\n";
-		suppFile.close();
+		return false;
+	}
+
+	std::vector<MathLib::Vector3> corners = m_bbTopPlane->GetCorners();
+	for (int c = 0; c < 4; c++)
+	{
+		ofs << corners[c][0] << " " << corners[c][1] << " " << corners[c][2] << "\n";
 	}
+
+	ofs.flush();
+	suppFile.close();
+
+	if (suppFile.error() != QFileDevice::NoError)
+	{
+		QFile::remove(tempFileName);
+		return false;
+	}
+
+	QFile::remove(suppPlaneFilename);
+	if (!QFile::rename(tempFileName, suppPlaneFilename))
+	{
+		return false;
+	}
+
+	ThreadLog() << "\t bb top plane saved to " << suppPlaneFilename.toStdString() << "\n";
+	return true;
 }
 
 //
@@ -642,7 +746,7 @@ void CModel::computeOBB(int fixAxis /*= -1*/)
 	OBBE.ComputeOBB_Min(fixAxis);
 
 	m_hasOBB = true;
-	std::cout << "\t\tModel " << m_nameStr.toStdString() << " OBB computed\n";
+	ThreadLog() << "\t\tModel " << m_nameStr.toStdString() << " OBB computed\n";
 
 	m_initOBBDiagLen = m_OBB.GetDiagLength();
 	m_initOBBPos = getModelPosOBB();
@@ -670,7 +774,7 @@ int CModel::loadOBB(const QString &sPathName /*= QString()*/)
 
 	m_hasOBB = true;
 
-	std::cout << "\t\tModel " << m_nameStr.toStdString() << " OBB loaded\n";
+	ThreadLog() << "\t\tModel " << m_nameStr.toStdString() << " OBB loaded\n";
 
 	// save the init info from file
 	m_initOBBDiagLen = m_OBB.GetDiagLength();
@@ -689,16 +793,44 @@ int CModel::saveOBB(const QString &sPathName /*= QString()*/)
 		sFilename = sPathName;
 	}
 
-	std::ofstream ofs(sFilename.toStdString());
-	if (!ofs.is_open()) {
-		return -1;
+	// write to a temp file first, scenes loaded on other threads may read the file meanwhile
+	QString tempFileName = sFilename + ".tmp";
+
+	{
+		std::ofstream ofs(tempFileName.toStdString());
+		if (!ofs.is_open()) {
+			return -1;
+		}
+
+		m_OBB.WriteData(ofs);
+
+		if (!ofs.good()) {
+			ofs.close();
+			QFile::remove(tempFileName);
+			return -1;
+		}
 	}
 
-	m_OBB.WriteData(ofs);
+	QFile::remove(sFilename);
+	if (!QFile::rename(tempFileName, sFilename)) {
+		return -1;
+	}
 
 	return 0;
 }
 
+void CModel::computeOBBForSceneUp()
+{
+	if (m_sceneUpVec == MathLib::Vector3(0, 0, 1))
+	{
+		computeOBB(2); // fix Z
+	}
+	else if (m_sceneUpVec == MathLib::Vector3(0, 1, 0))
+	{
+		computeOBB(1); // fix Y
+	}
+}
+
 bool CModel::IsSupport(CModel *pOther, bool roughOBB, double dDistT, const MathLib::Vector3 &Upright)
 {
 	if (pOther == NULL) {
@@ -723,18 +855,44 @@ bool CModel::IsSupport(CModel *pOther, bool roughOBB, double dDistT, const MathL
 		return true;
 	}
 
-	std::vector<MathLib::Vector3>& verts = m_mesh->getVertices();
-	std::vector<std::vector<int>>& faces = m_mesh->getFaces();
-	std::vector<MathLib::Vector3>& faceNormals = m_mesh->getfaceNormals();
+	return IsMeshSupport(pOther, dAngleT, dDistT, Upright, true);
+}
+
+bool CModel::IsMeshSupport(CModel *pOther, double dAngleT, double dDistT, const MathLib::Vector3 &Upright, bool useBVH)
+{
+	const std::vector<MathLib::Vector3>& verts = m_mesh->getVertices();
+	const std::vector<std::vector<int>>& faces = m_mesh->getFaces();
+	const std::vector<MathLib::Vector3>& faceNormals = m_mesh->getfaceNormals();
 
 	CMesh *pMeshOther = pOther->getMesh();
-	std::vector<MathLib::Vector3>& vertsOther = pMeshOther->getVertices();
-	std::vector<std::vector<int>>& facesOther = pMeshOther->getFaces();
-	std::vector<MathLib::Vector3>& faceNormalsOther = pMeshOther->getfaceNormals();
+	const std::vector<MathLib::Vector3>& vertsOther = pMeshOther->getVertices();
+	const std::vector<std::vector<int>>& facesOther = pMeshOther->getFaces();
+	const std::vector<MathLib::Vector3>& faceNormalsOther = pMeshOther->getfaceNormals();
+
+	if (useBVH)
+	{
+		// contact needs opposite facing normals and all verts of the other face near the face plane,
+		// so only upward faces against downward faces are traversed and far plane-box pairs are culled
+		auto contactTest = [&](int fi, int fj) {
+			const std::vector<int> &FI = faces[fi];
+			const std::vector<int> &FJ = facesOther[fj];
+			return ContactTriTri(verts[FI[0]], verts[FI[1]], verts[FI[2]], faceNormals[fi],
+				vertsOther[FJ[0]], vertsOther[FJ[1]], vertsOther[FJ[2]], faceNormalsOther[fj],
+				dAngleT, dDistT, true);
+		};
+
+		const CMeshBVH &upTree = m_mesh->getSupportFaceBVH(Upright, dAngleT, true);
+		const CMeshBVH &downTree = m_mesh->getSupportFaceBVH(Upright, dAngleT, false);
+		const CMeshBVH &upTreeOther = pMeshOther->getSupportFaceBVH(Upright, dAngleT, true);
+		const CMeshBVH &downTreeOther = pMeshOther->getSupportFaceBVH(Upright, dAngleT, false);
+
+		return upTree.findFacePair(downTreeOther, dDistT, contactTest)
+			|| downTree.findFacePair(upTreeOther, dDistT, contactTest);
+	}
 
 	for (unsigned int fi = 0; fi < faces.size(); fi++)
 	{
-		std::vector<int> &FI = faces[fi];
+		const std::vector<int> &FI = faces[fi];
 		const MathLib::Vector3 &FNI = faceNormals[fi];
 		if (MathLib::Acos(MathLib::Abs(FNI.dot(Upright))) > dAngleT) {
 			continue;
@@ -742,7 +900,7 @@ bool CModel::IsSupport(CModel *pOther, bool roughOBB, double dDistT, const MathL
 
 		for (unsigned int fj = 0; fj < facesOther.size(); fj++)
 		{
-			std::vector<int> &FJ = facesOther[fj];
+			const std::vector<int> &FJ = facesOther[fj];
 			const MathLib::Vector3 &FNJ = faceNormalsOther[fj];
 
 			if (MathLib::Acos(MathLib::Abs(FNJ.dot(Upright))) > dAngleT) {
@@ -1316,7 +1474,7 @@ void CModel::computeBBAlignMat()
 	{
 		if (!m_hasOBB)
 		{
-			std::cout << "For 3ds models, please compute OBB first before computing the model alignment matrix";
+			ThreadLog() << "For 3ds models, please compute OBB first before computing the model alignment matrix";
 			return;
 		}
 
@@ -15,7 +15,7 @@ class SuppPlane;
 class CModel
 {
 public:
-	CModel(std::map<QString, CMesh> &meshDB = std::map<QString, CMesh>());
+	CModel(MeshDatabase *meshDB = NULL);  // NULL for a model keeping its mesh in its own database, e.g. outside of a scene
 	~CModel();
 
 	bool loadModel(QString filename, double metric = 1.0, int metaDataOnly = 0, int obbOnly = 0, int reComputeOBB = 0);
@@ -70,6 +70,7 @@ public:
 	int loadOBB(const QString &sPathName = QString());
 	int saveOBB(const QString &sPathName = QString());
 	bool IsSupport(CModel *pOther, bool roughOBB, double dDistT, const MathLib::Vector3 &Upright);
+	bool IsMeshSupport(CModel *pOther, double dAngleT, double dDistT, const MathLib::Vector3 &Upright, bool useBVH = true);  // face contact test, all pairs when useBVH is false
 	double getOBBBottomHeight();
 	double getOBBHeight();
 	double getHorizonShortRange();
@@ -119,7 +120,9 @@ public:
 
 	//// support plane
 	void buildSuppPlane();
-	void builBBTopPlane();
+	void builBBTopPlane();  // compute and save
+	void computeBBTopPlane();
+	bool saveBBTopPlane();
 	bool hasSuppPlane() { return m_hasSuppPlane; };
 	//SuppPlane* getLargestSuppPlane();
 	//double getLargestSuppPlaneHeight();
@@ -129,6 +132,8 @@ public:
 
 	// transformation
 	void transformModel(const MathLib::Matrix4d &transMat, bool reOrientOBB = false);
+	static void transformModels(const std::vector<CModel*> &models, const std::vector<MathLib::Matrix4d> &transMats,
+		const std::vector<bool> &reOrientOBBs = std::vector<bool>());  // mesh bounds updated in one batch
 	void transformModel(double tarOBBDiagLen, const MathLib::Vector3 &tarOBBPos, const MathLib::Vector3 &tarFrontDir);
 	void computeTransMat(double tarOBBDiagLen, const MathLib::Vector3 &tarOBBPos, const MathLib::Vector3 &tarFrontDir);
 	MathLib::Matrix4d& getLastTransMat() { return m_lastTransMat; };
@@ -140,6 +145,9 @@ public:
 
 	// rendering options
 	void buildDisplayList(int showDiffColor = 1, int showFaceCluster = 0);
+	void invalidateDisplayList(int showDiffColor = 1, int showFaceCluster = 0);  // rebuild on next draw
+	bool isDrawnByInstance();  // plain color mesh, drawn from the shared buffers of its asset
+	QColor getMeshColor();
 	void draw(bool showModel = true, bool showOBB = false, bool showSuppPlane = false, bool showFrontDir =false, bool showSuppChildOnly=false);
 	void drawFrontDir();
 
@@ -173,6 +181,9 @@ public:
 	MathLib::Vector3 m_currOBBPos;  // OBB position in current scene
 
 private:
+	void transformModelData(const MathLib::Matrix4d &transMat, bool reOrientOBB);  // everything but the mesh
+	void computeOBBForSceneUp();
+
 	QString m_fileName;
 	QString m_filePath;
 	QString m_nameStr;   // name string with out the cat at head
@@ -208,6 +219,7 @@ private:
 	bool m_hasOBB;
 
 	GLuint m_displayListID;
+	bool m_displayListValid;
 	int m_status;  // whether model is fixed or movable
 
 	SuppPlaneManager *m_suppPlaneManager;
@@ -227,5 +239,6 @@ private:
 
 	bool m_isBusy;
 
-	std::map<QString, CMesh> &m_meshDatabase;
+	MeshDatabase *m_meshDatabase;
+	std::unique_ptr<MeshDatabase> m_ownMeshDatabase;
 };
\ No newline at end of file
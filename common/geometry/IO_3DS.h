@@ -7,7 +7,7 @@
 class CIO_3DS
 {
 public:
-	CIO_3DS(CMesh *mesh) :m_mesh(mesh) {};
+	CIO_3DS(CMeshAsset *mesh) :m_mesh(mesh) {};
 	~CIO_3DS();
 
 	void read3DS(const QString &filename);
@@ -17,7 +17,7 @@ private:
 	void buildMeshModelFrom3DSNodes(Lib3dsNode *pNode);
 	int extractMeshFrom3DSNode(Lib3dsMeshInstanceNode *pNode);
 
-	CMesh *m_mesh;
+	CMeshAsset *m_mesh;
 	Lib3dsFile *m_pFile;
 };
 
@@ -0,0 +1,299 @@
+#include "MeshBVH.h"
+#include "../utilities/utility.h"
+#include <algorithm>
+
+const int BVHLeafSize = 4;
+
+// relative and absolute slack on distance tests, keeps culling conservative under rounding
+const double BVHRelSlack = 1e-6;
+const double BVHAbsSlack = 1e-9;
+
+// range of the product of two intervals
+static void MulInterval(double a0, double a1, double b0, double b1, double &lo, double &hi)
+{
+	double p[4] = { a0*b0, a0*b1, a1*b0, a1*b1 };
+	lo = *std::min_element(p, p + 4);
+	hi = *std::max_element(p, p + 4);
+}
+
+CMeshBVH::CMeshBVH()
+{
+}
+
+CMeshBVH::~CMeshBVH()
+{
+	clear();
+}
+
+void CMeshBVH::clear()
+{
+	m_nodes.clear();
+	m_faceIds.clear();
+	m_faceBoxes.clear();
+	m_facePlanes.clear();
+	m_faceAnchors.clear();
+}
+
+void CMeshBVH::build(const std::vector<MathLib::Vector3> &verts, const std::vector<std::vector<int>> &faces,
+	const std::vector<MathLib::Vector3> &faceNormals, const std::vector<int> &faceIds)
+{
+	clear();
+
+	int faceNum = faceIds.size();
+	if (faceNum == 0)
+	{
+		return;
+	}
+
+	// face data by input position; box centers are used for splitting
+	m_faceBoxes.resize(6 * faceNum);
+	m_facePlanes.resize(4 * faceNum);
+	m_faceAnchors.resize(3 * faceNum);
+
+	for (int i = 0; i < faceNum; i++)
+	{
+		const std::vector<int> &f = faces[faceIds[i]];
+		const MathLib::Vector3 &n = faceNormals[faceIds[i]];
+
+		for (int d = 0; d < 3; d++)
+		{
+			m_faceBoxes[6 * i + d] = std::min(verts[f[0]][d], std::min(verts[f[1]][d], verts[f[2]][d]));
+			m_faceBoxes[6 * i + 3 + d] = std::max(verts[f[0]][d], std::max(verts[f[1]][d], verts[f[2]][d]));
+			m_facePlanes[4 * i + d] = n[d];
+			m_faceAnchors[3 * i + d] = verts[f[0]][d];
+		}
+
+		m_facePlanes[4 * i + 3] = n.dot(verts[f[0]]);
+	}
+
+	m_faceIds.resize(faceNum);
+	for (int i = 0; i < faceNum; i++)
+	{
+		m_faceIds[i] = i;
+	}
+
+	m_nodes.reserve(2 * faceNum / BVHLeafSize + 1);
+	buildNode(0, faceNum);
+
+	// reorder face data to tree order
+	std::vector<int> order = m_faceIds;
+	std::vector<double> boxes(6 * faceNum), planes(4 * faceNum), anchors(3 * faceNum);
+
+	for (int i = 0; i < faceNum; i++)
+	{
+		int k = order[i];
+		m_faceIds[i] = faceIds[k];
+		std::copy(m_faceBoxes.begin() + 6 * k, m_faceBoxes.begin() + 6 * k + 6, boxes.begin() + 6 * i);
+		std::copy(m_facePlanes.begin() + 4 * k, m_facePlanes.begin() + 4 * k + 4, planes.begin() + 4 * i);
+		std::copy(m_faceAnchors.begin() + 3 * k, m_faceAnchors.begin() + 3 * k + 3, anchors.begin() + 3 * i);
+	}
+
+	m_faceBoxes.swap(boxes);
+	m_facePlanes.swap(planes);
+	m_faceAnchors.swap(anchors);
+
+	for (int n = 0; n < m_nodes.size(); n++)
+	{
+		computeNodeBounds(m_nodes[n]);
+	}
+}
+
+int CMeshBVH::buildNode(int start, int count)
+{
+	int nodeId = m_nodes.size();
+
+	Node node;
+	node.left = -1;
+	node.right = -1;
+	node.start = start;
+	node.count = count;
+	m_nodes.push_back(node);
+
+	if (count <= BVHLeafSize)
+	{
+		return nodeId;
+	}
+
+	// split at the median of face box centers along the longest axis
+	double minC[3] = { MAX_VALUE, MAX_VALUE, MAX_VALUE };
+	double maxC[3] = { -MAX_VALUE, -MAX_VALUE, -MAX_VALUE };
+
+	for (int i = start; i < start + count; i++)
+	{
+		const double *box = &m_faceBoxes[6 * m_faceIds[i]];
+		for (int d = 0; d < 3; d++)
+		{
+			double c = box[d] + box[3 + d];
+			minC[d] = std::min(minC[d], c);
+			maxC[d] = std::max(maxC[d], c);
+		}
+	}
+
+	int axis = 0;
+	for (int d = 1; d < 3; d++)
+	{
+		if (maxC[d] - minC[d] > maxC[axis] - minC[axis])
+		{
+			axis = d;
+		}
+	}
+
+	int mid = start + count / 2;
+	const std::vector<double> &boxes = m_faceBoxes;
+	std::nth_element(m_faceIds.begin() + start, m_faceIds.begin() + mid, m_faceIds.begin() + start + count,
+		[&boxes, axis](int a, int b) { return boxes[6 * a + axis] + boxes[6 * a + 3 + axis] < boxes[6 * b + axis] + boxes[6 * b + 3 + axis]; });
+
+	int leftId = buildNode(start, mid - start);
+	int rightId = buildNode(mid, start + count - mid);
+
+	m_nodes[nodeId].left = leftId;
+	m_nodes[nodeId].right = rightId;
+
+	return nodeId;
+}
+
+void CMeshBVH::computeNodeBounds(Node &node)
+{
+	for (int d = 0; d < 3; d++)
+	{
+		node.minV[d] = node.minN[d] = MAX_VALUE;
+		node.maxV[d] = node.maxN[d] = -MAX_VALUE;
+	}
+
+	for (int i = node.start; i < node.start + node.count; i++)
+	{
+		for (int d = 0; d < 3; d++)
+		{
+			node.minV[d] = std::min(node.minV[d], m_faceBoxes[6 * i + d]);
+			node.maxV[d] = std::max(node.maxV[d], m_faceBoxes[6 * i + 3 + d]);
+			node.minN[d] = std::min(node.minN[d], m_facePlanes[4 * i + d]);
+			node.maxN[d] = std::max(node.maxN[d], m_facePlanes[4 * i + d]);
+		}
+	}
+
+	for (int d = 0; d < 3; d++)
+	{
+		node.center[d] = 0.5*(node.minV[d] + node.maxV[d]);
+	}
+
+	// plane offsets relative to node center keep the interval test tight for nearby boxes
+	node.minOff = MAX_VALUE;
+	node.maxOff = -MAX_VALUE;
+
+	for (int i = node.start; i < node.start + node.count; i++)
+	{
+		double off = 0;
+		for (int d = 0; d < 3; d++)
+		{
+			off += m_facePlanes[4 * i + d] * (m_faceAnchors[3 * i + d] - node.center[d]);
+		}
+
+		node.minOff = std::min(node.minOff, off);
+		node.maxOff = std::max(node.maxOff, off);
+	}
+}
+
+bool CMeshBVH::isNodeNearPlanes(const Node &planeNode, const Node &boxNode, double planeDist) const
+{
+	// range of n.dot(x - v0) for any face plane in planeNode and any point x in the box of boxNode
+	double lo = -planeNode.maxOff;
+	double hi = -planeNode.minOff;
+
+	for (int d = 0; d < 3; d++)
+	{
+		double pLo, pHi;
+		MulInterval(planeNode.minN[d], planeNode.maxN[d],
+			boxNode.minV[d] - planeNode.center[d], boxNode.maxV[d] - planeNode.center[d], pLo, pHi);
+
+		lo += pLo;
+		hi += pHi;
+	}
+
+	double slack = BVHRelSlack*(fabs(lo) + fabs(hi) + planeDist) + BVHAbsSlack;
+
+	return lo <= planeDist + slack && hi >= -planeDist - slack;
+}
+
+bool CMeshBVH::isBoxNearPlane(int planeFace, const double *box, double planeDist) const
+{
+	const double *plane = &m_facePlanes[4 * planeFace];
+
+	double centDist = -plane[3];
+	double radius = 0;
+
+	for (int d = 0; d < 3; d++)
+	{
+		centDist += plane[d] * 0.5*(box[d] + box[3 + d]);
+		radius += fabs(plane[d]) * 0.5*(box[3 + d] - box[d]);
+	}
+
+	double slack = BVHRelSlack*(fabs(centDist) + radius + planeDist + fabs(plane[3])) + BVHAbsSlack;
+
+	return centDist - radius <= planeDist + slack && centDist + radius >= -planeDist - slack;
+}
+
+bool CMeshBVH::findFacePair(const CMeshBVH &other, double planeDist, const std::function<bool(int, int)> &pairTest) const
+{
+	if (isEmpty() || other.isEmpty())
+	{
+		return false;
+	}
+
+	std::vector<std::pair<int, int>> nodePairs;
+	nodePairs.push_back(std::make_pair(0, 0));
+
+	while (!nodePairs.empty())
+	{
+		std::pair<int, int> currPair = nodePairs.back();
+		nodePairs.pop_back();
+
+		const Node &nodeA = m_nodes[currPair.first];
+		const Node &nodeB = other.m_nodes[currPair.second];
+
+		if (!isNodeNearPlanes(nodeA, nodeB, planeDist))
+		{
+			continue;
+		}
+
+		bool isLeafA = (nodeA.left == -1);
+		bool isLeafB = (nodeB.left == -1);
+
+		if (isLeafA && isLeafB)
+		{
+			for (int i = nodeA.start; i < nodeA.start + nodeA.count; i++)
+			{
+				for (int j = nodeB.start; j < nodeB.start + nodeB.count; j++)
+				{
+					if (isBoxNearPlane(i, &other.m_faceBoxes[6 * j], planeDist)
+						&& pairTest(m_faceIds[i], other.m_faceIds[j]))
+					{
+						return true;
+					}
+				}
+			}
+
+			continue;
+		}
+
+		// descend into the larger node
+		double sizeA = 0, sizeB = 0;
+		for (int d = 0; d < 3; d++)
+		{
+			sizeA = std::max(sizeA, nodeA.maxV[d] - nodeA.minV[d]);
+			sizeB = std::max(sizeB, nodeB.maxV[d] - nodeB.minV[d]);
+		}
+
+		if (isLeafB || (!isLeafA && sizeA >= sizeB))
+		{
+			nodePairs.push_back(std::make_pair(nodeA.left, currPair.second));
+			nodePairs.push_back(std::make_pair(nodeA.right, currPair.second));
+		}
+		else
+		{
+			nodePairs.push_back(std::make_pair(currPair.first, nodeB.left));
+			nodePairs.push_back(std::make_pair(currPair.first, nodeB.right));
+		}
+	}
+
+	return false;
+}
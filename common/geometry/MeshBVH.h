@@ -0,0 +1,56 @@
+#pragma once
+
+#include "../utilities/mathlib.h"
+#include <vector>
+#include <functional>
+
+// bounding volume hierarchy over a subset of mesh faces
+// besides the face boxes, each node bounds the face normals and plane offsets of its faces,
+// so a node of one tree can be rejected when no face box of the other tree's node gets close to any of its face planes
+
+class CMeshBVH
+{
+public:
+	struct Node
+	{
+		double minV[3];  // box of faces in subtree
+		double maxV[3];
+		double center[3];
+		double minN[3];  // range of face normals
+		double maxN[3];
+		double minOff;   // range of n.dot(v0 - center) over faces
+		double maxOff;
+		int left;        // child node ids, -1 for leaf
+		int right;
+		int start;       // face range in m_faceIds
+		int count;
+	};
+
+	CMeshBVH();
+	~CMeshBVH();
+
+	void build(const std::vector<MathLib::Vector3> &verts, const std::vector<std::vector<int>> &faces,
+		const std::vector<MathLib::Vector3> &faceNormals, const std::vector<int> &faceIds);
+	void clear();
+
+	bool isEmpty() const { return m_nodes.empty(); };
+	int getFaceNum() const { return m_faceIds.size(); };
+
+	// dual-tree traversal: call pairTest(faceId, otherFaceId) for face pairs where the box of the other face
+	// is within planeDist of the plane of this face; stops and returns true once pairTest returns true
+	bool findFacePair(const CMeshBVH &other, double planeDist, const std::function<bool(int, int)> &pairTest) const;
+
+private:
+	int buildNode(int start, int count);
+	void computeNodeBounds(Node &node);
+	bool isNodeNearPlanes(const Node &planeNode, const Node &boxNode, double planeDist) const;
+	bool isBoxNearPlane(int planeFace, const double *box, double planeDist) const;
+
+	std::vector<Node> m_nodes;
+
+	// per face data in tree order
+	std::vector<int> m_faceIds;
+	std::vector<double> m_faceBoxes;    // 6 doubles per face: min, max
+	std::vector<double> m_facePlanes;   // 4 doubles per face: normal, offset n.dot(v0)
+	std::vector<double> m_faceAnchors;  // 3 doubles per face: first vertex
+};
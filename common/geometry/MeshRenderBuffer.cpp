@@ -0,0 +1,126 @@
+#include "MeshRenderBuffer.h"
+#include "CMesh.h"
+#include <qgl.h>
+
+// floats per corner: position, normal
+const int RenderVertStride = 6;
+
+CMeshRenderBuffer::CMeshRenderBuffer()
+	: m_vertBuffer(QOpenGLBuffer::VertexBuffer)
+{
+	m_context = NULL;
+	m_vertNum = 0;
+}
+
+CMeshRenderBuffer::~CMeshRenderBuffer()
+{
+	destroy();
+}
+
+bool CMeshRenderBuffer::create(const CMeshAsset &asset)
+{
+	destroy();
+
+	QOpenGLContext *context = QOpenGLContext::currentContext();
+	if (context == NULL)
+	{
+		return false;
+	}
+
+	if (!m_vertBuffer.create())
+	{
+		return false;
+	}
+
+	const std::vector<MathLib::Vector3> &meshVerts = asset.m_vertices;
+	const std::vector<std::vector<int>> &meshFaces = asset.m_faces;
+	const std::vector<MathLib::Vector3> &meshNormals = asset.m_faceNormals;
+
+	int faceNum = meshFaces.size();
+	std::vector<float> vertData(2 * 3 * faceNum * RenderVertStride);
+
+	int k = 0;
+
+	// front faces
+	for (int f_id = 0; f_id < faceNum; f_id++)
+	{
+		for (int i = 0; i < 3; i++)
+		{
+			const MathLib::Vector3 &v = meshVerts[meshFaces[f_id][i]];
+			const MathLib::Vector3 &n = meshNormals[f_id];
+
+			vertData[k++] = v[0]; vertData[k++] = v[1]; vertData[k++] = v[2];
+			vertData[k++] = n[0]; vertData[k++] = n[1]; vertData[k++] = n[2];
+		}
+	}
+
+	// back faces
+	for (int f_id = 0; f_id < faceNum; f_id++)
+	{
+		for (int i = 2; i >= 0; i--)
+		{
+			const MathLib::Vector3 &v = meshVerts[meshFaces[f_id][i]];
+			const MathLib::Vector3 &n = meshNormals[f_id];
+
+			vertData[k++] = v[0]; vertData[k++] = v[1]; vertData[k++] = v[2];
+			vertData[k++] = -n[0]; vertData[k++] = -n[1]; vertData[k++] = -n[2];
+		}
+	}
+
+	m_vertBuffer.setUsagePattern(QOpenGLBuffer::StaticDraw);
+	m_vertBuffer.bind();
+	m_vertBuffer.allocate(vertData.data(), vertData.size() * sizeof(float));
+	m_vertBuffer.release();
+
+	m_context = context;
+	m_vertNum = 6 * faceNum;
+
+	return true;
+}
+
+void CMeshRenderBuffer::destroy()
+{
+	// the buffer is freed in its own context group by Qt, also when no context is current
+	if (m_vertBuffer.isCreated())
+	{
+		m_vertBuffer.destroy();
+	}
+
+	m_context = NULL;
+	m_vertNum = 0;
+}
+
+bool CMeshRenderBuffer::isValidInCurrentContext() const
+{
+	QOpenGLContext *context = QOpenGLContext::currentContext();
+
+	if (m_context == NULL || context == NULL || !m_vertBuffer.isCreated())
+	{
+		return false;
+	}
+
+	return context == m_context || QOpenGLContext::areSharing(context, m_context);
+}
+
+void CMeshRenderBuffer::bind()
+{
+	m_vertBuffer.bind();
+
+	glEnableClientState(GL_VERTEX_ARRAY);
+	glEnableClientState(GL_NORMAL_ARRAY);
+	glVertexPointer(3, GL_FLOAT, RenderVertStride * sizeof(float), (const GLvoid*)0);
+	glNormalPointer(GL_FLOAT, RenderVertStride * sizeof(float), (const GLvoid*)(3 * sizeof(float)));
+}
+
+void CMeshRenderBuffer::release()
+{
+	glDisableClientState(GL_NORMAL_ARRAY);
+	glDisableClientState(GL_VERTEX_ARRAY);
+
+	m_vertBuffer.release();
+}
+
+void CMeshRenderBuffer::drawFaces()
+{
+	glDrawArrays(GL_TRIANGLES, 0, m_vertNum);
+}
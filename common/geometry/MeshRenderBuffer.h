@@ -0,0 +1,37 @@
+#pragma once
+
+#include <QOpenGLBuffer>
+#include <QOpenGLContext>
+
+class CMeshAsset;
+
+// gpu copy of a mesh asset in model space, shared by all instances and drawn with their model matrix
+// one interleaved buffer of float position and normal per corner, front faces followed by the
+// reversed back faces with flipped normals, so both sides are lit as in immediate mode drawing
+// faces are flat shaded and corners are not shared, so no index buffer is used
+
+class CMeshRenderBuffer
+{
+public:
+	CMeshRenderBuffer();
+	~CMeshRenderBuffer();
+
+	// upload asset data in the current context; false if buffers are not supported
+	bool create(const CMeshAsset &asset);
+	void destroy();
+
+	// buffers are usable in the context they were created in and in contexts sharing with it
+	bool isValidInCurrentContext() const;
+
+	// bind the buffer and set vertex and normal arrays
+	void bind();
+	void release();
+
+	// draw with the arrays set by bind
+	void drawFaces();
+
+private:
+	QOpenGLBuffer m_vertBuffer;
+	QOpenGLContext *m_context;
+	int m_vertNum;
+};
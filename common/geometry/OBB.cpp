@@ -1,5 +1,6 @@
 #include "OBB.h"
 #include "TriTriIntersect.h"
+#include "OBBBatch.h"
 #include <fstream>
 #include <Set>
 
@@ -1255,55 +1256,82 @@ bool COBB::IsContact(const COBB &obb, double angleTh, double distTh, MathLib::Ve
 }
 
 
-bool COBB::IsIntersect(const COBB &obb) const
+bool COBB::IsIntersect(const COBB &obb, double margin) const
 {
-	const std::vector<MathLib::Vector3> &VI = vp;
-	const std::vector<MathLib::Vector3> &AI = axis;
-	const std::vector<MathLib::Vector3> &VJ = obb.vp;
-	const std::vector<MathLib::Vector3> &AJ = obb.axis;
-	MathLib::Vector3 FNI, FNJ;
-	for (int i = 0; i < boxNumFace; i++) {
-		FNI.set(AI[boxFaceNormalOrientAlongAxis[i][0]][0] * boxFaceNormalOrientAlongAxis[i][1], AI[boxFaceNormalOrientAlongAxis[i][0]][1] * boxFaceNormalOrientAlongAxis[i][1], AI[boxFaceNormalOrientAlongAxis[i][0]][2] * boxFaceNormalOrientAlongAxis[i][1]);
-		for (int j = 0; j < boxNumFace; j++) {
-			FNJ.set(AJ[boxFaceNormalOrientAlongAxis[j][0]][0] * boxFaceNormalOrientAlongAxis[j][1], AJ[boxFaceNormalOrientAlongAxis[j][0]][1] * boxFaceNormalOrientAlongAxis[j][1], AJ[boxFaceNormalOrientAlongAxis[j][0]][2] * boxFaceNormalOrientAlongAxis[j][1]);
+	double paramsA[COBBBatch::ParamNum], paramsB[COBBBatch::ParamNum];
+	COBBBatch::getParams(*this, paramsA);
+	COBBBatch::getParams(obb, paramsB);
 
-			if (IntersectTriTri(VI[boxTriFace[i][0]], VI[boxTriFace[i][1]], VI[boxTriFace[i][2]], VJ[boxTriFace[j][0]], VJ[boxTriFace[j][1]], VJ[boxTriFace[j][2]])) {
-				return true;
-			}
+	return COBBBatch::isIntersectSAT(paramsA, paramsB, margin);
+}
+
+// face ai, d of the box: normal d * axis[ai], center and in-face half axes
+static void GetFaceFrame(const COBB &obb, int ai, int d, MathLib::Vector3 &n, MathLib::Vector3 &c, MathLib::Vector3 &u, MathLib::Vector3 &v)
+{
+	int ui = (ai + 1) % 3, vi = (ai + 2) % 3;
+
+	n = obb.axis[ai] * d;
+	c = obb.cent + n * obb.hsize[ai];
+	u = obb.axis[ui] * obb.hsize[ui];
+	v = obb.axis[vi] * obb.hsize[vi];
+}
+
+// the in-face rectangles, projected along nj, overlap if no edge normal of either separates them
+static bool IsFaceOverlap(const MathLib::Vector3 &ci, const MathLib::Vector3 &ui, const MathLib::Vector3 &vi,
+	const MathLib::Vector3 &nj, const MathLib::Vector3 &cj, const MathLib::Vector3 &uj, const MathLib::Vector3 &vj)
+{
+	MathLib::Vector3 w[4] = { uj, vj, nj.cross(ui), nj.cross(vi) };
+	MathLib::Vector3 dc = ci - cj;
+
+	for (int k = 0; k < 4; k++)
+	{
+		// edge of face i parallel to nj, its normal is not a separating direction
+		if (w[k].dot(w[k]) < 1e-12 * (ui.dot(ui) + vi.dot(vi)))
+		{
+			continue;
+		}
+
+		double ri = MathLib::Abs(w[k].dot(ui)) + MathLib::Abs(w[k].dot(vi));
+		double rj = MathLib::Abs(w[k].dot(uj)) + MathLib::Abs(w[k].dot(vj));
+		if (MathLib::Abs(w[k].dot(dc)) > ri + rj)
+		{
+			return false;
 		}
 	}
-	return false;
-}
 
+	return true;
+}
 
 bool COBB::IsSupport(const COBB &obb, double ta, double td, const MathLib::Vector3 &upright) const
 {
-	const std::vector<MathLib::Vector3> &VI = vp;
-	const std::vector<MathLib::Vector3> &AI = axis;
-	const std::vector<MathLib::Vector3> &VJ = obb.vp;
-	const std::vector<MathLib::Vector3> &AJ = obb.axis;
-	MathLib::Vector3 FNI, FNJ;
-	for (int i = 0; i<boxNumFace; i++) {
-		int currAxisId = boxFaceNormalOrientAlongAxis[i][0];
-		int currAxisSign = boxFaceNormalOrientAlongAxis[i][1];
+	// angles as cosines, so no Acos per face
+	double cosUpright = MathLib::Cos(1.0);
+	double cosAngle = MathLib::Cos(ta);
 
-		FNI.set(AI[currAxisId][0] * currAxisSign, AI[currAxisId][1] * currAxisSign, AI[currAxisId][2] * currAxisSign);
-		if (MathLib::Acos(MathLib::Abs(FNI.dot(upright))) > 1.0) {
+	MathLib::Vector3 ni, ci, ui, vi, nj, cj, uj, vj;
+	for (int i = 0; i < boxNumQuadFace; i++) {
+		int ai = i / 2, di = (i % 2) ? -1 : 1;
+		if (MathLib::Abs(axis[ai].dot(upright)) < cosUpright) {
 			continue;
 		}
-		for (int j = 0; j < boxNumFace; j++) {
-			int currAxisId = boxFaceNormalOrientAlongAxis[j][0];
-			int currAxisSign = boxFaceNormalOrientAlongAxis[j][1];
+		GetFaceFrame(*this, ai, di, ni, ci, ui, vi);
 
-			FNJ.set(AJ[currAxisId][0] * currAxisSign, AJ[currAxisId][1] * currAxisSign, AJ[currAxisId][2] * currAxisSign);
+		for (int j = 0; j < boxNumQuadFace; j++) {
+			int aj = j / 2, dj = (j % 2) ? -1 : 1;
 
-			bool isOpposite = false;
-			if (FNI.dot(FNJ) < 0)
-			{
-				isOpposite = true;
+			// parallel or opposite normals
+			if (MathLib::Abs(axis[ai].dot(obb.axis[aj])) < cosAngle) {
+				continue;
+			}
+			GetFaceFrame(obb, aj, dj, nj, cj, uj, vj);
+
+			// all corners of face j within td of the plane of face i
+			double dist = MathLib::Abs(ni.dot(cj - ci)) + MathLib::Abs(ni.dot(uj)) + MathLib::Abs(ni.dot(vj));
+			if (dist > td) {
+				continue;
 			}
 
-			if (ContactTriTri(VI[boxTriFace[i][0]], VI[boxTriFace[i][1]], VI[boxTriFace[i][2]], FNI, VJ[boxTriFace[j][0]], VJ[boxTriFace[j][1]], VJ[boxTriFace[j][2]], FNJ, ta, td, isOpposite)) {
+			if (IsFaceOverlap(ci, ui, vi, nj, cj, uj, vj)) {
 				return true;
 			}
 		}
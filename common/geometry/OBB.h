@@ -106,10 +106,10 @@ public:
 	bool IsContain(const COBB &obb, double tp) const;
 	bool IsContain(const COBB &obb) const;
 	bool IsContact(const COBB &obb, double ta, double td, MathLib::Vector3 &dir) const;
-	bool IsSupport(const COBB &obb, double ta, double td, const MathLib::Vector3 &upright) const;
+	bool IsSupport(const COBB &obb, double ta, double td, const MathLib::Vector3 &upright) const;  // a near-upright face of this box against a face of obb
 	bool IsCoverCenter(const COBB &obb);
 
-	bool IsIntersect(const COBB &obb) const;
+	bool IsIntersect(const COBB &obb, double margin = 0.0) const;  // solid boxes, gap along every separating axis within margin
 
 	double ConnStrength_CD(const COBB &obb) const;
 	double ConnStrength_HD(const COBB &obb) const;
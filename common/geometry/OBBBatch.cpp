@@ -0,0 +1,264 @@
+#include "OBBBatch.h"
+#include "OBB.h"
+#include "VertexStore.h"
+#include <cmath>
+
+// double precision mul/add/cmp only need AVX; the kernel is compiled for it and picked at run time,
+// so the library itself does not require an /arch switch
+#if defined(_M_X64) || defined(__x86_64__)
+#define OBB_BATCH_SIMD
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#define OBB_BATCH_SIMD_TARGET
+#else
+#define OBB_BATCH_SIMD_TARGET __attribute__((target("avx")))
+#endif
+#endif
+
+// added to the axis dot products, so near parallel edges give a degenerate cross axis that never separates
+static const double SATEpsilon = 1e-6;
+
+COBBBatch::COBBBatch()
+{
+}
+
+COBBBatch::~COBBBatch()
+{
+}
+
+void COBBBatch::getParams(const COBB &obb, double *params)
+{
+	for (int d = 0; d < 3; d++)
+	{
+		params[d] = obb.cent[d];
+		params[3 + d] = obb.axis[0][d];
+		params[6 + d] = obb.axis[1][d];
+		params[9 + d] = obb.axis[2][d];
+		params[12 + d] = obb.hsize[d];
+	}
+}
+
+void COBBBatch::addBox(const COBB &obb)
+{
+	double params[ParamNum];
+	getParams(obb, params);
+
+	for (int p = 0; p < ParamNum; p++)
+	{
+		m_params[p].push_back(params[p]);
+	}
+}
+
+void COBBBatch::build(const std::vector<COBB> &boxes)
+{
+	clear();
+
+	for (int i = 0; i < boxes.size(); i++)
+	{
+		addBox(boxes[i]);
+	}
+}
+
+void COBBBatch::build(const std::vector<const COBB*> &boxes)
+{
+	clear();
+
+	for (int i = 0; i < boxes.size(); i++)
+	{
+		addBox(*boxes[i]);
+	}
+}
+
+void COBBBatch::clear()
+{
+	for (int p = 0; p < ParamNum; p++)
+	{
+		m_params[p].clear();
+	}
+}
+
+bool COBBBatch::isIntersectSAT(const double *A, const double *B, double margin)
+{
+	const double *hA = A + 12;
+	const double *hB = B + 12;
+
+	// rotation of B in A's frame and center offset in A's frame
+	double R[3][3], absR[3][3], t[3];
+	double d[3] = { B[0] - A[0], B[1] - A[1], B[2] - A[2] };
+
+	for (int i = 0; i < 3; i++)
+	{
+		const double *ai = A + 3 + 3 * i;
+		for (int j = 0; j < 3; j++)
+		{
+			const double *bj = B + 3 + 3 * j;
+			R[i][j] = ai[0] * bj[0] + ai[1] * bj[1] + ai[2] * bj[2];
+			absR[i][j] = std::abs(R[i][j]) + SATEpsilon;
+		}
+
+		t[i] = d[0] * ai[0] + d[1] * ai[1] + d[2] * ai[2];
+	}
+
+	// axes of A
+	for (int i = 0; i < 3; i++)
+	{
+		double rb = hB[0] * absR[i][0] + hB[1] * absR[i][1] + hB[2] * absR[i][2];
+		if (std::abs(t[i]) > hA[i] + rb + margin) return false;
+	}
+
+	// axes of B
+	for (int j = 0; j < 3; j++)
+	{
+		double ra = hA[0] * absR[0][j] + hA[1] * absR[1][j] + hA[2] * absR[2][j];
+		double dist = t[0] * R[0][j] + t[1] * R[1][j] + t[2] * R[2][j];
+		if (std::abs(dist) > ra + hB[j] + margin) return false;
+	}
+
+	// cross products of the axes
+	for (int i = 0; i < 3; i++)
+	{
+		int i1 = (i + 1) % 3, i2 = (i + 2) % 3;
+		for (int j = 0; j < 3; j++)
+		{
+			int j1 = (j + 1) % 3, j2 = (j + 2) % 3;
+			double ra = hA[i1] * absR[i2][j] + hA[i2] * absR[i1][j];
+			double rb = hB[j1] * absR[i][j2] + hB[j2] * absR[i][j1];
+			double dist = t[i2] * R[i1][j] - t[i1] * R[i2][j];
+			if (std::abs(dist) > ra + rb + margin) return false;
+		}
+	}
+
+	return true;
+}
+
+#ifdef OBB_BATCH_SIMD
+
+// four boxes of B per pass, same expressions and order as isIntersectSAT, no fused multiply-add
+OBB_BATCH_SIMD_TARGET
+static void IntersectSATAVX(const double *A, const std::vector<double> *B, int count, double margin, std::vector<int> &ids)
+{
+	const __m256d signMask = _mm256_set1_pd(-0.0);
+	const __m256d eps = _mm256_set1_pd(SATEpsilon);
+	const __m256d marginW = _mm256_set1_pd(margin);
+
+	__m256d hA[3], aA[3][3], cA[3];
+	for (int d = 0; d < 3; d++)
+	{
+		cA[d] = _mm256_set1_pd(A[d]);
+		hA[d] = _mm256_set1_pd(A[12 + d]);
+		for (int i = 0; i < 3; i++)
+		{
+			aA[i][d] = _mm256_set1_pd(A[3 + 3 * i + d]);
+		}
+	}
+
+	for (int k = 0; k < count; k += 4)
+	{
+		__m256d bB[3][3], hB[3], d[3];
+		for (int c = 0; c < 3; c++)
+		{
+			d[c] = _mm256_sub_pd(_mm256_loadu_pd(B[c].data() + k), cA[c]);
+			hB[c] = _mm256_loadu_pd(B[12 + c].data() + k);
+			for (int j = 0; j < 3; j++)
+			{
+				bB[j][c] = _mm256_loadu_pd(B[3 + 3 * j + c].data() + k);
+			}
+		}
+
+		__m256d R[3][3], absR[3][3], t[3];
+		for (int i = 0; i < 3; i++)
+		{
+			for (int j = 0; j < 3; j++)
+			{
+				R[i][j] = _mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(aA[i][0], bB[j][0]), _mm256_mul_pd(aA[i][1], bB[j][1])),
+					_mm256_mul_pd(aA[i][2], bB[j][2]));
+				absR[i][j] = _mm256_add_pd(_mm256_andnot_pd(signMask, R[i][j]), eps);
+			}
+
+			t[i] = _mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(d[0], aA[i][0]), _mm256_mul_pd(d[1], aA[i][1])),
+				_mm256_mul_pd(d[2], aA[i][2]));
+		}
+
+		__m256d separated = _mm256_setzero_pd();
+
+		for (int i = 0; i < 3; i++)
+		{
+			__m256d rb = _mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(hB[0], absR[i][0]), _mm256_mul_pd(hB[1], absR[i][1])),
+				_mm256_mul_pd(hB[2], absR[i][2]));
+			__m256d r = _mm256_add_pd(_mm256_add_pd(hA[i], rb), marginW);
+			separated = _mm256_or_pd(separated, _mm256_cmp_pd(_mm256_andnot_pd(signMask, t[i]), r, _CMP_GT_OQ));
+		}
+
+		for (int j = 0; j < 3; j++)
+		{
+			__m256d ra = _mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(hA[0], absR[0][j]), _mm256_mul_pd(hA[1], absR[1][j])),
+				_mm256_mul_pd(hA[2], absR[2][j]));
+			__m256d dist = _mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(t[0], R[0][j]), _mm256_mul_pd(t[1], R[1][j])),
+				_mm256_mul_pd(t[2], R[2][j]));
+			__m256d r = _mm256_add_pd(_mm256_add_pd(ra, hB[j]), marginW);
+			separated = _mm256_or_pd(separated, _mm256_cmp_pd(_mm256_andnot_pd(signMask, dist), r, _CMP_GT_OQ));
+		}
+
+		for (int i = 0; i < 3; i++)
+		{
+			int i1 = (i + 1) % 3, i2 = (i + 2) % 3;
+			for (int j = 0; j < 3; j++)
+			{
+				int j1 = (j + 1) % 3, j2 = (j + 2) % 3;
+				__m256d ra = _mm256_add_pd(_mm256_mul_pd(hA[i1], absR[i2][j]), _mm256_mul_pd(hA[i2], absR[i1][j]));
+				__m256d rb = _mm256_add_pd(_mm256_mul_pd(hB[j1], absR[i][j2]), _mm256_mul_pd(hB[j2], absR[i][j1]));
+				__m256d dist = _mm256_sub_pd(_mm256_mul_pd(t[i2], R[i1][j]), _mm256_mul_pd(t[i1], R[i2][j]));
+				__m256d r = _mm256_add_pd(_mm256_add_pd(ra, rb), marginW);
+				separated = _mm256_or_pd(separated, _mm256_cmp_pd(_mm256_andnot_pd(signMask, dist), r, _CMP_GT_OQ));
+			}
+		}
+
+		int separatedBits = _mm256_movemask_pd(separated);
+		for (int l = 0; l < 4; l++)
+		{
+			if ((separatedBits & (1 << l)) == 0)
+			{
+				ids.push_back(k + l);
+			}
+		}
+	}
+}
+
+#endif
+
+void COBBBatch::findIntersections(const COBB &obb, double margin, std::vector<int> &ids) const
+{
+	ids.clear();
+
+	double paramsA[ParamNum];
+	getParams(obb, paramsA);
+
+	int boxNum = size();
+	int simdNum = 0;
+
+#ifdef OBB_BATCH_SIMD
+	if (CVertexStore::isSIMDSupported())
+	{
+		simdNum = boxNum - boxNum % 4;
+
+		if (simdNum > 0)
+		{
+			IntersectSATAVX(paramsA, m_params, simdNum, margin, ids);
+		}
+	}
+#endif
+
+	double paramsB[ParamNum];
+	for (int k = simdNum; k < boxNum; k++)
+	{
+		for (int p = 0; p < ParamNum; p++)
+		{
+			paramsB[p] = m_params[p][k];
+		}
+
+		if (isIntersectSAT(paramsA, paramsB, margin))
+		{
+			ids.push_back(k);
+		}
+	}
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <vector>
+
+class COBB;
+
+// structure of arrays copy of many OBBs, used to test one box against all of them with the separating axis test
+// the vectorized kernel keeps double precision and the operation order of the scalar test, so results match COBB::IsIntersect
+
+class COBBBatch
+{
+public:
+	COBBBatch();
+	~COBBBatch();
+
+	// box parameters: center, 3 axes, 3 half sizes
+	static const int ParamNum = 15;
+
+	void build(const std::vector<COBB> &boxes);
+	void build(const std::vector<const COBB*> &boxes);
+	void clear();
+
+	int size() const { return m_params[0].size(); };
+
+	// ids of boxes within margin of obb, ascending; box i is reported iff obb.IsIntersect(boxes[i], margin)
+	void findIntersections(const COBB &obb, double margin, std::vector<int> &ids) const;
+
+	static void getParams(const COBB &obb, double *params);
+
+	// 15-axis separating axis test on box parameters, boxes are apart if their gap along any axis is larger than margin
+	static bool isIntersectSAT(const double *paramsA, const double *paramsB, double margin);
+
+private:
+	void addBox(const COBB &obb);
+
+	std::vector<double> m_params[ParamNum];
+};
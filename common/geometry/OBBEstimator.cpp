@@ -205,10 +205,10 @@ int COBBEstimator::computeMinOBBByRot(int iFixAxis)
 			BEST_FIT::computeBestFitOBB(m_ptsNum, points, 3 * sizeof(double), sides, matrix, BEST_FIT::FS_SLOW_FIT);
 			break;
 		case 1:
-			BEST_FIT::computeBestFitOBB_FixY(m_ptsNum, points, 3 * sizeof(double), sides, matrix, BEST_FIT::FS_SLOW_FIT);  // Rui
+			BEST_FIT::computeBestFitOBB_FixAxisByHull(m_ptsNum, points, 3 * sizeof(double), 1, sides, matrix);
 			break;
 		case 2:
-			BEST_FIT::computeBestFitOBB_FixZ(m_ptsNum, points, 3 * sizeof(double), sides, matrix, BEST_FIT::FS_SLOW_FIT);
+			BEST_FIT::computeBestFitOBB_FixAxisByHull(m_ptsNum, points, 3 * sizeof(double), 2, sides, matrix);
 			break;
 		default:
 			BEST_FIT::computeBestFitOBB(m_ptsNum, points, 3 * sizeof(double), sides, matrix, BEST_FIT::FS_SLOW_FIT);
@@ -0,0 +1,233 @@
+#include "RayBVH.h"
+#include "../utilities/utility.h"
+#include <algorithm>
+
+const int RayBVHLeafSize = 4;
+
+CRayBVH::CRayBVH()
+{
+}
+
+CRayBVH::~CRayBVH()
+{
+	clear();
+}
+
+void CRayBVH::clear()
+{
+	m_nodes.clear();
+	m_primIds.clear();
+	m_primBoxes.clear();
+}
+
+void CRayBVH::build(const std::vector<double> &primBoxes)
+{
+	clear();
+
+	int primNum = primBoxes.size() / 6;
+	m_primBoxes = primBoxes;
+
+	for (int i = 0; i < primNum; i++)
+	{
+		const double *box = &m_primBoxes[6 * i];
+		if (box[0] <= box[3] && box[1] <= box[4] && box[2] <= box[5])
+		{
+			m_primIds.push_back(i);
+		}
+	}
+
+	if (m_primIds.empty())
+	{
+		m_primBoxes.clear();
+		return;
+	}
+
+	m_nodes.reserve(2 * m_primIds.size() / RayBVHLeafSize + 1);
+	buildNode(0, m_primIds.size());
+}
+
+int CRayBVH::buildNode(int start, int count)
+{
+	int nodeId = m_nodes.size();
+
+	Node node;
+	node.left = -1;
+	node.right = -1;
+	node.start = start;
+	node.count = count;
+
+	// box of primitives and range of their box centers
+	double minC[3] = { MAX_VALUE, MAX_VALUE, MAX_VALUE };
+	double maxC[3] = { -MAX_VALUE, -MAX_VALUE, -MAX_VALUE };
+
+	for (int d = 0; d < 3; d++)
+	{
+		node.minV[d] = MAX_VALUE;
+		node.maxV[d] = -MAX_VALUE;
+	}
+
+	for (int i = start; i < start + count; i++)
+	{
+		const double *box = &m_primBoxes[6 * m_primIds[i]];
+		for (int d = 0; d < 3; d++)
+		{
+			node.minV[d] = std::min(node.minV[d], box[d]);
+			node.maxV[d] = std::max(node.maxV[d], box[3 + d]);
+
+			double c = box[d] + box[3 + d];
+			minC[d] = std::min(minC[d], c);
+			maxC[d] = std::max(maxC[d], c);
+		}
+	}
+
+	m_nodes.push_back(node);
+
+	if (count <= RayBVHLeafSize)
+	{
+		return nodeId;
+	}
+
+	// split at the median of box centers along the longest axis
+	int axis = 0;
+	for (int d = 1; d < 3; d++)
+	{
+		if (maxC[d] - minC[d] > maxC[axis] - minC[axis])
+		{
+			axis = d;
+		}
+	}
+
+	int mid = start + count / 2;
+	const std::vector<double> &boxes = m_primBoxes;
+	std::nth_element(m_primIds.begin() + start, m_primIds.begin() + mid, m_primIds.begin() + start + count,
+		[&boxes, axis](int a, int b) { return boxes[6 * a + axis] + boxes[6 * a + 3 + axis] < boxes[6 * b + axis] + boxes[6 * b + 3 + axis]; });
+
+	int leftId = buildNode(start, mid - start);
+	int rightId = buildNode(mid, start + count - mid);
+
+	m_nodes[nodeId].left = leftId;
+	m_nodes[nodeId].right = rightId;
+
+	return nodeId;
+}
+
+bool CRayBVH::isRayInNode(const Node &node, const double *orig, const double *invDir, double tMax, double &tEntry) const
+{
+	double tNear = 0, tFar = tMax;
+
+	for (int d = 0; d < 3; d++)
+	{
+		// ray parallel to the slab, inside or outside for all t
+		if (invDir[d] == MAX_VALUE)
+		{
+			if (orig[d] < node.minV[d] || orig[d] > node.maxV[d])
+			{
+				return false;
+			}
+
+			continue;
+		}
+
+		double t0 = (node.minV[d] - orig[d]) * invDir[d];
+		double t1 = (node.maxV[d] - orig[d]) * invDir[d];
+		if (t0 > t1)
+		{
+			std::swap(t0, t1);
+		}
+
+		tNear = std::max(tNear, t0);
+		tFar = std::min(tFar, t1);
+
+		if (tNear > tFar)
+		{
+			return false;
+		}
+	}
+
+	tEntry = tNear;
+	return true;
+}
+
+bool CRayBVH::intersectRay(const MathLib::Vector3 &orig, const MathLib::Vector3 &dir, double tMax,
+	const std::function<bool(int, double&)> &primTest) const
+{
+	if (isEmpty())
+	{
+		return false;
+	}
+
+	double o[3] = { orig[0], orig[1], orig[2] };
+	double invDir[3];
+	for (int d = 0; d < 3; d++)
+	{
+		invDir[d] = (dir[d] == 0) ? MAX_VALUE : 1.0 / dir[d];
+	}
+
+	double tEntry;
+	if (!isRayInNode(m_nodes[0], o, invDir, tMax, tEntry))
+	{
+		return false;
+	}
+
+	bool isHit = false;
+
+	// nodes with their entry distance, the nearer child is popped first
+	std::vector<std::pair<int, double>> nodeStack;
+	nodeStack.reserve(64);
+	nodeStack.push_back(std::make_pair(0, tEntry));
+
+	while (!nodeStack.empty())
+	{
+		std::pair<int, double> curr = nodeStack.back();
+		nodeStack.pop_back();
+
+		// tMax may have dropped below the entry since the node was pushed
+		if (curr.second > tMax)
+		{
+			continue;
+		}
+
+		const Node &node = m_nodes[curr.first];
+
+		if (node.left == -1)
+		{
+			for (int i = node.start; i < node.start + node.count; i++)
+			{
+				if (primTest(m_primIds[i], tMax))
+				{
+					isHit = true;
+				}
+			}
+
+			continue;
+		}
+
+		double tLeft, tRight;
+		bool inLeft = isRayInNode(m_nodes[node.left], o, invDir, tMax, tLeft);
+		bool inRight = isRayInNode(m_nodes[node.right], o, invDir, tMax, tRight);
+
+		if (inLeft && inRight)
+		{
+			if (tLeft <= tRight)
+			{
+				nodeStack.push_back(std::make_pair(node.right, tRight));
+				nodeStack.push_back(std::make_pair(node.left, tLeft));
+			}
+			else
+			{
+				nodeStack.push_back(std::make_pair(node.left, tLeft));
+				nodeStack.push_back(std::make_pair(node.right, tRight));
+			}
+		}
+		else if (inLeft)
+		{
+			nodeStack.push_back(std::make_pair(node.left, tLeft));
+		}
+		else if (inRight)
+		{
+			nodeStack.push_back(std::make_pair(node.right, tRight));
+		}
+	}
+
+	return isHit;
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include "../utilities/mathlib.h"
+#include <vector>
+#include <functional>
+
+// bounding volume hierarchy over primitive boxes for ray queries
+// used over mesh faces in model space, and over model instances in world space for scene picking
+
+class CRayBVH
+{
+public:
+	struct Node
+	{
+		double minV[3];  // box of primitives in subtree
+		double maxV[3];
+		int left;        // child node ids, -1 for leaf
+		int right;
+		int start;       // primitive range in m_primIds
+		int count;
+	};
+
+	CRayBVH();
+	~CRayBVH();
+
+	// 6 doubles per primitive: min, max; primitives with an empty box (min > max) are never visited
+	void build(const std::vector<double> &primBoxes);
+	void clear();
+
+	bool isEmpty() const { return m_nodes.empty(); };
+	int getPrimNum() const { return m_primIds.size(); };
+
+	// visit primitives whose box is entered by orig + t*dir for t in [0, tMax], nearer nodes first
+	// primTest(primId, tMax) lowers tMax to its hit and returns true, so nodes behind the closest hit are skipped
+	// returns true if any primTest returned true
+	bool intersectRay(const MathLib::Vector3 &orig, const MathLib::Vector3 &dir, double tMax,
+		const std::function<bool(int, double&)> &primTest) const;
+
+private:
+	int buildNode(int start, int count);
+	bool isRayInNode(const Node &node, const double *orig, const double *invDir, double tMax, double &tEntry) const;
+
+	std::vector<Node> m_nodes;
+	std::vector<int> m_primIds;  // in tree order
+	std::vector<double> m_primBoxes;
+};
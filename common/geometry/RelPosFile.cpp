@@ -0,0 +1,277 @@
+#include "RelPosFile.h"
+#include <map>
+#include <cstring>
+
+const char RelPosFileMagic[4] = { 'R', 'P', 'O', 'S' };
+const quint32 RelPosFileVersion = 1;
+
+struct RelPosFileHeader
+{
+	char magic[4];
+	quint32 version;
+	quint32 rowNum;
+	quint32 nameNum;
+	quint32 nameDataSize;  // utf8 bytes of all names, before padding
+	quint32 reserved;
+};
+
+const int RelPosIntColumnNum = 6;
+const int RelPosFloatsPerRow = 4 + 16 + 16;
+
+static qint64 padTo4(qint64 size)
+{
+	return (size + 3) & ~3;
+}
+
+static void appendData(QByteArray &data, const void *src, int size)
+{
+	data.append((const char*)src, size);
+}
+
+static void appendFloatMat(std::vector<float> &column, const MathLib::Matrix4d &mat)
+{
+	for (int i = 0; i < 16; i++)
+	{
+		column.push_back(mat.M[i]);
+	}
+}
+
+CRelPosFile::CRelPosFile()
+{
+	m_data = NULL;
+	m_rowNum = 0;
+	resetColumns();
+}
+
+CRelPosFile::~CRelPosFile()
+{
+	close();
+}
+
+void CRelPosFile::resetColumns()
+{
+	m_anchorNameIds = NULL;
+	m_actNameIds = NULL;
+	m_conditionNameIds = NULL;
+	m_sceneNameIds = NULL;
+	m_anchorObjIds = NULL;
+	m_actObjIds = NULL;
+	m_posThetas = NULL;
+	m_anchorAlignMats = NULL;
+	m_actAlignMats = NULL;
+}
+
+bool CRelPosFile::save(const QString &filename, const std::vector<RelativePos*> &relPositions)
+{
+	int rowNum = relPositions.size();
+
+	// intern names
+	std::map<QString, int> nameIds;
+	std::vector<QString> names;
+
+	auto getNameId = [&](const QString &name)
+	{
+		auto iter = nameIds.find(name);
+		if (iter != nameIds.end())
+		{
+			return iter->second;
+		}
+
+		int id = names.size();
+		nameIds[name] = id;
+		names.push_back(name);
+		return id;
+	};
+
+	std::vector<qint32> intColumns(RelPosIntColumnNum * rowNum);
+	std::vector<float> posThetas, anchorAlignMats, actAlignMats;
+	posThetas.reserve(4 * rowNum);
+	anchorAlignMats.reserve(16 * rowNum);
+	actAlignMats.reserve(16 * rowNum);
+
+	for (int i = 0; i < rowNum; i++)
+	{
+		RelativePos *relPos = relPositions[i];
+
+		intColumns[i] = getNameId(relPos->m_anchorObjName);
+		intColumns[rowNum + i] = getNameId(relPos->m_actObjName);
+		intColumns[2 * rowNum + i] = getNameId(relPos->m_conditionName);
+		intColumns[3 * rowNum + i] = getNameId(relPos->m_sceneName);
+		intColumns[4 * rowNum + i] = relPos->m_anchorObjId;
+		intColumns[5 * rowNum + i] = relPos->m_actObjId;
+
+		posThetas.push_back(relPos->pos.x);
+		posThetas.push_back(relPos->pos.y);
+		posThetas.push_back(relPos->pos.z);
+		posThetas.push_back(relPos->theta);
+
+		appendFloatMat(anchorAlignMats, relPos->anchorAlignMat);
+		appendFloatMat(actAlignMats, relPos->actAlignMat);
+	}
+
+	// name table
+	std::vector<quint32> nameOffsets(1, 0);
+	QByteArray nameData;
+	for (int i = 0; i < names.size(); i++)
+	{
+		nameData.append(names[i].toUtf8());
+		nameOffsets.push_back(nameData.size());
+	}
+
+	RelPosFileHeader header;
+	memcpy(header.magic, RelPosFileMagic, 4);
+	header.version = RelPosFileVersion;
+	header.rowNum = rowNum;
+	header.nameNum = names.size();
+	header.nameDataSize = nameData.size();
+	header.reserved = 0;
+
+	nameData.append(QByteArray(padTo4(nameData.size()) - nameData.size(), '\0'));
+
+	QByteArray data;
+	appendData(data, &header, sizeof(header));
+	appendData(data, nameOffsets.data(), nameOffsets.size() * sizeof(quint32));
+	data.append(nameData);
+	appendData(data, intColumns.data(), intColumns.size() * sizeof(qint32));
+	appendData(data, posThetas.data(), posThetas.size() * sizeof(float));
+	appendData(data, anchorAlignMats.data(), anchorAlignMats.size() * sizeof(float));
+	appendData(data, actAlignMats.data(), actAlignMats.size() * sizeof(float));
+
+	QFile outFile(filename);
+	if (!outFile.open(QIODevice::WriteOnly | QIODevice::Truncate))
+	{
+		return false;
+	}
+
+	bool isWritten = (outFile.write(data) == data.size());
+	outFile.close();
+
+	return isWritten;
+}
+
+bool CRelPosFile::isBinaryFile(const QString &filename)
+{
+	QFile inFile(filename);
+	if (!inFile.open(QIODevice::ReadOnly))
+	{
+		return false;
+	}
+
+	QByteArray magic = inFile.read(4);
+	inFile.close();
+
+	return magic.size() == 4 && memcmp(magic.constData(), RelPosFileMagic, 4) == 0;
+}
+
+bool CRelPosFile::open(const QString &filename)
+{
+	close();
+
+	m_file.setFileName(filename);
+	if (!m_file.open(QIODevice::ReadOnly))
+	{
+		return false;
+	}
+
+	qint64 fileSize = m_file.size();
+	if (fileSize < (qint64)sizeof(RelPosFileHeader))
+	{
+		close();
+		return false;
+	}
+
+	m_data = m_file.map(0, fileSize);
+	if (m_data == NULL)
+	{
+		close();
+		return false;
+	}
+
+	RelPosFileHeader header;
+	memcpy(&header, m_data, sizeof(header));
+
+	if (memcmp(header.magic, RelPosFileMagic, 4) != 0 || header.version != RelPosFileVersion)
+	{
+		std::cout << "\tCRelPosFile: unsupported file " << filename.toStdString() << "\n";
+		close();
+		return false;
+	}
+
+	// check the sections fit before pointing into them
+	qint64 offsetsStart = sizeof(RelPosFileHeader);
+	qint64 namesStart = offsetsStart + ((qint64)header.nameNum + 1) * sizeof(quint32);
+	qint64 columnsStart = namesStart + padTo4(header.nameDataSize);
+	qint64 expectedSize = columnsStart + (qint64)header.rowNum * (RelPosIntColumnNum * sizeof(qint32) + RelPosFloatsPerRow * sizeof(float));
+
+	if (fileSize != expectedSize)
+	{
+		std::cout << "\tCRelPosFile: corrupted file " << filename.toStdString() << "\n";
+		close();
+		return false;
+	}
+
+	const quint32 *nameOffsets = (const quint32*)(m_data + offsetsStart);
+	const char *nameData = (const char*)(m_data + namesStart);
+
+	m_names.resize(header.nameNum);
+	for (int i = 0; i < header.nameNum; i++)
+	{
+		if (nameOffsets[i] > nameOffsets[i + 1] || nameOffsets[i + 1] > header.nameDataSize)
+		{
+			std::cout << "\tCRelPosFile: corrupted name table in " << filename.toStdString() << "\n";
+			close();
+			return false;
+		}
+
+		m_names[i] = QString::fromUtf8(nameData + nameOffsets[i], nameOffsets[i + 1] - nameOffsets[i]);
+	}
+
+	m_rowNum = header.rowNum;
+
+	const qint32 *intColumns = (const qint32*)(m_data + columnsStart);
+	m_anchorNameIds = intColumns;
+	m_actNameIds = intColumns + m_rowNum;
+	m_conditionNameIds = intColumns + 2 * m_rowNum;
+	m_sceneNameIds = intColumns + 3 * m_rowNum;
+	m_anchorObjIds = intColumns + 4 * m_rowNum;
+	m_actObjIds = intColumns + 5 * m_rowNum;
+
+	m_posThetas = (const float*)(intColumns + RelPosIntColumnNum * m_rowNum);
+	m_anchorAlignMats = m_posThetas + 4 * m_rowNum;
+	m_actAlignMats = m_anchorAlignMats + 16 * m_rowNum;
+
+	// name ids index the name table
+	const int *nameIdColumns[] = { m_anchorNameIds, m_actNameIds, m_conditionNameIds, m_sceneNameIds };
+	for (int c = 0; c < 4; c++)
+	{
+		for (int i = 0; i < m_rowNum; i++)
+		{
+			if (nameIdColumns[c][i] < 0 || nameIdColumns[c][i] >= header.nameNum)
+			{
+				std::cout << "\tCRelPosFile: invalid name id in " << filename.toStdString() << "\n";
+				close();
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+void CRelPosFile::close()
+{
+	if (m_data != NULL)
+	{
+		m_file.unmap(m_data);
+		m_data = NULL;
+	}
+
+	if (m_file.isOpen())
+	{
+		m_file.close();
+	}
+
+	m_rowNum = 0;
+	m_names.clear();
+	resetColumns();
+}
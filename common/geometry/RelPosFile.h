@@ -0,0 +1,51 @@
+#pragma once
+
+#include "../scene_lab/RelationModel.h"
+#include <QFile>
+#include <vector>
+
+// versioned binary columnar .relPos file
+// layout: header, name table (offsets + utf8 bytes), int32 columns of name ids and obj ids,
+// float (x, y, z, theta) per row, then float column major anchor and act align matrices per row
+// all sections are 4 byte aligned and little endian, so a mapped file is read in place
+
+class CRelPosFile
+{
+public:
+	CRelPosFile();
+	~CRelPosFile();
+
+	static bool save(const QString &filename, const std::vector<RelativePos*> &relPositions);
+
+	// true if the file starts with the binary magic, old text files return false
+	static bool isBinaryFile(const QString &filename);
+
+	// maps the file, column pointers stay valid until close
+	bool open(const QString &filename);
+	void close();
+
+	bool isOpen() const { return m_data != NULL; };
+	int getRowNum() const { return m_rowNum; };
+
+	// names are decoded once at open
+	int getNameNum() const { return m_names.size(); };
+	const QString& getName(int nameId) const { return m_names[nameId]; };
+
+	const int *m_anchorNameIds;
+	const int *m_actNameIds;
+	const int *m_conditionNameIds;
+	const int *m_sceneNameIds;
+	const int *m_anchorObjIds;
+	const int *m_actObjIds;
+	const float *m_posThetas;        // 4 per row
+	const float *m_anchorAlignMats;  // 16 per row
+	const float *m_actAlignMats;     // 16 per row
+
+private:
+	void resetColumns();
+
+	QFile m_file;
+	uchar *m_data;
+	int m_rowNum;
+	std::vector<QString> m_names;
+};
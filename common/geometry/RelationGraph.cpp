@@ -22,20 +22,53 @@ RelationGraph::~RelationGraph()
 int RelationGraph::extractSupportRel()
 {
 	double dT = m_SuppThresh / m_sceneMetric;
-	for (unsigned int i = 0; i < m_nodeNum; i++) {
+
+	// only pairs with close AABBs can pass IsSupport, pairs come in the same order as the full i, j > i loop
+	buildSupportBroadPhase(dT);
+
+	std::vector<std::pair<int, int>> candPairs;
+	m_suppBroadPhase.findOverlapPairs(candPairs);
+
+	for (unsigned int k = 0; k < candPairs.size(); k++) {
+		int i = candPairs[k].first;
+		int j = candPairs[k].second;
 		CModel *pMI = m_scene->getModel(i);
-		for (unsigned int j = i + 1; j < m_nodeNum; j++) {
-			CModel *pMJ = m_scene->getModel(j);
-			bool roughOBB = false;
-			if (pMI->IsSupport(pMJ, roughOBB, dT, m_scene->getUprightVec())) {
-				this->InsertEdge(i, j, CT_VERT_SUPPORT);	// upright support
-			}
+		CModel *pMJ = m_scene->getModel(j);
+		bool roughOBB = false;
+		if (pMI->IsSupport(pMJ, roughOBB, dT, m_scene->getUprightVec())) {
+			this->InsertEdge(i, j, CT_VERT_SUPPORT);	// upright support
 		}
 	}
 
 	return 0;
 }
 
+void RelationGraph::buildSupportBroadPhase(double dT)
+{
+	std::vector<CAABB> modelBoxes(m_nodeNum);
+	for (unsigned int i = 0; i < m_nodeNum; i++) {
+		modelBoxes[i] = m_scene->getModel(i)->getAABB();
+	}
+
+	m_suppBroadPhase.build(modelBoxes, dT);
+}
+
+void RelationGraph::updateSupportBroadPhase(int modelID, double dT)
+{
+	m_nodeNum = m_scene->getModelNum();
+
+	int indexedNum = m_suppBroadPhase.getBoxNum();
+	bool isAppend = (modelID == indexedNum);
+
+	// rebuild if the index is out of sync with the scene, otherwise only move the box of modelID
+	if (m_suppBroadPhase.getMargin() != dT || modelID > indexedNum || indexedNum + (isAppend ? 1 : 0) != m_nodeNum) {
+		buildSupportBroadPhase(dT);
+	}
+	else {
+		m_suppBroadPhase.updateBox(modelID, m_scene->getModel(modelID)->getAABB());
+	}
+}
+
 void RelationGraph::correctSupportEdgeDir()
 {
 	// v1 should be support parent, v2 is support child
@@ -133,6 +166,8 @@ void RelationGraph::updateGraph(int modelID, int suppModelID)
 
 	double dT = m_SuppThresh / m_sceneMetric;
 
+	updateSupportBroadPhase(modelID, dT);
+
 	if (pMI->IsSupport(pMJ, false, dT, m_scene->getUprightVec())) {
 		this->InsertEdge(suppModelID, modelID, CT_VERT_SUPPORT);	// upright support
 	}
@@ -143,14 +178,17 @@ int RelationGraph::updateSupportRel(int modelID)
 	double dT = m_SuppThresh / m_sceneMetric;
 	CModel *pMJ = m_scene->getModel(modelID); 
 
-	for (unsigned int i = 0; i < m_nodeNum; i++) {
-		if ( i!=modelID)
-		{
-			CModel *pMI = m_scene->getModel(i);
+	updateSupportBroadPhase(modelID, dT);
 
-			if (pMI->IsSupport(pMJ, false, dT, m_scene->getUprightVec())) {
-				this->InsertEdge(i, modelID, CT_VERT_SUPPORT);	// upright support
-			}
+	std::vector<int> candIds;
+	m_suppBroadPhase.findOverlaps(modelID, candIds);
+
+	for (unsigned int k = 0; k < candIds.size(); k++) {
+		int i = candIds[k];
+		CModel *pMI = m_scene->getModel(i);
+
+		if (pMI->IsSupport(pMJ, false, dT, m_scene->getUprightVec())) {
+			this->InsertEdge(i, modelID, CT_VERT_SUPPORT);	// upright support
 		}
 	}
 
@@ -1,5 +1,6 @@
 #pragma once
 #include "UDGraph.h"
+#include "AABBBroadPhase.h"
 #include "../utilities/utility.h"
 
 class CScene;
@@ -47,6 +48,9 @@ private:
 	int pruneSupportRel();
 	int updateSupportRel(int modelID); // update support relationship after insert a new model into the scene
 
+	void buildSupportBroadPhase(double dT); // index model AABBs inflated by support threshold
+	void updateSupportBroadPhase(int modelID, double dT); // refresh box of a moved or newly added model
+
 private:
 	CScene *m_scene;
 	int m_nodeNum;
@@ -60,5 +64,7 @@ private:
 
 	double m_SuppThresh;
 	double m_sceneMetric;
+
+	CAABBBroadPhase m_suppBroadPhase;		// candidate pairs for support test
 };
 
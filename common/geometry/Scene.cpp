@@ -1,6 +1,7 @@
 ﻿#include "Scene.h"
 #include "RelationGraph.h"
 #include "SuppPlane.h"
+#include "RelPosFile.h"
 //#include "../action/Skeleton.h"
 #include "../utilities/utility.h"
 //#include "../utilities/rng.h"
@@ -15,7 +16,7 @@
 
 const double InchToMeterFactor = 0.0254;
 
-CScene::CScene(std::map<QString, CMesh> &meshDB)
+CScene::CScene(MeshDatabase &meshDB)
 	:m_meshDatabase(meshDB)
 {
 	m_modelNum = 0;
@@ -77,11 +78,11 @@ void CScene::loadStanfordScene(const QString &filename, int metaDataOnly, int ob
 
 	if (metaDataOnly)
 	{
-		std::cout << "\nLoading scene meta data: " << m_sceneName.toStdString() << "...\n";
+		ThreadLog() << "\nLoading scene meta data: " << m_sceneName.toStdString() << "...\n";
 	}
 	else
 	{
-		std::cout << "\nLoading scene: " << m_sceneName.toStdString() << "...\n";
+		ThreadLog() << "\nLoading scene: " << m_sceneName.toStdString() << "...\n";
 	}
 	
 
@@ -96,17 +97,17 @@ void CScene::loadStanfordScene(const QString &filename, int metaDataOnly, int ob
 	{
 		if (reComputeOBB)
 		{
-			std::cout << "\tloading objects with obb...\n";
+			ThreadLog() << "\tloading objects with obb...\n";
 			
 		}
 		else
 		{
-			std::cout << "\tloading objects without obb...\n";
+			ThreadLog() << "\tloading objects without obb...\n";
 		}
 	}
 	else
 	{
-		std::cout << "\tloading objects with obb only...\n";
+		ThreadLog() << "\tloading objects with obb only...\n";
 	}
 
 	if (m_sceneFormat == SceneFormat[DBTypeID::Stanford] || m_sceneFormat == SceneFormat[DBTypeID::SceneNN] 
@@ -130,6 +131,10 @@ void CScene::loadStanfordScene(const QString &filename, int metaDataOnly, int ob
 			m_modelDBPath = m_sceneDBPath + "/object";
 		}
 
+		// transforms are applied in one batch after parsing
+		std::vector<CModel*> transModels;
+		std::vector<MathLib::Matrix4d> transMats;
+
 		while (!ifs.atEnd())
 		{
 			QString currLine = ifs.readLine();
@@ -144,7 +149,7 @@ void CScene::loadStanfordScene(const QString &filename, int metaDataOnly, int ob
 				std::vector<std::string> parts = PartitionString(currLine.toStdString(), " ");
 				int modelIndex = StringToInt(parts[1]);
 
-				CModel *newModel = new CModel(m_meshDatabase);
+				CModel *newModel = new CModel(&m_meshDatabase);
 				newModel->setSceneMetric(m_metric);
 				newModel->setSceneUpRightVec(m_uprightVec);
 
@@ -215,27 +220,37 @@ void CScene::loadStanfordScene(const QString &filename, int metaDataOnly, int ob
 				//}
 				
 				m_modelList[currModelID]->setInitTransMat(transMat);
-				m_modelList[currModelID]->transformModel(transMat);
+				transModels.push_back(m_modelList[currModelID]);
+				transMats.push_back(transMat);
 
-				std::cout << "\t\t" << currModelID + 1 << "/" << m_modelNum << " models loaded\r";
+				// progress line is rewritten in place, which only makes sense on the console
+				if (!IsThreadLogRedirected())
+				{
+					std::cout << "\t\t" << currModelID + 1 << "/" << m_modelNum << " models loaded\r";
+				}
 			}
 		}
+
+		CModel::transformModels(transModels, transMats);
 	}
 
-	std::cout << "\n";
+	if (!IsThreadLogRedirected())
+	{
+		std::cout << "\n";
+	}
 
 	initRelationGraph();
 
 	if (metaDataOnly)
 	{
-		std::cout << "Scene loaded\n";
+		ThreadLog() << "Scene loaded\n";
 		return;
 	}
 
 	computeAABB();
 	buildModelDislayList();
 
-	std::cout << "Scene " << m_sceneName.toStdString() <<" loaded\n";
+	ThreadLog() << "Scene " << m_sceneName.toStdString() <<" loaded\n";
 }
 
 void CScene::loadTsinghuaScene(const QString &filename, int obbOnly /*= 0*/, int reComputeOBB /*= 0*/)
@@ -269,7 +284,7 @@ void CScene::loadTsinghuaScene(const QString &filename, int obbOnly /*= 0*/, int
 			{
 				QString modelFullName = m_sceneDBPath + "/" + m_sceneFileName + "/" + modelName;
 
-				CModel *newModel = new CModel();
+				CModel *newModel = new CModel(&m_meshDatabase);
 				newModel->setSceneMetric(m_metric);
 				newModel->setSceneUpRightVec(m_uprightVec);
 
@@ -292,7 +307,7 @@ void CScene::loadTsinghuaScene(const QString &filename, int obbOnly /*= 0*/, int
 	computeAABB();
 	buildModelDislayList();
 
-	std::cout << "Scene " << m_sceneName.toStdString() << " loaded\n";
+	ThreadLog() << "Scene " << m_sceneName.toStdString() << " loaded\n";
 }
 
 void CScene::loadJsonScene(const QString &filename, const int metaDataOnly, const int obbOnly /*= 0*/, const int reComputeOBB /*= 0*/)
@@ -351,6 +366,11 @@ void CScene::loadSunCGScene(const QJsonObject &sceneObject, const int metaDataOn
 
 	int currModelID = 0;
 
+	// transforms are applied in one batch after parsing
+	std::vector<CModel*> transModels;
+	std::vector<MathLib::Matrix4d> transMats;
+	std::vector<bool> reOrientOBBs;
+
 	QJsonArray levelArray = sceneObject["levels"].toArray();
 		
 	foreach(auto level, levelArray)
@@ -363,7 +383,7 @@ void CScene::loadSunCGScene(const QJsonObject &sceneObject, const int metaDataOn
 			QJsonObject modelObject = model.toObject();
 			QString modelNameString = modelObject["modelId"].toString();
 
-			CModel *newModel = new CModel(m_meshDatabase);
+			CModel *newModel = new CModel(&m_meshDatabase);
 			newModel->setSceneMetric(m_metric);
 			newModel->setSceneUpRightVec(m_uprightVec);
 
@@ -427,12 +447,16 @@ void CScene::loadSunCGScene(const QJsonObject &sceneObject, const int metaDataOn
 			}
 
 			newModel->setInitTransMat(transMat);
-			newModel->transformModel(transMat, reOrientOBB);
+			transModels.push_back(newModel);
+			transMats.push_back(transMat);
+			reOrientOBBs.push_back(reOrientOBB);
 
 			m_modelList.push_back(newModel);
 		}
 	}
 
+	CModel::transformModels(transModels, transMats, reOrientOBBs);
+
 	// init model category list
 	m_modelCatNameList.resize(m_modelList.size());
 
@@ -453,13 +477,13 @@ void CScene::initRelationGraph()
 
 		buildSupportHierarchy();
 
-		std::cout << "\tstructure graph loaded\n";
+		ThreadLog() << "\tstructure graph loaded\n";
 	}
 }
 
 void CScene::buildRelationGraph()
 {
-	std::cout << "\tstart build relation graph for "<< m_sceneName.toStdString()<< "...";
+	ThreadLog() << "\tstart build relation graph for "<< m_sceneName.toStdString()<< "...";
 
 	// build OBB if not exist
 	for (int i = 0; i < m_modelList.size(); i++)
@@ -467,7 +491,7 @@ void CScene::buildRelationGraph()
 		CModel *m = m_modelList[i];
 		if( !m->hasOBB())
 		{
-			std::cout << "\t no OBB found, computing OBB first\n";
+			ThreadLog() << "\t no OBB found, computing OBB first\n";
 			return;
 		}
 
@@ -484,14 +508,15 @@ void CScene::buildRelationGraph()
 
 	buildSupportHierarchy();
 	m_hasRelGraph = true;
-	std::cout << " done.\n";
+	ThreadLog() << " done.\n";
 }
 
 void CScene::buildModelDislayList(int showDiffColor /*= 1*/, int showFaceCluster /*= 0*/)
 {
+	// lists are built on next draw, so loading a scene needs no GL context
 	foreach(CModel *m, m_modelList)
 	{
-		m->buildDisplayList(showDiffColor, showFaceCluster);
+		m->invalidateDisplayList(showDiffColor, showFaceCluster);
 	}
 }
 
@@ -508,10 +533,23 @@ void CScene::draw()
 	}
 	else
 	{
+		// plain color meshes are drawn together, so all instances of a mesh share one buffer bind
+		std::vector<CMesh*> instanceMeshes;
+		std::vector<QColor> instanceColors;
+
 		foreach(CModel *m, m_modelList)
 		{
-			m->draw(1, m_showModelOBB, m_showSuppPlane, m_showModelFrontDir, m_showSuppChildOBB);
+			bool isInstance = m->isVisible() && m->isDrawnByInstance();
+			if (isInstance)
+			{
+				instanceMeshes.push_back(m->getMesh());
+				instanceColors.push_back(m->getMeshColor());
+			}
+
+			m->draw(!isInstance, m_showModelOBB, m_showSuppPlane, m_showModelFrontDir, m_showSuppChildOBB);
 		}
+
+		CMesh::drawInstances(instanceMeshes, instanceColors);
 	}
 }
 
@@ -540,6 +578,18 @@ bool CScene::isSegIntersectModel(MathLib::Vector3 &startPt, MathLib::Vector3 &en
 	return m_modelList[modelID]->isSegIntersectMesh(startPt, endPt, radius);
 }
 
+bool CScene::pickModelByRay(const MathLib::Vector3 &orig, const MathLib::Vector3 &dir, CScenePicker::Hit &hit)
+{
+	m_picker.update(m_modelList.toStdVector());
+	return m_picker.pickByRay(orig, dir, hit);
+}
+
+bool CScene::isSegIntersectScene(const MathLib::Vector3 &startPt, const MathLib::Vector3 &endPt, CScenePicker::Hit &hit, int excludeModelId)
+{
+	m_picker.update(m_modelList.toStdVector());
+	return m_picker.intersectSegment(startPt, endPt, hit, excludeModelId);
+}
+
 void CScene::prepareForIntersect()
 {
 		for (int i = 0; i < m_modelNum; i++)
@@ -1081,21 +1131,9 @@ void CScene::saveRelPositions()
 {
 	QString filename = m_sceneFilePath + "/" + m_sceneName + ".relPos";
 
-	QFile outFile(filename);
-	QTextStream ofs(&outFile);
-
-	if (outFile.open(QIODevice::ReadWrite | QIODevice::Text | QIODevice::Truncate))
+	if (!CRelPosFile::save(filename, m_relPositions))
 	{
-		for (int i = 0; i < m_relPositions.size(); i++)
-		{
-			RelativePos *relPos = m_relPositions[i];
-			ofs << relPos->m_instanceNameHash << "," << relPos->m_instanceIdHash <<"\n";
-			ofs << relPos->pos.x << " " << relPos->pos.y << " " << relPos->pos.z << " " << relPos->theta << "," 
-				<< GetTransformationString(relPos->anchorAlignMat) << ","
-				<< GetTransformationString(relPos->actAlignMat) << "\n";
-		}
-
-		outFile.close();
+		ThreadLog() << "\tCScene: cannot save relative positions to " << filename.toStdString() << "\n";
 	}
 }
 
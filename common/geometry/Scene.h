@@ -6,6 +6,7 @@
 
 #include "CModel.h"
 #include "CMesh.h"
+#include "ScenePicker.h"
 #include "../scene_lab/RelationModel.h"
 
 #include <QJsonDocument>
@@ -34,7 +35,7 @@ class CScene
 {
 public:
 
-	CScene(std::map<QString, CMesh> &meshDB = std::map<QString, CMesh>());
+	CScene(MeshDatabase &meshDB);  // models of the scene share mesh assets through meshDB, which must outlive the scene
 	~CScene();
 
 	void loadStanfordScene(const QString &filename, int metaDataOnly = 0, int obbOnly = 0, int reComputeOBB = 0);  // default load mesh only
@@ -126,6 +127,10 @@ public:
 	void prepareForIntersect();
 	bool isSegIntersectModel(MathLib::Vector3 &startPt, MathLib::Vector3 &endPt, int modelID, double radius = 0);
 
+	// closest visible model hit by a click ray or segment; the picker refreshes its instance tree when models moved
+	bool pickModelByRay(const MathLib::Vector3 &orig, const MathLib::Vector3 &dir, CScenePicker::Hit &hit);
+	bool isSegIntersectScene(const MathLib::Vector3 &startPt, const MathLib::Vector3 &endPt, CScenePicker::Hit &hit, int excludeModelId = -1);
+
 
 	// rendering
 	void draw();
@@ -180,5 +185,7 @@ private:
 	bool m_showModelFrontDir;
 	bool m_showSuppChildOBB;
 
-	std::map<QString, CMesh> &m_meshDatabase;
+	MeshDatabase &m_meshDatabase;
+
+	CScenePicker m_picker;
 };
\ No newline at end of file
@@ -0,0 +1,102 @@
+#include "ScenePicker.h"
+#include "CModel.h"
+
+CScenePicker::CScenePicker()
+{
+}
+
+CScenePicker::~CScenePicker()
+{
+}
+
+void CScenePicker::clear()
+{
+	m_models.clear();
+	m_modelBoxes.clear();
+	m_instanceBVH.clear();
+}
+
+void CScenePicker::getModelBox(CModel *m, double *box) const
+{
+	CMesh *mesh = m->getMesh();
+
+	// models without faces get an empty box and are left out of the tree
+	if (mesh == NULL || mesh->getFaceNum() == 0)
+	{
+		for (int d = 0; d < 3; d++)
+		{
+			box[d] = 1;
+			box[3 + d] = -1;
+		}
+
+		return;
+	}
+
+	MathLib::Vector3 minV = mesh->getMinVert();
+	MathLib::Vector3 maxV = mesh->getMaxVert();
+
+	for (int d = 0; d < 3; d++)
+	{
+		box[d] = minV[d];
+		box[3 + d] = maxV[d];
+	}
+}
+
+void CScenePicker::update(const std::vector<CModel*> &models)
+{
+	std::vector<double> boxes(6 * models.size());
+	for (int i = 0; i < models.size(); i++)
+	{
+		getModelBox(models[i], &boxes[6 * i]);
+	}
+
+	if (models == m_models && boxes == m_modelBoxes)
+	{
+		return;
+	}
+
+	m_models = models;
+	m_modelBoxes.swap(boxes);
+	m_instanceBVH.build(m_modelBoxes);
+}
+
+bool CScenePicker::pickByRay(const MathLib::Vector3 &orig, const MathLib::Vector3 &dir, Hit &hit,
+	double maxT, bool cullBackFaces, int excludeModelId) const
+{
+	auto instanceTest = [&](int modelId, double &tMax)
+	{
+		CModel *m = m_models[modelId];
+		if (modelId == excludeModelId || !m->isVisible())
+		{
+			return false;
+		}
+
+		double t;
+		int faceId;
+
+		if (m->getMesh()->intersectRay(orig, dir, tMax, cullBackFaces, t, faceId))
+		{
+			tMax = t;
+			hit.modelId = modelId;
+			hit.faceId = faceId;
+			hit.t = t;
+			return true;
+		}
+
+		return false;
+	};
+
+	if (!m_instanceBVH.intersectRay(orig, dir, maxT, instanceTest))
+	{
+		return false;
+	}
+
+	hit.point = orig + dir*hit.t;
+	return true;
+}
+
+bool CScenePicker::intersectSegment(const MathLib::Vector3 &startPt, const MathLib::Vector3 &endPt, Hit &hit, int excludeModelId) const
+{
+	// faces block the segment from both sides
+	return pickByRay(startPt, endPt - startPt, hit, 1.0, false, excludeModelId);
+}
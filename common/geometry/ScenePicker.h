@@ -0,0 +1,44 @@
+#pragma once
+
+#include "RayBVH.h"
+#include <vector>
+#include <limits>
+
+class CModel;
+
+// ray queries over the models of a scene, two levels: an instance tree over model world bounds,
+// and at each instance the model space face tree of its mesh asset, reached through the inverse instance transform
+// meshes are only read at query time, so moving a model needs no rebuild beyond the instance tree
+
+class CScenePicker
+{
+public:
+	struct Hit
+	{
+		int modelId;  // index in the model list given to update
+		int faceId;
+		MathLib::Vector3 point;  // world space
+		double t;  // point = orig + t*dir
+	};
+
+	CScenePicker();
+	~CScenePicker();
+
+	// rebuild the instance tree if the model list or any model bounds changed since the last update
+	void update(const std::vector<CModel*> &models);
+	void clear();
+
+	// closest hit of orig + t*dir, t in [0, maxT]; invisible models and excludeModelId are skipped
+	bool pickByRay(const MathLib::Vector3 &orig, const MathLib::Vector3 &dir, Hit &hit,
+		double maxT = std::numeric_limits<double>::max(), bool cullBackFaces = false, int excludeModelId = -1) const;
+
+	// line of sight: closest hit on the segment from startPt to endPt
+	bool intersectSegment(const MathLib::Vector3 &startPt, const MathLib::Vector3 &endPt, Hit &hit, int excludeModelId = -1) const;
+
+private:
+	void getModelBox(CModel *m, double *box) const;
+
+	std::vector<CModel*> m_models;
+	std::vector<double> m_modelBoxes;  // 6 doubles per model: world min, max
+	CRayBVH m_instanceBVH;
+};
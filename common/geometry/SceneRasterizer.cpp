@@ -0,0 +1,226 @@
+#include "SceneRasterizer.h"
+#include "Scene.h"
+#include "CModel.h"
+#include "CMesh.h"
+#include "../utilities/utility.h"
+#include <cmath>
+#include <cstring>
+
+// view directions in the z-up scene frame, iso is the view of scene_lab::ScreenShotForCurrScene
+static const int CameraPresetNum = 4;
+static const char *CameraPresetNames[CameraPresetNum] = { "iso", "top", "front", "side" };
+static const double CameraPresetDirs[CameraPresetNum][3] = { { -1, 1, -1 }, { 0, 0, -1 }, { 0, 1, 0 }, { -1, 0, 0 } };
+
+// share of light that does not depend on the face orientation
+const double RasterAmbient = 0.25;
+
+CSceneRasterizer::CSceneRasterizer(int width, int height, int superSample)
+{
+	m_width = width;
+	m_height = height;
+	m_superSample = std::max(1, superSample);
+	m_bgColor = QColor(255, 255, 255);
+
+	m_bufWidth = 0;
+	m_bufHeight = 0;
+}
+
+CSceneRasterizer::~CSceneRasterizer()
+{
+}
+
+bool CSceneRasterizer::getCameraPreset(const QString &name, CameraPreset &preset)
+{
+	for (int i = 0; i < CameraPresetNum; i++)
+	{
+		if (name == CameraPresetNames[i])
+		{
+			preset.name = name;
+			preset.viewDir = MathLib::Vector3(CameraPresetDirs[i][0], CameraPresetDirs[i][1], CameraPresetDirs[i][2]);
+			preset.fieldOfView = 45;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+QStringList CSceneRasterizer::getCameraPresetNames()
+{
+	QStringList names;
+	for (int i = 0; i < CameraPresetNum; i++)
+	{
+		names << CameraPresetNames[i];
+	}
+
+	return names;
+}
+
+bool CSceneRasterizer::render(CScene *scene, const CameraPreset &camera, QImage &image)
+{
+	// bounds of the visible meshes
+	std::vector<CModel*> models;
+	MathLib::Vector3 minV(MAX_VALUE, MAX_VALUE, MAX_VALUE), maxV(-MAX_VALUE, -MAX_VALUE, -MAX_VALUE);
+
+	for (int i = 0; i < scene->getModelNum(); i++)
+	{
+		CModel *m = scene->getModel(i);
+		if (!m->isVisible() || m->getMesh() == NULL || m->getMesh()->getFaceNum() == 0)
+		{
+			continue;
+		}
+
+		models.push_back(m);
+
+		MathLib::Vector3 meshMinV = m->getMesh()->getMinVert();
+		MathLib::Vector3 meshMaxV = m->getMesh()->getMaxVert();
+		for (int d = 0; d < 3; d++)
+		{
+			minV[d] = std::min(minV[d], meshMinV[d]);
+			maxV[d] = std::max(maxV[d], meshMaxV[d]);
+		}
+	}
+
+	if (models.empty())
+	{
+		return false;
+	}
+
+	// camera frame, the bounding sphere of the scene fills the shorter image side
+	MathLib::Vector3 center = (minV + maxV) * 0.5;
+	double radius = std::max(0.5*(maxV - minV).magnitude(), 1e-6);
+
+	MathLib::Vector3 forward = camera.viewDir;
+	forward.normalize();
+
+	MathLib::Vector3 upHint = scene->getUprightVec();
+	if (MathLib::Abs(forward.dot(upHint)) > 0.999)
+	{
+		upHint = MathLib::Vector3(0, 1, 0);  // looking along the upright, e.g. top view
+	}
+
+	MathLib::Vector3 right = forward.cross(upHint);
+	right.normalize();
+	MathLib::Vector3 up = right.cross(forward);
+
+	double halfTan = MathLib::Tan(0.5*camera.fieldOfView);
+	double eyeDist = radius / MathLib::Sin(0.5*camera.fieldOfView);
+	MathLib::Vector3 eye = center - forward*eyeDist;
+	double nearZ = 1e-3*radius;
+
+	m_bufWidth = m_width * m_superSample;
+	m_bufHeight = m_height * m_superSample;
+	double focal = 0.5*std::min(m_bufWidth, m_bufHeight) / halfTan;
+
+	m_depthBuffer.assign(m_bufWidth * m_bufHeight, 0.0f);
+	m_colorBuffer.assign(m_bufWidth * m_bufHeight, m_bgColor.rgb());
+
+	std::vector<MathLib::Vector3> worldVerts;
+	std::vector<double> screenVerts;  // 3 doubles per vertex: pixel x, pixel y, 1/z
+
+	for (int i = 0; i < models.size(); i++)
+	{
+		CMesh *mesh = models[i]->getMesh();
+		const std::vector<MathLib::Vector3> &verts = mesh->getAsset()->m_vertices;
+		const std::vector<std::vector<int>> &faces = mesh->getFaces();
+		const MathLib::Matrix4d &transMat = mesh->getTransMat();
+		QColor c = models[i]->getMeshColor();
+
+		// transform from the shared asset, world vertices of the instance are not materialized
+		worldVerts.resize(verts.size());
+		screenVerts.resize(3 * verts.size());
+
+		for (int v = 0; v < verts.size(); v++)
+		{
+			worldVerts[v] = transMat.transform(verts[v]);
+
+			MathLib::Vector3 p = worldVerts[v] - eye;
+			double z = std::max(p.dot(forward), nearZ);
+
+			screenVerts[3 * v] = 0.5*m_bufWidth + focal*p.dot(right) / z;
+			screenVerts[3 * v + 1] = 0.5*m_bufHeight - focal*p.dot(up) / z;
+			screenVerts[3 * v + 2] = 1.0 / z;
+		}
+
+		for (int f = 0; f < faces.size(); f++)
+		{
+			const std::vector<int> &face = faces[f];
+
+			// flat two-sided shading with the light at the camera
+			MathLib::Vector3 n = (worldVerts[face[1]] - worldVerts[face[0]]).cross(worldVerts[face[2]] - worldVerts[face[0]]);
+			double nLen = n.magnitude();
+			if (nLen == 0)
+			{
+				continue;
+			}
+
+			double shade = RasterAmbient + (1 - RasterAmbient)*MathLib::Abs(n.dot(forward)) / nLen;
+			QRgb faceColor = qRgb((int)(c.red()*shade), (int)(c.green()*shade), (int)(c.blue()*shade));
+
+			rasterizeTriangle(&screenVerts[3 * face[0]], &screenVerts[3 * face[1]], &screenVerts[3 * face[2]], faceColor);
+		}
+	}
+
+	QImage bufImage(m_bufWidth, m_bufHeight, QImage::Format_RGB32);
+	for (int y = 0; y < m_bufHeight; y++)
+	{
+		memcpy(bufImage.scanLine(y), &m_colorBuffer[y * m_bufWidth], m_bufWidth * sizeof(QRgb));
+	}
+
+	if (m_superSample > 1)
+	{
+		image = bufImage.scaled(m_width, m_height, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+	}
+	else
+	{
+		image = bufImage;
+	}
+
+	return true;
+}
+
+void CSceneRasterizer::rasterizeTriangle(const double *p0, const double *p1, const double *p2, QRgb color)
+{
+	double area = (p1[0] - p0[0])*(p2[1] - p0[1]) - (p1[1] - p0[1])*(p2[0] - p0[0]);
+	if (area == 0)
+	{
+		return;
+	}
+
+	int minX = std::max(0, (int)std::floor(std::min(p0[0], std::min(p1[0], p2[0]))));
+	int maxX = std::min(m_bufWidth - 1, (int)std::ceil(std::max(p0[0], std::max(p1[0], p2[0]))));
+	int minY = std::max(0, (int)std::floor(std::min(p0[1], std::min(p1[1], p2[1]))));
+	int maxY = std::min(m_bufHeight - 1, (int)std::ceil(std::max(p0[1], std::max(p1[1], p2[1]))));
+
+	double invArea = 1.0 / area;
+
+	for (int y = minY; y <= maxY; y++)
+	{
+		double py = y + 0.5;
+
+		for (int x = minX; x <= maxX; x++)
+		{
+			double px = x + 0.5;
+
+			// barycentric weights from edge functions, same sign as area inside the triangle
+			double w0 = ((p1[0] - px)*(p2[1] - py) - (p1[1] - py)*(p2[0] - px)) * invArea;
+			double w1 = ((p2[0] - px)*(p0[1] - py) - (p2[1] - py)*(p0[0] - px)) * invArea;
+			double w2 = 1.0 - w0 - w1;
+
+			if (w0 < 0 || w1 < 0 || w2 < 0)
+			{
+				continue;
+			}
+
+			// 1/z is linear in screen space
+			float invZ = w0*p0[2] + w1*p1[2] + w2*p2[2];
+
+			int pixelId = y * m_bufWidth + x;
+			if (invZ > m_depthBuffer[pixelId])
+			{
+				m_depthBuffer[pixelId] = invZ;
+				m_colorBuffer[pixelId] = color;
+			}
+		}
+	}
+}
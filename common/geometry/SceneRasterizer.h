@@ -0,0 +1,52 @@
+#pragma once
+
+#include "../utilities/mathlib.h"
+#include <QString>
+#include <QStringList>
+#include <QColor>
+#include <QImage>
+#include <vector>
+#include <algorithm>
+
+class CScene;
+
+// software z-buffer renderer for scene previews, needs no window or GL context
+// models are drawn flat shaded in their mesh colors with a light at the camera; each thread should use its own renderer
+
+class CSceneRasterizer
+{
+public:
+	// camera looking along viewDir and framing the whole scene, up is the scene upright
+	struct CameraPreset
+	{
+		QString name;
+		MathLib::Vector3 viewDir;
+		double fieldOfView;  // degrees, along the shorter image side
+	};
+
+	CSceneRasterizer(int width = 640, int height = 480, int superSample = 2);
+	~CSceneRasterizer();
+
+	void setSize(int width, int height) { m_width = width; m_height = height; };
+	void setSuperSample(int s) { m_superSample = std::max(1, s); };  // pixels rendered per image pixel along each side
+	void setBackgroundColor(const QColor &c) { m_bgColor = c; };
+
+	// iso (view of the interactive screenshot), top, front, side
+	static bool getCameraPreset(const QString &name, CameraPreset &preset);
+	static QStringList getCameraPresetNames();
+
+	// render visible models of the scene; false if no model has faces
+	bool render(CScene *scene, const CameraPreset &camera, QImage &image);
+
+private:
+	void rasterizeTriangle(const double *p0, const double *p1, const double *p2, QRgb color);
+
+	int m_width, m_height;
+	int m_superSample;
+	QColor m_bgColor;
+
+	// buffers of the current render at supersampled size
+	int m_bufWidth, m_bufHeight;
+	std::vector<float> m_depthBuffer;  // 1/z, 0 where nothing is drawn
+	std::vector<QRgb> m_colorBuffer;
+};
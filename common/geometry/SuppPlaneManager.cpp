@@ -615,7 +615,7 @@ void SuppPlaneManager::saveSuppPlane()
 
 	if (!suppFile.open(QIODevice::ReadWrite | QIODevice::Text | QIODevice::Truncate))
 	{
-		std::cout << "\t cannot save to file " << suppPlaneFilename.toStdString() << "\n";
+		ThreadLog() << "\t cannot save to file " << suppPlaneFilename.toStdString() << "\n";
 		return;
 	};
 
@@ -631,7 +631,7 @@ void SuppPlaneManager::saveSuppPlane()
 
 	suppFile.close();
 
-	std::cout << "\t support plane saved to " << suppPlaneFilename.toStdString() << "\n";
+	ThreadLog() << "\t support plane saved to " << suppPlaneFilename.toStdString() << "\n";
 }
 
 bool SuppPlaneManager::loadSuppPlane()
@@ -1,5 +1,6 @@
 #include "UDGraph.h"
 #include <fstream>
+#include <algorithm>
 
 //#include <boost/graph/adjacency_list.hpp>
 //#include <boost/graph/connected_components.hpp>
@@ -17,6 +18,8 @@ void CUDGraph::Clear(void)
 {
 	m_V.clear();
 	m_E.clear();
+	m_adjEdges.clear();
+	m_edgeIds.clear();
 }
 
 void CUDGraph::Initialize(int iNumV)
@@ -28,102 +31,80 @@ void CUDGraph::Initialize(int iNumV)
 void CUDGraph::SetV(int iNumV)
 {
 	m_V.resize(iNumV);
+	if (m_adjEdges.size() < iNumV) {
+		m_adjEdges.resize(iNumV);
+	}
 }
 
-int CUDGraph::InsertEdge(int ev1, int ev2)
+unsigned long long CUDGraph::EdgeKey(int ev1, int ev2)
 {
-	if (ev1 == ev2) {
-		return -1;
-	}
-	//else if (ev1 > ev2) {
-	//	std::swap(ev1, ev2);
-	//}
-	Edge e(ev1, ev2);
-	if (std::find(m_E.begin(), m_E.end(), e) == m_E.end()) {
-		m_E.push_back(e);
-		// 		m_dMaxW = std::max(m_dMaxW, e.w);
-		// 		m_dMinW = std::min(m_dMinW, e.w);
-		return 0;
-	}
-	else {
-		return -1;
+	if (ev1 > ev2) {
+		std::swap(ev1, ev2);
 	}
+	return ((unsigned long long)(unsigned int)ev1 << 32) | (unsigned int)ev2;
 }
 
-int CUDGraph::InsertEdge(int ev1, int ev2, double ew)
+int CUDGraph::AddEdge(const Edge &e)
 {
-	if (ev1 == ev2) {
+	if (e.v1 == e.v2 || e.v1 < 0 || e.v2 < 0) {
 		return -1;
 	}
-	//else if (ev1 > ev2) {
-	//	std::swap(ev1, ev2);
-	//}
-	Edge e(ev1, ev2, ew);
-	std::vector<Edge>::iterator it;
-	if ((it = std::find(m_E.begin(), m_E.end(), e)) == m_E.end()) { // if not found
-		m_E.push_back(e);
-		return 0;
-	}
-	else { // if already exist
+
+	int eid = m_E.size();
+	if (!m_edgeIds.insert(std::make_pair(EdgeKey(e.v1, e.v2), eid)).second) { // if already exist
 		return -1;
 	}
+
+	m_E.push_back(e);
+
+	// edges may be read before their vertices
+	int maxV = std::max(e.v1, e.v2);
+	if (m_adjEdges.size() <= maxV) {
+		m_adjEdges.resize(maxV + 1);
+	}
+	m_adjEdges[e.v1].push_back(eid);
+	m_adjEdges[e.v2].push_back(eid);
+
+	return 0;
 }
 
-int CUDGraph::InsertEdge(int ev1, int ev2, int tag, int dir)
+void CUDGraph::RebuildEdgeIndex(void)
 {
-	if (ev1 == ev2) {
-		return -1;
-	}
-	//else if (ev1 > ev2) {
-	//	std::swap(ev1, ev2);
-	//}
-	Edge e(ev1, ev2, tag, dir);
-	std::vector<Edge>::iterator it;
-	if ((it = std::find(m_E.begin(), m_E.end(), e)) == m_E.end()) { // if not found
-		m_E.push_back(e);
-		return 0;
+	m_edgeIds.clear();
+	for (unsigned int i = 0; i < m_adjEdges.size(); i++) {
+		m_adjEdges[i].clear();
 	}
-	else { // if already exist
-		return -1;
+
+	for (unsigned int i = 0; i < m_E.size(); i++) {
+		m_edgeIds[EdgeKey(m_E[i].v1, m_E[i].v2)] = i;
+		m_adjEdges[m_E[i].v1].push_back(i);
+		m_adjEdges[m_E[i].v2].push_back(i);
 	}
 }
 
+int CUDGraph::InsertEdge(int ev1, int ev2)
+{
+	return AddEdge(Edge(ev1, ev2));
+}
+
+int CUDGraph::InsertEdge(int ev1, int ev2, double ew)
+{
+	return AddEdge(Edge(ev1, ev2, ew));
+}
+
+int CUDGraph::InsertEdge(int ev1, int ev2, int tag, int dir)
+{
+	return AddEdge(Edge(ev1, ev2, tag, dir));
+}
+
 int CUDGraph::InsertEdge(int ev1, int ev2, int tag)
 {
-	if (ev1 == ev2) {
-		return -1;
-	}
-	//else if (ev1 > ev2) {
-	//	std::swap(ev1, ev2);
-	//}
-	Edge e(ev1, ev2, tag);
-	std::vector<Edge>::iterator it;
-	if ((it = std::find(m_E.begin(), m_E.end(), e)) == m_E.end()) { // if not found
-		m_E.push_back(e);
-		return 0;
-	}
-	else { // if already exist
-		return -1;
-	}
+	return AddEdge(Edge(ev1, ev2, tag));
 }
 
 int CUDGraph::InsertEdge(int ev1, int ev2, int tag, double ew)
 {
-	if (ev1 == ev2) {
-		return -1;
-	}
-	//else if (ev1 > ev2) {
-	//	std::swap(ev1, ev2);
-	//}
-	Edge e(ev1, ev2, tag, ew);
-	std::vector<Edge>::iterator it;
-	if ((it = std::find(m_E.begin(), m_E.end(), e)) == m_E.end()) { // if not found
-		m_E.push_back(e);
-		return 0;
-	}
-	else { // if already exist
-		return -1;
-	}
+	return AddEdge(Edge(ev1, ev2, tag, ew));
 }
 
 int CUDGraph::DeleteEdge(int eid)
@@ -131,17 +112,17 @@ int CUDGraph::DeleteEdge(int eid)
 	if (eid < 0 || eid >= m_E.size()) {
 		return -1;
 	}
+	// later edge ids shift down, as callers index m_E directly
 	m_E.erase(m_E.begin() + eid);
+	RebuildEdgeIndex();
 	return 0;
 }
 
 int CUDGraph::DeleteEdge(int ev1, int ev2)
 {
-	Edge e(ev1, ev2);
-	std::vector<Edge>::iterator it;
-	if ((it = std::find(m_E.begin(), m_E.end(), e)) != m_E.end()) { // if found
-		m_E.erase(it);
-		return 0;
+	int eid = GetEdgeId(ev1, ev2);
+	if (eid != -1) { // if found
+		return DeleteEdge(eid);
 	}
 	return 1;
 }
@@ -149,24 +130,30 @@ int CUDGraph::DeleteEdge(int ev1, int ev2)
 int CUDGraph::InsertNode(int tag, double weight)
 {
 	m_V.push_back(Vertex(tag, weight));
+	if (m_adjEdges.size() < m_V.size()) {
+		m_adjEdges.resize(m_V.size());
+	}
 	return 0;
 }
 
 int CUDGraph::InsertNode(int tag)
 {
-	m_V.push_back(Vertex(tag));
-	return 0;
+	return InsertNode(tag, 0.0);
 }
 
 bool CUDGraph::IsEdge(int ev1, int ev2)
 {
-	return (std::find(m_E.begin(), m_E.end(), Edge(ev1, ev2)) != m_E.end());
+	return GetEdgeId(ev1, ev2) != -1;
 }
 
 bool CUDGraph::HasEdge(int ev1, int tag)
 {
-	for (unsigned int i = 0; i < m_E.size(); i++) {
-		if (m_E[i].t == tag && (m_E[i][0] == ev1 || m_E[i][1] == ev1)) {
+	if (ev1 < 0 || ev1 >= (int)m_adjEdges.size()) {
+		return false;
+	}
+	const std::vector<int> &adj = m_adjEdges[ev1];
+	for (unsigned int i = 0; i < adj.size(); i++) {
+		if (m_E[adj[i]].t == tag) {
 			return true;
 		}
 	}
@@ -218,10 +205,9 @@ void CUDGraph::WriteVert(std::ofstream &ofs)
 
 int CUDGraph::SetEdgeTag(int ev1, int ev2, int tag)
 {
-	Edge e(ev1, ev2);
-	std::vector<Edge>::iterator it;
-	if ((it = std::find(m_E.begin(), m_E.end(), e)) != m_E.end()) { // if found
-		it->t = tag;
+	int eid = GetEdgeId(ev1, ev2);
+	if (eid != -1) { // if found
+		m_E[eid].t = tag;
 		return 0;
 	}
 	return -1;
@@ -246,30 +232,27 @@ CUDGraph::Edge* CUDGraph::GetEdge(int i)
 
 CUDGraph::Edge* CUDGraph::GetEdge(int ev1, int ev2)
 {
-	Edge e(ev1, ev2);
-	std::vector<Edge>::iterator it;
-	if ((it = std::find(m_E.begin(), m_E.end(), e)) != m_E.end()) {
-		return &(*it);
+	int eid = GetEdgeId(ev1, ev2);
+	if (eid != -1) {
+		return &m_E[eid];
 	}
 	return NULL;
 }
 
 int CUDGraph::GetEdgeId(int ev1, int ev2) const
 {
-	for (unsigned int i = 0; i < m_E.size(); i++) {
-		if ((m_E[i].v1 == ev1&&m_E[i].v2 == ev2) || (m_E[i].v1 == ev2&&m_E[i].v2 == ev1)) {
-			return i;
-		}
+	std::unordered_map<unsigned long long, int>::const_iterator it = m_edgeIds.find(EdgeKey(ev1, ev2));
+	if (it != m_edgeIds.end()) {
+		return it->second;
 	}
 	return -1;
 }
 
 int CUDGraph::GetEdgeTag(int ev1, int ev2) const
 {
-	Edge e(ev1, ev2);
-	std::vector<Edge>::const_iterator it;
-	if ((it = std::find(m_E.begin(), m_E.end(), e)) != m_E.end()) { // if found
-		return it->t;
+	int eid = GetEdgeId(ev1, ev2);
+	if (eid != -1) { // if found
+		return m_E[eid].t;
 	}
 	return -1;
 }
@@ -285,26 +268,21 @@ int CUDGraph::GetEdgeTag(int eid) const
 void CUDGraph::GetAllNeigborEdgeList(int ev1, std::vector<int> &el) const
 {
 	el.clear();
-	for (unsigned int i = 0; i < m_E.size(); i++) {
-		if (m_E[i][0] == ev1) {
-			el.push_back(i);
-		}
-		else if (m_E[i][1] == ev1) {
-			el.push_back(i);
-		}
+	if (ev1 >= 0 && ev1 < (int)m_adjEdges.size()) {
+		el = m_adjEdges[ev1];
 	}
 }
 
 void CUDGraph::GetAllNeigborEdgeList(int ev1, int tag, std::vector<int> &el) const
 {
 	el.clear();
-	for (unsigned int i = 0; i < m_E.size(); i++) {
-		if (m_E[i].t != tag) { continue; }
-		if (m_E[i][0] == ev1) {
-			el.push_back(i);
-		}
-		else if (m_E[i][1] == ev1) {
-			el.push_back(i);
+	if (ev1 < 0 || ev1 >= (int)m_adjEdges.size()) {
+		return;
+	}
+	const std::vector<int> &adj = m_adjEdges[ev1];
+	for (unsigned int i = 0; i < adj.size(); i++) {
+		if (m_E[adj[i]].t == tag) {
+			el.push_back(adj[i]);
 		}
 	}
 }
@@ -318,12 +296,13 @@ void CUDGraph::GetAllNeigborEdgeList(const std::vector<int> &evl, std::vector<in
 		vmap[evl[ev]] = 1;
 	}
 	for (unsigned int ev = 0; ev < evl.size(); ev++) {
-		for (unsigned int i = 0; i < m_E.size(); i++) {
-			if (m_E[i][0] == evl[ev] && vmap[m_E[i][1]] == 0) { // find an outgoing edge
-				el.push_back(i);
-			}
-			else if (m_E[i][1] == evl[ev] && vmap[m_E[i][0]] == 0) { // find an outgoing edge
-				el.push_back(i);
+		if (evl[ev] >= (int)m_adjEdges.size()) { continue; }
+		const std::vector<int> &adj = m_adjEdges[evl[ev]];
+		for (unsigned int i = 0; i < adj.size(); i++) {
+			const Edge &e = m_E[adj[i]];
+			int other = (e.v1 == evl[ev]) ? e.v2 : e.v1;
+			if (vmap[other] == 0) { // find an outgoing edge
+				el.push_back(adj[i]);
 			}
 		}
 	}
@@ -338,13 +317,14 @@ void CUDGraph::GetAllNeigborEdgeList(const std::vector<int> &evl, int tag, std::
 		vmap[evl[ev]] = 1;
 	}
 	for (unsigned int ev = 0; ev < evl.size(); ev++) {
-		for (unsigned int i = 0; i < m_E.size(); i++) {
-			if (m_E[i].t != tag) { continue; }
-			if (m_E[i][0] == evl[ev] && vmap[m_E[i][1]] == 0) { // find an outgoing edge
-				el.push_back(i);
-			}
-			else if (m_E[i][1] == evl[ev] && vmap[m_E[i][0]] == 0) { // find an outgoing edge
-				el.push_back(i);
+		if (evl[ev] >= (int)m_adjEdges.size()) { continue; }
+		const std::vector<int> &adj = m_adjEdges[evl[ev]];
+		for (unsigned int i = 0; i < adj.size(); i++) {
+			const Edge &e = m_E[adj[i]];
+			if (e.t != tag) { continue; }
+			int other = (e.v1 == evl[ev]) ? e.v2 : e.v1;
+			if (vmap[other] == 0) { // find an outgoing edge
+				el.push_back(adj[i]);
 			}
 		}
 	}
@@ -1,5 +1,6 @@
 #pragma once
 #include <vector>
+#include <unordered_map>
 
 #define MAX_STR_BUF_SIZE	1024
 
@@ -70,7 +71,7 @@ public:
 	int SetEdgeTag(int eid, int tag);
 
 	Edge* GetEdge(int i);
-	Edge* GetEdge(int ev1, int ev2);
+	Edge* GetEdge(int ev1, int ev2);  // do not change end vertices through the returned edge, the edge index keeps them
 	int GetEdgeId(int ev1, int ev2) const;
 	int GetEdgeTag(int ev1, int ev2) const;
 	int GetEdgeTag(int eid) const;
@@ -90,7 +91,15 @@ public:
 
 
 protected:
+	int AddEdge(const Edge &e);
+	void RebuildEdgeIndex(void);
+	static unsigned long long EdgeKey(int ev1, int ev2);
+
 	std::vector<Vertex>				m_V;
 	std::vector<Edge>				m_E;
+
+	// edge index, kept in sync with m_E by InsertEdge and DeleteEdge
+	std::vector<std::vector<int>>	m_adjEdges;	// edge ids of each vertex, ascending
+	std::unordered_map<unsigned long long, int>	m_edgeIds;	// packed (min, max) vertex pair to edge id
 };
 
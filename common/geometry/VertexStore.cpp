@@ -0,0 +1,238 @@
+#include "VertexStore.h"
+#include "../utilities/utility.h"
+#include <algorithm>
+
+// double precision mul/add/min/max only need AVX; the kernel is compiled for it and picked at run time,
+// so the library itself does not require an /arch switch
+#if defined(_M_X64) || defined(__x86_64__)
+#define VERTEX_STORE_SIMD
+#if defined(_MSC_VER)
+#include <intrin.h>
+#include <immintrin.h>
+#define VERTEX_STORE_SIMD_TARGET
+#else
+#include <immintrin.h>
+#include <cpuid.h>
+#define VERTEX_STORE_SIMD_TARGET __attribute__((target("avx")))
+#endif
+#endif
+
+static bool DetectSIMDSupport()
+{
+#ifdef VERTEX_STORE_SIMD
+	unsigned int ecx = 0;
+
+#if defined(_MSC_VER)
+	int cpuInfo[4];
+	__cpuid(cpuInfo, 1);
+	ecx = cpuInfo[2];
+#else
+	unsigned int eax, ebx, edx;
+	if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx))
+	{
+		return false;
+	}
+#endif
+
+	bool hasOSXSave = (ecx & (1 << 27)) != 0;
+	bool hasAVX = (ecx & (1 << 28)) != 0;
+
+	if (!hasOSXSave || !hasAVX)
+	{
+		return false;
+	}
+
+	// os must save the ymm registers
+#if defined(_MSC_VER)
+	unsigned long long xcr0 = _xgetbv(0);
+#else
+	unsigned int xcrLo, xcrHi;
+	__asm__("xgetbv" : "=a"(xcrLo), "=d"(xcrHi) : "c"(0));
+	unsigned long long xcr0 = ((unsigned long long)xcrHi << 32) | xcrLo;
+#endif
+
+	return (xcr0 & 6) == 6;
+#else
+	return false;
+#endif
+}
+
+CVertexStore::CVertexStore()
+{
+}
+
+CVertexStore::~CVertexStore()
+{
+}
+
+bool CVertexStore::isSIMDSupported()
+{
+	static const bool isSupported = DetectSIMDSupport();
+	return isSupported;
+}
+
+void CVertexStore::build(const std::vector<MathLib::Vector3> &verts)
+{
+	int vertNum = verts.size();
+
+	m_x.resize(vertNum);
+	m_y.resize(vertNum);
+	m_z.resize(vertNum);
+
+	for (int i = 0; i < vertNum; i++)
+	{
+		m_x[i] = verts[i].x;
+		m_y[i] = verts[i].y;
+		m_z[i] = verts[i].z;
+	}
+}
+
+void CVertexStore::clear()
+{
+	std::vector<double>().swap(m_x);
+	std::vector<double>().swap(m_y);
+	std::vector<double>().swap(m_z);
+}
+
+void CVertexStore::computeMinMax(MathLib::Vector3 &minVert, MathLib::Vector3 &maxVert) const
+{
+	MathLib::Matrix4d identityMat;
+	identityMat.setidentity();
+
+	transformMinMax(identityMat, minVert, maxVert);
+}
+
+void CVertexStore::transformMinMax(const MathLib::Matrix4d &transMat, MathLib::Vector3 &minVert, MathLib::Vector3 &maxVert,
+	std::vector<MathLib::Vector3> *outVerts /*= NULL*/) const
+{
+	double minV[3] = { MAX_VALUE, MAX_VALUE, MAX_VALUE };
+	double maxV[3] = { -MAX_VALUE, -MAX_VALUE, -MAX_VALUE };
+
+	MathLib::Vector3 *outPtr = NULL;
+	if (outVerts != NULL)
+	{
+		outVerts->resize(size());
+		outPtr = outVerts->data();
+	}
+
+	if (isSIMDSupported())
+	{
+		transformMinMaxSIMD(transMat.M, minV, maxV, outPtr);
+	}
+	else
+	{
+		transformMinMaxScalar(0, size(), transMat.M, minV, maxV, outPtr);
+	}
+
+	minVert = MathLib::Vector3(minV);
+	maxVert = MathLib::Vector3(maxV);
+}
+
+void CVertexStore::transformMinMaxScalar(int start, int end, const double *M, double *minV, double *maxV, MathLib::Vector3 *outVerts) const
+{
+	for (int i = start; i < end; i++)
+	{
+		double x = m_x[i], y = m_y[i], z = m_z[i];
+
+		double w[3];
+		w[0] = x * M[0] + y * M[4] + z * M[8] + M[12];
+		w[1] = x * M[1] + y * M[5] + z * M[9] + M[13];
+		w[2] = x * M[2] + y * M[6] + z * M[10] + M[14];
+
+		for (int d = 0; d < 3; d++)
+		{
+			if (w[d] < minV[d]) minV[d] = w[d];
+			if (w[d] > maxV[d]) maxV[d] = w[d];
+		}
+
+		if (outVerts != NULL)
+		{
+			outVerts[i] = MathLib::Vector3(w[0], w[1], w[2]);
+		}
+	}
+}
+
+#ifdef VERTEX_STORE_SIMD
+
+VERTEX_STORE_SIMD_TARGET
+static void TransformMinMaxAVX(const double *xs, const double *ys, const double *zs, int count, const double *M,
+	double *minV, double *maxV, MathLib::Vector3 *outVerts)
+{
+	__m256d m[12];
+	for (int r = 0; r < 3; r++)
+	{
+		m[4 * r + 0] = _mm256_set1_pd(M[r]);
+		m[4 * r + 1] = _mm256_set1_pd(M[4 + r]);
+		m[4 * r + 2] = _mm256_set1_pd(M[8 + r]);
+		m[4 * r + 3] = _mm256_set1_pd(M[12 + r]);
+	}
+
+	__m256d minW[3], maxW[3];
+	for (int d = 0; d < 3; d++)
+	{
+		minW[d] = _mm256_set1_pd(minV[d]);
+		maxW[d] = _mm256_set1_pd(maxV[d]);
+	}
+
+	for (int i = 0; i < count; i += 4)
+	{
+		__m256d x = _mm256_loadu_pd(xs + i);
+		__m256d y = _mm256_loadu_pd(ys + i);
+		__m256d z = _mm256_loadu_pd(zs + i);
+
+		__m256d w[3];
+		for (int d = 0; d < 3; d++)
+		{
+			// same order as Matrix4d::transform, ((x*m0 + y*m1) + z*m2) + m3, no fused multiply-add
+			w[d] = _mm256_add_pd(_mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(x, m[4 * d]), _mm256_mul_pd(y, m[4 * d + 1])),
+				_mm256_mul_pd(z, m[4 * d + 2])), m[4 * d + 3]);
+
+			// keeps the old bound when w is NaN, like the scalar comparisons
+			minW[d] = _mm256_min_pd(w[d], minW[d]);
+			maxW[d] = _mm256_max_pd(w[d], maxW[d]);
+		}
+
+		if (outVerts != NULL)
+		{
+			double wx[4], wy[4], wz[4];
+			_mm256_storeu_pd(wx, w[0]);
+			_mm256_storeu_pd(wy, w[1]);
+			_mm256_storeu_pd(wz, w[2]);
+
+			for (int k = 0; k < 4; k++)
+			{
+				outVerts[i + k] = MathLib::Vector3(wx[k], wy[k], wz[k]);
+			}
+		}
+	}
+
+	for (int d = 0; d < 3; d++)
+	{
+		double lanes[4];
+
+		_mm256_storeu_pd(lanes, minW[d]);
+		minV[d] = std::min(std::min(lanes[0], lanes[1]), std::min(lanes[2], lanes[3]));
+
+		_mm256_storeu_pd(lanes, maxW[d]);
+		maxV[d] = std::max(std::max(lanes[0], lanes[1]), std::max(lanes[2], lanes[3]));
+	}
+}
+
+#endif
+
+void CVertexStore::transformMinMaxSIMD(const double *M, double *minV, double *maxV, MathLib::Vector3 *outVerts) const
+{
+#ifdef VERTEX_STORE_SIMD
+	int vertNum = size();
+	int simdNum = vertNum - vertNum % 4;
+
+	if (simdNum > 0)
+	{
+		TransformMinMaxAVX(m_x.data(), m_y.data(), m_z.data(), simdNum, M, minV, maxV, outVerts);
+	}
+
+	transformMinMaxScalar(simdNum, vertNum, M, minV, maxV, outVerts);
+#else
+	transformMinMaxScalar(0, size(), M, minV, maxV, outVerts);
+#endif
+}
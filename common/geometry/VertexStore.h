@@ -0,0 +1,37 @@
+#pragma once
+
+#include "../utilities/mathlib.h"
+#include <vector>
+
+// structure of arrays copy of mesh vertices, used to transform a whole mesh and reduce its bounds in one pass
+// the kernel keeps double precision and the operation order of Matrix4d::transform, so results match it exactly
+
+class CVertexStore
+{
+public:
+	CVertexStore();
+	~CVertexStore();
+
+	void build(const std::vector<MathLib::Vector3> &verts);
+	void clear();
+
+	int size() const { return m_x.size(); };
+
+	// bounds of the stored vertices
+	void computeMinMax(MathLib::Vector3 &minVert, MathLib::Vector3 &maxVert) const;
+
+	// bounds of the vertices transformed by transMat; outVerts, if given, receives the transformed vertices
+	void transformMinMax(const MathLib::Matrix4d &transMat, MathLib::Vector3 &minVert, MathLib::Vector3 &maxVert,
+		std::vector<MathLib::Vector3> *outVerts = NULL) const;
+
+	// cpu and os support for the vectorized kernel, checked once
+	static bool isSIMDSupported();
+
+private:
+	void transformMinMaxScalar(int start, int end, const double *M, double *minV, double *maxV, MathLib::Vector3 *outVerts) const;
+	void transformMinMaxSIMD(const double *M, double *minV, double *maxV, MathLib::Vector3 *outVerts) const;
+
+	std::vector<double> m_x;
+	std::vector<double> m_y;
+	std::vector<double> m_z;
+};
@@ -9,6 +9,7 @@
 
 #include <fstream>
 #include <sstream>
+#include <iostream>
 #include "mathlib.h"
 #include "qglviewer/quaternion.h"
 #include <QQuaternion>
@@ -38,6 +39,33 @@ const double ML_PI_4 = 0.785398163397448279;
 		ptr = NULL; \
 			}
 
+// log of the calling thread, std::cout unless redirected
+// batch workers redirect it to the log of their current task, so messages of concurrently loaded scenes do not interleave
+inline std::ostream*& ThreadLogSlot()
+{
+	static thread_local std::ostream *logStream = NULL;
+	return logStream;
+}
+
+inline std::ostream& ThreadLog()
+{
+	std::ostream *logStream = ThreadLogSlot();
+	return logStream ? *logStream : std::cout;
+}
+
+inline void SetThreadLog(std::ostream *logStream) { ThreadLogSlot() = logStream; }
+inline bool IsThreadLogRedirected() { return ThreadLogSlot() != NULL; }
+
+// batch workers already keep every core busy, so code running on them should not start threads of its own
+inline bool& BatchWorkerThreadSlot()
+{
+	static thread_local bool isBatchWorker = false;
+	return isBatchWorker;
+}
+
+inline void SetBatchWorkerThread(bool isBatchWorker) { BatchWorkerThreadSlot() = isBatchWorker; }
+inline bool IsBatchWorkerThread() { return BatchWorkerThreadSlot(); }
+
 const int ColorNum = 16;
 
 const int ColorSet[16][3] = {
@@ -0,0 +1,332 @@
+#include "GMMFitter.h"
+#include <algorithm>
+
+const double GMMLogTwoPi = 1.8378770664093453;
+
+GMMFitter::GMMFitter(unsigned int seed)
+	:m_rng(seed)
+{
+	// same settings as fitGMMWithAIC.m
+	double mToInch = 1 / 0.0254;
+	m_jitterNum = 20;
+	m_jitterPosVar = 0.05*mToInch;  // 5cm
+	m_jitterDirVar = 5 * MathLib::ML_PI / 180;
+	m_regValue = 0.1;
+	m_maxIter = 500;
+	m_tolFun = 1e-6;
+
+	m_probPercents.push_back(20);
+	m_probPercents.push_back(50);
+	m_probPercents.push_back(80);
+}
+
+GMMFitter::~GMMFitter()
+{
+}
+
+GaussianMixtureModel* GMMFitter::fitWithAIC(const Eigen::MatrixXd &observations, const Eigen::MatrixXd &alignMats, int maxK)
+{
+	int dim = observations.rows();
+
+	// each row is an observation
+	Eigen::MatrixXd X;
+	if (alignMats.cols() == observations.cols())
+	{
+		X = jitterObservations(observations, alignMats);
+	}
+	else
+	{
+		X = observations.transpose();
+	}
+
+	// keep the fit with smallest AIC among the successful ones
+	GMMFit bestFit;
+	double minAIC = 0;
+	int numComp = 0;
+
+	for (int k = 1; k <= maxK; k++)
+	{
+		GMMFit fit;
+		if (!fitEM(X, k, fit))
+		{
+			continue;
+		}
+
+		int paraNum = k*dim + k*dim*(dim + 1) / 2 + (k - 1);
+		double aic = -2 * fit.logLikelihood + 2 * paraNum;
+
+		if (numComp == 0 || aic < minAIC)
+		{
+			minAIC = aic;
+			numComp = k;
+			bestFit = fit;
+		}
+	}
+
+	if (numComp == 0)
+	{
+		return NULL;
+	}
+
+	GaussianMixtureModel *gmm = new GaussianMixtureModel(numComp);
+	for (int i = 0; i < numComp; i++)
+	{
+		Eigen::VectorXd mean = bestFit.means.row(i).transpose();
+		gmm->m_gaussians[i] = new GaussianModel(dim, bestFit.weights[i], mean, bestFit.covars[i]);
+	}
+
+	// pdf percentiles of the original observations
+	Eigen::MatrixXd logProbs;
+	Eigen::MatrixXd origX = observations.transpose();
+	computeLogComponentProbs(origX, bestFit, logProbs);
+
+	std::vector<double> probs(origX.rows());
+	for (int i = 0; i < origX.rows(); i++)
+	{
+		probs[i] = logProbs.row(i).array().exp().sum();
+	}
+
+	gmm->m_probTh.resize(m_probPercents.size());
+	for (int i = 0; i < m_probPercents.size(); i++)
+	{
+		gmm->m_probTh[i] = computePercentile(probs, m_probPercents[i]);
+	}
+
+	return gmm;
+}
+
+Eigen::MatrixXd GMMFitter::jitterObservations(const Eigen::MatrixXd &observations, const Eigen::MatrixXd &alignMats)
+{
+	int dim = observations.rows();
+	int instNum = observations.cols();
+
+	std::normal_distribution<double> posDist(0, sqrt(m_jitterPosVar));
+	std::normal_distribution<double> dirDist(0, sqrt(m_jitterDirVar));
+
+	Eigen::MatrixXd X(m_jitterNum*instNum, dim);
+
+	for (int i = 0; i < instNum; i++)
+	{
+		// rotation part of the align matrix, translation is ignored
+		Eigen::Matrix3d alignRot;
+		for (int r = 0; r < 3; r++)
+		{
+			for (int c = 0; c < 3; c++)
+			{
+				alignRot(r, c) = alignMats(r + 4 * c, i);
+			}
+		}
+
+		for (int j = 0; j < m_jitterNum; j++)
+		{
+			Eigen::Vector3d jitPos(posDist(m_rng), posDist(m_rng), posDist(m_rng));
+			jitPos = alignRot*jitPos;
+
+			int row = i*m_jitterNum + j;
+			X.row(row) = observations.col(i).transpose();
+			X(row, 0) += jitPos[0];
+			X(row, 1) += jitPos[1];
+			X(row, 2) += jitPos[2];
+
+			if (dim > 3)
+			{
+				X(row, 3) += dirDist(m_rng);
+			}
+		}
+	}
+
+	return X;
+}
+
+void GMMFitter::initKMeansPlusPlus(const Eigen::MatrixXd &X, int k, GMMFit &fit)
+{
+	int n = X.rows();
+	int dim = X.cols();
+
+	// means picked by k-means++ seeding
+	fit.means.resize(k, dim);
+
+	std::uniform_int_distribution<int> firstDist(0, n - 1);
+	fit.means.row(0) = X.row(firstDist(m_rng));
+
+	Eigen::VectorXd minSqDists = (X.rowwise() - fit.means.row(0)).rowwise().squaredNorm();
+
+	for (int c = 1; c < k; c++)
+	{
+		int pickId = n - 1;
+		double distSum = minSqDists.sum();
+
+		if (distSum > 0)
+		{
+			std::uniform_real_distribution<double> pickDist(0, distSum);
+			double pickVal = pickDist(m_rng);
+
+			for (int i = 0; i < n; i++)
+			{
+				pickVal -= minSqDists[i];
+				if (pickVal <= 0)
+				{
+					pickId = i;
+					break;
+				}
+			}
+		}
+		else
+		{
+			pickId = firstDist(m_rng);
+		}
+
+		fit.means.row(c) = X.row(pickId);
+		minSqDists = minSqDists.cwiseMin((X.rowwise() - fit.means.row(c)).rowwise().squaredNorm());
+	}
+
+	// diagonal covariances with the variance of each variable, uniform weights
+	Eigen::RowVectorXd colMean = X.colwise().mean();
+	Eigen::RowVectorXd colVar = (X.rowwise() - colMean).colwise().squaredNorm() / std::max(n - 1, 1);
+
+	Eigen::MatrixXd initCovar = Eigen::MatrixXd::Zero(dim, dim);
+	initCovar.diagonal() = colVar.transpose().array() + m_regValue;
+
+	fit.covars.assign(k, initCovar);
+	fit.weights = Eigen::VectorXd::Constant(k, 1.0 / k);
+	fit.logLikelihood = 0;
+}
+
+bool GMMFitter::computeLogComponentProbs(const Eigen::MatrixXd &X, const GMMFit &fit, Eigen::MatrixXd &logProbs)
+{
+	int n = X.rows();
+	int dim = X.cols();
+	int k = fit.weights.size();
+
+	logProbs.resize(n, k);
+
+	for (int c = 0; c < k; c++)
+	{
+		Eigen::LLT<Eigen::MatrixXd> llt(fit.covars[c]);
+		if (llt.info() != Eigen::Success)
+		{
+			return false;
+		}
+
+		Eigen::MatrixXd L = llt.matrixL();
+		double logDet = 2 * L.diagonal().array().log().sum();
+
+		// squared mahalanobis distances by solving L*y = x - mu for all points at once
+		Eigen::MatrixXd centered = (X.rowwise() - fit.means.row(c)).transpose();
+		L.triangularView<Eigen::Lower>().solveInPlace(centered);
+		Eigen::VectorXd sqDists = centered.colwise().squaredNorm().transpose();
+
+		logProbs.col(c) = (-0.5*(sqDists.array() + logDet + dim*GMMLogTwoPi) + log(fit.weights[c])).matrix();
+	}
+
+	return true;
+}
+
+bool GMMFitter::fitEM(const Eigen::MatrixXd &X, int k, GMMFit &fit)
+{
+	int n = X.rows();
+	int dim = X.cols();
+
+	if (n < k)
+	{
+		return false;
+	}
+
+	initKMeansPlusPlus(X, k, fit);
+
+	Eigen::MatrixXd logProbs;
+	Eigen::MatrixXd resp(n, k);
+	double prevLogL = 0;
+
+	for (int iter = 0; iter < m_maxIter; iter++)
+	{
+		// E step
+		if (!computeLogComponentProbs(X, fit, logProbs))
+		{
+			return false;
+		}
+
+		Eigen::VectorXd maxLogs = logProbs.rowwise().maxCoeff();
+		Eigen::VectorXd logSums(n);
+		for (int i = 0; i < n; i++)
+		{
+			logSums[i] = maxLogs[i] + log((logProbs.row(i).array() - maxLogs[i]).exp().sum());
+			resp.row(i) = (logProbs.row(i).array() - logSums[i]).exp();
+		}
+
+		fit.logLikelihood = logSums.sum();
+
+		if (iter > 0 && fit.logLikelihood - prevLogL >= 0 && fit.logLikelihood - prevLogL < m_tolFun*fabs(fit.logLikelihood))
+		{
+			return true;
+		}
+
+		prevLogL = fit.logLikelihood;
+
+		// M step
+		Eigen::VectorXd compSums = resp.colwise().sum().transpose();
+
+		for (int c = 0; c < k; c++)
+		{
+			// a component without points makes the mixture ill-conditioned, as fitgmdist reports
+			if (compSums[c] < 1e-10)
+			{
+				return false;
+			}
+
+			fit.means.row(c) = (resp.col(c).transpose()*X) / compSums[c];
+
+			Eigen::MatrixXd centered = X.rowwise() - fit.means.row(c);
+			Eigen::MatrixXd weighted = centered.array().colwise()*resp.col(c).array();
+
+			fit.covars[c] = centered.transpose()*weighted / compSums[c];
+			fit.covars[c].diagonal().array() += m_regValue;
+		}
+
+		fit.weights = compSums / n;
+	}
+
+	// not converged, use the last estimate as fitgmdist does
+	if (!computeLogComponentProbs(X, fit, logProbs))
+	{
+		return false;
+	}
+
+	Eigen::VectorXd maxLogs = logProbs.rowwise().maxCoeff();
+	fit.logLikelihood = 0;
+	for (int i = 0; i < n; i++)
+	{
+		fit.logLikelihood += maxLogs[i] + log((logProbs.row(i).array() - maxLogs[i]).exp().sum());
+	}
+
+	return true;
+}
+
+// percentile as matlab prctile: sorted values sit at (i - 0.5)/n, linear in between, clamped at both ends
+double GMMFitter::computePercentile(std::vector<double> vals, double percent)
+{
+	if (vals.empty())
+	{
+		return 0;
+	}
+
+	std::sort(vals.begin(), vals.end());
+
+	int n = vals.size();
+	double pos = n*percent / 100.0 + 0.5;  // 1-based
+
+	if (pos <= 1)
+	{
+		return vals[0];
+	}
+
+	if (pos >= n)
+	{
+		return vals[n - 1];
+	}
+
+	int lowId = (int)floor(pos);
+	double t = pos - lowId;
+
+	return vals[lowId - 1] + t*(vals[lowId] - vals[lowId - 1]);
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include "GaussianMixtureModel.h"
+#include <random>
+
+// in-process port of fitGMMWithAIC.m
+// observations are enriched by jittering in the anchor frame, full covariance GMMs with 1..maxK components
+// are fitted by EM (k-means++ start, regularized covariances as fitgmdist) and the one with the smallest AIC is kept
+// each fitter owns its random generator, use one fitter per thread
+
+class GMMFitter
+{
+public:
+	GMMFitter(unsigned int seed);
+	~GMMFitter();
+
+	// observations: dim x n, (x, y, z, theta) per column
+	// alignMats: 16 x n column major anchor align matrices, empty to fit the observations without jittering
+	// returns NULL if no mixture could be fitted
+	GaussianMixtureModel* fitWithAIC(const Eigen::MatrixXd &observations, const Eigen::MatrixXd &alignMats, int maxK);
+
+	int m_jitterNum;
+	double m_jitterPosVar;   // variance of position jitter in inch
+	double m_jitterDirVar;   // variance of orientation jitter
+	double m_regValue;       // added to covariance diagonals
+	int m_maxIter;
+	double m_tolFun;         // relative log likelihood change to stop EM
+	std::vector<double> m_probPercents;
+
+private:
+	struct GMMFit
+	{
+		Eigen::VectorXd weights;
+		Eigen::MatrixXd means;  // k x dim
+		std::vector<Eigen::MatrixXd> covars;
+		double logLikelihood;
+	};
+
+	Eigen::MatrixXd jitterObservations(const Eigen::MatrixXd &observations, const Eigen::MatrixXd &alignMats);
+
+	bool fitEM(const Eigen::MatrixXd &X, int k, GMMFit &fit);
+	void initKMeansPlusPlus(const Eigen::MatrixXd &X, int k, GMMFit &fit);
+
+	// per point log of weighted component densities, n x k; false if a covariance is not positive definite
+	bool computeLogComponentProbs(const Eigen::MatrixXd &X, const GMMFit &fit, Eigen::MatrixXd &logProbs);
+
+	static double computePercentile(std::vector<double> vals, double percent);
+
+	std::mt19937 m_rng;
+};
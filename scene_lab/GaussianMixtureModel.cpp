@@ -1,20 +1,47 @@
 #include "GaussianMixtureModel.h"
+#include <limits>
+#include <algorithm>
+
+const double GaussLogTwoPi = 1.8378770664093453;
+
+// candidates per block in batch scoring, keeps the per component temporaries in cache
+const int GaussScoreBlockSize = 256;
 
 GaussianModel::GaussianModel(int d, double w, const Eigen::VectorXd &m, const Eigen::MatrixXd &c)
 	:dim(d), weight(w), mean(m), covarMat(c)
 {
+	logNormalizer = 0;
 }
 
 GaussianModel::~GaussianModel()
 {
 }
 
+bool GaussianModel::prepareForScoring()
+{
+	Eigen::LLT<Eigen::MatrixXd> llt(covarMat);
+	if (llt.info() != Eigen::Success || weight <= 0)
+	{
+		return false;
+	}
+
+	Eigen::MatrixXd L = llt.matrixL();
+	invCholL = Eigen::MatrixXd::Identity(dim, dim);
+	L.triangularView<Eigen::Lower>().solveInPlace(invCholL);
+
+	double logDet = 2 * L.diagonal().array().log().sum();
+	logNormalizer = log(weight) - 0.5*(logDet + dim*GaussLogTwoPi);
+
+	return true;
+}
+
 
 
 GaussianMixtureModel::GaussianMixtureModel(int n)
 	:m_numGauss(n)
 {
 	m_gaussians.resize(m_numGauss);
+	m_isScoringReady = false;
 }
 
 GaussianMixtureModel::~GaussianMixtureModel()
@@ -27,3 +54,91 @@ GaussianMixtureModel::~GaussianMixtureModel()
 	m_gaussians.clear();
 }
 
+bool GaussianMixtureModel::prepareForScoring()
+{
+	m_isScoringReady = false;
+
+	if (m_numGauss == 0)
+	{
+		return false;
+	}
+
+	for (int i = 0; i < m_numGauss; i++)
+	{
+		if (!m_gaussians[i]->prepareForScoring())
+		{
+			return false;
+		}
+	}
+
+	m_isScoringReady = true;
+	return true;
+}
+
+double GaussianMixtureModel::computeLogProb(const Eigen::VectorXd &x) const
+{
+	Eigen::VectorXd logProbs;
+	computeLogProbs(x, logProbs);
+
+	return logProbs[0];
+}
+
+void GaussianMixtureModel::computeLogProbs(const Eigen::MatrixXd &X, Eigen::VectorXd &logProbs) const
+{
+	int candNum = X.cols();
+	logProbs.resize(candNum);
+
+	if (!m_isScoringReady)
+	{
+		logProbs.setConstant(-std::numeric_limits<double>::infinity());
+		return;
+	}
+
+	Eigen::MatrixXd compLogProbs(m_numGauss, GaussScoreBlockSize);
+	Eigen::MatrixXd whitened;
+
+	for (int start = 0; start < candNum; start += GaussScoreBlockSize)
+	{
+		int blockSize = std::min(GaussScoreBlockSize, candNum - start);
+
+		// per component: log w - log norm - |L^-1 (x - mu)|^2 / 2, as dense products over the block
+		for (int c = 0; c < m_numGauss; c++)
+		{
+			const GaussianModel *gauss = m_gaussians[c];
+
+			whitened.noalias() = gauss->invCholL.triangularView<Eigen::Lower>() * (X.middleCols(start, blockSize).colwise() - gauss->mean);
+			compLogProbs.row(c).head(blockSize) = ((-0.5)*whitened.colwise().squaredNorm()).array() + gauss->logNormalizer;
+		}
+
+		// log-sum-exp over components
+		Eigen::RowVectorXd maxLogs = compLogProbs.leftCols(blockSize).colwise().maxCoeff();
+		Eigen::RowVectorXd sumExps = (compLogProbs.leftCols(blockSize).rowwise() - maxLogs).array().exp().matrix().colwise().sum();
+
+		logProbs.segment(start, blockSize) = (maxLogs.array() + sumExps.array().log()).transpose();
+	}
+}
+
+int GaussianMixtureModel::computeProbRank(double prob) const
+{
+	int rank = 0;
+	for (int i = 0; i < m_probTh.size(); i++)
+	{
+		if (prob >= m_probTh[i])
+		{
+			rank = i + 1;
+		}
+	}
+
+	return rank;
+}
+
+void GaussianMixtureModel::scoreCandidates(const Eigen::MatrixXd &X, Eigen::VectorXd &logProbs, std::vector<int> &probRanks) const
+{
+	computeLogProbs(X, logProbs);
+
+	probRanks.resize(logProbs.size());
+	for (int i = 0; i < logProbs.size(); i++)
+	{
+		probRanks[i] = computeProbRank(exp(logProbs[i]));
+	}
+}
@@ -9,11 +9,16 @@ public:
 	GaussianModel(int d, double w, const Eigen::VectorXd &m, const Eigen::MatrixXd &c);
 	~GaussianModel();
 
+	// inverse cholesky factor and log normalizer, false if covarMat is not positive definite
+	bool prepareForScoring();
+
 	int dim;
 	double weight;   // mixing weight
 	Eigen::VectorXd mean;
 	Eigen::MatrixXd covarMat;
 
+	Eigen::MatrixXd invCholL;  // inverse of the lower cholesky factor of covarMat, lower triangular
+	double logNormalizer;      // log(weight) - (log det(covarMat) + dim*log(2pi)) / 2
 };
 
 class GaussianMixtureModel
@@ -22,9 +27,28 @@ public:
 	GaussianMixtureModel(int n);
 	~GaussianMixtureModel();
 
+	// scoring; prepare once after the gaussians are set, scoring is then const and can be shared by threads
+	bool prepareForScoring();
+	bool isReadyForScoring() const { return m_isScoringReady; };
+
+	// log density of one candidate (pos.x, pos.y, pos.z, theta)
+	double computeLogProb(const Eigen::VectorXd &x) const;
+
+	// log densities of candidates, one per column of X (dim x n), evaluated in blocks of candidates
+	void computeLogProbs(const Eigen::MatrixXd &X, Eigen::VectorXd &logProbs) const;
+
+	// number of m_probTh thresholds a density passes, 0 is below the lowest percentile of the training observations
+	int computeProbRank(double prob) const;
+
+	// log densities and ranks of a batch of candidates
+	void scoreCandidates(const Eigen::MatrixXd &X, Eigen::VectorXd &logProbs, std::vector<int> &probRanks) const;
+
 	std::vector<GaussianModel*> m_gaussians;
 
 	Eigen::VectorXd m_probTh; // probability value that X percentiles of observations have passed, currently X = [20 50 80]
 	int m_numGauss;
+
+private:
+	bool m_isScoringReady;
 };
 
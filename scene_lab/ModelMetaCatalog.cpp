@@ -0,0 +1,553 @@
+#include "ModelMetaCatalog.h"
+#include "modelDatabase.h"
+#include "category.h"
+#include <algorithm>
+#include <numeric>
+#include <cstring>
+
+const char ModelMetaCatalogMagic[4] = { 'M', 'C', 'A', 'T' };
+const quint32 ModelMetaCatalogVersion = 2;
+
+struct ModelMetaCatalogHeader
+{
+	char magic[4];
+	quint32 version;
+	qint32 dbType;
+	quint32 modelNum;
+	quint32 categoryNum;
+	qint32 parentCatNum;
+	quint32 stringNum;
+	quint32 stringDataSize;  // utf8 bytes of all strings, before padding
+	quint32 listNum;
+	quint32 bucketNum;
+	quint32 slotNum;
+	quint32 metaInfoNum;
+	quint32 metaInfoDataSize;  // bytes of all meta info lines, before padding
+	quint32 reserved;
+};
+
+// perfect hash: ids are grouped in buckets of about this size, each bucket gets a seed placing its ids in free slots
+const int ModelsPerHashBucket = 4;
+const int MaxHashSeed = 1 << 20;
+
+static qint64 padTo4(qint64 size)
+{
+	return (size + 3) & ~3;
+}
+
+static void appendData(QByteArray &data, const void *src, qint64 size)
+{
+	data.append((const char*)src, size);
+}
+
+static void appendPadding(QByteArray &data)
+{
+	data.append(QByteArray(padTo4(data.size()) - data.size(), '\0'));
+}
+
+ModelMetaCatalog::ModelMetaCatalog()
+{
+	m_data = NULL;
+	resetSections();
+}
+
+ModelMetaCatalog::~ModelMetaCatalog()
+{
+	close();
+}
+
+void ModelMetaCatalog::resetSections()
+{
+	m_modelNum = 0;
+	m_categoryNum = 0;
+	m_parentCatNum = 0;
+
+	m_stringNum = 0;
+	m_stringOffsets = NULL;
+	m_stringData = NULL;
+
+	m_models = NULL;
+	m_categories = NULL;
+	m_lists = NULL;
+
+	m_bucketNum = 0;
+	m_slotNum = 0;
+	m_bucketSeeds = NULL;
+	m_slotRecordIds = NULL;
+
+	m_metaInfoNum = 0;
+	m_metaInfoOffsets = NULL;
+	m_metaInfoData = NULL;
+}
+
+quint32 ModelMetaCatalog::hashIdStr(const QString &idStr, quint32 seed)
+{
+	// FNV-1a over utf16 units, lookups need no conversion of the key
+	quint32 h = 2166136261u ^ (seed * 0x9e3779b9u);
+	const ushort *units = idStr.utf16();
+
+	for (int i = 0; i < idStr.size(); i++)
+	{
+		h = (h ^ units[i]) * 16777619u;
+	}
+
+	// final mix, so nearby seeds give unrelated slots
+	h ^= h >> 16;
+	h *= 0x85ebca6bu;
+	h ^= h >> 13;
+	h *= 0xc2b2ae35u;
+	h ^= h >> 16;
+
+	return h;
+}
+
+bool ModelMetaCatalog::buildPerfectHash(const std::vector<QString> &idStrs, std::vector<qint32> &bucketSeeds, std::vector<qint32> &slotRecordIds)
+{
+	int idNum = idStrs.size();
+	int bucketNum = std::max(1, (idNum + ModelsPerHashBucket - 1) / ModelsPerHashBucket);
+	int slotNum = std::max(1, idNum + idNum / 4);
+
+	std::vector<std::vector<int>> buckets(bucketNum);
+	for (int i = 0; i < idNum; i++)
+	{
+		buckets[hashIdStr(idStrs[i], 0) % bucketNum].push_back(i);
+	}
+
+	// place large buckets first, while most slots are free
+	std::vector<int> bucketOrder(bucketNum);
+	std::iota(bucketOrder.begin(), bucketOrder.end(), 0);
+	std::stable_sort(bucketOrder.begin(), bucketOrder.end(), [&buckets](int a, int b) { return buckets[a].size() > buckets[b].size(); });
+
+	bucketSeeds.assign(bucketNum, 0);
+	slotRecordIds.assign(slotNum, -1);
+
+	std::vector<int> bucketSlots;
+
+	for (int b = 0; b < bucketNum; b++)
+	{
+		const std::vector<int> &bucket = buckets[bucketOrder[b]];
+		if (bucket.empty())
+		{
+			break;
+		}
+
+		bool isPlaced = false;
+		for (int seed = 1; seed <= MaxHashSeed && !isPlaced; seed++)
+		{
+			bucketSlots.clear();
+			isPlaced = true;
+
+			for (int k = 0; k < bucket.size(); k++)
+			{
+				int slot = hashIdStr(idStrs[bucket[k]], seed) % slotNum;
+				if (slotRecordIds[slot] != -1 || std::find(bucketSlots.begin(), bucketSlots.end(), slot) != bucketSlots.end())
+				{
+					isPlaced = false;
+					break;
+				}
+
+				bucketSlots.push_back(slot);
+			}
+
+			if (isPlaced)
+			{
+				for (int k = 0; k < bucket.size(); k++)
+				{
+					slotRecordIds[bucketSlots[k]] = bucket[k];
+				}
+
+				bucketSeeds[bucketOrder[b]] = seed;
+			}
+		}
+
+		if (!isPlaced)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+bool ModelMetaCatalog::save(const QString &filename, int dbType, const std::map<QString, DBMetaModel*> &metaModels,
+	const std::map<QString, Category*> &categories, int parentCatNum, const std::vector<std::string> &metaInfoStrings)
+{
+	// intern strings
+	std::map<QString, int> stringIds;
+	std::vector<QString> strings;
+
+	auto getStringId = [&](const QString &s)
+	{
+		auto iter = stringIds.find(s);
+		if (iter != stringIds.end())
+		{
+			return iter->second;
+		}
+
+		int id = strings.size();
+		stringIds[s] = id;
+		strings.push_back(s);
+		return id;
+	};
+
+	std::vector<qint32> lists;
+
+	auto appendStringList = [&](const std::vector<QString> &names, qint32 &start, qint32 &num)
+	{
+		start = lists.size();
+		num = names.size();
+
+		for (int i = 0; i < names.size(); i++)
+		{
+			lists.push_back(getStringId(names[i]));
+		}
+	};
+
+	// model records in id order, as in the DB map
+	std::vector<ModelRecord> models;
+	std::vector<QString> idStrs;
+	std::map<const DBMetaModel*, int> recordIds;
+
+	for (auto it = metaModels.begin(); it != metaModels.end(); it++)
+	{
+		const DBMetaModel *m = it->second;
+		if (m == NULL)
+		{
+			continue;
+		}
+
+		ModelRecord record;
+		record.idStrId = getStringId(it->first);
+		record.dbID = m->dbID;
+		record.catNameId = getStringId(m->getCatName());
+		record.processedCatNameId = getStringId(m->getProcessedCatName());
+
+		appendStringList(m->getCandidateCatNames(), record.candidateStart, record.candidateNum);
+		appendStringList(m->getWordNetLemmas(), record.lemmaStart, record.lemmaNum);
+		appendStringList(m->m_attributes, record.attributeStart, record.attributeNum);
+
+		for (int d = 0; d < 3; d++)
+		{
+			record.frontDir[d] = m->frontDir[d];
+			record.upDir[d] = m->upDir[d];
+			record.position[d] = m->position[d];
+		}
+
+		record.scale = m->getScale();
+
+		recordIds[m] = models.size();
+		models.push_back(record);
+		idStrs.push_back(it->first);
+	}
+
+	std::vector<CategoryRecord> categoryRecords;
+
+	for (auto it = categories.begin(); it != categories.end(); it++)
+	{
+		Category *cat = it->second;
+		if (cat == NULL)
+		{
+			continue;
+		}
+
+		CategoryRecord record;
+		record.nameId = getStringId(it->first);
+		record.level = cat->getCatgoryLevel();
+
+		appendStringList(cat->getSubCatNames(), record.subCatStart, record.subCatNum);
+
+		record.instanceStart = lists.size();
+		for (int i = 0; i < cat->modelInstances.size(); i++)
+		{
+			auto idIter = recordIds.find(cat->modelInstances[i]);
+			if (idIter != recordIds.end())
+			{
+				lists.push_back(idIter->second);
+			}
+		}
+		record.instanceNum = lists.size() - record.instanceStart;
+
+		categoryRecords.push_back(record);
+	}
+
+	std::vector<qint32> bucketSeeds, slotRecordIds;
+	if (!buildPerfectHash(idStrs, bucketSeeds, slotRecordIds))
+	{
+		std::cout << "\tModelMetaCatalog: cannot build id index for " << filename.toStdString() << "\n";
+		return false;
+	}
+
+	// string table
+	std::vector<quint32> stringOffsets(1, 0);
+	QByteArray stringData;
+	for (int i = 0; i < strings.size(); i++)
+	{
+		stringData.append(strings[i].toUtf8());
+		stringOffsets.push_back(stringData.size());
+	}
+
+	// meta info lines, raw bytes
+	std::vector<quint32> metaInfoOffsets(1, 0);
+	QByteArray metaInfoData;
+	for (int i = 0; i < metaInfoStrings.size(); i++)
+	{
+		metaInfoData.append(metaInfoStrings[i].data(), metaInfoStrings[i].size());
+		metaInfoOffsets.push_back(metaInfoData.size());
+	}
+
+	ModelMetaCatalogHeader header;
+	memcpy(header.magic, ModelMetaCatalogMagic, 4);
+	header.version = ModelMetaCatalogVersion;
+	header.dbType = dbType;
+	header.modelNum = models.size();
+	header.categoryNum = categoryRecords.size();
+	header.parentCatNum = parentCatNum;
+	header.stringNum = strings.size();
+	header.stringDataSize = stringData.size();
+	header.listNum = lists.size();
+	header.bucketNum = bucketSeeds.size();
+	header.slotNum = slotRecordIds.size();
+	header.metaInfoNum = metaInfoStrings.size();
+	header.metaInfoDataSize = metaInfoData.size();
+	header.reserved = 0;
+
+	QByteArray data;
+	appendData(data, &header, sizeof(header));
+	appendData(data, stringOffsets.data(), stringOffsets.size() * sizeof(quint32));
+	data.append(stringData);
+	appendPadding(data);
+	appendData(data, models.data(), models.size() * sizeof(ModelRecord));
+	appendData(data, categoryRecords.data(), categoryRecords.size() * sizeof(CategoryRecord));
+	appendData(data, lists.data(), lists.size() * sizeof(qint32));
+	appendData(data, bucketSeeds.data(), bucketSeeds.size() * sizeof(qint32));
+	appendData(data, slotRecordIds.data(), slotRecordIds.size() * sizeof(qint32));
+	appendData(data, metaInfoOffsets.data(), metaInfoOffsets.size() * sizeof(quint32));
+	data.append(metaInfoData);
+	appendPadding(data);
+
+	// write to a temp file first, processes mapping the old catalog keep reading it
+	QString tempFileName = filename + ".tmp";
+	QFile outFile(tempFileName);
+	if (!outFile.open(QIODevice::WriteOnly | QIODevice::Truncate))
+	{
+		return false;
+	}
+
+	bool isWritten = (outFile.write(data) == data.size());
+	outFile.close();
+
+	if (!isWritten)
+	{
+		QFile::remove(tempFileName);
+		return false;
+	}
+
+	QFile::remove(filename);
+	return QFile::rename(tempFileName, filename);
+}
+
+bool ModelMetaCatalog::open(const QString &filename, int dbType)
+{
+	close();
+
+	m_file.setFileName(filename);
+	if (!m_file.open(QIODevice::ReadOnly))
+	{
+		return false;
+	}
+
+	qint64 fileSize = m_file.size();
+	if (fileSize < (qint64)sizeof(ModelMetaCatalogHeader))
+	{
+		close();
+		return false;
+	}
+
+	m_data = m_file.map(0, fileSize);
+	if (m_data == NULL)
+	{
+		close();
+		return false;
+	}
+
+	ModelMetaCatalogHeader header;
+	memcpy(&header, m_data, sizeof(header));
+
+	if (memcmp(header.magic, ModelMetaCatalogMagic, 4) != 0 || header.version != ModelMetaCatalogVersion || header.dbType != dbType)
+	{
+		std::cout << "\tModelMetaCatalog: unsupported file " << filename.toStdString() << "\n";
+		close();
+		return false;
+	}
+
+	// check the sections fit before pointing into them
+	qint64 stringOffsetsStart = sizeof(ModelMetaCatalogHeader);
+	qint64 stringsStart = stringOffsetsStart + ((qint64)header.stringNum + 1) * sizeof(quint32);
+	qint64 modelsStart = padTo4(stringsStart + header.stringDataSize);
+	qint64 categoriesStart = modelsStart + (qint64)header.modelNum * sizeof(ModelRecord);
+	qint64 listsStart = categoriesStart + (qint64)header.categoryNum * sizeof(CategoryRecord);
+	qint64 seedsStart = listsStart + (qint64)header.listNum * sizeof(qint32);
+	qint64 slotsStart = seedsStart + (qint64)header.bucketNum * sizeof(qint32);
+	qint64 metaOffsetsStart = slotsStart + (qint64)header.slotNum * sizeof(qint32);
+	qint64 metaStart = metaOffsetsStart + ((qint64)header.metaInfoNum + 1) * sizeof(quint32);
+	qint64 expectedSize = padTo4(metaStart + header.metaInfoDataSize);
+
+	if (fileSize != expectedSize || header.bucketNum == 0 || header.slotNum < header.modelNum)
+	{
+		std::cout << "\tModelMetaCatalog: corrupted file " << filename.toStdString() << "\n";
+		close();
+		return false;
+	}
+
+	m_stringNum = header.stringNum;
+	m_stringOffsets = (const quint32*)(m_data + stringOffsetsStart);
+	m_stringData = (const char*)(m_data + stringsStart);
+
+	for (int i = 0; i < m_stringNum; i++)
+	{
+		if (m_stringOffsets[i] > m_stringOffsets[i + 1] || m_stringOffsets[i + 1] > header.stringDataSize)
+		{
+			std::cout << "\tModelMetaCatalog: corrupted string table in " << filename.toStdString() << "\n";
+			close();
+			return false;
+		}
+	}
+
+	m_modelNum = header.modelNum;
+	m_categoryNum = header.categoryNum;
+	m_parentCatNum = header.parentCatNum;
+
+	m_models = (const ModelRecord*)(m_data + modelsStart);
+	m_categories = (const CategoryRecord*)(m_data + categoriesStart);
+	m_lists = (const qint32*)(m_data + listsStart);
+
+	m_bucketNum = header.bucketNum;
+	m_slotNum = header.slotNum;
+	m_bucketSeeds = (const qint32*)(m_data + seedsStart);
+	m_slotRecordIds = (const qint32*)(m_data + slotsStart);
+
+	m_metaInfoNum = header.metaInfoNum;
+	m_metaInfoOffsets = (const quint32*)(m_data + metaOffsetsStart);
+	m_metaInfoData = (const char*)(m_data + metaStart);
+
+	// ids index the string table, the list section and the records
+	qint64 stringNum = header.stringNum;
+	qint64 listNum = header.listNum;
+
+	auto isStringId = [stringNum](qint32 id) { return id >= 0 && id < stringNum; };
+	auto isListRange = [listNum](qint32 start, qint32 num) { return start >= 0 && num >= 0 && (qint64)start + num <= listNum; };
+	auto isStringList = [&](qint32 start, qint32 num)
+	{
+		if (!isListRange(start, num))
+		{
+			return false;
+		}
+
+		for (int i = start; i < start + num; i++)
+		{
+			if (!isStringId(m_lists[i]))
+			{
+				return false;
+			}
+		}
+
+		return true;
+	};
+
+	bool isValid = true;
+
+	for (int r = 0; r < m_modelNum && isValid; r++)
+	{
+		const ModelRecord &record = m_models[r];
+		isValid = isStringId(record.idStrId) && isStringId(record.catNameId) && isStringId(record.processedCatNameId)
+			&& isStringList(record.candidateStart, record.candidateNum)
+			&& isStringList(record.lemmaStart, record.lemmaNum) && isStringList(record.attributeStart, record.attributeNum);
+	}
+
+	for (int c = 0; c < m_categoryNum && isValid; c++)
+	{
+		const CategoryRecord &record = m_categories[c];
+		isValid = isStringId(record.nameId) && isStringList(record.subCatStart, record.subCatNum) && isListRange(record.instanceStart, record.instanceNum);
+
+		for (int i = record.instanceStart; i < record.instanceStart + record.instanceNum && isValid; i++)
+		{
+			isValid = m_lists[i] >= 0 && m_lists[i] < m_modelNum;
+		}
+	}
+
+	for (int s = 0; s < m_slotNum && isValid; s++)
+	{
+		isValid = m_slotRecordIds[s] >= -1 && m_slotRecordIds[s] < m_modelNum;
+	}
+
+	for (int i = 0; i < m_metaInfoNum && isValid; i++)
+	{
+		isValid = m_metaInfoOffsets[i] <= m_metaInfoOffsets[i + 1] && m_metaInfoOffsets[i + 1] <= header.metaInfoDataSize;
+	}
+
+	if (!isValid)
+	{
+		std::cout << "\tModelMetaCatalog: invalid index in " << filename.toStdString() << "\n";
+		close();
+		return false;
+	}
+
+	return true;
+}
+
+void ModelMetaCatalog::close()
+{
+	if (m_data != NULL)
+	{
+		m_file.unmap(m_data);
+		m_data = NULL;
+	}
+
+	if (m_file.isOpen())
+	{
+		m_file.close();
+	}
+
+	resetSections();
+}
+
+int ModelMetaCatalog::findModel(const QString &idStr) const
+{
+	if (m_modelNum == 0)
+	{
+		return -1;
+	}
+
+	quint32 bucket = hashIdStr(idStr, 0) % m_bucketNum;
+	quint32 slot = hashIdStr(idStr, m_bucketSeeds[bucket]) % m_slotNum;
+	int recordId = m_slotRecordIds[slot];
+
+	// ids not in the catalog land on any slot, compare with the id stored there
+	if (recordId != -1 && isString(m_models[recordId].idStrId, idStr.toUtf8()))
+	{
+		return recordId;
+	}
+
+	return -1;
+}
+
+QString ModelMetaCatalog::getString(int stringId) const
+{
+	return QString::fromUtf8(m_stringData + m_stringOffsets[stringId], m_stringOffsets[stringId + 1] - m_stringOffsets[stringId]);
+}
+
+bool ModelMetaCatalog::isString(int stringId, const QByteArray &utf8) const
+{
+	int size = m_stringOffsets[stringId + 1] - m_stringOffsets[stringId];
+	return size == utf8.size() && memcmp(m_stringData + m_stringOffsets[stringId], utf8.constData(), size) == 0;
+}
+
+std::string ModelMetaCatalog::getMetaInfoString(int lineId) const
+{
+	if (lineId < 0 || lineId >= m_metaInfoNum)
+	{
+		return std::string();
+	}
+
+	return std::string(m_metaInfoData + m_metaInfoOffsets[lineId], m_metaInfoOffsets[lineId + 1] - m_metaInfoOffsets[lineId]);
+}
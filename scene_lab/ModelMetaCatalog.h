@@ -0,0 +1,100 @@
+#pragma once
+
+#include "../common/utilities/utility.h"
+#include <QFile>
+#include <vector>
+#include <map>
+
+class DBMetaModel;
+class Category;
+
+// versioned binary snapshot of a loaded model DB, compiled once from the meta data csv files
+// layout: header, interned string table (offsets + utf8 bytes), model records, category records,
+// int32 list section (string ids and record ids), perfect hash of model ids, then the raw meta info lines
+// all sections are 4 byte aligned and little endian, so a mapped file is read in place and shared by processes
+// opening only checks the sections, records and strings are read from the mapping when they are requested
+
+class ModelMetaCatalog
+{
+public:
+	struct ModelRecord
+	{
+		qint32 idStrId;  // string ids index the string table
+		qint32 dbID;
+		qint32 catNameId;
+		qint32 processedCatNameId;
+		qint32 candidateStart, candidateNum;  // string ids in the list section
+		qint32 lemmaStart, lemmaNum;
+		qint32 attributeStart, attributeNum;
+		float frontDir[3];
+		float upDir[3];
+		float position[3];
+		float scale;
+	};
+
+	struct CategoryRecord
+	{
+		qint32 nameId;
+		qint32 level;
+		qint32 subCatStart, subCatNum;  // string ids in the list section
+		qint32 instanceStart, instanceNum;  // model record ids in the list section
+	};
+
+	ModelMetaCatalog();
+	~ModelMetaCatalog();
+
+	static bool save(const QString &filename, int dbType, const std::map<QString, DBMetaModel*> &metaModels,
+		const std::map<QString, Category*> &categories, int parentCatNum, const std::vector<std::string> &metaInfoStrings);
+
+	// maps the file, records stay valid until close
+	bool open(const QString &filename, int dbType);
+	void close();
+
+	bool isOpen() const { return m_data != NULL; };
+
+	int getModelNum() const { return m_modelNum; };
+	const ModelRecord& getModel(int recordId) const { return m_models[recordId]; };
+	int getCategoryNum() const { return m_categoryNum; };
+	const CategoryRecord& getCategory(int catId) const { return m_categories[catId]; };
+	const qint32* getList(int start) const { return m_lists + start; };
+	int getParentCatNum() const { return m_parentCatNum; };
+
+	// decoded from the mapped utf8 bytes on each call
+	QString getString(int stringId) const;
+
+	// record id of the model, -1 if it is not in the catalog
+	int findModel(const QString &idStr) const;
+
+	// meta info lines are kept in the mapped file and decoded on request
+	int getMetaInfoNum() const { return m_metaInfoNum; };
+	std::string getMetaInfoString(int lineId) const;
+
+private:
+	static quint32 hashIdStr(const QString &idStr, quint32 seed);
+	static bool buildPerfectHash(const std::vector<QString> &idStrs, std::vector<qint32> &bucketSeeds, std::vector<qint32> &slotRecordIds);
+
+	void resetSections();
+	bool isString(int stringId, const QByteArray &utf8) const;
+
+	QFile m_file;
+	uchar *m_data;
+
+	int m_modelNum;
+	int m_categoryNum;
+	int m_parentCatNum;
+	int m_stringNum;
+	const quint32 *m_stringOffsets;
+	const char *m_stringData;
+
+	const ModelRecord *m_models;
+	const CategoryRecord *m_categories;
+	const qint32 *m_lists;
+
+	int m_bucketNum, m_slotNum;
+	const qint32 *m_bucketSeeds;
+	const qint32 *m_slotRecordIds;  // -1 for empty slots
+
+	int m_metaInfoNum;
+	const quint32 *m_metaInfoOffsets;
+	const char *m_metaInfoData;
+};
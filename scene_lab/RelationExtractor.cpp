@@ -1,11 +1,10 @@
 #include "RelationExtractor.h"
 #include "../common/geometry/CModel.h"
 #include "../common/geometry/Scene.h"
-#include "../t2scene/SceneSemGraph.h"
 #include "../common/geometry/SuppPlane.h"
 
 RelationExtractor::RelationExtractor(double angleTh)
-	:m_angleThreshold(angleTh)
+	:m_currScene(NULL), m_angleThreshold(angleTh)
 {
 	m_rightAdjustObjNames.push_back("desk");
 	m_rightAdjustObjNames.push_back("bookcase");
@@ -22,6 +21,11 @@ RelationExtractor::~RelationExtractor()
 }
 
 QString RelationExtractor::getRelationConditionType(CModel *anchorModel, CModel *actModel)
+{
+	return getRelationConditionType(m_currScene, anchorModel, actModel);
+}
+
+QString RelationExtractor::getRelationConditionType(CScene *scene, CModel *anchorModel, CModel *actModel) const
 {
 	int anchorModelId = anchorModel->getID();
 	int actModelId = actModel->getID();
@@ -48,7 +52,7 @@ QString RelationExtractor::getRelationConditionType(CModel *anchorModel, CModel
 
 	// test for proximity relation
 	// do not consider proximity for "room"
-	if (anchorCatName != "room" && actCatName != "room" && isInProximity(anchorModel, actModel))
+	if (anchorCatName != "room" && actCatName != "room" && isInProximity(scene, anchorModel, actModel))
 	{
 		return ConditionName[ConditionType::Prox];
 	}
@@ -63,19 +67,29 @@ QString RelationExtractor::getRelationConditionType(CModel *anchorModel, CModel
 
 std::vector<QString> RelationExtractor::extractSpatialSideRelForModelPair(int anchorModelId, int actModelId)
 {
-	CModel *anchorModel = m_currScene->getModel(anchorModelId);
-	CModel *actModel = m_currScene->getModel(actModelId);
-
-	return extractSpatialSideRelForModelPair(anchorModel, actModel);
+	return extractSpatialSideRelForModelPair(m_currScene, anchorModelId, actModelId);
 }
 
 std::vector<QString> RelationExtractor::extractSpatialSideRelForModelPair(CModel *anchorModel, CModel *actModel)
 {
-	double distThreshold = 0.1 / m_currScene->getSceneMetric();
+	return extractSpatialSideRelForModelPair(m_currScene, anchorModel, actModel);
+}
+
+std::vector<QString> RelationExtractor::extractSpatialSideRelForModelPair(CScene *scene, int anchorModelId, int actModelId) const
+{
+	CModel *anchorModel = scene->getModel(anchorModelId);
+	CModel *actModel = scene->getModel(actModelId);
+
+	return extractSpatialSideRelForModelPair(scene, anchorModel, actModel);
+}
+
+std::vector<QString> RelationExtractor::extractSpatialSideRelForModelPair(CScene *scene, CModel *anchorModel, CModel *actModel) const
+{
+	double distThreshold = 0.1 / scene->getSceneMetric();
 
 	std::vector<QString> relationStrings;
 
-	QString conditionType = getRelationConditionType(anchorModel, actModel);
+	QString conditionType = getRelationConditionType(scene, anchorModel, actModel);
 
 	if (conditionType == "none") return relationStrings;
 
@@ -86,7 +100,7 @@ std::vector<QString> RelationExtractor::extractSpatialSideRelForModelPair(CModel
 	}
 
 	// add near to proximity objs
-	bool isNear = isInProximity(anchorModel, actModel);
+	bool isNear = isInProximity(scene, anchorModel, actModel);
 	if (isNear && isGroundSib)
 	{
 		relationStrings.push_back(PairRelStrings[PairRelation::Near]);  // near
@@ -112,7 +126,6 @@ std::vector<QString> RelationExtractor::extractSpatialSideRelForModelPair(CModel
 		double posFrontDot = fromRefPosToTestPosVec.dot(refFront); // diff to ref's front dir using the posVec
 		if (posFrontDot > sideSectionVal)
 		{
-			QString refName = m_currScene->getModelCatName(anchorModel->getID());
 			relationStrings.push_back(PairRelStrings[PairRelation::Front]); // front
 		}
 		else if (posFrontDot < -sideSectionVal && posFrontDot > -1)
@@ -137,7 +150,7 @@ std::vector<QString> RelationExtractor::extractSpatialSideRelForModelPair(CModel
 	MathLib::Vector3 refRight = refFront.cross(refUp);
 
 	// adjust Right for certain models
-	QString refName = m_currScene->getModelCatName(anchorModel->getID());
+	QString refName = scene->getModelCatName(anchorModel->getID());
 	bool isAnchorRightAdjust = false;
 	if(std::find(m_rightAdjustObjNames.begin(), m_rightAdjustObjNames.end(), refName) != m_rightAdjustObjNames.end())
 	{
@@ -228,8 +241,12 @@ std::vector<QString> RelationExtractor::extractSpatialSideRelForModelPair(CModel
 
 bool RelationExtractor::isInProximity(CModel *anchorModel, CModel *actModel)
 {
-	double sceneMetric = m_currScene->getSceneMetric();
-	MathLib::Vector3 sceneUpDir = m_currScene->getUprightVec();
+	return isInProximity(m_currScene, anchorModel, actModel);
+}
+
+bool RelationExtractor::isInProximity(CScene *scene, CModel *anchorModel, CModel *actModel) const
+{
+	double sceneMetric = scene->getSceneMetric();
 
 	COBB refOBB = anchorModel->getOBB();
 	COBB testOBB = actModel->getOBB();
@@ -246,6 +263,11 @@ bool RelationExtractor::isInProximity(CModel *anchorModel, CModel *actModel)
 }
 
 void RelationExtractor::extractRelativePosForModelPair(CModel *anchorModel, CModel *actModel, RelativePos *relPos)
+{
+	extractRelativePosForModelPair(m_currScene, anchorModel, actModel, relPos);
+}
+
+void RelationExtractor::extractRelativePosForModelPair(CScene *scene, CModel *anchorModel, CModel *actModel, RelativePos *relPos) const
 {
 	relPos->m_anchorObjName = anchorModel->getCatName();
 	relPos->m_actObjName = actModel->getCatName();
@@ -253,9 +275,6 @@ void RelationExtractor::extractRelativePosForModelPair(CModel *anchorModel, CMod
 	relPos->m_actObjId = actModel->getID();
 	relPos->m_anchorObjId = anchorModel->getID();
 
-	relPos->m_instanceNameHash = QString("%1_%2_%3").arg(relPos->m_anchorObjName).arg(relPos->m_actObjName).arg(relPos->m_conditionName);
-	relPos->m_instanceIdHash = QString("%1_%2_%3").arg(relPos->m_sceneName).arg(relPos->m_anchorObjId).arg(relPos->m_actObjId);
-
 	// first transform actModel into the scene and then bring it back using anchor model's alignMat
 	relPos->anchorAlignMat = anchorModel->m_WorldBBToUnitBoxMat;
 
@@ -272,7 +291,7 @@ void RelationExtractor::extractRelativePosForModelPair(CModel *anchorModel, CMod
 
 	MathLib::Vector3 anchorModelFrontDir = anchorModel->getFrontDir();
 	MathLib::Vector3 actModelFrontDir = actModel->getFrontDir();
-	relPos->theta = GetRotAngleR(anchorModelFrontDir, actModelFrontDir, m_currScene->getUprightVec())/MathLib::ML_PI;
+	relPos->theta = GetRotAngleR(anchorModelFrontDir, actModelFrontDir, scene->getUprightVec())/MathLib::ML_PI;
 
 	relPos->isValid = true;
 }
@@ -5,7 +5,6 @@
 
 class CScene;
 class CModel;
-class SceneSemGraph;
 
 const QString ConditionName[] = {"parentchild", "childparent", "sibling", "proximity","specified"};
 const QString PairRelStrings[] = { "vertsupport", "horizonsupport", "contain", "above", "under", "leftside", "rightside", "front", "back", "onleft", "onright", "oncenter","near", "pairaround", "pairaligned"};
@@ -51,6 +50,8 @@ enum GroupRelation
 	Scattered
 };
 
+// the overloads taking the scene only read the extractor and can be shared by threads working on different scenes;
+// the others use the scene set by updateCurrScene
 class RelationExtractor
 {
 public:
@@ -58,19 +59,23 @@ public:
 	~RelationExtractor();
 
 	void updateCurrScene(CScene *s) { m_currScene = s; };
-	void updateCurrSceneSemGraph(SceneSemGraph *sg) { m_currSceneSemGraph = sg; };
 
 	QString getRelationConditionType(CModel *anchorModel, CModel *actModel);
+	QString getRelationConditionType(CScene *scene, CModel *anchorModel, CModel *actModel) const;
+
 	void extractRelativePosForModelPair(CModel *anchorModel, CModel *actModel, RelativePos *relPos);
+	void extractRelativePosForModelPair(CScene *scene, CModel *anchorModel, CModel *actModel, RelativePos *relPos) const;
 
 	std::vector<QString> extractSpatialSideRelForModelPair(int anchorModelId, int actModelId);
 	std::vector<QString> extractSpatialSideRelForModelPair(CModel *anchorModel, CModel *actModel);
+	std::vector<QString> extractSpatialSideRelForModelPair(CScene *scene, int anchorModelId, int actModelId) const;
+	std::vector<QString> extractSpatialSideRelForModelPair(CScene *scene, CModel *anchorModel, CModel *actModel) const;
 
 	bool isInProximity(CModel *anchorModel, CModel *actModel);
+	bool isInProximity(CScene *scene, CModel *anchorModel, CModel *actModel) const;
 
 private:
 	CScene *m_currScene;
-	SceneSemGraph *m_currSceneSemGraph;
 
 	double m_angleThreshold;
 	std::vector<QString> m_rightAdjustObjNames;
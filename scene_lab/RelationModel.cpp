@@ -1,10 +1,8 @@
 #include "RelationModel.h"
-#include "engine.h"
-#include "../common/utilities/eigenMat.h"
+#include "GMMFitter.h"
 #include "../common/geometry/Scene.h"
 #include "../common/geometry/CModel.h"
-
-extern Engine *matlabEngine;
+#include <algorithm>
 
 PairwiseRelationModel::PairwiseRelationModel(const QString &anchorName, const QString &actName, const QString &conditionName, const QString & relationName /*= "general"*/)
 	:m_anchorObjName(anchorName), m_actObjName(actName), m_conditionName(conditionName), m_relationName(relationName)
@@ -39,28 +37,6 @@ void PairwiseRelationModel::fitGMM(int instanceTh)
 		return;
 	}
 
-	//double *observations = new double[m_numInstance*3];
-	//double *alignMats = new double[m_numInstance * 16];
-
-	//for (int i=0; i< m_numInstance; i++)
-	//{
-	//	RelativePos &relPos = m_instances[i];
-	//	observations[3 * i] = relPos->pos.x;
-	//	observations[3 * i +1] = relPos->pos.y;
-	//	observations[3 * i +2] = relPos->pos.z;
-
-	//	MathLib::Matrix4d alignM = relPos->anchorAlignMat;  // world to unit bb mat
-	//	for (int j=0; j < 16; j++)
-	//	{
-	//		alignMats[16 * i + j] = alignM.M[j];
-	//	}
-	//}
-
-	//mxArray *observationArray = mxCreateDoubleMatrix(3, m_numInstance, mxREAL);
-	//memcpy((void *)mxGetPr(observationArray), (void *)observations, sizeof(double) * 3 * m_numInstance);
-	//mxArray *alignMatsArray = mxCreateDoubleMatrix(16, m_numInstance, mxREAL);
-	//memcpy((void *)mxGetPr(alignMatsArray), (void *)alignMats, sizeof(double) * 16 * m_numInstance);
-
 	Eigen::MatrixXd observations(4, m_numInstance);
 	Eigen::MatrixXd alignMats(16, m_numInstance);
 	for (int i = 0; i< m_numInstance; i++)
@@ -78,59 +54,23 @@ void PairwiseRelationModel::fitGMM(int instanceTh)
 		}
 	}
 
-	mxArray *observationArray = toMAT(observations);
-	mxArray *alignMatsArray = toMAT(alignMats);
-
-	const int BUFSIZE = 1024;
-	char buffer[BUFSIZE + 1];
-	buffer[BUFSIZE] = '\0';
-	engOutputBuffer(matlabEngine, buffer, BUFSIZE);
-
-	// clear all variables (optional)
-	engEvalString(matlabEngine, "clc;clear;"); 
-	engPutVariable(matlabEngine, "X", observationArray); // put into matlab
-	engPutVariable(matlabEngine, "alignMats", alignMatsArray); // put into matlab
-
-	engEvalString(matlabEngine, "cd \'D:\\Graphics\\T2S\\text2scene-learning\\scene_lab'");
-	engEvalString(matlabEngine, "[isFitSuccess, mus, sigmas, weights, numComp, pTh] = fitGMMWithAIC(X, 4, alignMats);");
+	// seeded by the relation key, so the fit does not depend on the order models are fitted in
+	GMMFitter fitter(qHash(m_relationKey));
 
-	printf("%s\n", buffer); // get error messages or prints (optional)
+	if (m_GMM != NULL)
+	{
+		delete m_GMM;
+	}
 
-	mxArray *isFitSuccess = engGetVariable(matlabEngine, "isFitSuccess");
-	mxArray *mus = engGetVariable(matlabEngine, "mus");
-	mxArray *sigmas = engGetVariable(matlabEngine, "sigmas");
-	mxArray *weights = engGetVariable(matlabEngine, "weights");
-	mxArray *numComp = engGetVariable(matlabEngine, "numComp");
-	mxArray *pTh = engGetVariable(matlabEngine, "pTh");
+	m_GMM = fitter.fitWithAIC(observations, alignMats, 4);
 
-	int isGuassFitted = mxGetScalar(isFitSuccess);
-	if (!isGuassFitted)
+	if (m_GMM == NULL)
 	{
 		m_numGauss = 0;
 		return;
 	}
 
-	m_numGauss = mxGetScalar(numComp);
-	Eigen::Map<Eigen::MatrixXd> probTh = fromMATd(pTh);
-	Eigen::Map<Eigen::MatrixXd> gaussMus = fromMATd(mus);
-	std::vector<Eigen::Map<Eigen::MatrixXd>> gaussSigmas = from3DMATd(sigmas, m_numGauss);
-	Eigen::Map<Eigen::MatrixXd> gaussMixWeights = fromMATd(weights);
-
-	m_GMM = new GaussianMixtureModel(m_numGauss);
-	m_GMM->m_probTh = probTh.row(0);
-
-	for (int i=0; i < m_numGauss; i++)
-	{
-		int gaussDim = gaussMus.cols();
-		double gaussWeight = gaussMixWeights(i);
-
-		Eigen::VectorXd mean = gaussMus.row(i);
-		Eigen::MatrixXd covarMat = gaussSigmas[i];
-		
-		GaussianModel* newGauss = new GaussianModel(gaussDim, gaussWeight, mean, covarMat);
-
-		m_GMM->m_gaussians[i] = newGauss;
-	}
+	m_numGauss = m_GMM->m_numGauss;
 }
 
 void PairwiseRelationModel::output(QTextStream &ofs)
@@ -168,52 +108,93 @@ void PairwiseRelationModel::output(QTextStream &ofs)
 	}
 }
 
+void RelativePos::extractObjFeatures(CScene *scene)
+{
+	m_hasObjFeatures = extractObjFeatures(scene, m_anchorObjId, m_objFeatures[0]) && extractObjFeatures(scene, m_actObjId, m_objFeatures[1]);
+}
+
+void RelativePos::setObjFeatures(const double *anchorFeatures, const double *actFeatures)
+{
+	std::copy(anchorFeatures, anchorFeatures + ObjFeatureDim, m_objFeatures[0]);
+	std::copy(actFeatures, actFeatures + ObjFeatureDim, m_objFeatures[1]);
+	m_hasObjFeatures = true;
+}
+
+bool RelativePos::extractObjFeatures(CScene *scene, int objId, double *features)
+{
+	if (objId < 0 || objId >= scene->getModelNum())
+	{
+		return false;
+	}
+
+	CModel *currModel = scene->getModel(objId);
+	double heightToFloor = currModel->getOBBBottomHeight() - scene->getFloorHeight();
+	double modelHeight = currModel->getOBBHeight();
+	double modelVolume = currModel->getOBBVolume();
+
+	double xRange = currModel->getHorizonShortRange();  // treat x as horizon short range of OBB
+	double yRange = currModel->getHorizonLongRange();
+
+	features[0] = heightToFloor;
+	features[1] = modelHeight;
+	features[2] = modelVolume;
+	features[3] = modelHeight / xRange;
+	features[4] = modelHeight / yRange;
+	features[5] = yRange / xRange;
+
+	return true;
+}
+
 void PairwiseRelationModel::computeObjNodeFeatures(const std::vector<CScene*> &sceneList, std::map<QString, int> &sceneNameToIdMap)
 {
 	int instanceNum = m_instances.size();
-	int featureDim = 6;
+	int featureDim = ObjFeatureDim;
 	m_avgObjFeatures.resize(2, std::vector<double>(featureDim, 0));
 
-	std::vector<int> modelIds(2);
+	int usedNum = 0;
 
 	for (int i =0; i < instanceNum; i++)
 	{
 		RelativePos *relPos = m_instances[i];
-		int sceneId = sceneNameToIdMap[relPos->m_sceneName];
-		CScene *currScene = sceneList[sceneId];
 
-		modelIds[0] = relPos->m_anchorObjId;
-		modelIds[1] = relPos->m_actObjId;
+		// features of streamed scenes are extracted at load, resident scenes can still be read here
+		if (!relPos->m_hasObjFeatures)
+		{
+			auto sceneIter = sceneNameToIdMap.find(relPos->m_sceneName);
+			if (sceneIter == sceneNameToIdMap.end())
+			{
+				continue;
+			}
+
+			relPos->extractObjFeatures(sceneList[sceneIter->second]);
+
+			if (!relPos->m_hasObjFeatures)
+			{
+				continue;
+			}
+		}
 
 		for (int m = 0; m < 2; m++)
 		{
-			CModel *currModel = currScene->getModel(modelIds[m]);
-			double heightToFloor = currModel->getOBBBottomHeight() - currScene->getFloorHeight();
-			m_avgObjFeatures[m][0] += heightToFloor;
-			
-			double modelHeight = currModel->getOBBHeight();
-			m_avgObjFeatures[m][1] += modelHeight;
-
-			double modelVolume = currModel->getOBBVolume();
-			m_avgObjFeatures[m][2] += modelVolume;
-
-			double xRange = currModel->getHorizonShortRange();  // treat x as horizon short range of OBB
-			double yRange = currModel->getHorizonLongRange();
-			double xzRatio = modelHeight/xRange;
-			double yzRatio = modelHeight/yRange;
-			double xyRatio = yRange / xRange;
-
-			m_avgObjFeatures[m][3] += xzRatio;
-			m_avgObjFeatures[m][4] += yzRatio;
-			m_avgObjFeatures[m][5] += xyRatio;
+			for (int d = 0; d < featureDim; d++)
+			{
+				m_avgObjFeatures[m][d] += relPos->m_objFeatures[m][d];
+			}
 		}
+
+		usedNum++;
+	}
+
+	if (usedNum == 0)
+	{
+		return;
 	}
 
 	for (int m = 0; m < 2; m++)
 	{
 		for (int d=0; d < featureDim; d++)
 		{
-			m_avgObjFeatures[m][d] /= instanceNum;
+			m_avgObjFeatures[m][d] /= usedNum;
 		}
 	}
 }
@@ -275,12 +256,22 @@ void GroupRelationModel::computeOccurrence()
 
 void GroupRelationModel::fitGMMs()
 {
-	int id = 0;
-	m_pairModelKeys.resize(m_pairwiseModels.size());
 	for (auto iter = m_pairwiseModels.begin(); iter!=m_pairwiseModels.end(); iter++)
 	{
 		PairwiseRelationModel *relModel = iter->second;
 		relModel->fitGMM(15);
+	}
+
+	updatePairModelKeys();
+}
+
+void GroupRelationModel::updatePairModelKeys()
+{
+	int id = 0;
+	m_pairModelKeys.resize(m_pairwiseModels.size());
+	for (auto iter = m_pairwiseModels.begin(); iter != m_pairwiseModels.end(); iter++)
+	{
+		PairwiseRelationModel *relModel = iter->second;
 		relModel->m_modelId = id;
 
 		m_pairModelKeys[id] = relModel->m_relationKey;
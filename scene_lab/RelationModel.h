@@ -4,12 +4,21 @@
 
 class CScene;
 
+const int ObjFeatureDim = 6;  // heightToFloor, modelHeight, modelVolume, xzRatio, yzRatio, xyRatio
+
 class RelativePos
 {
 public:
-	RelativePos() {};
+	RelativePos() { m_hasObjFeatures = false; };
 	~RelativePos() {};
 
+	// features of anchor and act obj, taken while the scene is loaded so models can be built after it is freed
+	void extractObjFeatures(CScene *scene);
+	void setObjFeatures(const double *anchorFeatures, const double *actFeatures);
+
+	// features of one obj, false if the obj is not in the scene
+	static bool extractObjFeatures(CScene *scene, int objId, double *features);
+
 	MathLib::Vector3 pos;  // rel pos of actObj in anchor's unit frame
 	double theta;
 	MathLib::Matrix4d anchorAlignMat;  // transformation of anchorObj to unit frame
@@ -19,16 +28,17 @@ public:
 	QString m_actObjName;
 	QString m_anchorObjName;
 	QString m_conditionName;
-	QString m_instanceNameHash;  // anchorObjName_actObjName_conditionName
 
 
 	int m_actObjId;
 	int m_anchorObjId;
 	QString m_sceneName;
-	QString m_instanceIdHash;  // sceneName_anchorObjId_actObjId
 
 
 	bool isValid;
+
+	double m_objFeatures[2][ObjFeatureDim];  // anchor, act
+	bool m_hasObjFeatures;
 };
 
 
@@ -106,6 +116,7 @@ public:
 
 	void computeOccurrence();
 	void fitGMMs();
+	void updatePairModelKeys();  // model ids and keys in map order, after the pairwise models are fitted
 	void output(QTextStream &ofs);
 
 public:
@@ -1,15 +1,40 @@
 #include "RelationModelManager.h"
 #include "RelationExtractor.h"
+#include "RelationModelSimilarity.h"
 #include "../common/geometry/Scene.h"
 #include "../common/geometry/CModel.h"
+#include "../common/geometry/RelPosFile.h"
+#include "SceneRelationRecord.h"
 #include "../t2scene/SceneSemGraph.h"
 
-#include "engine.h"
-extern Engine *matlabEngine;
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <algorithm>
+#include <limits>
+
+// models of a symbol keyed map in the order of their string keys, model ids and saved files follow this order
+template<typename T, typename KeyFunc>
+static std::vector<T*> sortModelsByStringKey(const std::unordered_map<SymbolKey, T*> &models, KeyFunc getStringKey)
+{
+	std::vector<T*> sortedModels;
+	sortedModels.reserve(models.size());
+
+	for (auto iter = models.begin(); iter != models.end(); iter++)
+	{
+		sortedModels.push_back(iter->second);
+	}
+
+	std::sort(sortedModels.begin(), sortedModels.end(), [&](T *a, T *b) { return getStringKey(a) < getStringKey(b); });
+
+	return sortedModels;
+}
 
 RelationModelManager::RelationModelManager(RelationExtractor *mExtractor)
-	:m_relationExtractor(mExtractor)
+	:m_relationExtractor(mExtractor), m_sceneSymbols(std::numeric_limits<int>::max())
 {
+	m_fitThreadNum = 0;
+
 	m_adjustFrontObjs.push_back("desk");
 	m_adjustFrontObjs.push_back("bookcase");
 	m_adjustFrontObjs.push_back("cabinet");
@@ -23,7 +48,7 @@ RelationModelManager::~RelationModelManager()
 {
 	for (auto it = m_relativePostions.begin(); it != m_relativePostions.end(); it++)
 	{
-		delete it->second;
+		delete it->second.relPos;
 	}
 
 	for (auto it = m_pairwiseRelModels.begin(); it != m_pairwiseRelModels.end(); it++)
@@ -48,6 +73,45 @@ void RelationModelManager::updateCurrScene(CScene *s)
 	m_relationExtractor->updateCurrScene(m_currScene);
 }
 
+void RelationModelManager::fitGMMsInParallel(const std::vector<PairwiseRelationModel*> &relModels, const QString &modelTypeName)
+{
+	int totalNum = relModels.size();
+
+	int threadNum = m_fitThreadNum > 0 ? m_fitThreadNum : std::thread::hardware_concurrency();
+	threadNum = std::max(1, std::min(threadNum, totalNum));
+
+	std::atomic<int> nextModelId(0);
+	std::mutex outputMutex;
+	int fittedNum = 0;
+
+	auto fitWorker = [&]()
+	{
+		int modelId;
+		while ((modelId = nextModelId++) < totalNum)
+		{
+			relModels[modelId]->fitGMM(15);
+
+			std::lock_guard<std::mutex> lock(outputMutex);
+			std::cout << modelTypeName.toStdString() << " model fitted " << QString("%1/%2\r").arg(++fittedNum).arg(totalNum).toStdString();
+		}
+	};
+
+	std::vector<std::thread> workers;
+	for (int t = 1; t < threadNum; t++)
+	{
+		workers.push_back(std::thread(fitWorker));
+	}
+
+	fitWorker();
+
+	for (int t = 0; t < workers.size(); t++)
+	{
+		workers[t].join();
+	}
+
+	std::cout << "\n";
+}
+
 void RelationModelManager::collectRelativePosInCurrScene()
 {
 	int modelNum = m_currScene->getModelNum();
@@ -100,13 +164,30 @@ void RelationModelManager::loadRelativePosFromCurrScene()
 
 		}	*/
 
+	if (loadRelativePosFromFile(filename))
+	{
+		qDebug() << "RelationModelManager: loaded relative position for scene " << m_currScene->getSceneName();
+	}
+	else
+	{
+		qDebug() << "RelationModelManager: cannot load relative position for scene " << m_currScene->getSceneName();
+	}
+}
+
+bool RelationModelManager::loadRelativePosFromFile(const QString &filename)
+{
+	if (CRelPosFile::isBinaryFile(filename))
+	{
+		return loadRelativePosFromBinaryFile(filename);
+	}
+
+	// text files written before the binary format
 	QFile inFile(filename);
 	QTextStream ifs(&inFile);
 
 	if (!inFile.open(QIODevice::ReadOnly))
 	{
-		qDebug() << "RelationModelManager: cannot load relative position for scene " << m_currScene->getSceneName();
-		return;
+		return false;
 	}
 
 	while (!ifs.atEnd())
@@ -115,7 +196,6 @@ void RelationModelManager::loadRelativePosFromCurrScene()
 		std::vector<std::string> parts = PartitionString(currLine.toStdString(), ",");
 		
 		RelativePos *relPos = new RelativePos();
-		relPos->m_instanceNameHash = toQString(parts[0]);
 		std::vector<std::string> subParts = PartitionString(parts[0], "_");
 		relPos->m_anchorObjName = toQString(subParts[0]);
 		relPos->m_actObjName = toQString(subParts[1]);
@@ -125,7 +205,6 @@ void RelationModelManager::loadRelativePosFromCurrScene()
 		relPos->m_sceneName = toQString(subParts[0]);
 		relPos->m_anchorObjId = StringToInt(subParts[1]);
 		relPos->m_actObjId = StringToInt(subParts[2]);
-		relPos->m_instanceIdHash = QString("%1_%2_%3").arg(relPos->m_sceneName).arg(relPos->m_anchorObjId).arg(relPos->m_actObjId);
 
 		currLine = ifs.readLine();
 		parts = PartitionString(currLine.toStdString(), ",");
@@ -140,77 +219,223 @@ void RelationModelManager::loadRelativePosFromCurrScene()
 		transformVec = StringToFloatList(parts[2], "");
 		relPos->actAlignMat = MathLib::Matrix4d(transformVec);
 
-		m_relativePostions[relPos->m_instanceIdHash] = relPos;
+		relPos->isValid = true;
+
+		RelativePosEntry entry;
+		entry.relPos = relPos;
+		entry.row = -1;
+		entry.anchorSymId = m_symbols.intern(relPos->m_anchorObjName);
+		entry.actSymId = m_symbols.intern(relPos->m_actObjName);
+		entry.conditionSymId = m_symbols.intern(relPos->m_conditionName);
+
+		addRelativePos(entry, m_sceneSymbols.intern(relPos->m_sceneName), relPos->m_anchorObjId, relPos->m_actObjId);
 	}
 
 	inFile.close();
 
-	qDebug() << "RelationModelManager: loaded relative position for scene " << m_currScene->getSceneName();
+	return true;
+}
+
+bool RelationModelManager::loadRelativePosFromBinaryFile(const QString &filename)
+{
+	CRelPosFile relPosFile;
+	if (!relPosFile.open(filename))
+	{
+		return false;
+	}
+
+	int rowNum = relPosFile.getRowNum();
+	int firstRow = m_relPosColumns.posThetas.size() / 4;
+
+	m_relPosColumns.posThetas.insert(m_relPosColumns.posThetas.end(), relPosFile.m_posThetas, relPosFile.m_posThetas + 4 * rowNum);
+	m_relPosColumns.anchorAlignMats.insert(m_relPosColumns.anchorAlignMats.end(), relPosFile.m_anchorAlignMats, relPosFile.m_anchorAlignMats + 16 * rowNum);
+	m_relPosColumns.actAlignMats.insert(m_relPosColumns.actAlignMats.end(), relPosFile.m_actAlignMats, relPosFile.m_actAlignMats + 16 * rowNum);
+
+	// scene names and the other names of the file go to different tables, ids are resolved on first use
+	std::vector<int> fileSymIds(relPosFile.getNameNum(), -1);
+	std::vector<int> fileSceneIds(relPosFile.getNameNum(), -1);
+
+	auto getSymId = [&](int nameId)
+	{
+		if (fileSymIds[nameId] < 0)
+		{
+			fileSymIds[nameId] = m_symbols.intern(relPosFile.getName(nameId));
+		}
+
+		return fileSymIds[nameId];
+	};
+
+	for (int i = 0; i < rowNum; i++)
+	{
+		int &sceneId = fileSceneIds[relPosFile.m_sceneNameIds[i]];
+		if (sceneId < 0)
+		{
+			sceneId = m_sceneSymbols.intern(relPosFile.getName(relPosFile.m_sceneNameIds[i]));
+		}
+
+		RelativePosEntry entry;
+		entry.relPos = NULL;
+		entry.row = firstRow + i;
+		entry.anchorSymId = getSymId(relPosFile.m_anchorNameIds[i]);
+		entry.actSymId = getSymId(relPosFile.m_actNameIds[i]);
+		entry.conditionSymId = getSymId(relPosFile.m_conditionNameIds[i]);
+
+		addRelativePos(entry, sceneId, relPosFile.m_anchorObjIds[i], relPosFile.m_actObjIds[i]);
+	}
+
+	relPosFile.close();
+
+	return true;
+}
+
+void RelationModelManager::addRelativePos(const RelativePosEntry &entry, int sceneId, int anchorObjId, int actObjId)
+{
+	// obj ids are packed in 16 bits
+	if (anchorObjId < 0 || anchorObjId >= RelationSymbolTable::MaxSymbolNum || actObjId < 0 || actObjId >= RelationSymbolTable::MaxSymbolNum)
+	{
+		std::cout << "\tRelationModelManager: obj id out of range in scene " << m_sceneSymbols.getName(sceneId).toStdString() << "\n";
+		delete entry.relPos;
+		return;
+	}
+
+	m_relativePostions[RelationSymbolTable::packSceneObjKey(sceneId, anchorObjId, actObjId)] = entry;
+}
+
+RelativePos* RelationModelManager::getRelativePos(SymbolKey key, RelativePosEntry &entry)
+{
+	if (entry.relPos != NULL)
+	{
+		return entry.relPos;
+	}
+
+	RelativePos *relPos = new RelativePos();
+
+	relPos->m_anchorObjName = m_symbols.getName(entry.anchorSymId);
+	relPos->m_actObjName = m_symbols.getName(entry.actSymId);
+	relPos->m_conditionName = m_symbols.getName(entry.conditionSymId);
+
+	relPos->m_sceneName = m_sceneSymbols.getName((int)(key >> 32));
+	relPos->m_anchorObjId = (key >> 16) & 0xFFFF;
+	relPos->m_actObjId = key & 0xFFFF;
+
+	const float *posTheta = &m_relPosColumns.posThetas[4 * entry.row];
+	relPos->pos = MathLib::Vector3(posTheta[0], posTheta[1], posTheta[2]);
+	relPos->theta = posTheta[3];
+
+	relPos->anchorAlignMat = MathLib::Matrix4d(&m_relPosColumns.anchorAlignMats[16 * entry.row]);
+	relPos->actAlignMat = MathLib::Matrix4d(&m_relPosColumns.actAlignMats[16 * entry.row]);
+	relPos->isValid = true;
+
+	entry.relPos = relPos;
+	return relPos;
+}
+
+RelativePos* RelationModelManager::findRelativePos(const SceneRelationRecord &record, int sceneId, int anchorObjId, int actObjId, int &conditionSymId)
+{
+	if (anchorObjId < 0 || anchorObjId >= RelationSymbolTable::MaxSymbolNum || actObjId < 0 || actObjId >= RelationSymbolTable::MaxSymbolNum)
+	{
+		return NULL;
+	}
+
+	auto iter = m_relativePostions.find(RelationSymbolTable::packSceneObjKey(sceneId, anchorObjId, actObjId));
+	if (iter == m_relativePostions.end())
+	{
+		return NULL;
+	}
+
+	conditionSymId = iter->second.conditionSymId;
+	RelativePos *relPos = getRelativePos(iter->first, iter->second);
+
+	// obj features come with the record, the scene itself may not be loaded
+	if (!relPos->m_hasObjFeatures)
+	{
+		record.getObjFeatures(anchorObjId, actObjId, relPos);
+	}
+
+	return relPos;
+}
+
+void RelationModelManager::internRecordNames(const SceneRelationRecord &record, std::vector<int> &symIds)
+{
+	const RelationSymbolTable &recordSymbols = record.m_stats.m_symbols;
+
+	symIds.resize(recordSymbols.size());
+	for (int i = 0; i < symIds.size(); i++)
+	{
+		symIds[i] = m_symbols.intern(recordSymbols.getName(i));
+	}
 }
 
 void RelationModelManager::buildRelativeRelationModels()
 {
-	// collect instance ids for relative models
-	for(auto it = m_relativePostions.begin(); it!=m_relativePostions.end(); it++)
+	// instances in the order of scene name, anchor obj id and act obj id
+	std::vector<int> sceneRanks(m_sceneSymbols.size());
 	{
-		RelativePos *relPos = it->second;
-		QString relationKey = relPos->m_instanceNameHash;
+		std::vector<int> sceneIds(m_sceneSymbols.size());
+		for (int i = 0; i < sceneIds.size(); i++)
+		{
+			sceneIds[i] = i;
+		}
 
-		if (!m_relativeModels.count(relationKey))
+		std::sort(sceneIds.begin(), sceneIds.end(), [this](int a, int b) { return m_sceneSymbols.getName(a) < m_sceneSymbols.getName(b); });
+
+		for (int r = 0; r < sceneIds.size(); r++)
 		{
-			PairwiseRelationModel *relativeModel = new PairwiseRelationModel(relPos->m_anchorObjName, relPos->m_actObjName, relPos->m_conditionName, "general");
-			
-			relativeModel->m_instances.push_back(relPos);
-			m_relativeModels[relationKey] = relativeModel;
+			sceneRanks[sceneIds[r]] = r;
 		}
-		else
-			m_relativeModels[relationKey]->m_instances.push_back(relPos); 
+	}
 
-		m_relativeModels[relationKey]->m_numInstance = m_relativeModels[relationKey]->m_instances.size();
+	typedef std::pair<const SymbolKey, RelativePosEntry> RelativePosItem;
+	std::vector<std::pair<SymbolKey, RelativePosItem*>> sortedItems;
+	sortedItems.reserve(m_relativePostions.size());
+	for (auto it = m_relativePostions.begin(); it != m_relativePostions.end(); it++)
+	{
+		SymbolKey sortKey = ((SymbolKey)sceneRanks[it->first >> 32] << 32) | (it->first & 0xFFFFFFFF);
+		sortedItems.push_back(std::make_pair(sortKey, &*it));
 	}
 
-	// 1. Open MATLAB engine
-	matlabEngine = engOpen(NULL);
+	std::sort(sortedItems.begin(), sortedItems.end(), [](const std::pair<SymbolKey, RelativePosItem*> &a, const std::pair<SymbolKey, RelativePosItem*> &b) { return a.first < b.first; });
 
-	// fit GMM model
-	int id = 0;
-	int totalNum = m_relativeModels.size();
-	for (auto iter = m_relativeModels.begin(); iter != m_relativeModels.end(); iter++)
+	// collect instance ids for relative models
+	for (int i = 0; i < sortedItems.size(); i++)
 	{
-		PairwiseRelationModel *relModel = iter->second;
-		relModel->fitGMM(15);
+		RelativePosItem *item = sortedItems[i].second;
+		RelativePosEntry &entry = item->second;
+		SymbolKey relationKey = RelationSymbolTable::packKey(entry.anchorSymId, entry.actSymId, entry.conditionSymId);
 
-		std::cout << "Relative model fitted " << QString("%1/%2\r").arg(++id).arg(totalNum).toStdString();
+		// streamed scenes are freed by now, relative models do not use obj features
+		RelativePos *relPos = getRelativePos(item->first, entry);
+
+		PairwiseRelationModel *&relativeModel = m_relativeModels[relationKey];
+		if (relativeModel == NULL)
+		{
+			relativeModel = new PairwiseRelationModel(relPos->m_anchorObjName, relPos->m_actObjName, relPos->m_conditionName, "general");
+		}
+
+		relativeModel->m_instances.push_back(relPos);
+		relativeModel->m_numInstance = relativeModel->m_instances.size();
 	}
 
-	// 3. Close MATLAB engine
-	engClose(matlabEngine);
+	// fit GMM model
+	std::vector<PairwiseRelationModel*> relModels = sortModelsByStringKey(m_relativeModels, [](PairwiseRelationModel *m) { return m->m_relationKey; });
+
+	fitGMMsInParallel(relModels, "Relative");
 
 	qDebug() << "Relative relations extracted";
 }
 
 void RelationModelManager::buildPairwiseRelationModels()
 {
-	// 1. Open MATLAB engine
-	matlabEngine = engOpen(NULL);
+	// model ids follow the order of relation keys
+	m_sortedPairRelModels = sortModelsByStringKey(m_pairwiseRelModels, [](PairwiseRelationModel *m) { return m->m_relationKey; });
 
-	// fit GMM model
-	int id = 0;
-	int totalNum = m_pairwiseRelModels.size();
-	m_pairRelModelKeys.resize(totalNum);
-
-	for (auto iter = m_pairwiseRelModels.begin(); iter != m_pairwiseRelModels.end(); iter++)
+	for (int id = 0; id < m_sortedPairRelModels.size(); id++)
 	{
-		PairwiseRelationModel *relModel = iter->second;
-		relModel->fitGMM(15);
-		relModel->m_modelId = id;
-		m_pairRelModelKeys[id] = relModel->m_relationKey;
-
-		std::cout << "Pairwise model fitted " << QString("%1/%2\r").arg(++id).arg(totalNum).toStdString();
+		m_sortedPairRelModels[id]->m_modelId = id;
 	}
 
-	// 3. Close MATLAB engine
-	engClose(matlabEngine);
+	// fit GMM model
+	fitGMMsInParallel(m_sortedPairRelModels, "Pairwise");
 
 	qDebug() << "Pairwise relations extracted";
 }
@@ -218,49 +443,48 @@ void RelationModelManager::buildPairwiseRelationModels()
 // collect the observed instances for pair-wise relations in current scene
 void RelationModelManager::collectPairwiseInstanceFromCurrScene()
 {
-	SceneSemGraph *currSSG = m_currScene->m_ssg;
-	QString sceneName = m_currScene->getSceneName();
+	SceneRelationRecord record;
+	record.collectFromScene(m_currScene);
 
-	for (int i = 0; i < currSSG->m_nodeNum; i++)
-	{
-		SemNode &sgNode = currSSG->m_nodes[i];
+	addPairwiseInstances(record);
+}
 
-		if (sgNode.nodeType.contains(SSGNodeTypeStrings[SSGNodeType::PairRel]))
-		{
-			int anchorNodeId = sgNode.anchorNodeList[0];
-			int actNodeId = sgNode.activeNodeList[0];
+void RelationModelManager::addPairwiseInstances(const SceneRelationRecord &record)
+{
+	int sceneId = m_sceneSymbols.intern(record.m_sceneName);
 
-			QString anchorObjName = currSSG->m_nodes[anchorNodeId].nodeName;
-			QString actObjName = currSSG->m_nodes[actNodeId].nodeName;
-			QString conditionName;
+	std::vector<int> symIds;
+	internRecordNames(record, symIds);
 
-			QString instanceIdHash = QString("%1_%2_%3").arg(sceneName).arg(anchorNodeId).arg(actNodeId);
+	for (int i = 0; i < record.m_pairInstances.size(); i++)
+	{
+		const SceneRelationRecord::PairInstance &pairInstance = record.m_pairInstances[i];
 
-			// find condition name in observed relPos
-			if (m_relativePostions.count(instanceIdHash))
-			{
-				RelativePos *relPos = m_relativePostions[instanceIdHash];
-				conditionName = relPos->m_conditionName;
-				QString relationKey = anchorObjName + "_" + actObjName + "_" + conditionName + "_" + sgNode.nodeName;
+		// find condition name in observed relPos
+		int conditionSymId;
+		RelativePos *relPos = findRelativePos(record, sceneId, pairInstance.anchorObjId, pairInstance.actObjId, conditionSymId);
 
-				if (!m_pairwiseRelModels.count(relationKey))
-				{
-					PairwiseRelationModel *newPairwiseModel = new PairwiseRelationModel(anchorObjName, actObjName, conditionName, sgNode.nodeName);
-					newPairwiseModel->m_instances.push_back(relPos);
-					m_pairwiseRelModels[relationKey] = newPairwiseModel;
-				}
-				else
-				{
-					m_pairwiseRelModels[relationKey]->m_instances.push_back(relPos);
-				}
+		if (relPos != NULL)
+		{
+			int anchorSymId = symIds[pairInstance.anchorSymId];
+			int actSymId = symIds[pairInstance.actSymId];
+			int relationSymId = symIds[pairInstance.relationSymId];
+
+			SymbolKey relationKey = RelationSymbolTable::packKey(anchorSymId, actSymId, conditionSymId, relationSymId);
 
-				m_pairwiseRelModels[relationKey]->m_numInstance++;
+			PairwiseRelationModel *&pairwiseModel = m_pairwiseRelModels[relationKey];
+			if (pairwiseModel == NULL)
+			{
+				pairwiseModel = new PairwiseRelationModel(m_symbols.getName(anchorSymId), m_symbols.getName(actSymId), relPos->m_conditionName, m_symbols.getName(relationSymId));
 			}
+
+			pairwiseModel->m_instances.push_back(relPos);
+			pairwiseModel->m_numInstance++;
 		}
 	}
 }
 
-void RelationModelManager::computeSimForPairwiseModels(std::map<QString, PairwiseRelationModel*> &pairModels, const std::vector<QString> &pairModelKeys, const std::vector<CScene*> &sceneList, bool isInGroup, const QString &filePath)
+void RelationModelManager::computeSimForPairwiseModels(const std::vector<PairwiseRelationModel*> &pairModels, const std::vector<CScene*> &sceneList, bool isInGroup)
 {
 	qDebug() << "Computing similarity between pairwise models...";
 	int sceneNum = sceneList.size();
@@ -291,13 +515,11 @@ void RelationModelManager::computeSimForPairwiseModels(std::map<QString, Pairwis
 			QString conditionType = ConditionName[c];
 
 			// collect pair models with same relation and condition type
-			std::vector<int> pairModelIds;
-			std::map<int, int> globalToLocalIdMap;
+			std::vector<PairwiseRelationModel*> relModels;
 
-			int id = 0;
-			for (auto iter = pairModels.begin(); iter != pairModels.end(); iter++)
+			for (int i = 0; i < pairModels.size(); i++)
 			{
-				PairwiseRelationModel *relModel = iter->second;
+				PairwiseRelationModel *relModel = pairModels[i];
 				QString currConditionName = relModel->m_conditionName;
 
 				if (currConditionName == ConditionName[ConditionType::Spec])
@@ -308,154 +530,21 @@ void RelationModelManager::computeSimForPairwiseModels(std::map<QString, Pairwis
 				if (relModel->m_relationName == relType && currConditionName == conditionType)
 				{
 					relModel->computeObjNodeFeatures(sceneList, sceneNameToIdMap);
-					pairModelIds.push_back(relModel->m_modelId);
-
-					globalToLocalIdMap[relModel->m_modelId] = id;
-					id++;
-				}
-			}
-
-			std::vector<double> maxHeightToFloor(2,0), maxModelHeight(2,0), maxVolume(2, 0);  // max of avg of different models
-			int featureDim = 3;  // used feature dimension
-			std::vector<std::vector<double>> maxFeatures(2, std::vector<double>(featureDim, 0));
-
-			// collect max value for normalization
-			for (int m = 0; m < 2; m++)
-			{
-				for (int i = 0; i < pairModelIds.size(); i++)
-				{
-					QString modelKeyA = pairModelKeys[pairModelIds[i]];
-					PairwiseRelationModel *relModelA = pairModels[modelKeyA];
-
-					for (int d=0; d < featureDim; d++)
-					{
-						if (relModelA->m_avgObjFeatures[m][d] > maxFeatures[m][d]) maxFeatures[m][d] = relModelA->m_avgObjFeatures[m][d];
-					}
-
-					for (int j = 0; j < pairModelIds.size(); j++)
-					{
-						if (i == j) continue;
-						QString modelKeyB = pairModelKeys[pairModelIds[j]];
-						PairwiseRelationModel *relModelB = pairModels[modelKeyB];
-
-						for (int d = 0; d < featureDim; d++)
-						{
-							if (relModelB->m_avgObjFeatures[m][d] > maxFeatures[m][d]) maxFeatures[m][d] = relModelB->m_avgObjFeatures[m][d];
-						}
-					}
+					relModels.push_back(relModel);
 				}
 			}
 
-			// compute similarity
-			Eigen::MatrixXd simMat(pairModelIds.size(), pairModelIds.size());
-			double featureWeights[] = { 1,1,1,0.5,0.5,0.5 };
-			double catWeight = 0.3;			
+			std::vector<bool> isAdjustFront(relModels.size());
 
-			for (int i = 0; i < pairModelIds.size(); i++)
+			for (int i = 0; i < relModels.size(); i++)
 			{
-				QString modelKeyA = pairModelKeys[pairModelIds[i]];
-				PairwiseRelationModel *relModelA = pairModels[modelKeyA];
-				relModelA->m_maxObjFeatures = maxFeatures;
-
-				for (int j = 0; j < pairModelIds.size(); j++)
-				{
-					if (i == j) continue;
-
-					QString modelKeyB = pairModelKeys[pairModelIds[j]];
-					PairwiseRelationModel *relModelB = pairModels[modelKeyB];
-
-					if (isAnchorFrontDirConsistent(relModelA->m_anchorObjName, relModelB->m_anchorObjName))
-					{
-						std::vector<double> simVal(2, 0);
-						std::vector<double> geoSim(2, 0);
-						std::vector<double> catSim(2, 0);
-
-						if (relModelA->m_anchorObjName == relModelB->m_anchorObjName) catSim[0] = 1;
-						if (relModelA->m_actObjName == relModelB->m_actObjName) catSim[1] = 1;
-
-						for (int m = 0; m < 2; m++)
-						{
-							for (int d = 0; d < featureDim; d++)
-							{
-								geoSim[m] += featureWeights[d] * exp(-pow((relModelA->m_avgObjFeatures[m][d] - relModelB->m_avgObjFeatures[m][d]) / (maxFeatures[m][d] + 1e-3), 2));
-							}
-
-							geoSim[m] /= featureDim;
-							simVal[m] = catWeight*catSim[m] + (1 - catWeight)*geoSim[m];
-						}
-						simMat(i, j) = simVal[0] * simVal[1];
-					}
-					else
-					{
-						simMat(i, j) = 0;
-					}
-				}
+				isAdjustFront[i] = std::find(m_adjustFrontObjs.begin(), m_adjustFrontObjs.end(), relModels[i]->m_anchorObjName) != m_adjustFrontObjs.end();
 			}
 
-			// sort and save similar relation model ids
-			for (int i=0; i < pairModelIds.size(); i++)
-			{
-				std::vector<std::pair<double, int>> simPairs;
-				for (int j=0; j < pairModelIds.size(); j++ )
-				{
-					if (i == j) continue;
-
-					simPairs.push_back(std::make_pair(simMat(i, j), pairModelIds[j]));
-				}
-				std::sort(simPairs.begin(), simPairs.end()); // ascending order
-				std::reverse(simPairs.begin(), simPairs.end()); // descending order
-				
-				QString modelKey = pairModelKeys[pairModelIds[i]];
-				PairwiseRelationModel *relModel = pairModels[modelKey];
-				int topSimNum = 20;
-				for (int k = 0; k < simPairs.size()/2; k++)
-				{
-					if (k < topSimNum)
-					{
-						relModel->m_simModelIds.push_back(simPairs[k].second);
-					}
-				}
-			}
-
-			//// save sim Mat
-			//if (!pairModelIds.empty() && !filePath.isEmpty())
-			//{
-			//	QString filename = filePath + QString("/%1_%2.simMat").arg(relType).arg(conditionType);
-			//	std::ofstream ofs;
-			//	ofs.open(filename.toStdString(), std::ios::out | std::ios::trunc);
-
-			//	if (ofs.is_open())
-			//	{
-			//		for (int i = 0; i < pairModelIds.size(); i++)
-			//		{
-			//			QString modelKey = pairModelKeys[pairModelIds[i]];
-			//			PairwiseRelationModel *relModel = pairModels[modelKey];
-
-			//			ofs << relModel->m_relationKey.toStdString() << ",R_" << relModel->m_modelId << "," << i << "\n";
-			//			int simModelNum = relModel->m_simModelIds.size();
-			//			ofs << simModelNum << ",";
-
-			//			if (simModelNum > 0)
-			//			{
-			//				for (int k = 0; k < simModelNum - 1; k++)
-			//				{
-			//					ofs << relModel->m_simModelIds[k] << " ";
-			//				}
-			//				ofs << relModel->m_simModelIds[simModelNum - 1] << "\n";
-			//				for (int k = 0; k < simModelNum - 1; k++)
-			//				{
-			//					ofs << simMat(i, globalToLocalIdMap[relModel->m_simModelIds[k]]) << ",";
-			//				}
-			//				ofs << simMat(i, globalToLocalIdMap[relModel->m_simModelIds[simModelNum - 1]]) << "\n";
-			//			}
-			//			else
-			//			{
-			//				ofs << "-1\n";
-			//			}
-			//		}
-			//		ofs.close();
-			//	}
-			//}
+			// only the top similar models of each model are kept, no dense similarity matrix is built
+			RelationModelSimilarity simEngine;
+			simEngine.setThreadNum(m_fitThreadNum);
+			simEngine.computeTopSimModels(relModels, isAdjustFront, 20);
 		}
 	}
 }
@@ -465,7 +554,15 @@ void RelationModelManager::computeSimForPairModelInGroup(const std::vector<CScen
 	for (auto giter = m_groupRelModels.begin(); giter != m_groupRelModels.end(); giter++)
 	{
 		GroupRelationModel *groupModel = giter->second;
-		computeSimForPairwiseModels(groupModel->m_pairwiseModels, groupModel->m_pairModelKeys, sceneList, true);
+
+		// map order of the group is its model id order
+		std::vector<PairwiseRelationModel*> pairModels;
+		for (auto iter = groupModel->m_pairwiseModels.begin(); iter != groupModel->m_pairwiseModels.end(); iter++)
+		{
+			pairModels.push_back(iter->second);
+		}
+
+		computeSimForPairwiseModels(pairModels, sceneList, true);
 	}
 }
 
@@ -486,393 +583,77 @@ bool RelationModelManager::isAnchorFrontDirConsistent(const QString &currAnchorN
 	return true;
 }
 
-void RelationModelManager::collectCoOccInCurrentScene()
+static int getCount(const std::unordered_map<SymbolKey, int> &counts, SymbolKey key)
 {
-	SceneSemGraph *currSSG = m_currScene->m_ssg;
-
-	int modeNum = m_currScene->getModelNum();
-	for (int i = 0; i < modeNum; i++)
-	{
-		CModel *currModel = m_currScene->getModel(i);
-
-		if (!currModel->suppChindrenList.empty())
-		{
-			// collect unique support children list
-			std::vector<int> uniqueIds;
-			std::vector<QString> childCats;
-			for (int j = 0; j < currModel->suppChindrenList.size(); j++)
-			{
-				int childModelId = currModel->suppChindrenList[j];
-				CModel *childModel = m_currScene->getModel(childModelId);
-				QString currChildCat = childModel->getCatName();
-
-				if (std::find(childCats.begin(), childCats.end(), currChildCat) == childCats.end())
-				{
-					childCats.push_back(currChildCat);
-					uniqueIds.push_back(childModelId);
-				}
-			}
-
-			for (int j=0; j < uniqueIds.size(); j++)
-			{
-				CModel *firstModel = m_currScene->getModel(uniqueIds[j]);
-				int firstParentModelId = firstModel->suppParentID;
-				QString firstModelCatName = firstModel->getCatName();
-
-				if (firstParentModelId == -1) continue;
-				if (firstModelCatName == "room") continue;
-
-				CModel *parentModel = m_currScene->getModel(firstParentModelId);
-				QString parentCatName = parentModel->getCatName();
-
-				for (int k = 0; k < uniqueIds.size(); k++)
-				{
-					if (k == j) continue;
-
-					CModel *secondModel = m_currScene->getModel(uniqueIds[k]);
-					int secondParentModelId = secondModel->suppParentID;
-					QString secondModelCatName = secondModel->getCatName();
-
-					if (firstParentModelId == secondParentModelId)
-					{
-						QString conditionType = "sibling";
-						QString coOccKey = QString("%1_%2_%3_%4").arg(firstModelCatName).arg(secondModelCatName).arg(conditionType).arg(parentCatName);
-
-						if (m_coOccModelsOnSameParent.count(coOccKey))
-						{
-							m_coOccModelsOnSameParent[coOccKey]->m_coOccNum++;
-						}
-						else
-						{
-							CoOccurrenceModel *newModel = new CoOccurrenceModel(firstModelCatName, secondModelCatName, conditionType, parentCatName);
-							newModel->m_coOccNum++;
-							m_coOccModelsOnSameParent[coOccKey] = newModel;
-						}
-					}
-				}
-			}
-		}
-	}
-
-
-	//for (int i = 0; i < modeNum; i++)
-	//{
-	//	CModel *firstModel = m_currScene->getModel(i);
-	//	int firstParentModelId = firstModel->suppParentID;
-	//	QString firstModelCatName = firstModel->getCatName();
-
-	//	if (firstParentModelId == -1) continue;
-	//	if (firstModelCatName == "room") continue;
-
-	//	CModel *parentModel = m_currScene->getModel(firstParentModelId);
-	//	QString parentCatName = parentModel->getCatName();
-
-	//	for (int j = 0; j < m_currScene->getModelNum(); j++)
-	//	{
-	//		if (i == j) continue;
-
-	//		CModel *secondModel = m_currScene->getModel(j);
-	//		int secondParentModelId = secondModel->suppParentID;
-	//		QString secondModelCatName = secondModel->getCatName();
-
-	//		if (firstParentModelId == secondParentModelId)
-	//		{
-	//			QString conditionType = "sibling";
-	//			QString coOccKey = QString("%1_%2_%3_%4").arg(firstModelCatName).arg(secondModelCatName).arg(conditionType).arg(parentCatName);
-
-	//			if (m_coOccModelsOnSameParent.count(coOccKey))
-	//			{
-	//				m_coOccModelsOnSameParent[coOccKey]->m_coOccNum++;
-	//			}
-	//			else
-	//			{
-	//				CoOccurrenceModel *newModel = new CoOccurrenceModel(firstModelCatName, secondModelCatName, conditionType, parentCatName);
-	//				newModel->m_coOccNum++;
-	//				m_coOccModelsOnSameParent[coOccKey] = newModel;
-	//			}
-	//		}
-	//	}
-	//}
-
-	//std::vector<int> nodeCountedIndicator(modeNum, 0);
-	//for (int i = 0; i < modeNum; i++)
-	//{
-	//	CModel *firstModel = m_currScene->getModel(i);
-	//	int firstParentModelId = firstModel->suppParentID;
-	//	QString firstModelCatName = firstModel->getCatName();
-	//	CModel *parentModel = m_currScene->getModel(firstParentModelId);
-	//	QString parentCatName = parentModel->getCatName();
-
-	//	if (firstModelCatName == "room") continue;
-
-	//	// add instance for first obj
-	//	for (auto iter = m_coOccModelsOnSameParent.begin(); iter != m_coOccModelsOnSameParent.end(); iter++)
-	//	{
-	//		QString coOccKey = iter->first;
-	//		if (coOccKey.left(firstModelCatName.length()) == firstModelCatName && coOccKey.right(parentCatName.length()) == parentCatName)
-	//		{
-	//			CoOccurrenceModel *currModel = iter->second;
-	//			currModel->m_firstObjNum++;
-	//		}
-	//	}
-
-	//	for (int j = 0; j < m_currScene->getModelNum(); j++)
-	//	{
-	//		if (i == j) continue;
-
-	//		CModel *secondModel = m_currScene->getModel(j);
-	//		int secondParentModelId = secondModel->suppParentID;
-	//		QString secondModelCatName = secondModel->getCatName();
-
-	//		if (nodeCountedIndicator[j] == 0)
-	//		{
-	//			// add instance for second obj
-	//			for (auto iter = m_coOccModelsOnSameParent.begin(); iter != m_coOccModelsOnSameParent.end(); iter++)
-	//			{
-	//				QString coOccKey = iter->first;
-	//				QString matchKey = secondModelCatName + "_sibling_" + parentCatName;
-	//				if (coOccKey.right(matchKey.length()) == matchKey)
-	//				{
-	//					CoOccurrenceModel *currModel = iter->second;
-	//					currModel->m_secondObjNum++;
-	//				}
-	//			}
-	//			nodeCountedIndicator[j] = 1;
-	//		}
-	//	}
-	//}
+	auto iter = counts.find(key);
+	return iter != counts.end() ? iter->second : 0;
 }
 
-void RelationModelManager::addOccToCoOccFromSupportRelation()
+void RelationModelManager::collectRelationStatsFromCurrScene()
 {
-	for (auto spIter = m_supportRelations.begin(); spIter!=m_supportRelations.end(); spIter++)
-	{
-		SupportRelation *currSuppRelation = spIter->second;
-		QString childObjName = currSuppRelation->m_childName;
-		QString parentObjName = currSuppRelation->m_parentName;
-
-		for (auto iter = m_coOccModelsOnSameParent.begin(); iter!= m_coOccModelsOnSameParent.end(); iter++)
-		{
-			QString coOccKey = iter->first;
-			if (coOccKey.left(childObjName.length()) == childObjName && coOccKey.right(parentObjName.length()) == parentObjName)
-			{
-				CoOccurrenceModel *currModel = iter->second;
-				currModel->m_firstObjNum += currSuppRelation->m_childInstanceNum;
-			}
-
-			QString matchKey = childObjName + "_sibling_" + parentObjName;
-			if (coOccKey.right(matchKey.length()) == matchKey)
-			{
-				CoOccurrenceModel *currModel = iter->second;
-				currModel->m_secondObjNum += currSuppRelation->m_childInstanceNum;
-			}
-		}
-	}
+	m_relationStats.collectFromScene(m_currScene);
 }
 
-void RelationModelManager::addOccToCoOccFromCurrentScene()
+void RelationModelManager::addRelationStats(const SceneRelationStats &stats)
 {
-	SceneSemGraph *currSSG = m_currScene->m_ssg;
-
-	int modeNum = m_currScene->getModelNum();
-	for (int i = 0; i < modeNum; i++)
-	{
-		CModel *currModel = m_currScene->getModel(i);
-
-		if (!currModel->suppChindrenList.empty())
-		{
-			// collect unique support children list
-			std::vector<int> uniqueIds;
-			std::vector<QString> childCats;
-			for (int j = 0; j < currModel->suppChindrenList.size(); j++)
-			{
-				int childModelId = currModel->suppChindrenList[j];
-				CModel *childModel = m_currScene->getModel(childModelId);
-				QString currChildCat = childModel->getCatName();
-
-				if (std::find(childCats.begin(), childCats.end(), currChildCat) == childCats.end())
-				{
-					childCats.push_back(currChildCat);
-					uniqueIds.push_back(childModelId);
-				}
-			}
-
-			for (int j = 0; j < uniqueIds.size(); j++)
-			{
-				CModel *firstModel = m_currScene->getModel(uniqueIds[j]);
-				int firstParentModelId = firstModel->suppParentID;
-				QString firstModelCatName = firstModel->getCatName();
-
-				if (firstParentModelId == -1) continue;
-				if (firstModelCatName == "room") continue;
-
-				CModel *parentModel = m_currScene->getModel(firstParentModelId);
-				QString parentCatName = parentModel->getCatName();
-
-				for (auto iter = m_coOccModelsOnSameParent.begin(); iter != m_coOccModelsOnSameParent.end(); iter++)
-				{
-					QString coOccKey = iter->first;
-					if (coOccKey.left(firstModelCatName.length()) == firstModelCatName && coOccKey.right(parentCatName.length()) == parentCatName)
-					{
-						CoOccurrenceModel *currCoModel = iter->second;
-						currCoModel->m_firstObjNum += 1;
-					}
+	m_relationStats.merge(stats);
+}
 
-					QString matchKey = firstModelCatName + "_sibling_" + parentCatName;
-					if (coOccKey.right(matchKey.length()) == matchKey)
-					{
-						CoOccurrenceModel *currCoModel = iter->second;
-						currCoModel->m_secondObjNum += 1;
-					}
-				}
-			}
-		}
-	}
+void RelationModelManager::addSceneRecord(const SceneRelationRecord &record)
+{
+	addPairwiseInstances(record);
+	addGroupInstances(record);
+	addRelationStats(record.m_stats);
 }
 
-void RelationModelManager::computeOccToCoccOnSameParent()
+void RelationModelManager::buildSupportRelationModels()
 {
-	for (auto iter = m_coOccModelsOnSameParent.begin(); iter != m_coOccModelsOnSameParent.end(); iter++)
+	for (auto it = m_supportRelations.begin(); it != m_supportRelations.end(); it++)
 	{
-		CoOccurrenceModel *currModel = iter->second;
-		currModel->computCoOccProb();
+		delete it->second;
 	}
-}
 
-void RelationModelManager::collectSupportRelationInCurrentScene()
-{
-	SceneSemGraph *currSSG = m_currScene->m_ssg;
+	m_supportRelations.clear();
+	m_suppProbs.clear();
 
-	// count num of total object observation
-	for (int i = 0; i < currSSG->m_nodeNum; i++)
+	const SceneRelationStats &stats = m_relationStats;
+	std::vector<int> symIds(stats.m_symbols.size());
+	for (int i = 0; i < symIds.size(); i++)
 	{
-		SemNode &sgNode = currSSG->m_nodes[i];
-		if (sgNode.nodeType == "object")
-		{
-			if (m_suppProbs.count(sgNode.nodeName))
-			{
-				m_suppProbs[sgNode.nodeName].totalNum++;
-			}
-			else
-			{
-				SupportProb newSupportProb;
-				newSupportProb.totalNum++;
-				m_suppProbs[sgNode.nodeName] = newSupportProb;
-			}
-		}
+		symIds[i] = m_symbols.intern(stats.m_symbols.getName(i));
 	}
 
-	for (int i = 0; i < currSSG->m_nodeNum; i++)
+	// a child is counted for every parent of any category, a parent for every child of any category
+	for (auto iter = stats.m_suppJointNums.begin(); iter != stats.m_suppJointNums.end(); iter++)
 	{
-		SemNode &sgNode = currSSG->m_nodes[i];
-		if (sgNode.nodeType == "object")
-		{
-			bool isSupportParent = false;
-
-			// vertsupport and horizon support			
-			for (int rt = 0; rt < 2; rt++)
-			{
-				QString supportType = PairRelStrings[rt];
+		int parentSymId = RelationSymbolTable::unpackKey(iter->first, 0);
+		int childSymId = RelationSymbolTable::unpackKey(iter->first, 1);
+		int supportSymId = RelationSymbolTable::unpackKey(iter->first, 2);
 
-				std::vector<int> actNodeList;
-				for (int r = 0; r < sgNode.inEdgeNodeList.size(); r++)
-				{
-					int relNodeId = sgNode.inEdgeNodeList[r];
-					SemNode &relNode = currSSG->m_nodes[relNodeId];
-
-					if (relNode.nodeName == supportType)
-					{
-						actNodeList.push_back(relNode.activeNodeList[0]);
-					}
-				}
-
-				std::vector<int> actNodeCountedIndicator(actNodeList.size(), 0); // whether the node has been counted
-				for (int t = 0; t < actNodeList.size(); t++)
-				{
-					int actNodeId = actNodeList[t];
-					SemNode &actNode = currSSG->m_nodes[actNodeId];
-					QString actObjName = actNode.nodeName;
-
-					// count obj num in current active list
-					int currActObjNum = 0;
-					for (int ai = 0; ai < actNodeList.size(); ai++)
-					{
-						int testNodeId = actNodeList[ai];
-						SemNode &testNode = currSSG->m_nodes[testNodeId];
-						if (actNodeCountedIndicator[ai] == 0 && actObjName == testNode.nodeName)
-						{
-							actNodeCountedIndicator[ai] = 1;
-							currActObjNum++;
-						}
-					}
-				
-					if (currActObjNum)
-					{
-						SemNode &actNode = currSSG->m_nodes[actNodeList[t]];
-						QString suppRelKey = sgNode.nodeName + "_" + actNode.nodeName + "_" + supportType;
-
-						// add instance for joint
-						if (!m_supportRelations.count(suppRelKey))
-						{
-							SupportRelation *newSuppRelation = new SupportRelation(sgNode.nodeName, actNode.nodeName, supportType);
-							newSuppRelation->m_jointInstanceNum++;
-							m_supportRelations[suppRelKey] = newSuppRelation;
-						}
-						else
-						{
-							m_supportRelations[suppRelKey]->m_jointInstanceNum++;
-						}
-
-						// add instance for support child
-						for (auto iter = m_supportRelations.begin(); iter != m_supportRelations.end(); iter++)
-						{
-							SupportRelation *suppRel = iter->second;
-							if (suppRel->m_childName == actNode.nodeName && suppRel->m_supportType == supportType)
-							{
-								suppRel->m_childInstanceNum++;
-							}
-						}
-					}
+		SupportRelation *suppRel = new SupportRelation(stats.m_symbols.getName(parentSymId), stats.m_symbols.getName(childSymId), stats.m_symbols.getName(supportSymId));
+		suppRel->m_jointInstanceNum = iter->second;
+		suppRel->m_parentInstanceNum = getCount(stats.m_suppParentNums, RelationSymbolTable::packKey(parentSymId, supportSymId));
+		suppRel->m_childInstanceNum = getCount(stats.m_suppChildNums, RelationSymbolTable::packKey(childSymId, supportSymId));
 
-					// count num of object being support child while the parent is not "room"
-					if (sgNode.nodeName !="room")
-					{
-						m_suppProbs[actNode.nodeName].beChildNum++;
-					}
-				}
+		suppRel->m_childProbGivenParent = suppRel->m_jointInstanceNum / (double)suppRel->m_parentInstanceNum;
+		suppRel->m_parentProbGivenChild = suppRel->m_jointInstanceNum / (double)suppRel->m_childInstanceNum;
 
-				if (!actNodeList.empty())
-				{
-					isSupportParent = true;
+		m_supportRelations[RelationSymbolTable::packKey(symIds[parentSymId], symIds[childSymId], symIds[supportSymId])] = suppRel;
+	}
 
-					// add instance for support parent
-					for (auto iter = m_supportRelations.begin(); iter != m_supportRelations.end(); iter++)
-					{
-						SupportRelation *suppRel = iter->second;
-						if (suppRel->m_parentName == sgNode.nodeName && suppRel->m_supportType == supportType)
-						{
-							suppRel->m_parentInstanceNum++;
-						}
-					}
-				}
-			}
+	for (auto iter = stats.m_objNums.begin(); iter != stats.m_objNums.end(); iter++)
+	{
+		m_suppProbs[symIds[iter->first]].totalNum = iter->second;
+	}
 
-			if (isSupportParent)
-			{
-				// count num of object being support parent
-				m_suppProbs[sgNode.nodeName].beParentNum++;
-			}
-		}
+	for (auto iter = stats.m_beParentNums.begin(); iter != stats.m_beParentNums.end(); iter++)
+	{
+		m_suppProbs[symIds[iter->first]].beParentNum = iter->second;
 	}
-}
 
-void RelationModelManager::buildSupportRelationModels()
-{
-	for (auto iter = m_supportRelations.begin(); iter != m_supportRelations.end(); iter++)
+	for (auto iter = stats.m_beChildNums.begin(); iter != stats.m_beChildNums.end(); iter++)
 	{
-		SupportRelation *suppRel = iter->second;
-		suppRel->m_childProbGivenParent = suppRel->m_jointInstanceNum / (double)suppRel->m_parentInstanceNum;
-		suppRel->m_parentProbGivenChild = suppRel->m_jointInstanceNum / (double)suppRel->m_childInstanceNum;
+		m_suppProbs[symIds[iter->first]].beChildNum = iter->second;
 	}
 
 	for (auto iter = m_suppProbs.begin(); iter!= m_suppProbs.end(); iter++)
@@ -885,22 +666,62 @@ void RelationModelManager::buildSupportRelationModels()
 	qDebug() << "Support relations extracted";
 }
 
-void RelationModelManager::buildGroupRelationModels()
+void RelationModelManager::buildCoOccOnParentModels()
 {
+	for (auto it = m_coOccModelsOnSameParent.begin(); it != m_coOccModelsOnSameParent.end(); it++)
+	{
+		delete it->second;
+	}
 
-	// 1. Open MATLAB engine
-	matlabEngine = engOpen(NULL);
+	m_coOccModelsOnSameParent.clear();
 
-	// fit GMM model
-	int id = 0;
-	int totalNum = m_groupRelModels.size();
+	const SceneRelationStats &stats = m_relationStats;
+	int conditionSymId = m_symbols.intern("sibling");
+
+	for (auto iter = stats.m_coOccOnParentNums.begin(); iter != stats.m_coOccOnParentNums.end(); iter++)
+	{
+		int firstSymId = RelationSymbolTable::unpackKey(iter->first, 0);
+		int secondSymId = RelationSymbolTable::unpackKey(iter->first, 1);
+		int parentSymId = RelationSymbolTable::unpackKey(iter->first, 2);
+
+		const QString &firstName = stats.m_symbols.getName(firstSymId);
+		const QString &secondName = stats.m_symbols.getName(secondSymId);
+		const QString &parentName = stats.m_symbols.getName(parentSymId);
+
+		CoOccurrenceModel *coOccModel = new CoOccurrenceModel(firstName, secondName, m_symbols.getName(conditionSymId), parentName);
+		coOccModel->m_coOccNum = iter->second;
+		coOccModel->m_firstObjNum = getCount(stats.m_childOnParentNums, RelationSymbolTable::packKey(firstSymId, parentSymId));
+		coOccModel->m_secondObjNum = getCount(stats.m_childOnParentNums, RelationSymbolTable::packKey(secondSymId, parentSymId));
+		coOccModel->computCoOccProb();
+
+		SymbolKey coOccKey = RelationSymbolTable::packKey(m_symbols.intern(firstName), m_symbols.intern(secondName), conditionSymId, m_symbols.intern(parentName));
+		m_coOccModelsOnSameParent[coOccKey] = coOccModel;
+	}
+
+	qDebug() << "Co-Occurrence of sibling objects extracted";
+}
+
+void RelationModelManager::buildGroupRelationModels()
+{
+	// fit GMM model, pairwise models of all groups at once
+	std::vector<PairwiseRelationModel*> relModels;
 	for (auto iter = m_groupRelModels.begin(); iter != m_groupRelModels.end(); iter++)
 	{
 		GroupRelationModel *groupModel = iter->second;
 		groupModel->computeOccurrence();
-		groupModel->fitGMMs();
 
-		std::cout << "Group model fitted " << QString("%1/%2\r").arg(++id).arg(totalNum).toStdString();
+		for (auto pairIter = groupModel->m_pairwiseModels.begin(); pairIter != groupModel->m_pairwiseModels.end(); pairIter++)
+		{
+			relModels.push_back(pairIter->second);
+		}
+	}
+
+	fitGMMsInParallel(relModels, "Group pairwise");
+
+	for (auto iter = m_groupRelModels.begin(); iter != m_groupRelModels.end(); iter++)
+	{
+		GroupRelationModel *groupModel = iter->second;
+		groupModel->updatePairModelKeys();
 
 		addOccToCoOccForGroupModel(groupModel);
 	}
@@ -911,68 +732,66 @@ void RelationModelManager::buildGroupRelationModels()
 		currModel->computCoOccProb();
 	}
 
-	// 3. Close MATLAB engine
-	engClose(matlabEngine);
-
 	qDebug() << "Group relations extracted";
 }
 
 void RelationModelManager::collectGroupInstanceFromCurrScene()
 {
-	SceneSemGraph *currSSG = m_currScene->m_ssg;
-	QString sceneName = m_currScene->getSceneName();
+	SceneRelationRecord record;
+	record.collectFromScene(m_currScene);
+
+	addGroupInstances(record);
+}
+
+void RelationModelManager::addGroupInstances(const SceneRelationRecord &record)
+{
+	int sceneId = m_sceneSymbols.intern(record.m_sceneName);
+
+	std::vector<int> symIds;
+	internRecordNames(record, symIds);
 
-	for (int i=0; i< currSSG->m_nodeNum; i++)
+	for (int i = 0; i < record.m_groupInstances.size(); i++)
 	{
-		SemNode &sgNode = currSSG->m_nodes[i];
+		const SceneRelationRecord::GroupInstance &groupInstance = record.m_groupInstances[i];
 
-		if (sgNode.nodeType.contains("group"))
+		int groupSymId = symIds[groupInstance.relationSymId];
+		int anchorSymId = symIds[groupInstance.anchorSymId];
+
+		std::vector<int> actSymIds(groupInstance.actSymIds.size());
+		for (int t = 0; t < actSymIds.size(); t++)
 		{
-			int anchoNodeId = sgNode.anchorNodeList[0];
+			actSymIds[t] = symIds[groupInstance.actSymIds[t]];
+		}
 
-			QString anchorObjName = currSSG->m_nodes[anchoNodeId].nodeName;
-			QString groupKey = sgNode.nodeName + "_" + anchorObjName;
+		SymbolKey groupKey = RelationSymbolTable::packKey(groupSymId, anchorSymId);
 
-			if (!m_groupRelModels.count(groupKey))
-			{
-				GroupRelationModel *newGroupModel = new GroupRelationModel(anchorObjName, sgNode.nodeName);
-				collectRelPosForGroupModel(newGroupModel, sceneName, anchoNodeId, sgNode.activeNodeList);
-				collectOccurrForGroupModel(newGroupModel, sgNode.activeNodeList);
-				collectCoOccForGroupModel(newGroupModel, sgNode.activeNodeList);
+		GroupRelationModel *&groupModel = m_groupRelModels[groupKey];
+		if (groupModel == NULL)
+		{
+			groupModel = new GroupRelationModel(m_symbols.getName(anchorSymId), m_symbols.getName(groupSymId));
+		}
 
-				m_groupRelModels[groupKey] = newGroupModel;
-			}
-			else
-			{
-				collectRelPosForGroupModel(m_groupRelModels[groupKey], sceneName, anchoNodeId, sgNode.activeNodeList);
-				collectOccurrForGroupModel(m_groupRelModels[groupKey], sgNode.activeNodeList);
-				collectCoOccForGroupModel(m_groupRelModels[groupKey], sgNode.activeNodeList);
-			}
+		collectRelPosForGroupModel(groupModel, record, sceneId, groupInstance.anchorObjId, groupInstance.actObjIds);
+		collectOccurrForGroupModel(groupModel, actSymIds);
+		collectCoOccForGroupModel(groupModel, groupSymId, anchorSymId, actSymIds);
 
-			m_groupRelModels[groupKey]->m_numInstance++;
-		}
+		groupModel->m_numInstance++;
 	}
 }
 
-void RelationModelManager::collectOccurrForGroupModel(GroupRelationModel *groupModel, const std::vector<int> &actNodeList)
+void RelationModelManager::collectOccurrForGroupModel(GroupRelationModel *groupModel, const std::vector<int> &actSymIds)
 {
-	SceneSemGraph *currSSG = m_currScene->m_ssg;
-
-	std::vector<int> actNodeCountedIndicator(actNodeList.size(), 0); // whether the node has been counted
+	std::vector<int> actNodeCountedIndicator(actSymIds.size(), 0); // whether the node has been counted
 
-	for (int t=0; t < actNodeList.size(); t++)
+	for (int t=0; t < actSymIds.size(); t++)
 	{
-		int actNodeId = actNodeList[t];
-		SemNode &actNode = currSSG->m_nodes[actNodeId];
-		QString actObjName = actNode.nodeName;
+		const QString &actObjName = m_symbols.getName(actSymIds[t]);
 
 		int currActObjNum = 0;
 		// count obj num in current annotation
-		for (int i=0; i < actNodeList.size(); i++)
+		for (int i=0; i < actSymIds.size(); i++)
 		{
-			int testNodeId = actNodeList[i];
-			SemNode &testNode = currSSG->m_nodes[testNodeId];
-			if (actNodeCountedIndicator[i] == 0 && actObjName == testNode.nodeName)
+			if (actNodeCountedIndicator[i] == 0 && actSymIds[t] == actSymIds[i])
 			{
 				actNodeCountedIndicator[i] = 1;
 				currActObjNum++;
@@ -997,26 +816,20 @@ void RelationModelManager::collectOccurrForGroupModel(GroupRelationModel *groupM
 	}
 }
 
-void RelationModelManager::collectCoOccForGroupModel(GroupRelationModel *groupModel, const std::vector<int> &actNodeList)
+void RelationModelManager::collectCoOccForGroupModel(GroupRelationModel *groupModel, int groupSymId, int anchorSymId, const std::vector<int> &actSymIds)
 {
-	SceneSemGraph *currSSG = m_currScene->m_ssg;
-
-	std::vector<int> actNodeCountedIndicator(actNodeList.size(), 0); // whether the node has been counted
-	std::vector<int> uniqueActNodeIds;
+	std::vector<int> actNodeCountedIndicator(actSymIds.size(), 0); // whether the node has been counted
+	std::vector<int> uniqueActSymIds;
 
-	for (int t = 0; t < actNodeList.size(); t++)
+	for (int t = 0; t < actSymIds.size(); t++)
 	{
-		int actNodeId = actNodeList[t];
-		SemNode &actNode = currSSG->m_nodes[actNodeId];
-		QString actObjName = actNode.nodeName;
+		int actSymId = actSymIds[t];
 
 		int currActObjNum = 0;
 		// count obj num in current annotation
-		for (int i = 0; i < actNodeList.size(); i++)
+		for (int i = 0; i < actSymIds.size(); i++)
 		{
-			int testNodeId = actNodeList[i];
-			SemNode &testNode = currSSG->m_nodes[testNodeId];
-			if (actNodeCountedIndicator[i] == 0 && actObjName == testNode.nodeName)
+			if (actNodeCountedIndicator[i] == 0 && actSymId == actSymIds[i])
 			{
 				actNodeCountedIndicator[i] = 1;
 				currActObjNum++;
@@ -1025,29 +838,26 @@ void RelationModelManager::collectCoOccForGroupModel(GroupRelationModel *groupMo
 
 		if (currActObjNum)
 		{
-			uniqueActNodeIds.push_back(actNodeId);
+			uniqueActSymIds.push_back(actSymId);
 		}
 	}
 
-	for (int i = 0; i < uniqueActNodeIds.size(); i++)
+	for (int i = 0; i < uniqueActSymIds.size(); i++)
 	{
-		SemNode &firstActNode = currSSG->m_nodes[uniqueActNodeIds[i]];
-		for (int j = 0; j < uniqueActNodeIds.size(); j++)
+		int firstSymId = uniqueActSymIds[i];
+		for (int j = 0; j < uniqueActSymIds.size(); j++)
 		{
 			if (i == j) continue;
-			SemNode &secondActNode = currSSG->m_nodes[uniqueActNodeIds[j]];
-			QString coOccKey = QString("%1_%2_%3_%4").arg(firstActNode.nodeName).arg(secondActNode.nodeName).arg(groupModel->m_relationName).arg(groupModel->m_anchorObjName);
+			int secondSymId = uniqueActSymIds[j];
+			SymbolKey coOccKey = RelationSymbolTable::packKey(firstSymId, secondSymId, groupSymId, anchorSymId);
 
-			if (m_coOccModelsInSameGroup.count(coOccKey))
+			CoOccurrenceModel *&coOccModel = m_coOccModelsInSameGroup[coOccKey];
+			if (coOccModel == NULL)
 			{
-				m_coOccModelsInSameGroup[coOccKey]->m_coOccNum++;
-			}
-			else
-			{
-				CoOccurrenceModel *newModel = new CoOccurrenceModel(firstActNode.nodeName, secondActNode.nodeName, groupModel->m_relationName, groupModel->m_anchorObjName);
-				newModel->m_coOccNum++;
-				m_coOccModelsInSameGroup[coOccKey] = newModel;
+				coOccModel = new CoOccurrenceModel(m_symbols.getName(firstSymId), m_symbols.getName(secondSymId), groupModel->m_relationName, groupModel->m_anchorObjName);
 			}
+
+			coOccModel->m_coOccNum++;
 		}
 	}
 
@@ -1091,29 +901,25 @@ void RelationModelManager::collectCoOccForGroupModel(GroupRelationModel *groupMo
 	//}
 }
 
-void RelationModelManager::collectRelPosForGroupModel(GroupRelationModel *groupModel, const QString &sceneName, int anchorNodeId, const std::vector<int> &actNodeList)
+void RelationModelManager::collectRelPosForGroupModel(GroupRelationModel *groupModel, const SceneRelationRecord &record, int sceneId, int anchorObjId, const std::vector<int> &actObjIds)
 {
-	for (int t = 0; t < actNodeList.size(); t++)
+	for (int t = 0; t < actObjIds.size(); t++)
 	{
-		QString instanceIdHash = QString("%1_%2_%3").arg(sceneName).arg(anchorNodeId).arg(actNodeList[t]);
+		int conditionSymId;
+		RelativePos* relPos = findRelativePos(record, sceneId, anchorObjId, actObjIds[t], conditionSymId);
 
-		if (m_relativePostions.count(instanceIdHash))
+		if (relPos != NULL)
 		{
-			RelativePos* relPos = m_relativePostions[instanceIdHash];
 			QString relationKey = relPos->m_anchorObjName + "_" + relPos->m_actObjName + "_" +relPos->m_conditionName + "_general";
 
-			if (!groupModel->m_pairwiseModels.count(relationKey))
+			PairwiseRelationModel *&relativeModel = groupModel->m_pairwiseModels[relationKey];
+			if (relativeModel == NULL)
 			{
-				PairwiseRelationModel *relativeModel = new PairwiseRelationModel(relPos->m_anchorObjName, relPos->m_actObjName, relPos->m_conditionName, "general");
-
-				relativeModel->m_instances.push_back(relPos);
-				groupModel->m_pairwiseModels[relationKey] = relativeModel;
+				relativeModel = new PairwiseRelationModel(relPos->m_anchorObjName, relPos->m_actObjName, relPos->m_conditionName, "general");
 			}
 
-			else
-				groupModel->m_pairwiseModels[relationKey]->m_instances.push_back(relPos);
-
-			groupModel->m_pairwiseModels[relationKey]->m_numInstance = groupModel->m_pairwiseModels[relationKey]->m_instances.size();
+			relativeModel->m_instances.push_back(relPos);
+			relativeModel->m_numInstance = relativeModel->m_instances.size();
 		}
 	}
 }
@@ -1127,7 +933,7 @@ void RelationModelManager::addOccToCoOccForGroupModel(GroupRelationModel *groupM
 
 		for (auto iter = m_coOccModelsInSameGroup.begin(); iter != m_coOccModelsInSameGroup.end(); iter++)
 		{
-			QString coOccKey = iter->first;
+			const QString &coOccKey = iter->second->m_coOccurKey;
 			QString matchKey = groupModel->m_relationName + "_" + groupModel->m_anchorObjName;
 			if (coOccKey.left(currModelName.length()) == currModelName && coOccKey.right(matchKey.length()) == matchKey)
 			{
@@ -1155,10 +961,10 @@ void RelationModelManager::saveRelativeRelationModels(const QString &filePath, c
 	if (outFile.open(QIODevice::ReadWrite | QIODevice::Text | QIODevice::Truncate))
 	{
 		// save relative relations
-		for (auto iter = m_relativeModels.begin(); iter != m_relativeModels.end(); iter++)
+		std::vector<PairwiseRelationModel*> relModels = sortModelsByStringKey(m_relativeModels, [](PairwiseRelationModel *m) { return m->m_relationKey; });
+		for (int i = 0; i < relModels.size(); i++)
 		{
-			PairwiseRelationModel *relModel = iter->second;
-			relModel->output(ofs);
+			relModels[i]->output(ofs);
 		}
 
 		outFile.close();
@@ -1176,10 +982,10 @@ void RelationModelManager::savePairwiseRelationModels(const QString &filePath, c
 	if (outFile.open(QIODevice::ReadWrite | QIODevice::Text | QIODevice::Truncate))
 	{
 		// save relative relations
-		for (auto iter = m_pairwiseRelModels.begin(); iter != m_pairwiseRelModels.end(); iter++)
+		std::vector<PairwiseRelationModel*> relModels = sortModelsByStringKey(m_pairwiseRelModels, [](PairwiseRelationModel *m) { return m->m_relationKey; });
+		for (int i = 0; i < relModels.size(); i++)
 		{
-			PairwiseRelationModel *relModel = iter->second;
-			relModel->output(ofs);
+			relModels[i]->output(ofs);
 		}
 
 		outFile.close();
@@ -1196,10 +1002,10 @@ void RelationModelManager::saveGroupRelationModels(const QString &filePath, cons
 
 	if (outFile.open(QIODevice::ReadWrite | QIODevice::Text | QIODevice::Truncate))
 	{
-		for (auto giter = m_groupRelModels.begin(); giter != m_groupRelModels.end(); giter++)
+		std::vector<GroupRelationModel*> groupModels = sortModelsByStringKey(m_groupRelModels, [](GroupRelationModel *m) { return m->m_groupKey; });
+		for (int g = 0; g < groupModels.size(); g++)
 		{
-			GroupRelationModel *groupModel = giter->second;
-			groupModel->output(ofs);
+			groupModels[g]->output(ofs);
 		}
 
 		outFile.close();
@@ -1216,10 +1022,10 @@ void RelationModelManager::saveSupportRelationModels(const QString &filePath, co
 
 	if (outFile.open(QIODevice::ReadWrite | QIODevice::Text | QIODevice::Truncate))
 	{
-		for (auto iter = m_supportRelations.begin(); iter != m_supportRelations.end(); iter++)
+		std::vector<SupportRelation*> suppRels = sortModelsByStringKey(m_supportRelations, [](SupportRelation *m) { return m->m_suppRelKey; });
+		for (int i = 0; i < suppRels.size(); i++)
 		{
-			SupportRelation *suppRel = iter->second;
-			suppRel->output(ofs);
+			suppRels[i]->output(ofs);
 		}
 
 		outFile.close();
@@ -1229,10 +1035,18 @@ void RelationModelManager::saveSupportRelationModels(const QString &filePath, co
 	outFile.setFileName(filename);
 	if (outFile.open(QIODevice::ReadWrite | QIODevice::Text | QIODevice::Truncate))
 	{
-		for (auto iter = m_suppProbs.begin(); iter!= m_suppProbs.end(); iter++)
+		std::vector<std::pair<QString, SupportProb*>> suppProbs;
+		for (auto iter = m_suppProbs.begin(); iter != m_suppProbs.end(); iter++)
+		{
+			suppProbs.push_back(std::make_pair(m_symbols.getName(iter->first), &iter->second));
+		}
+
+		std::sort(suppProbs.begin(), suppProbs.end(), [](const std::pair<QString, SupportProb*> &a, const std::pair<QString, SupportProb*> &b) { return a.first < b.first; });
+
+		for (int i = 0; i < suppProbs.size(); i++)
 		{
-			SupportProb &suppProb = iter->second;
-			ofs << iter->first << "," << suppProb.beParentProb << " " << suppProb.beChildProb << "\n";
+			SupportProb &suppProb = *suppProbs[i].second;
+			ofs << suppProbs[i].first << "," << suppProb.beParentProb << " " << suppProb.beChildProb << "\n";
 		}
 
 		outFile.close();
@@ -1250,9 +1064,10 @@ void RelationModelManager::savePairwiseModelSim(const QString &filePath, const Q
 	if (outFile.open(QIODevice::ReadWrite | QIODevice::Text | QIODevice::Truncate))
 	{
 		// save relative relations
-		for (auto iter = m_pairwiseRelModels.begin(); iter != m_pairwiseRelModels.end(); iter++)
+		std::vector<PairwiseRelationModel*> relModels = sortModelsByStringKey(m_pairwiseRelModels, [](PairwiseRelationModel *m) { return m->m_relationKey; });
+		for (int r = 0; r < relModels.size(); r++)
 		{
-			PairwiseRelationModel *relModel = iter->second;
+			PairwiseRelationModel *relModel = relModels[r];
 			ofs << relModel->m_relationKey << ","<<QString("R_%1").arg(relModel->m_modelId)<<"\n";
 			
 			int simModelNum = relModel->m_simModelIds.size();
@@ -1305,9 +1120,10 @@ void RelationModelManager::saveGroupModelSim(const QString &filePath, const QStr
 
 	if (outFile.open(QIODevice::ReadWrite | QIODevice::Text | QIODevice::Truncate))
 	{
-		for (auto giter = m_groupRelModels.begin(); giter != m_groupRelModels.end(); giter++)
+		std::vector<GroupRelationModel*> groupModels = sortModelsByStringKey(m_groupRelModels, [](GroupRelationModel *m) { return m->m_groupKey; });
+		for (int g = 0; g < groupModels.size(); g++)
 		{
-			GroupRelationModel *groupModel = giter->second;
+			GroupRelationModel *groupModel = groupModels[g];
 			ofs << groupModel->m_groupKey << "\n";
 
 			for (auto iter = groupModel->m_pairwiseModels.begin(); iter!=groupModel->m_pairwiseModels.end(); iter++)
@@ -1352,16 +1168,17 @@ void RelationModelManager::saveCoOccurOnParentModels(const QString &filePath, co
 	qDebug() << "Co-Occurrence of sibling objects saved.";
 }
 
-void RelationModelManager::saveCoOccurModels(const QString &filename, std::map<QString, CoOccurrenceModel*> &models)
+void RelationModelManager::saveCoOccurModels(const QString &filename, const std::unordered_map<SymbolKey, CoOccurrenceModel*> &models)
 {
 	QFile outFile(filename);
 	QTextStream ofs(&outFile);
 
 	if (outFile.open(QIODevice::ReadWrite | QIODevice::Text | QIODevice::Truncate))
 	{
-		for (auto iter = models.begin(); iter!=models.end(); iter++)
+		std::vector<CoOccurrenceModel*> sortedModels = sortModelsByStringKey(models, [](CoOccurrenceModel *m) { return m->m_coOccurKey; });
+		for (int i = 0; i < sortedModels.size(); i++)
 		{
-			CoOccurrenceModel *currModel = iter->second;
+			CoOccurrenceModel *currModel = sortedModels[i];
 			ofs << currModel->m_coOccurKey << "," << currModel->m_prob << "\n";
 			ofs << currModel->m_coOccNum << "," << currModel->m_firstObjNum << ","  << currModel->m_secondObjNum<<"\n";
 		}
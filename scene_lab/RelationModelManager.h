@@ -1,9 +1,13 @@
 #pragma once
 #include "RelationModel.h"
+#include "RelationSymbolTable.h"
+#include "SceneRelationStats.h"
+#include <unordered_map>
 
 class GroupRelationModel;
 class CScene;
 class RelationExtractor;
+class SceneRelationRecord;
 
 struct SupportProb
 {
@@ -25,35 +29,47 @@ public:
 	~RelationModelManager();
 
 	void updateCurrScene(CScene *s);
+	void setFitThreadNum(int n) { m_fitThreadNum = n; };  // 0 for one thread per core
+
+	// fit GMMs of the models on all cores, models are independent and each fit is seeded by its key
+	void fitGMMsInParallel(const std::vector<PairwiseRelationModel*> &relModels, const QString &modelTypeName);
 
 	// extract relative pos
 	void collectRelativePosInCurrScene();
 
 	// load relative pos from file
 	void loadRelativePosFromCurrScene();
+	bool loadRelativePosFromFile(const QString &filename);  // binary or text .relPos, scene does not need to be loaded
+	bool loadRelativePosFromBinaryFile(const QString &filename);
 	void buildRelativeRelationModels();
 
+	// instances of a scene are read from its record, relative positions of the scene must be loaded first
 	void buildPairwiseRelationModels();
 	void collectPairwiseInstanceFromCurrScene();
+	void addPairwiseInstances(const SceneRelationRecord &record);
 
 	void buildGroupRelationModels();
 	void collectGroupInstanceFromCurrScene();
-	void collectOccurrForGroupModel(GroupRelationModel *groupModel, const std::vector<int> &actNodeList);
-	void collectCoOccForGroupModel(GroupRelationModel *groupModel, const std::vector<int> &actNodeList);
-	void collectRelPosForGroupModel(GroupRelationModel *groupModel, const QString &sceneName, int anchorNodeId, const std::vector<int> &actNodeList);
+	void addGroupInstances(const SceneRelationRecord &record);
+	void collectOccurrForGroupModel(GroupRelationModel *groupModel, const std::vector<int> &actSymIds);
+	void collectCoOccForGroupModel(GroupRelationModel *groupModel, int groupSymId, int anchorSymId, const std::vector<int> &actSymIds);
+	void collectRelPosForGroupModel(GroupRelationModel *groupModel, const SceneRelationRecord &record, int sceneId, int anchorObjId, const std::vector<int> &actObjIds);
 	void addOccToCoOccForGroupModel(GroupRelationModel *groupModel);
 
-	void computeSimForPairwiseModels(std::map<QString, PairwiseRelationModel*> &pairModels, const std::vector<QString> &pairModelKeys, const std::vector<CScene*> &sceneList, bool isInGroup = false, const QString &filePath = "");
+	// pairModels in model id order
+	void computeSimForPairwiseModels(const std::vector<PairwiseRelationModel*> &pairModels, const std::vector<CScene*> &sceneList, bool isInGroup = false);
 	void computeSimForPairModelInGroup(const std::vector<CScene*> &sceneList);
 
 	bool isAnchorFrontDirConsistent(const QString &currAnchorName, const QString &dbAnchorName);
 
-	void collectSupportRelationInCurrentScene();
+	// support and sibling co-occurrence counts; scenes can also be summarized elsewhere, e.g. on batch threads, and added
+	void collectRelationStatsFromCurrScene();
+	void addRelationStats(const SceneRelationStats &stats);
+
+	// pairwise and group instances and counts of a scene, e.g. from its cached .relStats file
+	void addSceneRecord(const SceneRelationRecord &record);
 	void buildSupportRelationModels();
-	void collectCoOccInCurrentScene();
-	void addOccToCoOccFromSupportRelation();
-	void addOccToCoOccFromCurrentScene();
-	void computeOccToCoccOnSameParent();
+	void buildCoOccOnParentModels();
 
 	void saveRelativeRelationModels(const QString &filePath, const QString &dbType);
 	void savePairwiseRelationModels(const QString &filePath, const QString &dbType);
@@ -65,24 +81,54 @@ public:
 
 	void saveCoOccurInGroupModels(const QString &filePath, const QString &dbType);
 	void saveCoOccurOnParentModels(const QString &filePath, const QString &dbType);
-	void saveCoOccurModels(const QString &filename, std::map<QString, CoOccurrenceModel*> &models);
+	void saveCoOccurModels(const QString &filename, const std::unordered_map<SymbolKey, CoOccurrenceModel*> &models);
 
 public:
-	std::map<QString, PairwiseRelationModel*> m_relativeModels;  // relative models with general relations
-	std::map<QString, PairwiseRelationModel*> m_pairwiseRelModels;  // pairwise relation models
-	std::map<QString, GroupRelationModel*> m_groupRelModels;
-	std::map<QString, SupportRelation*> m_supportRelations;
-	std::map<QString, SupportProb> m_suppProbs; //
+	// keyed by packed symbol ids of the names in the model's string key, saved in the order of the string keys
+	std::unordered_map<SymbolKey, PairwiseRelationModel*> m_relativeModels;  // relative models with general relations: anchor, act, condition
+	std::unordered_map<SymbolKey, PairwiseRelationModel*> m_pairwiseRelModels;  // pairwise relation models: anchor, act, condition, relation
+	std::unordered_map<SymbolKey, GroupRelationModel*> m_groupRelModels;  // relation, anchor
+	std::unordered_map<SymbolKey, SupportRelation*> m_supportRelations;  // parent, child, support type
+	std::unordered_map<int, SupportProb> m_suppProbs;  // obj name
+
+	std::vector<PairwiseRelationModel*> m_sortedPairRelModels;  // in model id order
 
-	std::vector<QString> m_pairRelModelKeys;
+	std::unordered_map<SymbolKey, CoOccurrenceModel*> m_coOccModelsOnSameParent;  // first, second, condition, anchor
+	std::unordered_map<SymbolKey, CoOccurrenceModel*> m_coOccModelsInSameGroup;
 
-	std::map<QString, CoOccurrenceModel*> m_coOccModelsOnSameParent;
-	std::map<QString, CoOccurrenceModel*> m_coOccModelsInSameGroup;
+	SceneRelationStats m_relationStats;  // counts of all collected scenes, support and co-occurrence on parent models are built from it
+
+	RelationSymbolTable m_symbols;
+	RelationSymbolTable m_sceneSymbols;  // scene names, not limited to 16-bit ids
 
 private:
-	std::map<QString, RelativePos*> m_relativePostions;  // load from saved file for per scene
+	struct RelativePosEntry
+	{
+		RelativePos *relPos;  // rows of binary files are built when they are first used
+		int row;  // row in m_relPosColumns, -1 for rows of text files
+		int anchorSymId;
+		int actSymId;
+		int conditionSymId;
+	};
+
+	// rows of all loaded binary files, every column of a file is appended in one piece
+	struct RelativePosColumns
+	{
+		std::vector<float> posThetas;        // 4 per row
+		std::vector<float> anchorAlignMats;  // 16 per row
+		std::vector<float> actAlignMats;     // 16 per row
+	};
+
+	void addRelativePos(const RelativePosEntry &entry, int sceneId, int anchorObjId, int actObjId);
+	RelativePos* findRelativePos(const SceneRelationRecord &record, int sceneId, int anchorObjId, int actObjId, int &conditionSymId);
+	RelativePos* getRelativePos(SymbolKey key, RelativePosEntry &entry);
+	void internRecordNames(const SceneRelationRecord &record, std::vector<int> &symIds);
+
+	std::unordered_map<SymbolKey, RelativePosEntry> m_relativePostions;  // load from saved file for per scene, keyed by scene id, anchor and act obj ids
+	RelativePosColumns m_relPosColumns;
 
 	RelationExtractor *m_relationExtractor;
+	int m_fitThreadNum;
 	CScene *m_currScene;
 
 	std::vector<QString> m_adjustFrontObjs;
@@ -0,0 +1,205 @@
+#include "RelationModelSimilarity.h"
+#include "RelationModel.h"
+#include <thread>
+#include <atomic>
+#include <queue>
+#include <algorithm>
+
+const int SimFeatureDim = 3;  // heightToFloor, modelHeight, modelVolume of anchor and act obj
+const double SimFeatureWeights[] = { 1, 1, 1 };
+const double SimCatWeight = 0.3;
+
+// rows handed to a thread at a time
+const int SimRowTileSize = 64;
+
+RelationModelSimilarity::RelationModelSimilarity()
+{
+	m_threadNum = 0;
+	m_modelNum = 0;
+}
+
+RelationModelSimilarity::~RelationModelSimilarity()
+{
+}
+
+void RelationModelSimilarity::collectFeatures(const std::vector<PairwiseRelationModel*> &relModels, const std::vector<bool> &isAdjustFront)
+{
+	m_modelNum = relModels.size();
+
+	m_features.resize(2 * SimFeatureDim * m_modelNum);
+	m_featureNorms.assign(2 * SimFeatureDim, 0);
+	m_anchorNameIds.resize(m_modelNum);
+	m_actNameIds.resize(m_modelNum);
+	m_frontGroupIds.resize(m_modelNum);
+	m_modelIds.resize(m_modelNum);
+
+	std::map<QString, int> nameIds;
+
+	for (int i = 0; i < m_modelNum; i++)
+	{
+		PairwiseRelationModel *relModel = relModels[i];
+
+		// single pass max reduction for normalization
+		for (int m = 0; m < 2; m++)
+		{
+			for (int d = 0; d < SimFeatureDim; d++)
+			{
+				int f = m*SimFeatureDim + d;
+				double val = relModel->m_avgObjFeatures[m][d];
+
+				m_features[f*m_modelNum + i] = val;
+				if (val > m_featureNorms[f]) m_featureNorms[f] = val;
+			}
+		}
+
+		auto anchorIter = nameIds.insert(std::make_pair(relModel->m_anchorObjName, (int)nameIds.size())).first;
+		m_anchorNameIds[i] = anchorIter->second;
+
+		auto actIter = nameIds.insert(std::make_pair(relModel->m_actObjName, (int)nameIds.size())).first;
+		m_actNameIds[i] = actIter->second;
+
+		m_frontGroupIds[i] = isAdjustFront[i] ? 1 : 0;
+		m_modelIds[i] = relModel->m_modelId;
+	}
+
+	// max features are shared by all models of the bucket
+	std::vector<std::vector<double>> maxFeatures(2, std::vector<double>(SimFeatureDim, 0));
+	for (int m = 0; m < 2; m++)
+	{
+		for (int d = 0; d < SimFeatureDim; d++)
+		{
+			maxFeatures[m][d] = m_featureNorms[m*SimFeatureDim + d];
+		}
+	}
+
+	for (int i = 0; i < m_modelNum; i++)
+	{
+		relModels[i]->m_maxObjFeatures = maxFeatures;
+	}
+
+	for (int f = 0; f < 2 * SimFeatureDim; f++)
+	{
+		m_featureNorms[f] += 1e-3;
+	}
+}
+
+double RelationModelSimilarity::computeSim(int i, int j) const
+{
+	// anchors with and without adjusted front dir are not comparable
+	if (m_frontGroupIds[i] != m_frontGroupIds[j])
+	{
+		return 0;
+	}
+
+	double simVal[2];
+	double catSim[2];
+	catSim[0] = (m_anchorNameIds[i] == m_anchorNameIds[j]) ? 1 : 0;
+	catSim[1] = (m_actNameIds[i] == m_actNameIds[j]) ? 1 : 0;
+
+	for (int m = 0; m < 2; m++)
+	{
+		double geoSim = 0;
+		for (int d = 0; d < SimFeatureDim; d++)
+		{
+			int f = m*SimFeatureDim + d;
+			const double *feature = &m_features[f*m_modelNum];
+
+			geoSim += SimFeatureWeights[d] * exp(-pow((feature[i] - feature[j]) / m_featureNorms[f], 2));
+		}
+
+		geoSim /= SimFeatureDim;
+		simVal[m] = SimCatWeight*catSim[m] + (1 - SimCatWeight)*geoSim;
+	}
+
+	return simVal[0] * simVal[1];
+}
+
+void RelationModelSimilarity::computeTopSimForRow(int i, int topNum, std::vector<int> &simIds) const
+{
+	simIds.clear();
+	if (topNum <= 0)
+	{
+		return;
+	}
+
+	// min heap on (sim, model id), the top is the weakest of the kept candidates
+	typedef std::pair<double, int> SimPair;
+	std::priority_queue<SimPair, std::vector<SimPair>, std::greater<SimPair>> topPairs;
+
+	for (int j = 0; j < m_modelNum; j++)
+	{
+		if (i == j) continue;
+
+		SimPair currPair(computeSim(i, j), m_modelIds[j]);
+
+		if (topPairs.size() < topNum)
+		{
+			topPairs.push(currPair);
+		}
+		else if (topPairs.top() < currPair)
+		{
+			topPairs.pop();
+			topPairs.push(currPair);
+		}
+	}
+
+	simIds.resize(topPairs.size());
+	for (int k = simIds.size() - 1; k >= 0; k--)
+	{
+		simIds[k] = topPairs.top().second;
+		topPairs.pop();
+	}
+}
+
+void RelationModelSimilarity::computeTopSimModels(const std::vector<PairwiseRelationModel*> &relModels, const std::vector<bool> &isAdjustFront, int topSimNum)
+{
+	collectFeatures(relModels, isAdjustFront);
+
+	if (m_modelNum == 0)
+	{
+		return;
+	}
+
+	// same count as keeping the first half of the sorted row, capped at topSimNum
+	int topNum = std::min(topSimNum, (m_modelNum - 1) / 2);
+
+	std::vector<std::vector<int>> rowSimIds(m_modelNum);
+
+	int tileNum = (m_modelNum + SimRowTileSize - 1) / SimRowTileSize;
+	int threadNum = m_threadNum > 0 ? m_threadNum : std::thread::hardware_concurrency();
+	threadNum = std::max(1, std::min(threadNum, tileNum));
+
+	std::atomic<int> nextTileId(0);
+
+	auto simWorker = [&]()
+	{
+		int tileId;
+		while ((tileId = nextTileId++) < tileNum)
+		{
+			int rowEnd = std::min(m_modelNum, (tileId + 1)*SimRowTileSize);
+			for (int i = tileId*SimRowTileSize; i < rowEnd; i++)
+			{
+				computeTopSimForRow(i, topNum, rowSimIds[i]);
+			}
+		}
+	};
+
+	std::vector<std::thread> workers;
+	for (int t = 1; t < threadNum; t++)
+	{
+		workers.push_back(std::thread(simWorker));
+	}
+
+	simWorker();
+
+	for (int t = 0; t < workers.size(); t++)
+	{
+		workers[t].join();
+	}
+
+	for (int i = 0; i < m_modelNum; i++)
+	{
+		std::vector<int> &simModelIds = relModels[i]->m_simModelIds;
+		simModelIds.insert(simModelIds.end(), rowSimIds[i].begin(), rowSimIds[i].end());
+	}
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <vector>
+
+class PairwiseRelationModel;
+
+// top-k similar pairwise relation models within one bucket of models with the same relation and condition
+// features are kept in flat arrays and names as integer ids; rows are scored in parallel, each keeping
+// a bounded heap of its best candidates instead of a dense similarity matrix
+
+class RelationModelSimilarity
+{
+public:
+	RelationModelSimilarity();
+	~RelationModelSimilarity();
+
+	void setThreadNum(int n) { m_threadNum = n; };  // 0 for one thread per core
+
+	// relModels need m_avgObjFeatures; isAdjustFront[i] tells whether the anchor of model i has an adjusted front dir
+	// sets m_maxObjFeatures and appends the top similar model ids to m_simModelIds of each model,
+	// ranked as a descending sort of (similarity, model id) pairs, at most min(topSimNum, (n-1)/2) per model
+	void computeTopSimModels(const std::vector<PairwiseRelationModel*> &relModels, const std::vector<bool> &isAdjustFront, int topSimNum);
+
+private:
+	void collectFeatures(const std::vector<PairwiseRelationModel*> &relModels, const std::vector<bool> &isAdjustFront);
+	double computeSim(int i, int j) const;
+	void computeTopSimForRow(int i, int topNum, std::vector<int> &simIds) const;
+
+	int m_threadNum;
+	int m_modelNum;
+
+	// per model data, index is the position in the bucket
+	std::vector<double> m_features;     // featureDim values of anchor then act obj, feature major: m_features[f*m_modelNum + i]
+	std::vector<double> m_featureNorms; // max feature over the bucket + 1e-3
+	std::vector<int> m_anchorNameIds;
+	std::vector<int> m_actNameIds;
+	std::vector<int> m_frontGroupIds;
+	std::vector<int> m_modelIds;
+};
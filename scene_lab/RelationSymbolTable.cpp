@@ -0,0 +1,54 @@
+#include "RelationSymbolTable.h"
+#include <iostream>
+#include <cstdlib>
+
+RelationSymbolTable::RelationSymbolTable(int maxSymbolNum)
+	:m_maxSymbolNum(maxSymbolNum)
+{
+}
+
+RelationSymbolTable::~RelationSymbolTable()
+{
+}
+
+int RelationSymbolTable::intern(const QString &name)
+{
+	auto iter = m_symIds.constFind(name);
+	if (iter != m_symIds.constEnd())
+	{
+		return iter.value();
+	}
+
+	int symId = m_names.size();
+	if (symId >= m_maxSymbolNum)
+	{
+		std::cout << "\tRelationSymbolTable: more than " << m_maxSymbolNum << " symbols, cannot intern " << name.toStdString() << "\n";
+		std::cout.flush();
+		std::abort();
+	}
+
+	m_symIds.insert(name, symId);
+	m_names.push_back(name);
+
+	return symId;
+}
+
+int RelationSymbolTable::find(const QString &name) const
+{
+	return m_symIds.value(name, -1);
+}
+
+SymbolKey RelationSymbolTable::packKey(int a, int b, int c, int d)
+{
+	return ((SymbolKey)a << 48) | ((SymbolKey)b << 32) | ((SymbolKey)c << 16) | (SymbolKey)d;
+}
+
+int RelationSymbolTable::unpackKey(SymbolKey key, int part)
+{
+	return (key >> (48 - 16 * part)) & 0xFFFF;
+}
+
+SymbolKey RelationSymbolTable::packSceneObjKey(int sceneId, int anchorObjId, int actObjId)
+{
+	return ((SymbolKey)(quint32)sceneId << 32) | ((SymbolKey)anchorObjId << 16) | (SymbolKey)actObjId;
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <QString>
+#include <QHash>
+#include <vector>
+
+// interned category, condition and relation names
+// relation models are keyed by packed symbol ids while instances are collected, names are only joined into
+// string keys when models are created or saved
+
+typedef quint64 SymbolKey;
+
+class RelationSymbolTable
+{
+public:
+	RelationSymbolTable(int maxSymbolNum = MaxSymbolNum);
+	~RelationSymbolTable();
+
+	// running out of ids is a hard error, an aliased id would silently merge unrelated instances
+	int intern(const QString &name);
+	int find(const QString &name) const;  // -1 if the name is not interned
+	const QString& getName(int symId) const { return m_names[symId]; };
+	int size() const { return m_names.size(); };
+
+	// up to four symbol ids, each below MaxSymbolNum, packed in 16 bits
+	static SymbolKey packKey(int a, int b = 0, int c = 0, int d = 0);
+	static int unpackKey(SymbolKey key, int part);
+
+	// scene id in 32 bits, anchor and act obj ids in 16 bits each; scenes have their own table, so the key is not limited
+	// by the number of distinct scenes
+	static SymbolKey packSceneObjKey(int sceneId, int anchorObjId, int actObjId);
+
+	static const int MaxSymbolNum = 0xFFFF;
+
+private:
+	int m_maxSymbolNum;
+	QHash<QString, int> m_symIds;
+	std::vector<QString> m_names;
+};
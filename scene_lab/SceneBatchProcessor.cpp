@@ -0,0 +1,174 @@
+#include "SceneBatchProcessor.h"
+#include "../common/geometry/Scene.h"
+#include "../common/utilities/utility.h"
+#include <thread>
+#include <algorithm>
+#include <sstream>
+#include <iostream>
+
+SceneBatchProcessor::SceneBatchProcessor(int threadNum)
+	:m_threadNum(threadNum), m_logStream(&std::cout)
+{
+	if (m_threadNum <= 0)
+	{
+		m_threadNum = std::max(1, (int)std::thread::hardware_concurrency());
+	}
+
+	m_sceneFullNames = NULL;
+	m_loader = NULL;
+	m_stage = NULL;
+}
+
+SceneBatchProcessor::~SceneBatchProcessor()
+{
+}
+
+int SceneBatchProcessor::run(const QStringList &sceneFullNames, const SceneLoader &loader, const SceneStage &stage)
+{
+	int taskNum = sceneFullNames.size();
+	if (taskNum == 0)
+	{
+		return 0;
+	}
+
+	m_sceneFullNames = &sceneFullNames;
+	m_loader = &loader;
+	m_stage = &stage;
+
+	m_taskLogs.assign(taskNum, std::string());
+	m_isTaskDone.assign(taskNum, false);
+	m_nextLogTaskId = 0;
+	m_doneNum = 0;
+	m_successNum = 0;
+
+	int workerNum = std::min(m_threadNum, taskNum);
+
+	// deal tasks round robin, so every worker starts from the front of the list and logs flush early
+	std::vector<WorkerQueue> workerQueues(workerNum);
+	m_workerQueues.swap(workerQueues);
+
+	for (int t = 0; t < taskNum; t++)
+	{
+		m_workerQueues[t % workerNum].taskIds.push_back(t);
+	}
+
+	std::vector<std::thread> workers;
+	for (int w = 1; w < workerNum; w++)
+	{
+		workers.push_back(std::thread(&SceneBatchProcessor::workerLoop, this, w));
+	}
+
+	// calling thread works as worker 0
+	workerLoop(0);
+
+	for (int w = 0; w < workers.size(); w++)
+	{
+		workers[w].join();
+	}
+
+	m_workerQueues.clear();
+	m_sceneFullNames = NULL;
+	m_loader = NULL;
+	m_stage = NULL;
+
+	return m_successNum;
+}
+
+bool SceneBatchProcessor::popTask(int workerId, int &taskId)
+{
+	// own tasks from the front
+	{
+		WorkerQueue &ownQueue = m_workerQueues[workerId];
+		std::lock_guard<std::mutex> lock(ownQueue.queueMutex);
+
+		if (!ownQueue.taskIds.empty())
+		{
+			taskId = ownQueue.taskIds.front();
+			ownQueue.taskIds.pop_front();
+			return true;
+		}
+	}
+
+	// steal from the back of other queues
+	int workerNum = m_workerQueues.size();
+	for (int k = 1; k < workerNum; k++)
+	{
+		WorkerQueue &victimQueue = m_workerQueues[(workerId + k) % workerNum];
+		std::lock_guard<std::mutex> lock(victimQueue.queueMutex);
+
+		if (!victimQueue.taskIds.empty())
+		{
+			taskId = victimQueue.taskIds.back();
+			victimQueue.taskIds.pop_back();
+			return true;
+		}
+	}
+
+	// no task is ever added during a run, so all queues stay empty from now on
+	return false;
+}
+
+void SceneBatchProcessor::workerLoop(int workerId)
+{
+	int taskId;
+
+	// with several workers the cores are busy, so per-scene code stays serial
+	SetBatchWorkerThread(m_workerQueues.size() > 1);
+
+	while (popTask(workerId, taskId))
+	{
+		const QString &sceneFullName = (*m_sceneFullNames)[taskId];
+		std::ostringstream taskLog;
+		bool isSuccess = false;
+
+		// messages of the scene code go to the task log as well
+		SetThreadLog(&taskLog);
+
+		CScene *scene = (*m_loader)(sceneFullName);
+
+		if (scene != NULL)
+		{
+			isSuccess = (*m_stage)(scene, taskLog);
+			delete scene;
+		}
+		else
+		{
+			taskLog << "\tcannot load scene " << sceneFullName.toStdString() << "\n";
+		}
+
+		SetThreadLog(NULL);
+
+		finishTask(taskId, isSuccess, taskLog.str());
+	}
+
+	SetBatchWorkerThread(false);
+}
+
+void SceneBatchProcessor::finishTask(int taskId, bool isSuccess, const std::string &taskLog)
+{
+	std::lock_guard<std::mutex> lock(m_outputMutex);
+
+	m_taskLogs[taskId] = taskLog;
+	m_isTaskDone[taskId] = true;
+	m_doneNum++;
+
+	if (isSuccess)
+	{
+		m_successNum++;
+	}
+
+	// write logs of the finished prefix of the list
+	while (m_nextLogTaskId < m_isTaskDone.size() && m_isTaskDone[m_nextLogTaskId])
+	{
+		*m_logStream << m_taskLogs[m_nextLogTaskId];
+		std::string().swap(m_taskLogs[m_nextLogTaskId]);
+		m_nextLogTaskId++;
+	}
+
+	m_logStream->flush();
+
+	if (m_progressCallback)
+	{
+		m_progressCallback(m_doneNum, m_isTaskDone.size(), (*m_sceneFullNames)[taskId]);
+	}
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <QString>
+#include <QStringList>
+#include <functional>
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <ostream>
+
+class CScene;
+
+// runs an independent per-scene stage over a scene list on a pool of worker threads
+// every task loads its own CScene, processes it and deletes it; idle workers steal tasks from busy ones
+// task logs are written in scene list order, once all earlier scenes are finished
+// while a task runs, ThreadLog() of its worker writes to the task log, so scene loading messages do not interleave
+// no widget or GL context is needed, so the processor can be driven headless
+
+class SceneBatchProcessor
+{
+public:
+	typedef std::function<CScene*(const QString &sceneFullName)> SceneLoader;
+	typedef std::function<bool(CScene *scene, std::ostream &log)> SceneStage;
+	typedef std::function<void(int doneNum, int totalNum, const QString &sceneFullName)> ProgressCallback;
+
+	SceneBatchProcessor(int threadNum = 0);  // 0: one thread per core
+	~SceneBatchProcessor();
+
+	// progress is reported from worker threads, one call at a time, in finishing order
+	void setProgressCallback(const ProgressCallback &callback) { m_progressCallback = callback; };
+	void setLogStream(std::ostream *logStream) { m_logStream = logStream; };
+
+	// return number of scenes loaded and processed successfully
+	int run(const QStringList &sceneFullNames, const SceneLoader &loader, const SceneStage &stage);
+
+	int getThreadNum() { return m_threadNum; };
+
+private:
+	struct WorkerQueue
+	{
+		std::deque<int> taskIds;
+		std::mutex queueMutex;
+	};
+
+	void workerLoop(int workerId);
+	bool popTask(int workerId, int &taskId);
+	void finishTask(int taskId, bool isSuccess, const std::string &taskLog);
+
+	int m_threadNum;
+
+	ProgressCallback m_progressCallback;
+	std::ostream *m_logStream;
+
+	// state of current run
+	const QStringList *m_sceneFullNames;
+	const SceneLoader *m_loader;
+	const SceneStage *m_stage;
+
+	std::vector<WorkerQueue> m_workerQueues;
+
+	std::mutex m_outputMutex;
+	std::vector<std::string> m_taskLogs;
+	std::vector<bool> m_isTaskDone;
+	int m_nextLogTaskId;  // first task whose log is not written yet
+	int m_doneNum;
+	int m_successNum;
+};
@@ -0,0 +1,213 @@
+#include "SceneBuildTracker.h"
+#include <QFile>
+#include <QTextStream>
+#include <QCryptographicHash>
+#include <iostream>
+
+SceneBuildTracker::SceneBuildTracker()
+{
+}
+
+SceneBuildTracker::~SceneBuildTracker()
+{
+}
+
+static QString getEntryKey(const QString &stageName, const QString &sceneFullName)
+{
+	return stageName + "|" + sceneFullName;
+}
+
+bool SceneBuildTracker::load(const QString &manifestFileName)
+{
+	m_manifestFileName = manifestFileName;
+	m_entries.clear();
+	m_hashCache.clear();
+
+	QFile inFile(manifestFileName);
+	QTextStream ifs(&inFile);
+
+	if (!inFile.open(QIODevice::ReadOnly | QIODevice::Text))
+	{
+		return false;
+	}
+
+	Entry *currEntry = NULL;
+
+	while (!ifs.atEnd())
+	{
+		QString currLine = ifs.readLine();
+		QStringList parts = currLine.split("\t");
+
+		if (parts[0] == "stage" && parts.size() == 4)
+		{
+			currEntry = &m_entries[getEntryKey(parts[1], parts[2])];
+			currEntry->paraKey = parts[3];
+			currEntry->files.clear();
+		}
+		else if ((parts[0] == "in" || parts[0] == "out") && parts.size() == 3 && currEntry != NULL)
+		{
+			TrackedFile trackedFile;
+			trackedFile.isOutput = (parts[0] == "out");
+			trackedFile.hash = parts[1];
+			trackedFile.fileName = parts[2];
+			currEntry->files.push_back(trackedFile);
+		}
+	}
+
+	inFile.close();
+
+	return true;
+}
+
+bool SceneBuildTracker::save()
+{
+	QFile outFile(m_manifestFileName);
+	QTextStream ofs(&outFile);
+
+	if (!outFile.open(QIODevice::WriteOnly | QIODevice::Text | QIODevice::Truncate))
+	{
+		std::cout << "\tSceneBuildTracker: cannot save manifest " << m_manifestFileName.toStdString() << "\n";
+		return false;
+	}
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	for (auto it = m_entries.begin(); it != m_entries.end(); it++)
+	{
+		int cutPos = it->first.indexOf("|");
+		ofs << "stage\t" << it->first.left(cutPos) << "\t" << it->first.mid(cutPos + 1) << "\t" << it->second.paraKey << "\n";
+
+		for (int i = 0; i < it->second.files.size(); i++)
+		{
+			const TrackedFile &trackedFile = it->second.files[i];
+			ofs << (trackedFile.isOutput ? "out" : "in") << "\t" << trackedFile.hash << "\t" << trackedFile.fileName << "\n";
+		}
+	}
+
+	outFile.close();
+
+	return true;
+}
+
+bool SceneBuildTracker::isUpToDate(const QString &stageName, const QString &sceneFullName, const QString &paraKey)
+{
+	auto iter = m_entries.find(getEntryKey(stageName, sceneFullName));
+	if (iter == m_entries.end() || iter->second.paraKey != paraKey)
+	{
+		return false;
+	}
+
+	const std::vector<TrackedFile> &files = iter->second.files;
+	for (int i = 0; i < files.size(); i++)
+	{
+		if (getCachedHash(files[i].fileName) != files[i].hash)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+QStringList SceneBuildTracker::getOutputFiles(const QString &stageName, const QString &sceneFullName)
+{
+	QStringList outputFiles;
+
+	auto iter = m_entries.find(getEntryKey(stageName, sceneFullName));
+	if (iter == m_entries.end())
+	{
+		return outputFiles;
+	}
+
+	const std::vector<TrackedFile> &files = iter->second.files;
+	for (int i = 0; i < files.size(); i++)
+	{
+		if (files[i].isOutput)
+		{
+			outputFiles << files[i].fileName;
+		}
+	}
+
+	return outputFiles;
+}
+
+void SceneBuildTracker::record(const QString &stageName, const QString &sceneFullName, const QString &paraKey,
+	const QStringList &inputFiles, const QStringList &outputFiles)
+{
+	Entry entry;
+	entry.paraKey = paraKey;
+
+	for (int i = 0; i < inputFiles.size(); i++)
+	{
+		TrackedFile trackedFile;
+		trackedFile.isOutput = false;
+		trackedFile.fileName = inputFiles[i];
+		trackedFile.hash = getCachedHash(inputFiles[i]);
+		entry.files.push_back(trackedFile);
+	}
+
+	// outputs were just written, cached hashes of them are stale
+	for (int i = 0; i < outputFiles.size(); i++)
+	{
+		TrackedFile trackedFile;
+		trackedFile.isOutput = true;
+		trackedFile.fileName = outputFiles[i];
+		trackedFile.hash = hashFile(outputFiles[i]);
+		entry.files.push_back(trackedFile);
+	}
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	for (int i = 0; i < outputFiles.size(); i++)
+	{
+		m_hashCache[outputFiles[i]] = entry.files[inputFiles.size() + i].hash;
+	}
+
+	m_entries[getEntryKey(stageName, sceneFullName)] = entry;
+}
+
+QString SceneBuildTracker::getCachedHash(const QString &fileName)
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		auto iter = m_hashCache.find(fileName);
+		if (iter != m_hashCache.end())
+		{
+			return iter->second;
+		}
+	}
+
+	// model .obb and .supp files are shared by many scenes, hash them once
+	QString hash = hashFile(fileName);
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_hashCache[fileName] = hash;
+
+	return hash;
+}
+
+QString SceneBuildTracker::hashFile(const QString &fileName)
+{
+	QFile inFile(fileName);
+
+	if (!inFile.open(QIODevice::ReadOnly))
+	{
+		return QString();
+	}
+
+	QCryptographicHash hash(QCryptographicHash::Md5);
+	while (!inFile.atEnd())
+	{
+		hash.addData(inFile.read(1 << 20));
+	}
+
+	inFile.close();
+
+	return QString(hash.result().toHex());
+}
+
+QString SceneBuildTracker::hashString(const QString &s)
+{
+	return QString(QCryptographicHash::hash(s.toUtf8(), QCryptographicHash::Md5).toHex());
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <QString>
+#include <QStringList>
+#include <map>
+#include <vector>
+#include <mutex>
+
+// manifest of artifacts built per scene, so re-runs only process stale scenes
+// an entry keeps the parameters a stage ran with and the content hashes of the files it read and wrote for one scene
+// a scene is stale for a stage when any of them changed; since upstream artifacts are inputs of downstream stages,
+// a rewritten .sg or .alignMat makes .ssg and .relPos stale in turn
+
+class SceneBuildTracker
+{
+public:
+	SceneBuildTracker();
+	~SceneBuildTracker();
+
+	bool load(const QString &manifestFileName);  // a missing manifest is empty, every scene is stale
+	bool save();
+
+	// true if the stage ran for the scene with the same parameters and none of its files changed since
+	// a file missing then and now counts as unchanged
+	bool isUpToDate(const QString &stageName, const QString &sceneFullName, const QString &paraKey);
+
+	// files the stage wrote for the scene when it last ran, empty if it never ran
+	QStringList getOutputFiles(const QString &stageName, const QString &sceneFullName);
+
+	// called after the stage succeeded; safe to call from batch worker threads
+	void record(const QString &stageName, const QString &sceneFullName, const QString &paraKey,
+		const QStringList &inputFiles, const QStringList &outputFiles);
+
+	static QString hashFile(const QString &fileName);  // empty if the file cannot be read
+	static QString hashString(const QString &s);
+
+private:
+	struct TrackedFile
+	{
+		bool isOutput;
+		QString fileName;
+		QString hash;
+	};
+
+	struct Entry
+	{
+		QString paraKey;
+		std::vector<TrackedFile> files;
+	};
+
+	QString getCachedHash(const QString &fileName);
+
+	QString m_manifestFileName;
+	std::map<QString, Entry> m_entries;  // key: stageName|sceneFullName
+	std::map<QString, QString> m_hashCache;
+	std::mutex m_mutex;
+};
@@ -0,0 +1,308 @@
+#include "SceneRelationRecord.h"
+#include "../common/geometry/Scene.h"
+#include "../t2scene/SceneSemGraph.h"
+
+#include <QFile>
+#include <QTextStream>
+#include <QStringList>
+#include <iostream>
+
+const QString RelationRecordMagic = "SceneRelationRecord";
+const int RelationRecordVersion = 1;
+
+SceneRelationRecord::SceneRelationRecord()
+{
+}
+
+SceneRelationRecord::~SceneRelationRecord()
+{
+}
+
+void SceneRelationRecord::collectFromScene(CScene *scene)
+{
+	m_sceneName = scene->getSceneName();
+	m_stats.collectFromScene(scene);
+
+	SceneSemGraph *currSSG = scene->m_ssg;
+	if (currSSG == NULL)
+	{
+		return;
+	}
+
+	std::vector<int> nameSymIds(currSSG->getNameNum());
+	for (int i = 0; i < nameSymIds.size(); i++)
+	{
+		nameSymIds[i] = m_stats.m_symbols.intern(currSSG->getName(i));
+	}
+
+	std::vector<int> nodeSymIds(currSSG->m_nodeNum);
+	for (int i = 0; i < currSSG->m_nodeNum; i++)
+	{
+		nodeSymIds[i] = nameSymIds[currSSG->m_nodes[i].nodeNameId];
+	}
+
+	for (int i = 0; i < currSSG->m_nodeNum; i++)
+	{
+		if (currSSG->m_nodes[i].isPairRelation())
+		{
+			PairInstance pairInstance;
+			pairInstance.relationSymId = nodeSymIds[i];
+			pairInstance.anchorObjId = currSSG->anchorNodes(i)[0];
+			pairInstance.anchorSymId = nodeSymIds[pairInstance.anchorObjId];
+			pairInstance.actObjId = currSSG->activeNodes(i)[0];
+			pairInstance.actSymId = nodeSymIds[pairInstance.actObjId];
+
+			m_pairInstances.push_back(pairInstance);
+
+			addObjFeatures(scene, pairInstance.anchorObjId);
+			addObjFeatures(scene, pairInstance.actObjId);
+		}
+	}
+
+	for (int i = 0; i < currSSG->m_nodeNum; i++)
+	{
+		if (currSSG->m_nodes[i].isGroupRelation())
+		{
+			GroupInstance groupInstance;
+			groupInstance.relationSymId = nodeSymIds[i];
+			groupInstance.anchorObjId = currSSG->anchorNodes(i)[0];
+			groupInstance.anchorSymId = nodeSymIds[groupInstance.anchorObjId];
+
+			addObjFeatures(scene, groupInstance.anchorObjId);
+
+			SemNodeList actNodeList = currSSG->activeNodes(i);
+			for (int t = 0; t < actNodeList.size(); t++)
+			{
+				groupInstance.actObjIds.push_back(actNodeList[t]);
+				groupInstance.actSymIds.push_back(nodeSymIds[actNodeList[t]]);
+
+				addObjFeatures(scene, actNodeList[t]);
+			}
+
+			m_groupInstances.push_back(groupInstance);
+		}
+	}
+}
+
+void SceneRelationRecord::addObjFeatures(CScene *scene, int objId)
+{
+	if (m_objFeatures.count(objId))
+	{
+		return;
+	}
+
+	std::vector<double> features(ObjFeatureDim);
+	if (RelativePos::extractObjFeatures(scene, objId, &features[0]))
+	{
+		m_objFeatures[objId] = features;
+	}
+}
+
+bool SceneRelationRecord::getObjFeatures(int anchorObjId, int actObjId, RelativePos *relPos) const
+{
+	auto anchorIter = m_objFeatures.find(anchorObjId);
+	auto actIter = m_objFeatures.find(actObjId);
+
+	if (anchorIter == m_objFeatures.end() || actIter == m_objFeatures.end())
+	{
+		return false;
+	}
+
+	relPos->setObjFeatures(&anchorIter->second[0], &actIter->second[0]);
+	return true;
+}
+
+bool SceneRelationRecord::save(const QString &filename) const
+{
+	QFile outFile(filename);
+	QTextStream ofs(&outFile);
+
+	if (!outFile.open(QIODevice::WriteOnly | QIODevice::Text | QIODevice::Truncate))
+	{
+		std::cout << "\tSceneRelationRecord: cannot save " << filename.toStdString() << "\n";
+		return false;
+	}
+
+	ofs.setRealNumberPrecision(17);
+
+	ofs << RelationRecordMagic << " " << RelationRecordVersion << "\n";
+	ofs << m_sceneName << "\n";
+
+	m_stats.save(ofs);
+
+	ofs << "features " << m_objFeatures.size() << "\n";
+	for (auto it = m_objFeatures.begin(); it != m_objFeatures.end(); it++)
+	{
+		ofs << it->first;
+		for (int d = 0; d < ObjFeatureDim; d++)
+		{
+			ofs << " " << it->second[d];
+		}
+		ofs << "\n";
+	}
+
+	ofs << "pairs " << m_pairInstances.size() << "\n";
+	for (int i = 0; i < m_pairInstances.size(); i++)
+	{
+		const PairInstance &p = m_pairInstances[i];
+		ofs << p.relationSymId << " " << p.anchorObjId << " " << p.anchorSymId << " " << p.actObjId << " " << p.actSymId << "\n";
+	}
+
+	// group line: relation, anchor obj and name, then obj and name of each act obj
+	ofs << "groups " << m_groupInstances.size() << "\n";
+	for (int i = 0; i < m_groupInstances.size(); i++)
+	{
+		const GroupInstance &g = m_groupInstances[i];
+		ofs << g.relationSymId << " " << g.anchorObjId << " " << g.anchorSymId;
+		for (int t = 0; t < g.actObjIds.size(); t++)
+		{
+			ofs << " " << g.actObjIds[t] << " " << g.actSymIds[t];
+		}
+		ofs << "\n";
+	}
+
+	outFile.close();
+
+	return true;
+}
+
+static bool isSymId(int symId, int symbolNum)
+{
+	return symId >= 0 && symId < symbolNum;
+}
+
+// reads a "<name> <n>" line followed by n lines of integers
+static bool readIntLines(QTextStream &ifs, const QString &name, std::vector<std::vector<int>> &lines)
+{
+	QStringList parts = ifs.readLine().split(" ");
+	if (parts.size() != 2 || parts[0] != name)
+	{
+		return false;
+	}
+
+	int n = parts[1].toInt();
+	lines.resize(n);
+
+	for (int i = 0; i < n; i++)
+	{
+		QStringList values = ifs.readLine().split(" ", QString::SkipEmptyParts);
+		lines[i].resize(values.size());
+
+		for (int j = 0; j < values.size(); j++)
+		{
+			bool isNum;
+			lines[i][j] = values[j].toInt(&isNum);
+
+			if (!isNum)
+			{
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+bool SceneRelationRecord::load(const QString &filename)
+{
+	QFile inFile(filename);
+	QTextStream ifs(&inFile);
+
+	if (!inFile.open(QIODevice::ReadOnly | QIODevice::Text))
+	{
+		return false;
+	}
+
+	QStringList header = ifs.readLine().split(" ");
+	if (header.size() != 2 || header[0] != RelationRecordMagic || header[1].toInt() != RelationRecordVersion)
+	{
+		return false;
+	}
+
+	m_sceneName = ifs.readLine();
+
+	if (!m_stats.load(ifs))
+	{
+		return false;
+	}
+
+	int symbolNum = m_stats.m_symbols.size();
+
+	QStringList parts = ifs.readLine().split(" ");
+	if (parts.size() != 2 || parts[0] != "features")
+	{
+		return false;
+	}
+
+	int featureNum = parts[1].toInt();
+	for (int i = 0; i < featureNum; i++)
+	{
+		QStringList values = ifs.readLine().split(" ", QString::SkipEmptyParts);
+		if (values.size() != ObjFeatureDim + 1)
+		{
+			return false;
+		}
+
+		std::vector<double> &features = m_objFeatures[values[0].toInt()];
+		features.resize(ObjFeatureDim);
+		for (int d = 0; d < ObjFeatureDim; d++)
+		{
+			features[d] = values[d + 1].toDouble();
+		}
+	}
+
+	std::vector<std::vector<int>> lines;
+
+	if (!readIntLines(ifs, "pairs", lines))
+	{
+		return false;
+	}
+
+	for (int i = 0; i < lines.size(); i++)
+	{
+		const std::vector<int> &v = lines[i];
+		if (v.size() != 5 || !isSymId(v[0], symbolNum) || !isSymId(v[2], symbolNum) || !isSymId(v[4], symbolNum))
+		{
+			return false;
+		}
+
+		PairInstance pairInstance = { v[0], v[1], v[2], v[3], v[4] };
+		m_pairInstances.push_back(pairInstance);
+	}
+
+	if (!readIntLines(ifs, "groups", lines))
+	{
+		return false;
+	}
+
+	for (int i = 0; i < lines.size(); i++)
+	{
+		const std::vector<int> &v = lines[i];
+		if (v.size() < 3 || v.size() % 2 == 0 || !isSymId(v[0], symbolNum) || !isSymId(v[2], symbolNum))
+		{
+			return false;
+		}
+
+		GroupInstance groupInstance;
+		groupInstance.relationSymId = v[0];
+		groupInstance.anchorObjId = v[1];
+		groupInstance.anchorSymId = v[2];
+
+		for (int j = 3; j < v.size(); j += 2)
+		{
+			if (!isSymId(v[j + 1], symbolNum))
+			{
+				return false;
+			}
+
+			groupInstance.actObjIds.push_back(v[j]);
+			groupInstance.actSymIds.push_back(v[j + 1]);
+		}
+
+		m_groupInstances.push_back(groupInstance);
+	}
+
+	inFile.close();
+
+	return true;
+}
@@ -0,0 +1,59 @@
+#pragma once
+#include "SceneRelationStats.h"
+#include "RelationModel.h"
+#include <QString>
+#include <vector>
+#include <map>
+
+class CScene;
+
+// everything the relation model builders read from one scene: pair and group relation instances of its ssg,
+// features of the objs they relate and its support and co-occurrence counts
+// saved as .relStats next to the scene's .relPos, so models can be rebuilt without loading unchanged scenes
+// names are ids of the symbol table of m_stats
+
+class SceneRelationRecord
+{
+public:
+	SceneRelationRecord();
+	~SceneRelationRecord();
+
+	// scene needs its ssg loaded
+	void collectFromScene(CScene *scene);
+
+	bool save(const QString &filename) const;
+	bool load(const QString &filename);
+
+	// false if the features of either obj are unknown
+	bool getObjFeatures(int anchorObjId, int actObjId, RelativePos *relPos) const;
+
+	struct PairInstance
+	{
+		int relationSymId;
+		int anchorObjId;
+		int anchorSymId;
+		int actObjId;
+		int actSymId;
+	};
+
+	struct GroupInstance
+	{
+		int relationSymId;
+		int anchorObjId;
+		int anchorSymId;
+		std::vector<int> actObjIds;
+		std::vector<int> actSymIds;
+	};
+
+	QString m_sceneName;
+	SceneRelationStats m_stats;
+
+	// in ssg node order, obj ids are ssg node ids
+	std::vector<PairInstance> m_pairInstances;
+	std::vector<GroupInstance> m_groupInstances;
+
+	std::map<int, std::vector<double>> m_objFeatures;  // obj id: features of the objs in pair and group instances
+
+private:
+	void addObjFeatures(CScene *scene, int objId);
+};
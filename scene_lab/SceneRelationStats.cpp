@@ -0,0 +1,335 @@
+#include "SceneRelationStats.h"
+#include "RelationExtractor.h"
+#include "../common/geometry/Scene.h"
+#include "../common/geometry/CModel.h"
+#include "../t2scene/SceneSemGraph.h"
+
+#include <QTextStream>
+#include <QStringList>
+#include <algorithm>
+
+SceneRelationStats::SceneRelationStats()
+{
+}
+
+SceneRelationStats::~SceneRelationStats()
+{
+}
+
+void SceneRelationStats::collectFromScene(CScene *scene)
+{
+	collectSupportFromScene(scene);
+	collectCoOccOnParentFromScene(scene);
+}
+
+void SceneRelationStats::collectSupportFromScene(CScene *scene)
+{
+	SceneSemGraph *currSSG = scene->m_ssg;
+	if (currSSG == NULL)
+	{
+		return;
+	}
+
+	std::vector<int> nameSymIds(currSSG->getNameNum());
+	for (int i = 0; i < nameSymIds.size(); i++)
+	{
+		nameSymIds[i] = m_symbols.intern(currSSG->getName(i));
+	}
+
+	std::vector<int> nodeSymIds(currSSG->m_nodeNum);
+	for (int i = 0; i < currSSG->m_nodeNum; i++)
+	{
+		nodeSymIds[i] = nameSymIds[currSSG->m_nodes[i].nodeNameId];
+	}
+
+	int roomSymId = m_symbols.intern("room");
+
+	// count num of total object observation
+	for (int i = 0; i < currSSG->m_nodeNum; i++)
+	{
+		if (currSSG->m_nodes[i].isObject())
+		{
+			m_objNums[nodeSymIds[i]]++;
+		}
+	}
+
+	for (int i = 0; i < currSSG->m_nodeNum; i++)
+	{
+		SemNode &sgNode = currSSG->m_nodes[i];
+		if (sgNode.isObject())
+		{
+			bool isSupportParent = false;
+			int parentSymId = nodeSymIds[i];
+
+			// vertsupport and horizon support
+			for (int rt = 0; rt < 2; rt++)
+			{
+				int supportSymId = m_symbols.intern(PairRelStrings[rt]);
+
+				std::vector<int> actNodeList;
+				SemNodeList relNodeList = currSSG->inNodes(i);
+				for (int r = 0; r < relNodeList.size(); r++)
+				{
+					int relNodeId = relNodeList[r];
+
+					if (nodeSymIds[relNodeId] == supportSymId)
+					{
+						actNodeList.push_back(currSSG->activeNodes(relNodeId)[0]);
+					}
+				}
+
+				std::vector<int> actNodeCountedIndicator(actNodeList.size(), 0); // whether the node has been counted
+				for (int t = 0; t < actNodeList.size(); t++)
+				{
+					int actSymId = nodeSymIds[actNodeList[t]];
+
+					// count obj num in current active list
+					int currActObjNum = 0;
+					for (int ai = 0; ai < actNodeList.size(); ai++)
+					{
+						if (actNodeCountedIndicator[ai] == 0 && actSymId == nodeSymIds[actNodeList[ai]])
+						{
+							actNodeCountedIndicator[ai] = 1;
+							currActObjNum++;
+						}
+					}
+
+					// each child category counts once per parent instance
+					if (currActObjNum)
+					{
+						m_suppJointNums[RelationSymbolTable::packKey(parentSymId, actSymId, supportSymId)]++;
+						m_suppChildNums[RelationSymbolTable::packKey(actSymId, supportSymId)]++;
+					}
+
+					if (parentSymId != roomSymId)
+					{
+						m_beChildNums[actSymId]++;
+					}
+				}
+
+				if (!actNodeList.empty())
+				{
+					isSupportParent = true;
+					m_suppParentNums[RelationSymbolTable::packKey(parentSymId, supportSymId)]++;
+				}
+			}
+
+			if (isSupportParent)
+			{
+				m_beParentNums[parentSymId]++;
+			}
+		}
+	}
+}
+
+void SceneRelationStats::collectCoOccOnParentFromScene(CScene *scene)
+{
+	int modelNum = scene->getModelNum();
+
+	std::vector<int> catSymIds(modelNum);
+	for (int i = 0; i < modelNum; i++)
+	{
+		catSymIds[i] = m_symbols.intern(scene->getModel(i)->getCatName());
+	}
+
+	int roomSymId = m_symbols.intern("room");
+
+	for (int i = 0; i < modelNum; i++)
+	{
+		CModel *currModel = scene->getModel(i);
+
+		if (currModel->suppChindrenList.empty())
+		{
+			continue;
+		}
+
+		// collect unique support children list
+		std::vector<int> uniqueIds;
+		std::vector<int> childCatSymIds;
+		for (int j = 0; j < currModel->suppChindrenList.size(); j++)
+		{
+			int childModelId = currModel->suppChindrenList[j];
+
+			if (std::find(childCatSymIds.begin(), childCatSymIds.end(), catSymIds[childModelId]) == childCatSymIds.end())
+			{
+				childCatSymIds.push_back(catSymIds[childModelId]);
+				uniqueIds.push_back(childModelId);
+			}
+		}
+
+		for (int j = 0; j < uniqueIds.size(); j++)
+		{
+			int firstParentModelId = scene->getModel(uniqueIds[j])->suppParentID;
+			int firstCatSymId = catSymIds[uniqueIds[j]];
+
+			if (firstParentModelId == -1) continue;
+			if (firstCatSymId == roomSymId) continue;
+
+			int parentCatSymId = catSymIds[firstParentModelId];
+			m_childOnParentNums[RelationSymbolTable::packKey(firstCatSymId, parentCatSymId)]++;
+
+			for (int k = 0; k < uniqueIds.size(); k++)
+			{
+				if (k == j) continue;
+
+				if (scene->getModel(uniqueIds[k])->suppParentID == firstParentModelId)
+				{
+					m_coOccOnParentNums[RelationSymbolTable::packKey(firstCatSymId, catSymIds[uniqueIds[k]], parentCatSymId)]++;
+				}
+			}
+		}
+	}
+}
+
+// add counts keyed by symbols of another table, partNum leading parts of the key are symbol ids
+static void mergeCounts(std::unordered_map<SymbolKey, int> &counts, const std::unordered_map<SymbolKey, int> &otherCounts, int partNum, const std::vector<int> &symIds)
+{
+	for (auto iter = otherCounts.begin(); iter != otherCounts.end(); iter++)
+	{
+		int parts[4] = { 0, 0, 0, 0 };
+		bool isValid = true;
+
+		for (int p = 0; p < partNum; p++)
+		{
+			int otherSymId = RelationSymbolTable::unpackKey(iter->first, p);
+			if (otherSymId >= symIds.size())
+			{
+				isValid = false;
+				break;
+			}
+
+			parts[p] = symIds[otherSymId];
+		}
+
+		if (isValid)
+		{
+			counts[RelationSymbolTable::packKey(parts[0], parts[1], parts[2], parts[3])] += iter->second;
+		}
+	}
+}
+
+static void mergeCounts(std::unordered_map<int, int> &counts, const std::unordered_map<int, int> &otherCounts, const std::vector<int> &symIds)
+{
+	for (auto iter = otherCounts.begin(); iter != otherCounts.end(); iter++)
+	{
+		if (iter->first < symIds.size())
+		{
+			counts[symIds[iter->first]] += iter->second;
+		}
+	}
+}
+
+void SceneRelationStats::merge(const SceneRelationStats &other)
+{
+	std::vector<int> symIds(other.m_symbols.size());
+	for (int i = 0; i < symIds.size(); i++)
+	{
+		symIds[i] = m_symbols.intern(other.m_symbols.getName(i));
+	}
+
+	mergeCounts(m_suppJointNums, other.m_suppJointNums, 3, symIds);
+	mergeCounts(m_suppParentNums, other.m_suppParentNums, 2, symIds);
+	mergeCounts(m_suppChildNums, other.m_suppChildNums, 2, symIds);
+	mergeCounts(m_objNums, other.m_objNums, symIds);
+	mergeCounts(m_beParentNums, other.m_beParentNums, symIds);
+	mergeCounts(m_beChildNums, other.m_beChildNums, symIds);
+
+	mergeCounts(m_coOccOnParentNums, other.m_coOccOnParentNums, 3, symIds);
+	mergeCounts(m_childOnParentNums, other.m_childOnParentNums, 2, symIds);
+}
+
+// section: "<name> <n>" line, then one "<key> <count>" line per entry; keys are written in sorted order, so the
+// file of a scene does not depend on hash map iteration
+template<typename Key>
+static void saveCounts(QTextStream &ofs, const QString &name, const std::unordered_map<Key, int> &counts)
+{
+	std::vector<std::pair<Key, int>> sortedCounts(counts.begin(), counts.end());
+	std::sort(sortedCounts.begin(), sortedCounts.end());
+
+	ofs << name << " " << sortedCounts.size() << "\n";
+	for (int i = 0; i < sortedCounts.size(); i++)
+	{
+		ofs << (qulonglong)sortedCounts[i].first << " " << sortedCounts[i].second << "\n";
+	}
+}
+
+static int readSectionSize(QTextStream &ifs, const QString &name)
+{
+	QStringList parts = ifs.readLine().split(" ");
+	if (parts.size() != 2 || parts[0] != name)
+	{
+		return -1;
+	}
+
+	bool isNum;
+	int n = parts[1].toInt(&isNum);
+	return isNum ? n : -1;
+}
+
+template<typename Key>
+static bool loadCounts(QTextStream &ifs, const QString &name, std::unordered_map<Key, int> &counts)
+{
+	int n = readSectionSize(ifs, name);
+	if (n < 0)
+	{
+		return false;
+	}
+
+	counts.clear();
+	for (int i = 0; i < n; i++)
+	{
+		QStringList parts = ifs.readLine().split(" ");
+		if (parts.size() != 2)
+		{
+			return false;
+		}
+
+		counts[(Key)parts[0].toULongLong()] = parts[1].toInt();
+	}
+
+	return true;
+}
+
+void SceneRelationStats::save(QTextStream &ofs) const
+{
+	// names may contain spaces, one per line
+	ofs << "symbols " << m_symbols.size() << "\n";
+	for (int i = 0; i < m_symbols.size(); i++)
+	{
+		ofs << m_symbols.getName(i) << "\n";
+	}
+
+	saveCounts(ofs, "suppJoint", m_suppJointNums);
+	saveCounts(ofs, "suppParent", m_suppParentNums);
+	saveCounts(ofs, "suppChild", m_suppChildNums);
+	saveCounts(ofs, "obj", m_objNums);
+	saveCounts(ofs, "beParent", m_beParentNums);
+	saveCounts(ofs, "beChild", m_beChildNums);
+	saveCounts(ofs, "coOccOnParent", m_coOccOnParentNums);
+	saveCounts(ofs, "childOnParent", m_childOnParentNums);
+}
+
+bool SceneRelationStats::load(QTextStream &ifs)
+{
+	int symbolNum = readSectionSize(ifs, "symbols");
+	if (symbolNum < 0 || m_symbols.size() > 0)
+	{
+		return false;
+	}
+
+	for (int i = 0; i < symbolNum; i++)
+	{
+		m_symbols.intern(ifs.readLine());
+	}
+
+	// repeated names would shift the ids of the counts
+	if (m_symbols.size() != symbolNum)
+	{
+		return false;
+	}
+
+	return loadCounts(ifs, "suppJoint", m_suppJointNums) && loadCounts(ifs, "suppParent", m_suppParentNums)
+		&& loadCounts(ifs, "suppChild", m_suppChildNums) && loadCounts(ifs, "obj", m_objNums)
+		&& loadCounts(ifs, "beParent", m_beParentNums) && loadCounts(ifs, "beChild", m_beChildNums)
+		&& loadCounts(ifs, "coOccOnParent", m_coOccOnParentNums) && loadCounts(ifs, "childOnParent", m_childOnParentNums);
+}
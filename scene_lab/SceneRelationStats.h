@@ -0,0 +1,43 @@
+#pragma once
+#include "RelationSymbolTable.h"
+#include <unordered_map>
+
+class CScene;
+class QTextStream;
+
+// support and co-occurrence counts of one or more scenes
+// names are interned in the summary's own table, so scenes can be summarized on any thread without a manager;
+// every count is a sum over parent instances, so merging summaries in any order gives the same totals
+
+class SceneRelationStats
+{
+public:
+	SceneRelationStats();
+	~SceneRelationStats();
+
+	// scene needs its ssg loaded
+	void collectFromScene(CScene *scene);
+	void merge(const SceneRelationStats &other);
+
+	// symbol table and counts as text sections, part of the per-scene .relStats file
+	void save(QTextStream &ofs) const;
+	bool load(QTextStream &ifs);
+
+	RelationSymbolTable m_symbols;
+
+	// support relations from the ssg
+	std::unordered_map<SymbolKey, int> m_suppJointNums;  // parent, child, support type: parent instances supporting the child category
+	std::unordered_map<SymbolKey, int> m_suppParentNums;  // parent, support type: parent instances supporting any child
+	std::unordered_map<SymbolKey, int> m_suppChildNums;  // child, support type: parent instances supporting the child category
+	std::unordered_map<int, int> m_objNums;  // obj name: observations of the obj
+	std::unordered_map<int, int> m_beParentNums;
+	std::unordered_map<int, int> m_beChildNums;  // being a child while the parent is not "room"
+
+	// siblings on the same support parent, from model categories
+	std::unordered_map<SymbolKey, int> m_coOccOnParentNums;  // first, second, parent: parent instances with both child categories
+	std::unordered_map<SymbolKey, int> m_childOnParentNums;  // child, parent: parent instances with the child category
+
+private:
+	void collectSupportFromScene(CScene *scene);
+	void collectCoOccOnParentFromScene(CScene *scene);
+};
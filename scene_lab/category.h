@@ -19,6 +19,7 @@ public:
 	void setCatgoryLevel(int l){ m_categoryLevel = l; };
 	int getCatgoryLevel() { return m_categoryLevel; };
 	void addSubCatNames(const QString &s) { m_subCatNames.push_back(s); };
+	const std::vector<QString>& getSubCatNames() const { return m_subCatNames; };
 
 	bool isInModelBlackList(const QString &s);
 	bool isSharedModel(const QString &s);
@@ -4,6 +4,7 @@
 #include "../common/utilities/utility.h"
 #include <QDir>
 #include <QFile>
+#include <QFileInfo>
 #include <QTextStream>
 
 ModelDatabase::ModelDatabase()
@@ -26,12 +27,15 @@ ModelDatabase::ModelDatabase()
 
 	//m_parentCatNum = 0;
 	//m_modelNum = 0;
+
+	m_isCatalogLoaded = false;
 }
 
 
 ModelDatabase::ModelDatabase(const QString &projectPath, int dBType)
 {
 	m_projectPath = projectPath;
+	m_dbType = dBType;
 
 	if (dBType == ModelDBType::ShapeNetDB)
 	{
@@ -57,6 +61,8 @@ ModelDatabase::ModelDatabase(const QString &projectPath, int dBType)
 
 	m_parentCatNum = 0;
 	m_modelNum = 0;
+
+	m_isCatalogLoaded = false;
 }
 
 ModelDatabase::~ModelDatabase()
@@ -105,6 +111,8 @@ void ModelDatabase::loadModelTsv(const QString &modelsTsvFile)
 
 void ModelDatabase::readModelScaleFile(const QString &filename)
 {
+	loadAllMetaModels();
+
 	auto lines = GetFileLines(filename.toStdString(), 0);
 
 	//std::map<std::string, float> modelScaleById;
@@ -219,6 +227,8 @@ CModel* ModelDatabase::getModelById(QString idStr)
 
 Category* ModelDatabase::getCategory(QString catName)
 {
+	loadAllMetaModels();
+
 	//if (catName == "mouse")
 	//{
 	//	catName = QString("computermouse");
@@ -261,6 +271,8 @@ Category* ModelDatabase::getCategory(QString catName)
 
 bool ModelDatabase::isCatInDB(QString catname)
 {
+	loadAllMetaModels();
+
 	if (dbCategories.count(catname) == 0)
 	{
 		if (catname == "coffeetable")
@@ -284,6 +296,8 @@ bool ModelDatabase::isCatInDB(QString catname)
 // add models to annotated models: 1. create modelname.arv under interaction map
 void ModelDatabase::extractScaledAnnoModels()
 {
+	loadAllMetaModels();
+
 	int cutPos = m_dbPath.lastIndexOf("/");
 	QString dbParentPath = m_dbPath.left(cutPos);
 
@@ -445,11 +459,15 @@ void ModelDatabase::extractModelWithTexture()
 
 int ModelDatabase::getModelNum()
 {
+	loadAllMetaModels();
+
 	return dbMetaModels.size();
 }
 
 QString ModelDatabase::getModelIdStr(int id)
 {
+	loadAllMetaModels();
+
 	std::map<QString, DBMetaModel*>::iterator it = dbMetaModels.begin();
 
 	std::advance(it, id);
@@ -457,10 +475,15 @@ QString ModelDatabase::getModelIdStr(int id)
 	return it->first;
 }
 
-QString ModelDatabase::getModelCat(const QString &idStr)
+QString ModelDatabase::getModelCat(const QString &idStr) const
 {
-	DBMetaModel *cm = dbMetaModels[idStr];
-	return cm->getCatName();
+	DBModelFields fields;
+	if (!getModelFields(idStr, fields))
+	{
+		return QString();
+	}
+
+	return fields.catName;
 }
 
 QString ModelDatabase::getUpdatedModelCat(const QString &catName, const QString &modelIdStr)
@@ -517,7 +540,7 @@ void ModelDatabase::loadShapeNetSemTxt()
 	QString shapeNetSemTxtFileName = m_projectPath + "/meta_data/" + m_dbMetaFileType + ".txt";
 
 	auto lines = GetFileLines(shapeNetSemTxtFileName.toStdString(), 3);
-	modelMetaInfoStrings = std::vector<std::string>(lines.begin()+1, lines.end());
+	m_modelMetaInfoStrings = std::vector<std::string>(lines.begin()+1, lines.end());
 
 	// parsing from second line
 	for (int i = 1; i < lines.size(); i++)
@@ -632,12 +655,80 @@ void ModelDatabase::loadShapeNetSemTxt()
 		}
 	}
 
+	processModelCatNames();
+
 	std::cout << "Model annotation loading done.\n";
 }
 
-DBMetaModel* ModelDatabase::getMetaModelByNameString(const QString &s)
+const DBMetaModel* ModelDatabase::getMetaModelByNameString(const QString &s) const
+{
+	if (m_metaCatalog.isOpen())
+	{
+		int recordId = m_metaCatalog.findModel(s);
+		if (recordId != -1)
+		{
+			return getCatalogModel(recordId);
+		}
+	}
+
+	// models added after the catalog was compiled are only in the map
+	auto it = dbMetaModels.find(s);
+	if (it == dbMetaModels.end())
+	{
+		return NULL;
+	}
+
+	return it->second;
+}
+
+bool ModelDatabase::getModelFields(const QString &s, DBModelFields &fields) const
 {
-	return dbMetaModels[s]; 
+	if (m_metaCatalog.isOpen())
+	{
+		int recordId = m_metaCatalog.findModel(s);
+		if (recordId != -1)
+		{
+			const ModelMetaCatalog::ModelRecord &record = m_metaCatalog.getModel(recordId);
+
+			fields.dbID = record.dbID;
+			fields.idStr = s;
+			fields.catName = m_metaCatalog.getString(record.catNameId);
+			fields.processedCatName = m_metaCatalog.getString(record.processedCatNameId);
+			fields.frontDir = MathLib::Vector3(record.frontDir[0], record.frontDir[1], record.frontDir[2]);
+			fields.upDir = MathLib::Vector3(record.upDir[0], record.upDir[1], record.upDir[2]);
+			fields.position = MathLib::Vector3(record.position[0], record.position[1], record.position[2]);
+			fields.scale = record.scale;
+
+			return true;
+		}
+	}
+
+	auto it = dbMetaModels.find(s);
+	if (it == dbMetaModels.end() || it->second == NULL)
+	{
+		return false;
+	}
+
+	const DBMetaModel *m = it->second;
+
+	fields.dbID = m->dbID;
+	fields.idStr = m->getIdStr();
+	fields.catName = m->getCatName();
+	fields.processedCatName = m->getProcessedCatName();
+	fields.frontDir = m->frontDir;
+	fields.upDir = m->upDir;
+	fields.position = m->position;
+	fields.scale = m->getScale();
+
+	return true;
+}
+
+void ModelDatabase::processModelCatNames()
+{
+	for (auto it = dbMetaModels.begin(); it != dbMetaModels.end(); it++)
+	{
+		it->second->processCatName();
+	}
 }
 
 void ModelDatabase::loadSunCGMetaData()
@@ -647,7 +738,7 @@ void ModelDatabase::loadSunCGMetaData()
 	QString sunCGMetaDataFileName = m_projectPath + "/meta_data/modelsSunCG.csv";
 
 	auto lines = GetFileLines(sunCGMetaDataFileName.toStdString(), 3);
-	modelMetaInfoStrings = std::vector<std::string>(lines.begin() + 1, lines.end());
+	m_modelMetaInfoStrings = std::vector<std::string>(lines.begin() + 1, lines.end());
 
 	// parsing from second line
 	for (int i = 1; i < lines.size(); i++)
@@ -712,7 +803,7 @@ void ModelDatabase::loadSunCGModelCat()
 	QString sunCGMetaDataFileName = m_projectPath + "/meta_data/ModelCategoryAnnoSunCG.csv";
 
 	auto lines = GetFileLines(sunCGMetaDataFileName.toStdString(), 3);
-	modelMetaInfoStrings = std::vector<std::string>(lines.begin() + 1, lines.end());
+	m_modelMetaInfoStrings = std::vector<std::string>(lines.begin() + 1, lines.end());
 
 	// parsing from second line
 	for (int i = 1; i < lines.size(); i++)
@@ -771,6 +862,8 @@ void ModelDatabase::loadSunCGModelCat()
 		}
 	}
 
+	processModelCatNames();
+
 
 	// save category names if not done before
 	QString modelCatFileName = m_projectPath + "/meta_data/suncg_model_category.txt";
@@ -795,17 +888,220 @@ void ModelDatabase::loadSunCGModelCat()
 	std::cout << "Model annotation loading done.\n";
 }
 
-bool ModelDatabase::isModelInDB(const QString &s)
+bool ModelDatabase::isModelInDB(const QString &s) const
 {
-	if (dbMetaModels.find(s)!= dbMetaModels.end())
+	return getMetaModelByNameString(s) != NULL;
+}
+
+std::string ModelDatabase::getModelMetaInfoString(int lineId) const
+{
+	if (m_metaCatalog.isOpen())
 	{
-		return true;
+		return m_metaCatalog.getMetaInfoString(lineId);
+	}
+
+	if (lineId < 0 || lineId >= m_modelMetaInfoStrings.size())
+	{
+		return std::string();
 	}
 
+	return m_modelMetaInfoStrings[lineId];
+}
+
+QString ModelDatabase::getMetaCatalogFileName() const
+{
+	if (m_dbType == ModelDBType::SunCGDB)
+	{
+		return m_projectPath + "/meta_data/modelsSunCG.mcat";
+	}
+
+	return m_projectPath + "/meta_data/" + m_dbMetaFileType + ".mcat";
+}
+
+QStringList ModelDatabase::getMetaCatalogSourceFileNames() const
+{
+	QStringList fileNames;
+	fileNames << m_projectPath + "/meta_data/SpecifiedModelCategory.txt";
+
+	if (m_dbType == ModelDBType::SunCGDB)
+	{
+		fileNames << m_projectPath + "/meta_data/modelsSunCG.csv";
+		fileNames << m_projectPath + "/meta_data/ModelCategoryAnnoSunCG.csv";
+		fileNames << m_projectPath + "/meta_data/ModelCategoryMapSunCG.txt";
+	}
 	else
+	{
+		fileNames << m_projectPath + "/meta_data/" + m_dbMetaFileType + ".txt";
+	}
+
+	return fileNames;
+}
+
+bool ModelDatabase::isMetaCatalogUpToDate() const
+{
+	QFileInfo catalogFileInfo(getMetaCatalogFileName());
+
+	if (!catalogFileInfo.exists()) return false;
+
+	// catalog is stale if any meta data or category map file was modified after it was compiled
+	foreach(QString fileName, getMetaCatalogSourceFileNames())
+	{
+		QFileInfo sourceFileInfo(fileName);
+		if (sourceFileInfo.exists() && sourceFileInfo.lastModified() > catalogFileInfo.lastModified())
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+bool ModelDatabase::loadMetaCatalog()
+{
+	if (!isMetaCatalogUpToDate() || !m_metaCatalog.open(getMetaCatalogFileName(), m_dbType))
 	{
 		return false;
 	}
+
+	m_catalogModels.assign(m_metaCatalog.getModelNum(), NULL);
+	m_isCatalogLoaded = false;
+
+	m_modelNum = m_metaCatalog.getModelNum();
+	m_parentCatNum = m_metaCatalog.getParentCatNum();
+
+	std::cout << "\t Model meta catalog opened with " << m_modelNum << " models.\n";
+
+	return true;
+}
+
+DBMetaModel* ModelDatabase::getCatalogModel(int recordId) const
+{
+	std::lock_guard<std::mutex> lock(m_catalogModelMutex);
+
+	DBMetaModel *&m = m_catalogModels[recordId];
+	if (m != NULL)
+	{
+		return m;
+	}
+
+	const ModelMetaCatalog::ModelRecord &record = m_metaCatalog.getModel(recordId);
+
+	m = new DBMetaModel(m_metaCatalog.getString(record.idStrId));
+	m->dbID = record.dbID;
+	m->setCatName(m_metaCatalog.getString(record.catNameId));
+	m->setScale(record.scale);
+
+	m->frontDir = MathLib::Vector3(record.frontDir[0], record.frontDir[1], record.frontDir[2]);
+	m->upDir = MathLib::Vector3(record.upDir[0], record.upDir[1], record.upDir[2]);
+	m->position = MathLib::Vector3(record.position[0], record.position[1], record.position[2]);
+
+	const qint32 *candidateIds = m_metaCatalog.getList(record.candidateStart);
+	for (int i = 0; i < record.candidateNum; i++)
+	{
+		m->addCandidateCatName(m_metaCatalog.getString(candidateIds[i]));
+	}
+
+	const qint32 *lemmaIds = m_metaCatalog.getList(record.lemmaStart);
+	for (int i = 0; i < record.lemmaNum; i++)
+	{
+		m->addWordNetLemmas(m_metaCatalog.getString(lemmaIds[i]));
+	}
+
+	const qint32 *attributeIds = m_metaCatalog.getList(record.attributeStart);
+	for (int i = 0; i < record.attributeNum; i++)
+	{
+		m->m_attributes.push_back(m_metaCatalog.getString(attributeIds[i]));
+	}
+
+	// processed when the catalog was compiled
+	m->m_processedCatName = m_metaCatalog.getString(record.processedCatNameId);
+	m->m_isCatNameProcessed = true;
+
+	return m;
+}
+
+void ModelDatabase::loadAllMetaModels()
+{
+	if (!m_metaCatalog.isOpen() || m_isCatalogLoaded)
+	{
+		return;
+	}
+
+	// records are in id order, as the map
+	for (int r = 0; r < m_metaCatalog.getModelNum(); r++)
+	{
+		DBMetaModel *m = getCatalogModel(r);
+		dbMetaModels.insert(dbMetaModels.end(), std::make_pair(m->getIdStr(), m));
+	}
+
+	for (int c = 0; c < m_metaCatalog.getCategoryNum(); c++)
+	{
+		const ModelMetaCatalog::CategoryRecord &record = m_metaCatalog.getCategory(c);
+		QString catName = m_metaCatalog.getString(record.nameId);
+
+		Category *&cat = dbCategories[catName];
+		if (cat == NULL)
+		{
+			cat = new Category(catName);
+			cat->setCatgoryLevel(record.level);
+
+			const qint32 *subCatIds = m_metaCatalog.getList(record.subCatStart);
+			for (int i = 0; i < record.subCatNum; i++)
+			{
+				cat->addSubCatNames(m_metaCatalog.getString(subCatIds[i]));
+			}
+		}
+
+		const qint32 *instanceIds = m_metaCatalog.getList(record.instanceStart);
+		for (int i = 0; i < record.instanceNum; i++)
+		{
+			cat->addInstance(getCatalogModel(instanceIds[i]));
+		}
+	}
+
+	m_isCatalogLoaded = true;
+}
+
+void ModelDatabase::clearMetaModels()
+{
+	for (auto it = dbMetaModels.begin(); it != dbMetaModels.end(); it++)
+	{
+		delete it->second;
+	}
+
+	for (auto it = dbCategories.begin(); it != dbCategories.end(); it++)
+	{
+		delete it->second;
+	}
+
+	dbMetaModels.clear();
+	dbCategories.clear();
+}
+
+bool ModelDatabase::saveMetaCatalog()
+{
+	QString catalogFileName = getMetaCatalogFileName();
+
+	if (!ModelMetaCatalog::save(catalogFileName, m_dbType, dbMetaModels, dbCategories, m_parentCatNum, m_modelMetaInfoStrings))
+	{
+		std::cout << "\tCannot save model meta catalog " << catalogFileName.toStdString() << "\n";
+		return false;
+	}
+
+	// lookups and meta info lines are served by the mapped catalog from now on, as in later sessions
+	if (!m_metaCatalog.open(catalogFileName, m_dbType))
+	{
+		return false;
+	}
+
+	// parsed entries would duplicate the catalog, they are created again on request
+	clearMetaModels();
+	m_catalogModels.assign(m_metaCatalog.getModelNum(), NULL);
+	m_isCatalogLoaded = false;
+
+	std::vector<std::string>().swap(m_modelMetaInfoStrings);
+
+	return true;
 }
 
 DBMetaModel::DBMetaModel()
@@ -860,137 +1156,149 @@ DBMetaModel::DBMetaModel(DBMetaModel *m)
 	frontDir = m->frontDir;
 	upDir = m->upDir;
 	position = m->position;
+
+	parentId = -1;
+	onSuppPlaneUV = std::vector<double>(2, 0.5);
+	positionToSuppPlaneDist = 0;
+
+	m_isCatNameProcessed = m->m_isCatNameProcessed;
+	m_processedCatName = m->m_processedCatName;
+}
+
+void DBMetaModel::processCatName()
+{
+	m_processedCatName = computeProcessedCatName();
+	m_isCatNameProcessed = true;
 }
 
-QString DBMetaModel::getProcessedCatName()
+QString DBMetaModel::getProcessedCatName() const
 {
 	if (m_isCatNameProcessed)
 	{
 		return m_processedCatName;
 	}
 
+	return computeProcessedCatName();
+}
+
+QString DBMetaModel::computeProcessedCatName() const
+{
 	//if (m_idStr == "416674f64be11975bc4f8438441dcb1d")
 	//{
-	//	m_isCatNameProcessed = true;
-	//	m_processedCatName = "monitor";
-	//	return m_processedCatName;
+	//	return "monitor";
 	//}
 
-	m_processedCatName = "";
-
 	if (m_CandidateCategoryNames.empty() && m_wordNetLemmas.empty())
 	{
-		m_isCatNameProcessed = true;
-		return m_processedCatName;
+		return QString("");
 	}
 
+	// filter a copy, the entry may be shared by reader threads
+	std::vector<QString> candidateNames = m_CandidateCategoryNames;
+
 	const int badCatNum = 12;
 	QString badCatNames[badCatNum] = { "_stanfordscenedbmodels", "_scenegallerymodels", "_oimwhitelist", "_attributestrain", 
 		"_attributes", "_evalsetinscenes", "_pilotstudymodels", "_geoautotagevalset", "_randomsetstudymodels", "_evalsetexclude","drinkingutensil", "fooditem"};
 
 	for (int i = 0; i < badCatNum; i++)
 	{
-		auto it = std::find(m_CandidateCategoryNames.begin(), m_CandidateCategoryNames.end(), badCatNames[i]);
-		if (it != m_CandidateCategoryNames.end())
-			m_CandidateCategoryNames.erase(it);
+		auto it = std::find(candidateNames.begin(), candidateNames.end(), badCatNames[i]);
+		if (it != candidateNames.end())
+			candidateNames.erase(it);
 	}
 
-	if (m_CandidateCategoryNames.empty())
+	if (candidateNames.empty())
 	{
 		if (!m_wordNetLemmas.empty())
 		{
-			m_processedCatName = m_wordNetLemmas[0];
+			return m_wordNetLemmas[0];
 		}
 		else
 		{
-			m_processedCatName = "noname";
+			return QString("noname");
 		}
-		
-		m_isCatNameProcessed = true;
-		return m_processedCatName;
 	}
 
-	m_processedCatName = m_CandidateCategoryNames[0];
+	QString processedCatName = candidateNames[0];
 
-	if (m_CandidateCategoryNames[0] == "chestofdrawers")
+	if (candidateNames[0] == "chestofdrawers")
 	{
-		if (m_CandidateCategoryNames.size()>1)
+		if (candidateNames.size()>1)
 		{
-			m_processedCatName = m_CandidateCategoryNames[1];
+			processedCatName = candidateNames[1];
 		}
 	}
 
 	
-	if (m_CandidateCategoryNames[0] == "lamp")
+	if (candidateNames[0] == "lamp")
 	{
-		for (int i = 1; i < m_CandidateCategoryNames.size(); i++)
+		for (int i = 1; i < candidateNames.size(); i++)
 		{
-			if (m_CandidateCategoryNames[i] == "desklamp")
+			if (candidateNames[i] == "desklamp")
 			{
-				m_processedCatName = "desklamp";
+				processedCatName = "desklamp";
 				break;
 			}
 
-			if (m_CandidateCategoryNames[i] == "floorlamp")
+			if (candidateNames[i] == "floorlamp")
 			{
-				m_processedCatName = "floorlamp";
+				processedCatName = "floorlamp";
 				break;
 			}
 		}
 	}
 
 	// book
-	if (m_CandidateCategoryNames[0] == "book")
+	if (candidateNames[0] == "book")
 	{
-		for (int i = 1; i < m_CandidateCategoryNames.size(); i++)
+		for (int i = 1; i < candidateNames.size(); i++)
 		{
-			if (m_CandidateCategoryNames[i] == "openbook")
+			if (candidateNames[i] == "openbook")
 			{
-				m_processedCatName = "openbook";
+				processedCatName = "openbook";
 				break;
 			}
 
-			if (m_CandidateCategoryNames[i] == "standbook")
+			if (candidateNames[i] == "standbook")
 			{
-				m_processedCatName = "standbook";
+				processedCatName = "standbook";
 				break;
 			}
 		}
 	}
 
 	// books
-	if (m_CandidateCategoryNames[0] == "books")
+	if (candidateNames[0] == "books")
 	{
-		for (int i = 1; i < m_CandidateCategoryNames.size(); i++)
+		for (int i = 1; i < candidateNames.size(); i++)
 		{
-			if (m_CandidateCategoryNames[i] == "standbooks")
+			if (candidateNames[i] == "standbooks")
 			{
-				m_processedCatName = "standbooks";
+				processedCatName = "standbooks";
 				break;
 			}
 
-			if (m_CandidateCategoryNames[i] == "stackbooks")
+			if (candidateNames[i] == "stackbooks")
 			{
-				m_processedCatName = "stackbooks";
+				processedCatName = "stackbooks";
 				break;
 			}
 		}
 	}
 
-	if (m_CandidateCategoryNames[0] == "computer")
+	if (candidateNames[0] == "computer")
 	{
-		for (int i = 1; i < m_CandidateCategoryNames.size(); i++)
+		for (int i = 1; i < candidateNames.size(); i++)
 		{
-			if (m_CandidateCategoryNames[i] == "laptop")
+			if (candidateNames[i] == "laptop")
 			{
-				m_processedCatName = "laptop";
+				processedCatName = "laptop";
 				break;
 			}
 		}
 	}
 
-	m_isCatNameProcessed = true;
-	return m_processedCatName;
+	return processedCatName;
 }
 
 const QString& DBMetaModel::getShapeNetCatsStr()
@@ -1,5 +1,7 @@
 #pragma once
 #include "../common/utilities/utility.h"
+#include "ModelMetaCatalog.h"
+#include <mutex>
 
 class CModel;
 class Category;
@@ -19,23 +21,27 @@ public:
 	DBMetaModel(DBMetaModel *m);
 
 	void setCatName(const QString &s) { m_categoryName = s; };
-	QString getCatName() { return m_categoryName; };
+	QString getCatName() const { return m_categoryName; };
 
 	void addCandidateCatName(const QString &s) { m_CandidateCategoryNames.push_back(s); };
 	void addWordNetLemmas(const QString &s) { m_wordNetLemmas.push_back(s); };
-	QString getProcessedCatName();
+	const std::vector<QString>& getCandidateCatNames() const { return m_CandidateCategoryNames; };
+	const std::vector<QString>& getWordNetLemmas() const { return m_wordNetLemmas; };
+
+	void processCatName();  // cache the processed cat name, call after candidate names and lemmas are added
+	QString getProcessedCatName() const;
 
 	void extractAttributeFromCandidateCatNames();
 
 	void setScale(double s) { m_scale = s; };
-	double getScale() { return m_scale; };
+	double getScale() const { return m_scale; };
 
 	void setIdStr(const QString &idStr) { m_idStr = idStr; };
-	QString getIdStr() { return m_idStr; };
+	QString getIdStr() const { return m_idStr; };
 	const QString& getShapeNetCatsStr();
 
 	void setTransMat(const MathLib::Matrix4d &m) { m_initTrans = m; };
-	MathLib::Matrix4d getTransMat() { return m_initTrans; };
+	MathLib::Matrix4d getTransMat() const { return m_initTrans; };
 
 	int dbID;
 	MathLib::Vector3 frontDir;
@@ -54,6 +60,8 @@ public:
 	std::vector<QString> m_attributes;
 
 private:
+	QString computeProcessedCatName() const;
+
 	QString m_idStr;
 	QString m_categoryName;
 
@@ -65,6 +73,22 @@ private:
 	MathLib::Matrix4d m_initTrans;
 };
 
+// fields of a DB model, read from the catalog record without creating its DBMetaModel
+struct DBModelFields
+{
+	int dbID;
+	QString idStr;
+	QString catName;
+	QString processedCatName;
+	MathLib::Vector3 frontDir;
+	MathLib::Vector3 upDir;
+	MathLib::Vector3 position;
+	double scale;
+};
+
+// entries are only written while the DB is loaded; afterwards the const lookups are safe for concurrent readers
+// a loaded DB is compiled into a mapped catalog, which then serves lookups in this and later sessions;
+// DBMetaModel and Category objects of catalog models are only created for callers that need them
 class ModelDatabase{
 public:
 
@@ -87,8 +111,9 @@ public:
 
 	// ShapeNet
 	void loadShapeNetSemTxt();
-	bool isModelInDB(const QString &s);
-	DBMetaModel* getMetaModelByNameString(const QString &s);
+	bool isModelInDB(const QString &s) const;
+	const DBMetaModel* getMetaModelByNameString(const QString &s) const;  // NULL if the model is not in the DB, created on first request
+	bool getModelFields(const QString &s, DBModelFields &fields) const;  // false if the model is not in the DB
 
 	// SunCG
 	void loadSunCGMetaData();
@@ -103,23 +128,39 @@ public:
 
 	QString getMetaFileType() { return m_dbMetaFileType; };
 
+	// catalog of the DB type, false if it is missing, older than the meta data files or invalid
+	bool loadMetaCatalog();
+	bool saveMetaCatalog();  // call after the meta data is loaded
+	QString getMetaCatalogFileName() const;
+	bool isMetaCatalogUpToDate() const;
+
+	// fill dbMetaModels and dbCategories with every catalog model, for callers walking the whole DB, e.g. the DB viewer
+	void loadAllMetaModels();
+
 	CModel* getModelById(QString idStr);
 	CModel* getModelByCat(const QString &catName);	
 	Category* getCategory(QString catName);
 
-	QString getModelCat(const QString &idStr);
+	QString getModelCat(const QString &idStr) const;
 
 	QString getModelIdStr(int id);
 	int getModelNum();
 
 	int getParentCatNum() { return m_parentCatNum; };
 
+	// raw line of the meta data file, empty if lineId is out of range
+	std::string getModelMetaInfoString(int lineId) const;
+
+	// while the catalog is open, only models added after it was compiled until loadAllMetaModels is called
 	std::map<QString, DBMetaModel*> dbMetaModels; // <modelIdStr, CandidateModel>
 	std::map<QString, Category*> dbCategories;  // <categoryName, categoryStruct>
 
-	std::vector<std::string> modelMetaInfoStrings;
-
 private:
+	void processModelCatNames();
+	void clearMetaModels();
+	DBMetaModel* getCatalogModel(int recordId) const;
+	QStringList getMetaCatalogSourceFileNames() const;
+
 	QString m_dbPath;
 	QString m_dbMetaFileType;
 	QString m_projectPath;
@@ -131,4 +172,12 @@ private:
 
 	std::map<QString, QString> m_modelCatMapSunCG;
 	std::map<QString, QString> m_specifiedModelCatMap;  // other manual annotation for specified models
+
+	std::vector<std::string> m_modelMetaInfoStrings;  // dropped once the catalog is open
+
+	ModelMetaCatalog m_metaCatalog;
+	bool m_isCatalogLoaded;  // every catalog model is in dbMetaModels
+
+	mutable std::vector<DBMetaModel*> m_catalogModels;  // by catalog record id, NULL until requested
+	mutable std::mutex m_catalogModelMutex;
 };
\ No newline at end of file
@@ -14,6 +14,9 @@ ModelDBViewer_widget::ModelDBViewer_widget(ModelDatabase *modleDB, QWidget *pare
 	m_viewer->show();
 
 
+	// the viewer walks the whole DB, create every entry of the catalog
+	m_modelDB->loadAllMetaModels();
+
 	// init category list
 	for (auto it = m_modelDB->dbCategories.begin(); it != m_modelDB->dbCategories.end(); it++)
 	{
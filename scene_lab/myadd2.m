@@ -1,6 +0,0 @@
-function [y, z] = myadd2(a, b)
-% dummy function, just to demonstrate the idea
-y = a+b;
-z = a+2*b;
-disp('Output from MATLAB.');
-end
\ No newline at end of file
@@ -4,16 +4,20 @@
 #include "modelDBViewer_widget.h"
 #include "RelationModelManager.h"
 #include "RelationExtractor.h"
+#include "SceneBatchProcessor.h"
+#include "SceneBuildTracker.h"
+#include "SceneRelationRecord.h"
 #include "../common/geometry/Scene.h"
+#include "../common/geometry/UDGraph.h"
+#include "../common/geometry/SceneRasterizer.h"
 #include "../t2scene/SceneSemGraph.h"
 #include <set>
-#include "engine.h"
+#include <mutex>
+#include <random>
 #include <stdio.h>
 
 #include <QResource>
 
-Engine *matlabEngine;
-
 scene_lab::scene_lab(QObject *parent)
 	: QObject(parent)
 {
@@ -29,6 +33,16 @@ scene_lab::scene_lab(QObject *parent)
 
 	m_sunCGModelDB = NULL;
 
+	m_batchThreadNum = 0;
+	m_isBatchThreadNumFixed = false;
+	m_streamSceneList = true;
+	m_incrementalBuild = true;
+
+	m_thumbnailWidth = 640;
+	m_thumbnailHeight = 480;
+	m_thumbnailViews << "iso";
+
+	m_paraFileName = ":/paras.txt";
 	loadParas();
 }
 
@@ -51,12 +65,11 @@ void scene_lab::create_widget()
 
 void scene_lab::loadParas()
 {
-	QString fileName(":/paras.txt");
-	QFile paraFile(fileName);
+	QFile paraFile(m_paraFileName);
 
 	if (!paraFile.open(QIODevice::ReadOnly | QIODevice::Text))
 	{
-		std::cout << "Cannot open paras.txt\n";
+		std::cout << "Cannot open " << m_paraFileName.toStdString() << "\n";
 	}
 
 	QString currLine;
@@ -96,12 +109,62 @@ void scene_lab::loadParas()
 				m_sceneANNPath = currLine.replace("GroupAnnotationPath=", "");
 				m_sceneANNPath = currLine.replace("\n", "");
 			}
+
+			if ((pos = currLine.lastIndexOf("BatchThreadNum=")) != -1 && !m_isBatchThreadNumFixed)
+			{
+				m_batchThreadNum = currLine.replace("BatchThreadNum=", "").toInt();
+			}
+
+			if ((pos = currLine.lastIndexOf("StreamSceneList=")) != -1)
+			{
+				m_streamSceneList = currLine.replace("StreamSceneList=", "").toInt() != 0;
+			}
+
+			if ((pos = currLine.lastIndexOf("IncrementalBuild=")) != -1)
+			{
+				m_incrementalBuild = currLine.replace("IncrementalBuild=", "").toInt() != 0;
+			}
+
+			if ((pos = currLine.lastIndexOf("ThumbnailSize=")) != -1)
+			{
+				QStringList sizeStrs = currLine.replace("ThumbnailSize=", "").replace("\n", "").split("x");
+				if (sizeStrs.size() == 2 && sizeStrs[0].toInt() > 0 && sizeStrs[1].toInt() > 0)
+				{
+					m_thumbnailWidth = sizeStrs[0].toInt();
+					m_thumbnailHeight = sizeStrs[1].toInt();
+				}
+			}
+
+			if ((pos = currLine.lastIndexOf("ThumbnailViews=")) != -1)
+			{
+				m_thumbnailViews = currLine.replace("ThumbnailViews=", "").replace("\n", "").split(",", QString::SkipEmptyParts);
+			}
 		}
 	}
 }
 
 void scene_lab::loadSceneWithName(const QString &sceneFullName, int metaDataOnly, int obbOnly, int reComputeOBB, int updateModelCat)
 {
+	initModelDBsForScenes(QStringList(sceneFullName));
+
+	CScene *scene = loadSceneFromFile(sceneFullName, metaDataOnly, obbOnly, reComputeOBB, updateModelCat);
+
+	if (scene != NULL)
+	{
+		m_currScene = scene;
+	}
+
+	if (m_relationExtractor == NULL)
+	{
+		m_relationExtractor = new RelationExtractor(m_angleTh);
+	}
+
+	emit sceneLoaded();
+}
+
+CScene* scene_lab::loadSceneFromFile(const QString &sceneFullName, int metaDataOnly, int obbOnly, int reComputeOBB, int updateModelCat)
+{
+	// model DBs must be initialized, see initModelDBsForScenes; safe to call from batch worker threads
 	CScene *scene = new CScene(m_meshDatabase);
 
 	QFile sceneFile(sceneFullName);
@@ -113,52 +176,258 @@ void scene_lab::loadSceneWithName(const QString &sceneFullName, int metaDataOnly
 	{
 		// only load scene mesh
 		scene->loadStanfordScene(sceneFullName, metaDataOnly, obbOnly, reComputeOBB);
-		m_currScene = scene;
+		updateModelMetaInfoForScene(scene);
+	}
+	else if (sceneFormat == "th")
+	{
+		scene->loadTsinghuaScene(sceneFullName, obbOnly, reComputeOBB);
+
+		if (updateModelCat)
+			updateModelCatForTsinghuaScene(scene);
+	}
+	else if (sceneFormat == "json")
+	{
+		scene->loadJsonScene(sceneFullName, metaDataOnly, obbOnly, reComputeOBB);
+		updateModelMetaInfoForScene(scene);
+	}
+	else
+	{
+		std::cout << "SceneLab: unknown scene format " << sceneFormat.toStdString() << "\n";
+		delete scene;
+		return NULL;
+	}
+
+	return scene;
+}
+
+void scene_lab::initModelDBsForScenes(const QStringList &sceneFullNames)
+{
+	foreach(QString sceneFullName, sceneFullNames)
+	{
+		QString sceneFormat = QFileInfo(sceneFullName).suffix();
 
-		if (m_shapeNetModelDB == NULL)
+		if (sceneFormat == "txt" || sceneFormat == "ssg")
+		{
+			if (m_shapeNetModelDB == NULL)
+			{
+				initShapeNetDB();
+			}
+
+			if (m_sunCGModelDB == NULL)
+			{
+				initSunCGDB();
+			}
+		}
+		else if (sceneFormat == "th")
+		{
+			if (m_modelCatMapTsinghua.empty())
+			{
+				initTsinghuaDB();
+			}
+		}
+		else if (sceneFormat == "json")
 		{
-			initShapeNetDB();
+			if (m_sunCGModelDB == NULL)
+			{
+				initSunCGDB();
+			}
 		}
+	}
+}
+
+QStringList scene_lab::getSceneListFileNames()
+{
+	QStringList allSceneFullNames;
+
+	for (auto it = m_loadedSceneFileNames.begin(); it != m_loadedSceneFileNames.end(); it++)
+	{
+		allSceneFullNames << it->second;
+	}
+
+	return allSceneFullNames;
+}
+
+int scene_lab::runStageForSceneList(const QString &stageName, int metaDataOnly, int obbOnly, int reComputeOBB, int updateModelCat,
+	const std::function<bool(CScene*, std::ostream&)> &stage, const StageDependency &dependency, const QString &paraKey)
+{
+	loadSceneListNamesFromDBListFile();
+	QStringList sceneFullNames = getSceneListFileNames();
 
-		if (m_sunCGModelDB == NULL)
+	bool isTracked = m_incrementalBuild && dependency;
+	SceneBuildTracker buildTracker;
+
+	if (isTracked)
+	{
+		buildTracker.load(getBuildManifestFileName());
+
+		QStringList staleSceneNames;
+		foreach(QString sceneFullName, sceneFullNames)
 		{
-			initSunCGDB();
+			if (!buildTracker.isUpToDate(stageName, sceneFullName, paraKey))
+			{
+				staleSceneNames << sceneFullName;
+			}
 		}
-		
-		updateModelMetaInfoForScene(m_currScene);
+
+		std::cout << "SceneLab: " << stageName.toStdString() << " up to date for " << sceneFullNames.size() - staleSceneNames.size()
+			<< "/" << sceneFullNames.size() << " scenes\n";
+
+		sceneFullNames = staleSceneNames;
 	}
-	else if (sceneFormat == "th")
+
+	// shared DBs are filled before workers start, workers only read them
+	initModelDBsForScenes(sceneFullNames);
+
+	// per-model .obb and .bbtop files asked for by this stage are written once, by the first scene using the model
+	m_meshDatabase.clearWrittenFiles();
+
+	SceneBatchProcessor batchProcessor(m_batchThreadNum);
+
+	batchProcessor.setProgressCallback([&stageName](int doneNum, int totalNum, const QString &sceneFullName) {
+		std::cout << "SceneLab: " << stageName.toStdString() << " " << doneNum << "/" << totalNum << " "
+			<< QFileInfo(sceneFullName).baseName().toStdString() << "\n";
+	});
+
+	// stages only get the scene, tracked ones record it by full name
+	std::map<CScene*, QString> loadedSceneNames;
+	std::mutex loadedSceneMutex;
+
+	uint64 startTime = GetTimeMs64();
+
+	int successNum = batchProcessor.run(sceneFullNames, [&](const QString &sceneFullName) {
+		CScene *scene = loadSceneFromFile(sceneFullName, metaDataOnly, obbOnly, reComputeOBB, updateModelCat);
+
+		if (isTracked && scene != NULL)
+		{
+			std::lock_guard<std::mutex> lock(loadedSceneMutex);
+			loadedSceneNames[scene] = sceneFullName;
+		}
+
+		return scene;
+	}, [&](CScene *scene, std::ostream &log) {
+		if (!stage(scene, log))
+		{
+			return false;
+		}
+
+		if (isTracked)
+		{
+			QString sceneFullName;
+			{
+				std::lock_guard<std::mutex> lock(loadedSceneMutex);
+				sceneFullName = loadedSceneNames[scene];
+				loadedSceneNames.erase(scene);
+			}
+
+			QStringList inputFiles(sceneFullName), outputFiles;
+			dependency(scene, inputFiles, outputFiles);
+			buildTracker.record(stageName, sceneFullName, paraKey, inputFiles, outputFiles);
+		}
+
+		return true;
+	});
+
+	if (isTracked)
 	{
-		scene->loadTsinghuaScene(sceneFullName, obbOnly, reComputeOBB);
-		m_currScene = scene;
+		buildTracker.save();
+	}
+
+	std::cout << "SceneLab: " << stageName.toStdString() << " done for " << successNum << "/" << sceneFullNames.size() << " scenes with "
+		<< batchProcessor.getThreadNum() << " threads in " << (GetTimeMs64() - startTime) / 1000.0 << " s\n";
+
+	return successNum;
+}
+
+QString scene_lab::getBuildManifestFileName()
+{
+	return m_localSceneDBPath + QString("/Build_%1.manifest").arg(m_sceneDBType);
+}
+
+// artifact written next to the scene file, e.g. .sg, .ssg, .alignMat or .relPos
+static QString getSceneArtifactFile(CScene *scene, const QString &suffix)
+{
+	return scene->getFilePath() + "/" + scene->getSceneName() + suffix;
+}
+
+// OBB and support plane files of the scene models, shared with other scenes
+static QStringList getModelArtifactFiles(CScene *scene)
+{
+	QStringList fileNames;
+
+	for (int i = 0; i < scene->getModelNum(); i++)
+	{
+		CModel *m = scene->getModel(i);
+		fileNames << m->getModelFilePath() + "/" + m->getModelFileName() + ".obb";
+		fileNames << m->getModelFilePath() + "/" + m->getNameStr() + ".supp";
+	}
+
+	fileNames.removeDuplicates();
+
+	return fileNames;
+}
 
-		if (m_modelCatMapTsinghua.empty())
+std::vector<CScene*> scene_lab::collectFromSceneList(int metaDataOnly, const std::function<void(CScene*)> &collector)
+{
+	if (!m_streamSceneList)
+	{
+		LoadWholeSceneList(metaDataOnly);
+
+		for (int i = 0; i < m_sceneList.size(); i++)
 		{
-			initTsinghuaDB();
+			m_currScene = m_sceneList[i];
+			collector(m_currScene);
 		}
 
-		if (updateModelCat)
-			updateModelCatForTsinghuaScene(m_currScene);
+		return m_sceneList;
 	}
-	else if (sceneFormat == "json")
+
+	loadSceneListNamesFromDBListFile();
+	QStringList sceneFullNames = getSceneListFileNames();
+	initModelDBsForScenes(sceneFullNames);
+
+	uint64 startTime = GetTimeMs64();
+	int sceneNum = 0;
+
+	foreach(QString sceneFullName, sceneFullNames)
 	{
-		scene->loadJsonScene(sceneFullName, metaDataOnly, obbOnly, reComputeOBB);
-		m_currScene = scene;
+		CScene *scene = loadSceneFromFile(sceneFullName, metaDataOnly);
+		if (scene == NULL)
+		{
+			continue;
+		}
+
+		collector(scene);
+		sceneNum++;
 
-		if (m_sunCGModelDB == NULL)
+		// nothing may keep the scene once it is freed
+		if (m_relationModelManager != NULL)
 		{
-			initSunCGDB();
+			m_relationModelManager->updateCurrScene(NULL);
 		}
 
-		updateModelMetaInfoForScene(m_currScene);
+		delete scene;
 	}
 
+	std::cout << "SceneLab: collected from " << sceneNum << "/" << sceneFullNames.size() << " streamed scenes in "
+		<< (GetTimeMs64() - startTime) / 1000.0 << " s\n";
+
+	return std::vector<CScene*>();
+}
+
+void scene_lab::resetRelationModelManager()
+{
 	if (m_relationExtractor == NULL)
 	{
 		m_relationExtractor = new RelationExtractor(m_angleTh);
 	}
 
-	emit sceneLoaded();
+	if (m_relationModelManager != NULL)
+	{
+		delete m_relationModelManager;
+	}
+
+	m_relationModelManager = new RelationModelManager(m_relationExtractor);
+	m_relationModelManager->setFitThreadNum(m_batchThreadNum);
 }
 
 void scene_lab::LoadScene()
@@ -344,8 +613,13 @@ void scene_lab::initShapeNetDB()
 {
 	m_shapeNetModelDB = new ModelDatabase(m_projectPath, ModelDBType::ShapeNetDB);
 
-	m_shapeNetModelDB->loadSpecifiedCatMap();
-	m_shapeNetModelDB->loadShapeNetSemTxt();
+	// meta data is only parsed when the compiled catalog is missing or stale
+	if (!m_shapeNetModelDB->loadMetaCatalog())
+	{
+		m_shapeNetModelDB->loadSpecifiedCatMap();
+		m_shapeNetModelDB->loadShapeNetSemTxt();
+		m_shapeNetModelDB->saveMetaCatalog();
+	}
 }
 
 void scene_lab::initTsinghuaDB()
@@ -357,11 +631,15 @@ void scene_lab::initSunCGDB()
 {
 	m_sunCGModelDB = new ModelDatabase(m_projectPath, ModelDBType::SunCGDB);
 
-	m_sunCGModelDB->loadSunCGMetaData();
+	if (!m_sunCGModelDB->loadMetaCatalog())
+	{
+		m_sunCGModelDB->loadSunCGMetaData();
 
-	m_sunCGModelDB->loadSpecifiedCatMap();
-	m_sunCGModelDB->loadSunCGModelCatMap();
-	m_sunCGModelDB->loadSunCGModelCat();
+		m_sunCGModelDB->loadSpecifiedCatMap();
+		m_sunCGModelDB->loadSunCGModelCatMap();
+		m_sunCGModelDB->loadSunCGModelCat();
+		m_sunCGModelDB->saveMetaCatalog();
+	}
 }
 
 void scene_lab::loadModelCatsMapTsinghua()
@@ -453,14 +731,12 @@ void scene_lab::ExtractModelCatsFromSceneList()
 		std::set<QString> allModelCats;
 		for (auto it = allModelNameStrings.begin(); it != allModelNameStrings.end(); it++)
 		{
-			if (m_shapeNetModelDB != NULL && m_shapeNetModelDB->dbMetaModels.count(*it))
+			DBModelFields fields;
+			if (m_shapeNetModelDB != NULL && m_shapeNetModelDB->getModelFields(*it, fields))
 			{
-				auto metaIt = m_shapeNetModelDB->dbMetaModels.find(*it);
-				DBMetaModel *m = metaIt->second;
-				QString modelCat = m->getProcessedCatName();
-				allModelCats.insert(modelCat);
+				allModelCats.insert(fields.processedCatName);
 
-				ofs << m->getIdStr() << "," << modelCat << "\n";
+				ofs << fields.idStr << "," << fields.processedCatName << "\n";
 			}
 		}
 
@@ -532,16 +808,14 @@ void scene_lab::updateModelMetaInfoForScene(CScene *s)
 		{
 			QString modelNameString = s->getModelNameString(i);
 
-			if (m_shapeNetModelDB->dbMetaModels.count(modelNameString))
+			// called from batch workers, only the const lookups of the DB are used
+			DBModelFields fields;
+			if (m_shapeNetModelDB->getModelFields(modelNameString, fields))
 			{
-				MathLib::Vector3 frontDir = m_shapeNetModelDB->dbMetaModels[modelNameString]->frontDir;
-				s->updateModelFrontDir(i, frontDir);
-
-				MathLib::Vector3 upDir = m_shapeNetModelDB->dbMetaModels[modelNameString]->upDir;
-				s->updateModelUpDir(i, upDir); // actually, no need to update up dir as it is already be rotated to (0,0,1) ?
+				s->updateModelFrontDir(i, fields.frontDir);
+				s->updateModelUpDir(i, fields.upDir); // actually, no need to update up dir as it is already be rotated to (0,0,1) ?
 
-				QString catName = m_shapeNetModelDB->dbMetaModels[modelNameString]->getProcessedCatName();
-				s->updateModelCat(i, catName);
+				s->updateModelCat(i, fields.processedCatName);
 			}
 
 			if (modelNameString.contains("room"))
@@ -557,15 +831,14 @@ void scene_lab::updateModelMetaInfoForScene(CScene *s)
 		{
 			QString modelNameString = s->getModelNameString(i);
 
-			if (m_sunCGModelDB->dbMetaModels.count(modelNameString))
+			DBModelFields fields;
+			if (m_sunCGModelDB->getModelFields(modelNameString, fields))
 			{
 				// update front dir based on annotation
 				// no need to update up dir as it is already be rotated to (0,0,1)
-				MathLib::Vector3 frontDir = m_sunCGModelDB->dbMetaModels[modelNameString]->frontDir;
-				s->updateModelFrontDir(i, frontDir);  
+				s->updateModelFrontDir(i, fields.frontDir);
 
-				QString catName = m_sunCGModelDB->dbMetaModels[modelNameString]->getCatName();
-				s->updateModelCat(i, catName);
+				s->updateModelCat(i, fields.catName);
 			}
 		}
 	}
@@ -573,41 +846,203 @@ void scene_lab::updateModelMetaInfoForScene(CScene *s)
 
 void scene_lab::BuildOBBForSceneList()
 {
+	runStageForSceneList("build OBB", 0, 0, 1, 0, [](CScene *scene, std::ostream &log) {
+		for (int i = 0; i < scene->getModelNum(); i++)
+		{
+			CModel *m = scene->getModel(i);
+
+			// re-compute model OBB if it is skewed when placing into current scene
+			if (m->m_OBBSkewed)
+			{
+				if (scene->getUprightVec() == MathLib::Vector3(0, 0, 1))
+				{
+					m->computeOBB(2);
+				}
+				else
+				{
+					m->computeOBB(1);
+				}
+			}
+		}
+
+		return true;
+	});
+}
+
+void scene_lab::BuildMeshCacheForModelDB()
+{
+	// pre-bake binary mesh caches so later scene loads skip obj parsing
+	QStringList modelDBFolders;
+	// tsinghua models are stored per scene with scene metric, they are cached lazily on first load
+	modelDBFolders << m_localSceneDBPath + "/StanfordSceneDB/models"
+		<< m_localSceneDBPath + "/suncg_data/object";
+
+	uint64 startTime = GetTimeMs64();
+
+	foreach(QString folder, modelDBFolders)
+	{
+		if (QDir(folder).exists())
+		{
+			CMesh::buildBinaryMeshCacheForFolder(folder, 1.0);
+		}
+	}
+
+	std::cout << "SceneLab: mesh cache built in " << (GetTimeMs64() - startTime) / 1000.0 << " s\n";
+}
+
+void scene_lab::BenchmarkSupportTestForSceneList()
+{
+	// compare all-pairs and bvh face contact test on the first scenes of each db in the list
+	const int maxSceneNumPerDB = 20;
+	const double dAngleT = 5.0;
+
 	loadSceneListNamesFromDBListFile();
 
 	for (auto it = m_loadedSceneFileNames.begin(); it != m_loadedSceneFileNames.end(); it++)
 	{
 		QStringList& sceneFullNames = it->second;
+
+		int sceneNum = 0, testedPairNum = 0, suppPairNum = 0, mismatchNum = 0;
+		uint64 bruteTime = 0, bvhTime = 0;
+
 		foreach(QString sceneName, sceneFullNames)
 		{
+			if (sceneNum >= maxSceneNumPerDB)
+			{
+				break;
+			}
+
 			if (m_currScene != NULL)
 			{
 				delete m_currScene;
 			}
 
-			loadSceneWithName(sceneName, 0, 0, 1, 0);
+			loadSceneWithName(sceneName, 0, 0, 0, 0);
+			sceneNum++;
+
+			double dT = 0.05 / m_currScene->getSceneMetric();
+			MathLib::Vector3 upright = m_currScene->getUprightVec();
 
 			for (int i = 0; i < m_currScene->getModelNum(); i++)
 			{
-				CModel *m = m_currScene->getModel(i);
-
-				// re-compute model OBB if it is skewed when placing into current scene
-				if (m->m_OBBSkewed)
+				CModel *pMI = m_currScene->getModel(i);
+				for (int j = i + 1; j < m_currScene->getModelNum(); j++)
 				{
-					if (m_currScene->getUprightVec() == MathLib::Vector3(0,0,1))
+					CModel *pMJ = m_currScene->getModel(j);
+					if (!pMI->getAABB().IsIntersect(pMJ->getAABB(), dT*2.0))
+					{
+						continue;
+					}
+
+					uint64 startTime = GetTimeMs64();
+					bool bruteSupp = pMI->IsMeshSupport(pMJ, dAngleT, dT, upright, false);
+					uint64 midTime = GetTimeMs64();
+					bool bvhSupp = pMI->IsMeshSupport(pMJ, dAngleT, dT, upright, true);
+					uint64 endTime = GetTimeMs64();
+
+					bruteTime += midTime - startTime;
+					bvhTime += endTime - midTime;
+					testedPairNum++;
+
+					if (bruteSupp)
 					{
-						m->computeOBB(2);
+						suppPairNum++;
 					}
-					else
+
+					if (bruteSupp != bvhSupp)
 					{
-						m->computeOBB(1);
+						mismatchNum++;
+						std::cout << "\tSupport test mismatch in " << sceneName.toStdString() << " for models " << i << " and " << j << "\n";
 					}
 				}
 			}
 		}
+
+		std::cout << "SceneLab: support test benchmark for " << it->first.toStdString() << ", " << sceneNum << " scenes, " << testedPairNum << " pairs, "
+			<< suppPairNum << " in contact, " << mismatchNum << " mismatches\n";
+		std::cout << "\tall pairs " << bruteTime / 1000.0 << " s, bvh " << bvhTime / 1000.0 << " s\n";
 	}
 }
 
+void scene_lab::BenchmarkGraphEdgeLookup()
+{
+	// edge index of CUDGraph against a linear scan over the edge list, on a random 1000-node graph
+	const int nodeNum = 1000;
+	const int edgeNum = 20000;
+
+	std::mt19937 rng(0);
+	std::uniform_int_distribution<int> nodeDist(0, nodeNum - 1);
+
+	CUDGraph graph(nodeNum);
+
+	uint64 startTime = GetTimeMs64();
+	for (int i = 0; i < edgeNum; i++)
+	{
+		graph.InsertEdge(nodeDist(rng), nodeDist(rng), i % 3);
+	}
+	uint64 insertTime = GetTimeMs64() - startTime;
+
+	auto scanEdgeId = [&graph](int ev1, int ev2) {
+		for (int i = 0; i < graph.ESize(); i++)
+		{
+			CUDGraph::Edge *e = graph.GetEdge(i);
+			if ((e->v1 == ev1 && e->v2 == ev2) || (e->v1 == ev2 && e->v2 == ev1))
+			{
+				return i;
+			}
+		}
+		return -1;
+	};
+
+	// index on all node pairs, the scan is only timed and checked on the first rows
+	const int scanNodeNum = 50;
+	int hitNum = 0, mismatchNum = 0;
+
+	std::vector<int> indexIds(nodeNum * nodeNum);
+
+	startTime = GetTimeMs64();
+	for (int i = 0; i < nodeNum; i++)
+	{
+		for (int j = 0; j < nodeNum; j++)
+		{
+			indexIds[i * nodeNum + j] = graph.GetEdgeId(i, j);
+		}
+	}
+	uint64 indexTime = GetTimeMs64() - startTime;
+
+	startTime = GetTimeMs64();
+	for (int i = 0; i < scanNodeNum; i++)
+	{
+		for (int j = 0; j < nodeNum; j++)
+		{
+			if (scanEdgeId(i, j) != indexIds[i * nodeNum + j]) mismatchNum++;
+		}
+	}
+	uint64 scanTime = GetTimeMs64() - startTime;
+
+	for (int i = 0; i < indexIds.size(); i++)
+	{
+		if (indexIds[i] != -1) hitNum++;
+	}
+
+	// neighbor edges of every node
+	startTime = GetTimeMs64();
+	int neighborNum = 0;
+	std::vector<int> neighborEdges;
+	for (int i = 0; i < nodeNum; i++)
+	{
+		graph.GetAllNeigborEdgeList(i, neighborEdges);
+		neighborNum += neighborEdges.size();
+	}
+	uint64 neighborTime = GetTimeMs64() - startTime;
+
+	std::cout << "SceneLab: graph edge lookup benchmark, " << nodeNum << " nodes, " << graph.ESize() << " edges, "
+		<< hitNum << " edge hits, " << mismatchNum << " mismatches\n";
+	std::cout << "\tinsert " << insertTime / 1000.0 << " s, " << nodeNum * nodeNum << " lookups by index " << indexTime / 1000.0
+		<< " s, " << scanNodeNum * nodeNum << " lookups by scan " << scanTime / 1000.0 << " s, neighbor lists " << neighborTime / 1000.0
+		<< " s for " << neighborNum << " edges\n";
+}
+
 void scene_lab::destroy_widget()
 {
 	if (m_widget != NULL)
@@ -661,53 +1096,6 @@ void scene_lab::destory_modelDBViewer_widget()
 
 }
 
-#define BUFSIZE 1000
-void scene_lab::testMatlab()
-{
-	// 1. Open MATLAB engine
-	matlabEngine = engOpen(NULL);
-	if (matlabEngine == NULL) {
-		printf("Can't start MATLAB engine!!!\n");
-		exit(-1);
-	}
-
-	// 2. Call MATLAB engine
-	{
-		// 2.1. Pre-work: capture MATLAB output. Ensure the buffer is always NULL terminated.
-		char buffer[BUFSIZE + 1];
-		buffer[BUFSIZE] = '\0';
-		engOutputBuffer(matlabEngine, buffer, BUFSIZE);
-		engEvalString(matlabEngine, "clc;clear;"); // clear all variables (optional)
-
-											 // 2.2. Setup inputs: a, b
-		mxArray *a = mxCreateDoubleScalar(2); // assume a=2
-		mxArray *b = mxCreateDoubleScalar(3); // assume b=3
-		engPutVariable(matlabEngine, "a", a); // put into matlab
-		engPutVariable(matlabEngine, "b", b); // put into matlab
-
-										// 2.3. Call MATLAB
-		engEvalString(matlabEngine, "cd \'C:\\Ruim\\Graphics\\T2S_MPC\\text2scene-learning\\scene_lab'");
-		engEvalString(matlabEngine, "[y, z] = myadd2(a, b);");
-		printf("%s\n", buffer); // get error messages or prints (optional)
-
-							 // 2.4. Get result: y, z
-		mxArray *y = engGetVariable(matlabEngine, "y");
-		mxArray *z = engGetVariable(matlabEngine, "z");
-		double y_res = mxGetScalar(y);
-		double z_res = mxGetScalar(z);
-		printf("y=%f\nz=%f\n", y_res, z_res);
-
-		// 2.5. Release (to all mxArray)
-		mxDestroyArray(a);
-		mxDestroyArray(b);
-		mxDestroyArray(y);
-		mxDestroyArray(z);
-	}
-
-	// 3. Close MATLAB engine
-	engClose(matlabEngine);
-}
-
 void scene_lab::ScreenShotForCurrScene()
 {
 	if (m_currScene != NULL)
@@ -726,17 +1114,80 @@ void scene_lab::ScreenShotForCurrScene()
 }
 
 void scene_lab::ScreenShotForSceneList()
+{
+	// scenes are streamed through the batch workers instead of being loaded and shown one by one
+	RenderThumbnailsForSceneList();
+}
+
+void scene_lab::RenderThumbnailsForSceneList()
 {
 	loadParas();
-	LoadWholeSceneList(0,0,0);
 
-	for (int i = 0; i < m_sceneList.size(); i++)
+	std::vector<CSceneRasterizer::CameraPreset> cameras;
+	foreach(QString viewName, m_thumbnailViews)
+	{
+		CSceneRasterizer::CameraPreset preset;
+		if (!CSceneRasterizer::getCameraPreset(viewName.trimmed(), preset))
+		{
+			std::cout << "SceneLab: unknown thumbnail view " << viewName.toStdString() << ", use one of "
+				<< CSceneRasterizer::getCameraPresetNames().join(",").toStdString() << "\n";
+			return;
+		}
+
+		cameras.push_back(preset);
+	}
+
+	if (cameras.empty())
 	{
-		m_currScene = m_sceneList[i];
+		std::cout << "SceneLab: no thumbnail view given\n";
+		return;
+	}
 
-		emit sceneLoaded();
-		ScreenShotForCurrScene();
+	// the first view keeps the name of the interactive screenshot
+	auto getThumbnailFiles = [cameras](CScene *scene) {
+		QStringList fileNames;
+		for (int i = 0; i < cameras.size(); i++)
+		{
+			fileNames << getSceneArtifactFile(scene, i == 0 ? QString(".png") : "_" + cameras[i].name + ".png");
+		}
+
+		return fileNames;
+	};
+
+	int width = m_thumbnailWidth;
+	int height = m_thumbnailHeight;
+	QStringList viewNames;
+	for (int i = 0; i < cameras.size(); i++)
+	{
+		viewNames << cameras[i].name;
 	}
+
+	QString paraKey = QString("ThumbnailSize=%1x%2;ThumbnailViews=%3").arg(width).arg(height).arg(viewNames.join(","));
+
+	runStageForSceneList("render thumbnails", 0, 0, 0, 0, [&](CScene *scene, std::ostream &log) {
+		CSceneRasterizer rasterizer(width, height);
+		QStringList fileNames = getThumbnailFiles(scene);
+
+		for (int i = 0; i < cameras.size(); i++)
+		{
+			QImage image;
+			if (!rasterizer.render(scene, cameras[i], image))
+			{
+				log << "\tno faces to render in " << scene->getSceneName().toStdString() << "\n";
+				return false;
+			}
+
+			if (!image.save(fileNames[i], "PNG"))
+			{
+				log << "\tcannot save " << fileNames[i].toStdString() << "\n";
+				return false;
+			}
+		}
+
+		return true;
+	}, [&](CScene *scene, QStringList &inputFiles, QStringList &outputFiles) {
+		outputFiles << getThumbnailFiles(scene);
+	}, paraKey);
 }
 
 void scene_lab::BuildSemGraphForCurrentScene()
@@ -762,14 +1213,20 @@ void scene_lab::BuildSemGraphForSceneList()
 {
 	loadParas();
 
-	// only load meta data (stanford and scenenn) and obb (tsinghua)
-	LoadWholeSceneList(1,1,0);
+	QString sceneANNPath = m_sceneANNPath;
+	RelationExtractor relationExtractor(m_angleTh);
 
-	for (int i = 0; i < m_sceneList.size(); i++)
-	{
-		m_currScene = m_sceneList[i];
-		BuildSemGraphForCurrentScene();
-	}
+	// DB and extractor are shared read-only, every task generates its own graph
+	// only load meta data (stanford and scenenn) and obb (tsinghua)
+	runStageForSceneList("build semantic graph", 1, 1, 0, 1, [&](CScene *scene, std::ostream &log) {
+		SceneSemGraph sceneSemGraph(scene, m_shapeNetModelDB, &relationExtractor, sceneANNPath);
+		sceneSemGraph.generateGraph();
+		sceneSemGraph.saveGraph();
+		return true;
+	}, [&](CScene *scene, QStringList &inputFiles, QStringList &outputFiles) {
+		inputFiles << getModelArtifactFiles(scene) << getSceneArtifactFile(scene, ".sg") << sceneANNPath + "/" + scene->getSceneName() + ".snn";
+		outputFiles << getSceneArtifactFile(scene, ".ssg");
+	}, QString("AngleThreshold=%1").arg(m_angleTh));
 
 	std::cout << "\nSceneLab: all scene semantic graph generated.\n";
 }
@@ -788,22 +1245,14 @@ void scene_lab::BuildRelationGraphForCurrentScene()
 void scene_lab::BuildRelationGraphForSceneList()
 {
 	loadParas();
-	loadSceneListNamesFromDBListFile();
 
-	for (auto it = m_loadedSceneFileNames.begin(); it != m_loadedSceneFileNames.end(); it++)
-	{
-		QStringList& sceneFullNames = it->second;
-		foreach(QString sceneName, sceneFullNames)
-		{
-			if (m_currScene != NULL)
-			{
-				delete m_currScene;
-			}
-
-			loadSceneWithName(sceneName, 0, 0, 0, 0);
-			BuildRelationGraphForCurrentScene();
-		}
-	}
+	runStageForSceneList("build relation graph", 0, 0, 0, 0, [](CScene *scene, std::ostream &log) {
+		scene->buildRelationGraph();
+		return true;
+	}, [](CScene *scene, QStringList &inputFiles, QStringList &outputFiles) {
+		inputFiles << getModelArtifactFiles(scene);
+		outputFiles << getSceneArtifactFile(scene, ".sg");
+	});
 
 	//if (m_sceneDBType == "stanford")
 	//{
@@ -863,7 +1312,7 @@ void scene_lab::ExtractMetaFileForSceneList()
 				delete m_currScene;
 			}
 
-			CScene *scene = new CScene();
+			CScene *scene = new CScene(m_meshDatabase);
 			QString filename = sceneDBPath + "/" + sceneName + ".txt";
 			scene->loadStanfordScene(filename, 1, 0, 0);
 			m_currScene = scene;
@@ -894,11 +1343,10 @@ void scene_lab::ExtractMetaFileForSceneList()
 
 	for (auto it = allModelNameStrings.begin(); it != allModelNameStrings.end(); it++)
 	{
-		if (m_shapeNetModelDB->dbMetaModels.count(*it))
+		DBModelFields fields;
+		if (m_shapeNetModelDB->getModelFields(*it, fields))
 		{
-			auto metaIt = m_shapeNetModelDB->dbMetaModels.find(*it);
-			DBMetaModel *m = metaIt->second;
-			ofs << QString(m_shapeNetModelDB->modelMetaInfoStrings[m->dbID].c_str()) << "\n";				
+			ofs << QString(m_shapeNetModelDB->getModelMetaInfoString(fields.dbID).c_str()) << "\n";
 		}
 	}
 
@@ -909,25 +1357,14 @@ void scene_lab::ExtractMetaFileForSceneList()
 
 void scene_lab::BuildRelativeRelationModels()
 {
-	//testMatlab();
-
 	loadParas();
-	// load metadata
-	LoadWholeSceneList(1);
+	resetRelationModelManager();
 
-	if (m_relationModelManager!=NULL)
-	{
-		delete m_relationModelManager;
-	}
-
-	m_relationModelManager = new RelationModelManager(m_relationExtractor);
-
-	for (int i = 0; i < m_sceneList.size(); i++)
-	{
-		m_currScene = m_sceneList[i];
-		m_relationModelManager->updateCurrScene(m_currScene);
+	// load metadata
+	collectFromSceneList(1, [this](CScene *scene) {
+		m_relationModelManager->updateCurrScene(scene);
 		m_relationModelManager->loadRelativePosFromCurrScene();
-	}
+	});
 
 	m_relationModelManager->buildRelativeRelationModels();
 	m_relationModelManager->saveRelativeRelationModels(m_localSceneDBPath, m_sceneDBType);
@@ -936,27 +1373,18 @@ void scene_lab::BuildRelativeRelationModels()
 void scene_lab::BuildPairwiseRelationModels()
 {
 	loadParas();
-	LoadWholeSceneList(1);
+	resetRelationModelManager();
 
-	if (m_relationModelManager != NULL)
-	{
-		delete m_relationModelManager;
-	}
-
-	m_relationModelManager = new RelationModelManager(m_relationExtractor);
-
-	for (int i = 0; i < m_sceneList.size(); i++)
-	{
-		m_currScene = m_sceneList[i];
-		m_currScene->loadSSG();
+	std::vector<CScene*> sceneList = collectFromSceneList(1, [this](CScene *scene) {
+		scene->loadSSG();
 
-		m_relationModelManager->updateCurrScene(m_currScene);
+		m_relationModelManager->updateCurrScene(scene);
 		m_relationModelManager->loadRelativePosFromCurrScene();
 		m_relationModelManager->collectPairwiseInstanceFromCurrScene();
-	}
+	});
 
 	m_relationModelManager->buildPairwiseRelationModels();
-	m_relationModelManager->computeSimForPairwiseModels(m_relationModelManager->m_pairwiseRelModels, m_relationModelManager->m_pairRelModelKeys, m_sceneList, false, m_localSceneDBPath);
+	m_relationModelManager->computeSimForPairwiseModels(m_relationModelManager->m_sortedPairRelModels, sceneList);
 
 	m_relationModelManager->savePairwiseRelationModels(m_localSceneDBPath, m_sceneDBType);
 	m_relationModelManager->savePairwiseModelSim(m_localSceneDBPath, m_sceneDBType);
@@ -965,27 +1393,18 @@ void scene_lab::BuildPairwiseRelationModels()
 void scene_lab::BuildGroupRelationModels()
 {
 	loadParas();
-	LoadWholeSceneList(1);
-
-	if (m_relationModelManager != NULL)
-	{
-		delete m_relationModelManager;
-	}
+	resetRelationModelManager();
 
-	m_relationModelManager = new RelationModelManager(m_relationExtractor);
-
-	for (int i = 0; i < m_sceneList.size(); i++)
-	{
-		m_currScene = m_sceneList[i];
-		m_currScene->loadSSG();
+	std::vector<CScene*> sceneList = collectFromSceneList(1, [this](CScene *scene) {
+		scene->loadSSG();
 
-		m_relationModelManager->updateCurrScene(m_currScene);
+		m_relationModelManager->updateCurrScene(scene);
 		m_relationModelManager->loadRelativePosFromCurrScene();
 		m_relationModelManager->collectGroupInstanceFromCurrScene();
-	}
+	});
 
 	m_relationModelManager->buildGroupRelationModels();
-	m_relationModelManager->computeSimForPairModelInGroup(m_sceneList);
+	m_relationModelManager->computeSimForPairModelInGroup(sceneList);
 
 	m_relationModelManager->saveGroupRelationModels(m_localSceneDBPath, m_sceneDBType);
 	m_relationModelManager->saveGroupModelSim(m_localSceneDBPath, m_sceneDBType);
@@ -998,43 +1417,126 @@ void scene_lab::BatchBuildModelsForList()
 	uint64 startTime = GetTimeMs64();
 
 	loadParas();
-	// load metadata
-	LoadWholeSceneList(1);
 
-	if (m_relationModelManager != NULL)
+	// models depend on the relative positions and relation record of every scene in the list
+	// records of unchanged scenes are read back from their .relStats, only new or stale scenes are loaded
+	QString stageName = "build models";
+	QString recordStageName = "relation record";
+	SceneBuildTracker buildTracker;
+
+	loadSceneListNamesFromDBListFile();
+	QStringList sceneFullNames = getSceneListFileNames();
+	QString paraKey = QString("SceneList=%1").arg(SceneBuildTracker::hashString(sceneFullNames.join("\n")));
+
+	QStringList staleSceneNames = sceneFullNames;
+
+	if (m_incrementalBuild)
 	{
-		delete m_relationModelManager;
+		buildTracker.load(getBuildManifestFileName());
+
+		staleSceneNames.clear();
+		foreach(QString sceneFullName, sceneFullNames)
+		{
+			if (!buildTracker.isUpToDate(recordStageName, sceneFullName, "") || buildTracker.getOutputFiles(recordStageName, sceneFullName).isEmpty())
+			{
+				staleSceneNames << sceneFullName;
+			}
+		}
+
+		if (staleSceneNames.isEmpty() && buildTracker.isUpToDate(stageName, m_sceneDBType, paraKey))
+		{
+			std::cout << "SceneLab: relation models are up to date.\n";
+			return;
+		}
+
+		std::cout << "SceneLab: " << recordStageName.toStdString() << " up to date for " << sceneFullNames.size() - staleSceneNames.size()
+			<< "/" << sceneFullNames.size() << " scenes\n";
 	}
 
-	m_relationModelManager = new RelationModelManager(m_relationExtractor);
+	resetRelationModelManager();
+	initModelDBsForScenes(staleSceneNames);
+
+	std::set<QString> staleSceneSet(staleSceneNames.begin(), staleSceneNames.end());
 
-	for (int i = 0; i < m_sceneList.size(); i++)
+	QStringList inputFiles;
+	int sceneNum = 0;
+
+	// scenes are added in list order, so models do not depend on which records were cached
+	foreach(QString sceneFullName, sceneFullNames)
 	{
-		m_currScene = m_sceneList[i];
-		m_currScene->loadSSG();
+		SceneRelationRecord record;
+		QString recordFileName;
+		bool isCached = false;
 
-		m_relationModelManager->updateCurrScene(m_currScene);
-		m_relationModelManager->loadRelativePosFromCurrScene();
+		if (!staleSceneSet.count(sceneFullName))
+		{
+			recordFileName = buildTracker.getOutputFiles(recordStageName, sceneFullName)[0];
+			isCached = record.load(recordFileName);
 
-		m_relationModelManager->collectPairwiseInstanceFromCurrScene();
-		m_relationModelManager->collectGroupInstanceFromCurrScene();
-		m_relationModelManager->collectSupportRelationInCurrentScene();
+			if (!isCached)
+			{
+				std::cout << "\tSceneLab: cannot load relation record " << recordFileName.toStdString() << ", collecting it again\n";
+				record = SceneRelationRecord();
+				initModelDBsForScenes(QStringList(sceneFullName));
+			}
+		}
+
+		if (!isCached)
+		{
+			CScene *scene = loadSceneFromFile(sceneFullName, 1);
+			if (scene == NULL)
+			{
+				continue;
+			}
+
+			scene->loadSSG();
+			record.collectFromScene(scene);
+
+			recordFileName = getSceneArtifactFile(scene, ".relStats");
+
+			if (m_incrementalBuild && record.save(recordFileName))
+			{
+				QStringList recordInputFiles(sceneFullName), recordOutputFiles(recordFileName);
+				recordInputFiles << getModelArtifactFiles(scene) << getSceneArtifactFile(scene, ".ssg");
+				buildTracker.record(recordStageName, sceneFullName, "", recordInputFiles, recordOutputFiles);
+			}
+
+			delete scene;
+		}
+
+		// .relPos is written next to .relStats
+		QString relPosFileName = recordFileName.left(recordFileName.length() - QString(".relStats").length()) + ".relPos";
+
+		if (!m_relationModelManager->loadRelativePosFromFile(relPosFileName))
+		{
+			qDebug() << "SceneLab: cannot load relative position for scene " << record.m_sceneName;
+		}
+
+		m_relationModelManager->addSceneRecord(record);
+		inputFiles << relPosFileName << recordFileName;
+		sceneNum++;
 	}
 
+	std::cout << "SceneLab: collected from " << sceneNum << "/" << sceneFullNames.size() << " scenes, "
+		<< staleSceneNames.size() << " loaded, in " << (GetTimeMs64() - startTime) / 1000.0 << " s\n";
+
+	// obj features come with the records, no scene is kept
+	std::vector<CScene*> sceneList;
+
 	// relative
 	m_relationModelManager->buildRelativeRelationModels();
 	m_relationModelManager->saveRelativeRelationModels(m_localSceneDBPath, m_sceneDBType);
 
 	// pairwise
 	m_relationModelManager->buildPairwiseRelationModels();
-	m_relationModelManager->computeSimForPairwiseModels(m_relationModelManager->m_pairwiseRelModels, m_relationModelManager->m_pairRelModelKeys, m_sceneList, false, m_localSceneDBPath);
+	m_relationModelManager->computeSimForPairwiseModels(m_relationModelManager->m_sortedPairRelModels, sceneList);
 
 	m_relationModelManager->savePairwiseRelationModels(m_localSceneDBPath, m_sceneDBType);
 	m_relationModelManager->savePairwiseModelSim(m_localSceneDBPath, m_sceneDBType);
 
 	// group
 	m_relationModelManager->buildGroupRelationModels();
-	m_relationModelManager->computeSimForPairModelInGroup(m_sceneList);
+	m_relationModelManager->computeSimForPairModelInGroup(sceneList);
 
 	m_relationModelManager->saveGroupRelationModels(m_localSceneDBPath, m_sceneDBType);
 	m_relationModelManager->saveGroupModelSim(m_localSceneDBPath, m_sceneDBType);
@@ -1043,6 +1545,22 @@ void scene_lab::BatchBuildModelsForList()
 	m_relationModelManager->buildSupportRelationModels();
 	m_relationModelManager->saveSupportRelationModels(m_localSceneDBPath, m_sceneDBType);
 
+	if (m_incrementalBuild)
+	{
+		QStringList outputFiles;
+		QStringList modelFileNames;
+		modelFileNames << "Relative_%1.model" << "Pairwise_%1.model" << "Pairwise_%1.sim" << "Group_%1.model" << "Group_%1.sim"
+			<< "SupportRelation_%1.model" << "SupportParent_%1.prob";
+
+		foreach(QString modelFileName, modelFileNames)
+		{
+			outputFiles << m_localSceneDBPath + "/" + modelFileName.arg(m_sceneDBType);
+		}
+
+		buildTracker.record(stageName, m_sceneDBType, paraKey, inputFiles, outputFiles);
+		buildTracker.save();
+	}
+
 	uint64 endTime = GetTimeMs64();
 	qDebug() << QString("Done in %1 seconds").arg((endTime-startTime)/1000);
 }
@@ -1064,23 +1582,15 @@ void scene_lab::ComputeBBAlignMatForSceneList()
 	//}
 
 	loadParas();
-	loadSceneListNamesFromDBListFile();
-
-	for (auto it = m_loadedSceneFileNames.begin(); it != m_loadedSceneFileNames.end(); it++)
-	{
-		QStringList& sceneFullNames = it->second;
-		foreach(QString sceneName, sceneFullNames)
-		{
-			if (m_currScene != NULL)
-			{
-				delete m_currScene;
-			}
 
-			loadSceneWithName(sceneName, 0, 0, 0, 0);
-			m_currScene->computeModelBBAlignMat();
-			qDebug() << "SceneLab: bounding box alignment matrix saved for " << m_currScene->getSceneName();
-		}
-	}
+	runStageForSceneList("compute BB align mat", 0, 0, 0, 0, [](CScene *scene, std::ostream &log) {
+		scene->computeModelBBAlignMat();
+		log << "SceneLab: bounding box alignment matrix saved for " << scene->getSceneName().toStdString() << "\n";
+		return true;
+	}, [](CScene *scene, QStringList &inputFiles, QStringList &outputFiles) {
+		inputFiles << getModelArtifactFiles(scene);
+		outputFiles << getSceneArtifactFile(scene, ".alignMat");
+	});
 }
 
 void scene_lab::ExtractRelPosForSceneList()
@@ -1108,74 +1618,53 @@ void scene_lab::ExtractRelPosForSceneList()
 	//}
 
 	loadParas();
-	loadSceneListNamesFromDBListFile();
 
 	if (m_relationExtractor == NULL)
 	{
 		m_relationExtractor = new RelationExtractor(m_angleTh);
 	}
 
-	if (m_relationModelManager != NULL)
-	{
-		delete m_relationModelManager;
-	}
-
-	m_relationModelManager = new RelationModelManager(m_relationExtractor);
-
-	for (auto it = m_loadedSceneFileNames.begin(); it != m_loadedSceneFileNames.end(); it++)
-	{
-		QStringList& sceneFullNames = it->second;
-		foreach(QString sceneName, sceneFullNames)
-		{
-			if (m_currScene != NULL)
-			{
-				delete m_currScene;
-			}
-
-			loadSceneWithName(sceneName, 0, 1, 0, 0);
-			m_relationModelManager->updateCurrScene(m_currScene);
-			m_relationModelManager->collectRelativePosInCurrScene();
-			qDebug() << "SceneLab: relative position saved for " << m_currScene->getSceneName();
-		}
-	}
+	double angleTh = m_angleTh;
+
+	// extractor and manager keep the current scene, so every task uses its own
+	runStageForSceneList("extract relative position", 0, 1, 0, 0, [angleTh](CScene *scene, std::ostream &log) {
+		RelationExtractor relationExtractor(angleTh);
+		RelationModelManager relationModelManager(&relationExtractor);
+
+		relationModelManager.updateCurrScene(scene);
+		relationModelManager.collectRelativePosInCurrScene();
+		log << "SceneLab: relative position saved for " << scene->getSceneName().toStdString() << "\n";
+		return true;
+	}, [](CScene *scene, QStringList &inputFiles, QStringList &outputFiles) {
+		// stale once the ssg or align mat is rebuilt
+		inputFiles << getModelArtifactFiles(scene) << getSceneArtifactFile(scene, ".ssg") << getSceneArtifactFile(scene, ".alignMat");
+		outputFiles << getSceneArtifactFile(scene, ".relPos");
+	}, QString("AngleThreshold=%1").arg(angleTh));
 }
 
 void scene_lab::ExtractSuppProbForSceneList()
 {
 	loadParas();
-	LoadWholeSceneList(1);
+	resetRelationModelManager();
 
-	if (m_relationModelManager != NULL)
-	{
-		delete m_relationModelManager;
-	}
-
-	m_relationModelManager = new RelationModelManager(m_relationExtractor);
+	// every scene is summarized on its own thread, summaries are merged in finishing order
+	std::mutex statsMutex;
 
-	for (int i = 0; i < m_sceneList.size(); i++)
-	{
-		m_currScene = m_sceneList[i];
-		m_currScene->loadSSG();
+	runStageForSceneList("extract support probability", 1, 0, 0, 1, [&](CScene *scene, std::ostream &log) {
+		scene->loadSSG();
 
-		m_relationModelManager->updateCurrScene(m_currScene);
-		m_relationModelManager->collectSupportRelationInCurrentScene();
+		SceneRelationStats sceneStats;
+		sceneStats.collectFromScene(scene);
 
-		m_relationModelManager->collectCoOccInCurrentScene();
-	}
+		std::lock_guard<std::mutex> lock(statsMutex);
+		m_relationModelManager->addRelationStats(sceneStats);
+		return true;
+	});
 
 	m_relationModelManager->buildSupportRelationModels();
 	m_relationModelManager->saveSupportRelationModels(m_localSceneDBPath, m_sceneDBType);
 
-	for (int i = 0; i < m_sceneList.size(); i++)
-	{
-		m_currScene = m_sceneList[i];
-		m_relationModelManager->updateCurrScene(m_currScene);
-		m_relationModelManager->collectSupportRelationInCurrentScene();
-
-		m_relationModelManager->addOccToCoOccFromCurrentScene();
-	}
-
-	m_relationModelManager->computeOccToCoccOnSameParent();
+	m_relationModelManager->buildCoOccOnParentModels();
 	m_relationModelManager->saveCoOccurOnParentModels(m_localSceneDBPath, m_sceneDBType);
 }
 
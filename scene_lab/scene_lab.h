@@ -2,6 +2,8 @@
 #define SCENE_LAB_H
 
 #include <QObject>
+#include <functional>
+#include <ostream>
 #include "StarlabDrawArea.h"
 #include "../common/geometry/CMesh.h"
 
@@ -31,13 +33,33 @@ public:
 	CScene *getScene() { return m_currScene; };
 
 	void loadParas();
+	void setParaFileName(const QString &fileName) { m_paraFileName = fileName; };  // default is the embedded :/paras.txt
 
 	void loadSceneWithName(const QString &sceneFullName, int metaDataOnly = 0, int obbOnly = 0, int reComputeOBB = 0, int updateModelCat = 1);
+	CScene* loadSceneFromFile(const QString &sceneFullName, int metaDataOnly = 0, int obbOnly = 0, int reComputeOBB = 0, int updateModelCat = 1);  // does not touch current scene
+	void initModelDBsForScenes(const QStringList &sceneFullNames);  // init model DBs needed by the scene formats
 
 	void loadSceneListNamesFromDBListFile();
 	void loadSceneFileNamesFromSceneListFile(const QString &sceneDBName, const QString &sceneListFileName, std::map<QString, QStringList> &loadedSceneFileNames);
 
 	void LoadWholeSceneList(int metaDataOnly = 0, int obbOnly = 0, int reComputeOBB = 0, int updateModelCat = 1);
+	QStringList getSceneListFileNames();  // all loaded scene file names, in DB list order
+
+	// files a stage reads and writes for a scene, the scene file itself is always an input
+	typedef std::function<void(CScene*, QStringList &inputFiles, QStringList &outputFiles)> StageDependency;
+
+	// run a per-scene stage over the scene list on SceneBatchProcessor threads
+	// with a dependency and IncrementalBuild=1, scenes whose artifacts are up to date are skipped, see SceneBuildTracker
+	int runStageForSceneList(const QString &stageName, int metaDataOnly, int obbOnly, int reComputeOBB, int updateModelCat,
+		const std::function<bool(CScene*, std::ostream&)> &stage, const StageDependency &dependency = StageDependency(), const QString &paraKey = QString());
+	QString getBuildManifestFileName();
+
+	// collect from each scene of the list in DB list order; streamed scenes are freed right after collector returns,
+	// otherwise the whole list stays in m_sceneList. returns the scenes still resident
+	std::vector<CScene*> collectFromSceneList(int metaDataOnly, const std::function<void(CScene*)> &collector);
+	void resetRelationModelManager();
+
+	void setBatchThreadNum(int threadNum) { m_batchThreadNum = threadNum; m_isBatchThreadNumFixed = true; };  // overrides BatchThreadNum in paras
 
 	void InitModelDBs();
 	void initShapeNetDB();
@@ -56,9 +78,14 @@ public slots:
 	// obb
 	void BuildOBBForSceneList();
 
+	// mesh cache
+	void BuildMeshCacheForModelDB();
+
 	// structure graph
 	void BuildRelationGraphForCurrentScene();
 	void BuildRelationGraphForSceneList();
+	void BenchmarkSupportTestForSceneList();
+	void BenchmarkGraphEdgeLookup();
 
 	// ssg
 	void BuildSemGraphForCurrentScene();
@@ -84,11 +111,10 @@ public slots:
 	void create_modelDBViewer_widget();
 	void destory_modelDBViewer_widget();
 
-	void testMatlab();
-
 	// screen shots
 	void ScreenShotForCurrScene();
 	void ScreenShotForSceneList();
+	void RenderThumbnailsForSceneList();  // headless, with the software rasterizer
 
 signals:
 	void sceneLoaded();
@@ -113,7 +139,7 @@ private:
 
 	ModelDatabase *m_sunCGModelDB;
 
-	std::map<QString, CMesh> m_meshDatabase;  // database for saving loaded meshes; to speed up mesh loading time
+	MeshDatabase m_meshDatabase;  // database of shared mesh assets; to speed up mesh loading time and save memory
 
 	std::map<QString, QString> m_modelCatMapTsinghua; // model category mapping from tsinghua to stanford
 
@@ -122,6 +148,14 @@ private:
 	QString m_localSceneDBPath;
 	double m_angleTh;
 	QString m_sceneANNPath;
+	int m_batchThreadNum;  // 0: one thread per core
+	bool m_isBatchThreadNumFixed;
+	bool m_streamSceneList;  // build models with one scene in memory at a time
+	bool m_incrementalBuild;  // only rebuild stale artifacts
+	int m_thumbnailWidth;
+	int m_thumbnailHeight;
+	QStringList m_thumbnailViews;  // camera presets of CSceneRasterizer
+	QString m_paraFileName;
 };
 
 #endif // SCENE_LAB_H
@@ -28,11 +28,19 @@ HEADERS += \
 	modeldbviewer_widget.h \
 	ModelDBViewer.h \
 	modelDatabase.h \ 
+	ModelMetaCatalog.h \
 	category.h \
 	GaussianMixtureModel.h \
+	GMMFitter.h \
 	RelationModel.h \
 	RelationExtractor.h \
-	RelationModelManager.h
+	RelationModelManager.h \
+	RelationModelSimilarity.h \
+	RelationSymbolTable.h \
+	SceneBatchProcessor.h \
+	SceneBuildTracker.h \
+	SceneRelationStats.h \
+	SceneRelationRecord.h
 	
 SOURCES += \
 	scene_lab.cpp \
@@ -40,11 +48,19 @@ SOURCES += \
 	modeldbviewer_widget.cpp \
 	ModelDBViewer.cpp \
 	modelDatabase.cpp \
+	ModelMetaCatalog.cpp \
 	category.cpp \
 	GaussianMixtureModel.cpp \
+	GMMFitter.cpp \
 	RelationModel.cpp \
 	RelationExtractor.cpp \
-	RelationModelManager.cpp
+	RelationModelManager.cpp \
+	RelationModelSimilarity.cpp \
+	RelationSymbolTable.cpp \
+	SceneBatchProcessor.cpp \
+	SceneBuildTracker.cpp \
+	SceneRelationStats.cpp \
+	SceneRelationRecord.cpp
 	
 	
 {# Prevent rebuild and Enable debuging in release mode
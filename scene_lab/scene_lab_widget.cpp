@@ -19,7 +19,10 @@ scene_lab_widget::scene_lab_widget(scene_lab *s_lab, QWidget *parent/*=0*/)
 
 	// scene list processing
 	connect(ui->buildOBBForListButton, SIGNAL(clicked()), m_scene_lab, SLOT(BuildOBBForSceneList()));
+	connect(ui->buildMeshCacheButton, SIGNAL(clicked()), m_scene_lab, SLOT(BuildMeshCacheForModelDB()));
 	connect(ui->buildRGForListButton, SIGNAL(clicked()), m_scene_lab, SLOT(BuildRelationGraphForSceneList()));
+	connect(ui->benchmarkSuppTestButton, SIGNAL(clicked()), m_scene_lab, SLOT(BenchmarkSupportTestForSceneList()));
+	connect(ui->benchmarkGraphLookupButton, SIGNAL(clicked()), m_scene_lab, SLOT(BenchmarkGraphEdgeLookup()));
 	connect(ui->buildSSGForListButton, SIGNAL(clicked()), m_scene_lab, SLOT(BuildSemGraphForSceneList()));
 
 	connect(ui->extractModelCatsButton, SIGNAL(clicked()), m_scene_lab, SLOT(ExtractModelCatsFromSceneList()));
@@ -0,0 +1,157 @@
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QFileInfo>
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <functional>
+
+#include "scene_lab.h"
+#include "../common/utilities/utility.h"
+
+// headless front end of the scene_lab offline pipeline
+// runs stages without widget or GL context, e.g.
+//   scene_lab_cli --jobs 16 obb sg ssg
+//   scene_lab_cli --paras D:/T2S/paras.txt all
+
+struct PipelineStage
+{
+	QString name;
+	QString description;
+	std::function<void(scene_lab*)> run;
+};
+
+static std::vector<PipelineStage> getPipelineStages()
+{
+	// in pipeline order, later stages read the files written by earlier ones
+	std::vector<PipelineStage> stages;
+
+	stages.push_back({ "meshcache", "binary mesh cache for model DBs (.bmesh)", [](scene_lab *lab) { lab->BuildMeshCacheForModelDB(); } });
+	stages.push_back({ "obb", "model OBBs for skewed models", [](scene_lab *lab) { lab->BuildOBBForSceneList(); } });
+	stages.push_back({ "sg", "relation graphs (.sg)", [](scene_lab *lab) { lab->BuildRelationGraphForSceneList(); } });
+	stages.push_back({ "ssg", "scene semantic graphs (.ssg)", [](scene_lab *lab) { lab->BuildSemGraphForSceneList(); } });
+	stages.push_back({ "alignmat", "bounding box alignment matrices (.alignMat)", [](scene_lab *lab) { lab->ComputeBBAlignMatForSceneList(); } });
+	stages.push_back({ "relpos", "relative positions (.relPos)", [](scene_lab *lab) { lab->ExtractRelPosForSceneList(); } });
+	stages.push_back({ "models", "relative, pairwise, group and support models (*.model, *.sim)", [](scene_lab *lab) { lab->BatchBuildModelsForList(); } });
+	stages.push_back({ "supp", "support probabilities and co-occurrence (SupportRelation.model)", [](scene_lab *lab) { lab->ExtractSuppProbForSceneList(); } });
+	stages.push_back({ "thumbs", "scene preview images (.png), software rendered", [](scene_lab *lab) { lab->RenderThumbnailsForSceneList(); } });
+
+	return stages;
+}
+
+int main(int argc, char *argv[])
+{
+	QCoreApplication app(argc, argv);
+	QCoreApplication::setApplicationName("scene_lab_cli");
+
+	std::vector<PipelineStage> allStages = getPipelineStages();
+
+	QString stageHelp = "Stages to run in the given order, or \"all\" for the whole pipeline:";
+	for (int i = 0; i < allStages.size(); i++)
+	{
+		stageHelp += QString("\n  %1\t%2").arg(allStages[i].name, allStages[i].description);
+	}
+
+	QCommandLineParser parser;
+	parser.setApplicationDescription("Run scene_lab learning stages on the scene lists in scene_db_list.txt.");
+	parser.addHelpOption();
+
+	QCommandLineOption jobsOption(QStringList() << "j" << "jobs", "Number of worker threads for per-scene stages, 0 for one per core.", "N");
+	QCommandLineOption parasOption(QStringList() << "p" << "paras", "Parameter file to use instead of the embedded paras.txt.", "file");
+	parser.addOption(jobsOption);
+	parser.addOption(parasOption);
+	parser.addPositionalArgument("stages", stageHelp, "stage [stage ...]");
+
+	parser.process(app);
+
+	QStringList stageNames = parser.positionalArguments();
+	if (stageNames.isEmpty())
+	{
+		parser.showHelp(1);
+	}
+
+	// collect requested stages
+	std::vector<const PipelineStage*> runStages;
+	foreach(QString stageName, stageNames)
+	{
+		if (stageName == "all")
+		{
+			for (int i = 0; i < allStages.size(); i++)
+			{
+				runStages.push_back(&allStages[i]);
+			}
+			continue;
+		}
+
+		int stageId = -1;
+		for (int i = 0; i < allStages.size(); i++)
+		{
+			if (allStages[i].name == stageName)
+			{
+				stageId = i;
+				break;
+			}
+		}
+
+		if (stageId == -1)
+		{
+			std::cout << "scene_lab_cli: unknown stage " << stageName.toStdString() << "\n";
+			return 1;
+		}
+
+		runStages.push_back(&allStages[stageId]);
+	}
+
+	scene_lab lab;
+
+	if (parser.isSet(parasOption))
+	{
+		QString paraFileName = parser.value(parasOption);
+		if (!QFileInfo(paraFileName).exists())
+		{
+			std::cout << "scene_lab_cli: cannot find parameter file " << paraFileName.toStdString() << "\n";
+			return 1;
+		}
+
+		lab.setParaFileName(paraFileName);
+		lab.loadParas();
+	}
+
+	if (parser.isSet(jobsOption))
+	{
+		bool isValid = false;
+		int jobNum = parser.value(jobsOption).toInt(&isValid);
+
+		if (!isValid || jobNum < 0)
+		{
+			std::cout << "scene_lab_cli: invalid job number " << parser.value(jobsOption).toStdString() << "\n";
+			return 1;
+		}
+
+		lab.setBatchThreadNum(jobNum);
+	}
+
+	// run stages and time each of them
+	std::vector<double> stageTimes;
+	uint64 pipelineStartTime = GetTimeMs64();
+
+	for (int i = 0; i < runStages.size(); i++)
+	{
+		std::cout << "scene_lab_cli: stage " << runStages[i]->name.toStdString() << " started\n";
+
+		uint64 startTime = GetTimeMs64();
+		runStages[i]->run(&lab);
+		stageTimes.push_back((GetTimeMs64() - startTime) / 1000.0);
+
+		std::cout << "scene_lab_cli: stage " << runStages[i]->name.toStdString() << " done in " << stageTimes.back() << " s\n";
+	}
+
+	std::cout << "\nscene_lab_cli: stage timing\n";
+	for (int i = 0; i < runStages.size(); i++)
+	{
+		std::cout << "\t" << std::left << std::setw(12) << runStages[i]->name.toStdString() << std::fixed << std::setprecision(3) << stageTimes[i] << " s\n";
+	}
+	std::cout << "\t" << std::left << std::setw(12) << "total" << (GetTimeMs64() - pipelineStartTime) / 1000.0 << " s\n";
+
+	return 0;
+}
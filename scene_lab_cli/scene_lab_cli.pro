@@ -0,0 +1,26 @@
+include($$[STARLAB])
+include( ../common.pri )
+include( ../scene_lab.pri )
+
+
+StarlabTemplate(console)
+
+TARGET = scene_lab_cli
+
+# scene_lab builds scene semantic graphs with the t2scene classes
+HEADERS += \
+	../t2scene/SemanticGraph.h \
+	../t2scene/SceneSemGraph.h 
+
+SOURCES += \
+	main.cpp \
+	../t2scene/SemanticGraph.cpp \
+	../t2scene/SceneSemGraph.cpp 
+
+RESOURCES += \
+	../t2scene/text2scene.qrc
+	
+{# Prevent rebuild and Enable debuging in release mode
+	QMAKE_CXXFLAGS_RELEASE += /Zi
+    QMAKE_LFLAGS_RELEASE += /DEBUG
+}
@@ -8,12 +8,23 @@
 #include "../scene_lab/RelationExtractor.h"
 
 
-SceneSemGraph::SceneSemGraph(CScene *s, ModelDatabase *db, RelationExtractor *relationExtractor, const QString &groupAnnPath)
-	:m_scene(s), m_modelDB(db), m_relationExtractor(relationExtractor), m_sceneANNPath(groupAnnPath)
+SSGModelInstance::SSGModelInstance()
 {
-	m_relationExtractor->updateCurrScene(s);
-	m_relationExtractor->updateCurrSceneSemGraph(this);
+	dbModel = NULL;
+	transMat = MathLib::Matrix4d::Identity_Matrix;
+
+	frontDir = MathLib::Vector3(0, -1, 0);
+	upDir = MathLib::Vector3(0, 0, 1);
+	position = MathLib::Vector3(0, 0, 0);
 
+	parentId = -1;
+	onSuppPlaneUV = std::vector<double>(2, 0.5);
+	positionToSuppPlaneDist = 0;
+}
+
+SceneSemGraph::SceneSemGraph(CScene *s, const ModelDatabase *db, const RelationExtractor *relationExtractor, const QString &groupAnnPath)
+	:m_scene(s), m_modelDB(db), m_relationExtractor(relationExtractor), m_sceneANNPath(groupAnnPath)
+{
 	m_sceneFormat = m_scene->getSceneFormat();
 	m_relGraph = m_scene->getSceneGraph();
 }
@@ -26,58 +37,57 @@ SceneSemGraph::SceneSemGraph(const QString &s)
 
 SceneSemGraph::~SceneSemGraph()
 {
-	for (int i = 0; i < m_metaModelList.size(); i++)
-	{
-		// since we create a new instance of MetaModel
-		delete m_metaModelList[i];
-	}
-	m_metaModelList.clear();
 }
 
 void SceneSemGraph::generateGraph()
 {
 	// extract model as object node
 	m_modelNum = m_scene->getModelNum();
+	m_modelInstances.reserve(m_modelNum);
 
 	for (int i = 0; i < m_modelNum;  i++)
 	{
 		QString modelNameStr = m_scene->getModelNameString(i);
+		CModel *m = m_scene->getModel(i);
+
+		SSGModelInstance modelInstance;
+		modelInstance.idStr = modelNameStr;
+		//modelInstance.transMat = m_scene->getModelInitTransMat(i);
+		modelInstance.transMat = m_scene->getModelInitTransMatWithSceneMetric(i);
+		modelInstance.onSuppPlaneUV = m_scene->getUVonBBTopPlaneForModel(i);
+		modelInstance.positionToSuppPlaneDist = m_scene->getHightToBBTopPlaneForModel(i);
+
+		if (m->m_bbTopPlane != NULL)
+		{
+			modelInstance.suppPlaneCorners = m_scene->getCurrModelBBTopPlaneCornersWithSceneMetric(i);
+		}
 
-		if (m_modelDB != NULL && m_modelDB->isModelInDB(modelNameStr))
+		const DBMetaModel *dbModel = NULL;
+		if (m_modelDB != NULL)
 		{
-			DBMetaModel *metaModel = m_modelDB->getMetaModelByNameString(modelNameStr);
-			CModel *m = m_scene->getModel(i);
-			DBMetaModel *newMetaModelInstance = new DBMetaModel(metaModel);
+			dbModel = m_modelDB->getMetaModelByNameString(modelNameStr);
+		}
 
-			// add extra info to meta model
-			//newMetaModelInstance->setTransMat(m_scene->getModelInitTransMat(i));
-			newMetaModelInstance->setTransMat(m_scene->getModelInitTransMatWithSceneMetric(i));
+		if (dbModel != NULL)
+		{
+			// view of the DB entry, only instance info is kept
+			modelInstance.dbModel = dbModel;
+			modelInstance.idStr = dbModel->getIdStr();
+			modelInstance.catName = dbModel->getProcessedCatName();
+			modelInstance.frontDir = dbModel->frontDir;
+			modelInstance.upDir = dbModel->upDir;
+			modelInstance.position = dbModel->position;
 
 			if (m_scene->modelHasOBB(i))
 			{
-				newMetaModelInstance->position = m->getModelPosOBB();
-			}
-			newMetaModelInstance->parentId = m_scene->getSuppParentId(i);
-			newMetaModelInstance->onSuppPlaneUV = m_scene->getUVonBBTopPlaneForModel(i);
-			newMetaModelInstance->positionToSuppPlaneDist = m_scene->getHightToBBTopPlaneForModel(i);
-
-			if (m->m_bbTopPlane != NULL)
-			{
-				newMetaModelInstance->suppPlaneCorners = m_scene->getCurrModelBBTopPlaneCornersWithSceneMetric(i);
+				modelInstance.position = m->getModelPosOBB();
 			}
-
-			m_metaModelList.push_back(newMetaModelInstance);
-
-			QString objectNodeName = metaModel->getProcessedCatName();
-			addNode(QString(SSGNodeTypeStrings[SSGNodeType::Object]), objectNodeName);
+			modelInstance.parentId = m_scene->getSuppParentId(i);
 		}
 		else
 		{
 			//std::cout << "SceneSemGraph: cannot find model: " << modelNameStr.toStdString() << " in ShapeNetDB-"<<m_modelDB->getMetaFileType().toStdString()<<"\n";
 
-			// add model to DB
-			DBMetaModel *newMetaModel = new DBMetaModel();
-			CModel *m = m_scene->getModel(i);
 			//QString modelCatName = "unknown";
 			QString modelCatName = m->getCatName();
 
@@ -86,34 +96,17 @@ void SceneSemGraph::generateGraph()
 				modelCatName = "room";
 			}
 
-			newMetaModel->frontDir = m->getFrontDir() * m_scene->getSceneMetric();
-			newMetaModel->upDir = m->getUpDir()* m_scene->getSceneMetric();
-			//newMetaModel->position = m->getOBBInitPos();
-			newMetaModel->position = m->getModelPosOBB();
-
-			newMetaModel->setCatName(modelCatName);
-			newMetaModel->setIdStr(modelNameStr);
-			//newMetaModel->setTransMat(m_scene->getModelInitTransMat(i));
-			newMetaModel->setTransMat(m_scene->getModelInitTransMatWithSceneMetric(i));
-
-
-			newMetaModel->parentId = m->suppParentID;
-			newMetaModel->onSuppPlaneUV = m_scene->getUVonBBTopPlaneForModel(i);
-			newMetaModel->positionToSuppPlaneDist = m_scene->getHightToBBTopPlaneForModel(i);
-
-			if (m->m_bbTopPlane!=NULL)
-			{
-				newMetaModel->suppPlaneCorners = m_scene->getCurrModelBBTopPlaneCornersWithSceneMetric(i);
-			}
+			modelInstance.catName = modelCatName;
+			modelInstance.frontDir = m->getFrontDir() * m_scene->getSceneMetric();
+			modelInstance.upDir = m->getUpDir()* m_scene->getSceneMetric();
+			//modelInstance.position = m->getOBBInitPos();
+			modelInstance.position = m->getModelPosOBB();
+			modelInstance.parentId = m->suppParentID;
+		}
 
-			//// add current instance to DB
-			//newMetaModel->dbID = m_modelDB->dbMetaModels.size();
-			//m_modelDB->dbMetaModels[modelNameStr] = newMetaModel;
+		m_modelInstances.push_back(modelInstance);
 
-			m_metaModelList.push_back(newMetaModel);			
-			
-			addNode(QString(SSGNodeTypeStrings[SSGNodeType::Object]), modelCatName);
-		}
+		addNode(QString(SSGNodeTypeStrings[SSGNodeType::Object]), modelInstance.catName);
 	}
 
 	// extract low-level model attributes from ShapeNetSem annotation
@@ -129,14 +122,18 @@ void SceneSemGraph::generateGraph()
 
 	parseNodeNeighbors();
 
-	std::cout << "SceneSemGraph: graph generated.\n";
+	ThreadLog() << "SceneSemGraph: graph generated.\n";
 }
 
 void SceneSemGraph::addModelDBAnnotation()
 {
-	for (int i = 0; i < m_metaModelList.size(); i++)
+	for (int i = 0; i < m_modelInstances.size(); i++)
 	{
-		DBMetaModel *currDBModel = m_metaModelList[i];
+		const DBMetaModel *currDBModel = m_modelInstances[i].dbModel;
+		if (currDBModel == NULL)
+		{
+			continue;
+		}
 
 		for (int a = 0; a < currDBModel->m_attributes.size(); a++)
 		{
@@ -150,7 +147,7 @@ void SceneSemGraph::addRelationsFromRelationGraph()
 {
 	if (m_relGraph == NULL)
 	{
-		std::cout << "SceneSemGraph: relation graph is not generated.\n";
+		ThreadLog() << "SceneSemGraph: relation graph is not generated.\n";
 		return;	
 	}
 
@@ -208,7 +205,7 @@ void SceneSemGraph::addSpatialSideRel()
 
 void SceneSemGraph::addSpatialSideRelForModelPair(int refModelId, int testModelId)
 {
-	std::vector<QString> sideRels = m_relationExtractor->extractSpatialSideRelForModelPair(refModelId, testModelId);
+	std::vector<QString> sideRels = m_relationExtractor->extractSpatialSideRelForModelPair(m_scene, refModelId, testModelId);
 
 	for (int r = 0; r < sideRels.size(); r++)
 	{
@@ -225,7 +222,7 @@ void SceneSemGraph::addSpatialSideRelForModelPair(int refModelId, int testModelI
 	int newRefModelId = testModelId;
 	int newTestNodeId = refModelId;
 
-	sideRels = m_relationExtractor->extractSpatialSideRelForModelPair(newRefModelId, newTestNodeId);
+	sideRels = m_relationExtractor->extractSpatialSideRelForModelPair(m_scene, newRefModelId, newTestNodeId);
 
 	for (int r = 0; r < sideRels.size(); r++)
 	{
@@ -334,21 +331,29 @@ void SceneSemGraph::addGroupAttributeFromAnnotation()
 
 void SceneSemGraph::splitSpecialGroupRelationToPairRelations()
 {
-	for (int i=0; i < m_nodeNum; i++)
+	parseNodeNeighbors();
+
+	// only nodes of the current adjacency are visited, added nodes are pair relations
+	int annoNodeNum = m_nodeNum;
+	for (int i=0; i < annoNodeNum; i++)
 	{
-		SemNode &currNode = m_nodes[i];
-		if (currNode.nodeType == SSGNodeTypeStrings[SSGNodeType::GroupRelAnno])
+		if (m_nodes[i].typeId == SSGNodeType::GroupRelAnno)
 		{
-			if (currNode.nodeName == "surround")
+			// addNode may reallocate m_nodes, copy the name
+			QString annoName = m_nodes[i].nodeName;
+			SemNodeList actNodeList = activeNodes(i);
+			SemNodeList anchorNodeList = anchorNodes(i);
+
+			if (annoName == "surround")
 			{
-				if (!currNode.outEdgeNodeList.empty())
+				if (!anchorNodeList.empty())
 				{
-					int anchorNodeId = currNode.outEdgeNodeList[0];
+					int anchorNodeId = anchorNodeList[0];
 
 					// add pairwise node to each act obj
-					for (int j=0; j < currNode.inEdgeNodeList.size(); j++)
+					for (int j=0; j < actNodeList.size(); j++)
 					{
-						int actNodeId = currNode.inEdgeNodeList[j];
+						int actNodeId = actNodeList[j];
 						addNode(SSGNodeTypeStrings[SSGNodeType::PairRel], PairRelStrings[PairRelation::PairAround]);
 
 						addEdge(actNodeId, m_nodeNum - 1);
@@ -357,13 +362,13 @@ void SceneSemGraph::splitSpecialGroupRelationToPairRelations()
 				}
 			}
 
-			if (currNode.nodeName == "aligned")
+			if (annoName == "aligned")
 			{
 				// find same obj in same cats and use the first one as anchor
 				std::map<QString, std::vector<int>> objIds;
-				for (int j=0; j < currNode.inEdgeNodeList.size(); j++)
+				for (int j=0; j < actNodeList.size(); j++)
 				{
-					int actNodeId = currNode.inEdgeNodeList[j];
+					int actNodeId = actNodeList[j];
 					SemNode& actNode = m_nodes[actNodeId];
 
 					objIds[actNode.nodeName].push_back(actNodeId);
@@ -402,36 +407,44 @@ void SceneSemGraph::saveGraph()
 		ofs << m_sceneFormat << "\n";
 
 		// save scene meta data
-		int modelNum = m_metaModelList.size();
+		int modelNum = m_modelInstances.size();
 		ofs << "modelCount " << modelNum << "\n";
 
 		for (int i = 0; i < modelNum; i++)
 		{
-			ofs << "newModel "<< i << " " << m_metaModelList[i]->getIdStr() << "\n";
-			ofs << "transform " << GetTransformationString(m_metaModelList[i]->getTransMat()) << "\n";
-			ofs << "position " << m_metaModelList[i]->position[0] << " " << m_metaModelList[i]->position[1] << " " << m_metaModelList[i]->position[2] << "\n";
-			ofs << "frontDir " << m_metaModelList[i]->frontDir[0] << " " << m_metaModelList[i]->frontDir[1] << " " << m_metaModelList[i]->frontDir[2] << "\n";
-			ofs << "upDir " << m_metaModelList[i]->upDir[0] << " " << m_metaModelList[i]->upDir[1] << " " << m_metaModelList[i]->upDir[2] << "\n";
+			const SSGModelInstance &modelInstance = m_modelInstances[i];
 
-			if (!m_metaModelList[i]->suppPlaneCorners.empty())
+			ofs << "newModel "<< i << " " << modelInstance.idStr << "\n";
+			ofs << "transform " << GetTransformationString(modelInstance.transMat) << "\n";
+			ofs << "position " << modelInstance.position[0] << " " << modelInstance.position[1] << " " << modelInstance.position[2] << "\n";
+			ofs << "frontDir " << modelInstance.frontDir[0] << " " << modelInstance.frontDir[1] << " " << modelInstance.frontDir[2] << "\n";
+			ofs << "upDir " << modelInstance.upDir[0] << " " << modelInstance.upDir[1] << " " << modelInstance.upDir[2] << "\n";
+
+			if (!modelInstance.suppPlaneCorners.empty())
 			{
-				ofs << "bbTopPlane " << m_metaModelList[i]->suppPlaneCorners[0][0] << " " << m_metaModelList[i]->suppPlaneCorners[0][1] << " " << m_metaModelList[i]->suppPlaneCorners[0][2] << " "
-					<< m_metaModelList[i]->suppPlaneCorners[1][0] << " " << m_metaModelList[i]->suppPlaneCorners[1][1] << " " << m_metaModelList[i]->suppPlaneCorners[1][2] << " "
-					<< m_metaModelList[i]->suppPlaneCorners[2][0] << " " << m_metaModelList[i]->suppPlaneCorners[2][1] << " " << m_metaModelList[i]->suppPlaneCorners[2][2] << " "
-					<< m_metaModelList[i]->suppPlaneCorners[3][0] << " " << m_metaModelList[i]->suppPlaneCorners[3][1] << " " << m_metaModelList[i]->suppPlaneCorners[3][2] << "\n";
+				const std::vector<MathLib::Vector3> &corners = modelInstance.suppPlaneCorners;
+				ofs << "bbTopPlane " << corners[0][0] << " " << corners[0][1] << " " << corners[0][2] << " "
+					<< corners[1][0] << " " << corners[1][1] << " " << corners[1][2] << " "
+					<< corners[2][0] << " " << corners[2][1] << " " << corners[2][2] << " "
+					<< corners[3][0] << " " << corners[3][1] << " " << corners[3][2] << "\n";
 			}
 
-			ofs << "parentId " << m_metaModelList[i]->parentId << "\n";
-			ofs << "parentPlaneUVH " << m_metaModelList[i]->onSuppPlaneUV[0] << " " << m_metaModelList[i]->onSuppPlaneUV[1] << " " << m_metaModelList[i]->positionToSuppPlaneDist << "\n";
+			ofs << "parentId " << modelInstance.parentId << "\n";
+			ofs << "parentPlaneUVH " << modelInstance.onSuppPlaneUV[0] << " " << modelInstance.onSuppPlaneUV[1] << " " << modelInstance.positionToSuppPlaneDist << "\n";
 		}
 
 		// save nodes in format: nodeId,nodeType,nodeName,inEdgeNodeList,outEdgeNodeList
+		parseNodeNeighbors();
+
 		ofs << "nodeNum " << m_nodeNum << "\n";
 		for (int i = 0; i < m_nodeNum; i++)
 		{
+			SemNodeList inNodeList = inNodes(i);
+			SemNodeList outNodeList = outNodes(i);
+
 			ofs << i << "," << m_nodes[i].nodeType << "," << m_nodes[i].nodeName << ","
-				<< GetIntString(m_nodes[i].inEdgeNodeList, " ") << "," 
-				<< GetIntString(m_nodes[i].outEdgeNodeList, " ") << "\n";
+				<< GetIntString(std::vector<int>(inNodeList.begin(), inNodeList.end()), " ") << "," 
+				<< GetIntString(std::vector<int>(outNodeList.begin(), outNodeList.end()), " ") << "\n";
 		}
 
 
@@ -444,12 +457,12 @@ void SceneSemGraph::saveGraph()
 
 		outFile.close();
 
-		std::cout << "SceneSemGraph: graph saved.\n";
+		ThreadLog() << "SceneSemGraph: graph saved.\n";
 	}
 
 	else
 	{
-		std::cout << "SceneSemGraph: fail to save graph .\n";
+		ThreadLog() << "SceneSemGraph: fail to save graph .\n";
 	}
 } 
 
@@ -481,8 +494,9 @@ void SceneSemGraph::loadGraph(const QString &filename)
 			int modelIndex = StringToInt(parts[1]);
 			QString modelNameString = QString(parts[2].c_str());
 
-			DBMetaModel *newMetaModel = new DBMetaModel(modelNameString);
-			m_metaModelList.push_back(newMetaModel);
+			SSGModelInstance modelInstance;
+			modelInstance.idStr = modelNameString;
+			m_modelInstances.push_back(modelInstance);
 
 			currModelID++;
 		}
@@ -492,7 +506,7 @@ void SceneSemGraph::loadGraph(const QString &filename)
 			std::vector<float> transformVec = StringToFloatList(currLine.toStdString(), "transform ");  // transformation vector in stanford scene file is column-wise
 			MathLib::Matrix4d transMat(transformVec);
 			transMat = transMat.transpose();
-			m_metaModelList[currModelID]->setTransMat(transMat);
+			m_modelInstances[currModelID].transMat = transMat;
 		}
 	}
 
@@ -516,6 +530,12 @@ void SceneSemGraph::loadGraph(const QString &filename)
 				{
 					addNode(toQString(parts[1]), "noname");
 				}
+
+				// object nodes come first, in model order
+				if (i < m_modelInstances.size())
+				{
+					m_modelInstances[i].catName = m_nodes[m_nodeNum - 1].nodeName;
+				}
 			}
 			else
 			{
@@ -545,7 +565,7 @@ void SceneSemGraph::loadGraph(const QString &filename)
 
 QString SceneSemGraph::getCatName(int modelId)
 {
-	return m_metaModelList[modelId]->getProcessedCatName();
+	return m_modelInstances[modelId].catName;
 }
 
 
@@ -10,19 +10,9 @@ class DBMetaModel;
 class RelationExtractor;
 class CModel;
 
-const QString SSGNodeTypeStrings[] = { "object", "attribute", "pair_relation", "group_relation", "group_relation_anno"};
 const QString SingleAttriStrings[] = {"round", "rectangular", "office", "dining", "kitchen", "floor", "wall"};
 const QString GroupAttrStings[] = {"messy", "clean", "organized", "disorganized", "formal", "casual", "spacious", "crowded"};
 
-enum SSGNodeType
-{
-	Object=0,
-	Attribute,
-	PairRel,
-	GroupRel,
-	GroupRelAnno
-};
-
 struct GroupAnnotation 
 {
 	QString name;
@@ -30,11 +20,33 @@ struct GroupAnnotation
 	std::vector<int> actModelIds;
 };
 
+// model instance of the graph; shared attributes are read from the DB entry, which is not copied
+struct SSGModelInstance
+{
+	SSGModelInstance();
+
+	const DBMetaModel *dbModel;  // NULL if the model is not in the DB or the graph is loaded from file
+
+	QString idStr;
+	QString catName;
+	MathLib::Matrix4d transMat;
+
+	MathLib::Vector3 frontDir;
+	MathLib::Vector3 upDir;
+	MathLib::Vector3 position;
+	std::vector<MathLib::Vector3> suppPlaneCorners;
+
+	int parentId;
+	std::vector<double> onSuppPlaneUV;
+	double positionToSuppPlaneDist;
+};
+
 class SceneSemGraph : public SemanticGraph
 {
 public:
 	SceneSemGraph(const QString &s);
-	SceneSemGraph(CScene *s, ModelDatabase *db, RelationExtractor *relationExtractor, const QString &groupAnnPath);
+	// generating only reads db and relationExtractor, graphs of different scenes can be generated in parallel
+	SceneSemGraph(CScene *s, const ModelDatabase *db, const RelationExtractor *relationExtractor, const QString &groupAnnPath);
 	~SceneSemGraph();
 
 	void loadGraph(const QString &filename);
@@ -58,11 +70,11 @@ private:
 	QString m_sceneFormat;
 	RelationGraph *m_relGraph;
 
-	ModelDatabase *m_modelDB;
-	RelationExtractor *m_relationExtractor;  // pointer to the singleton
+	const ModelDatabase *m_modelDB;
+	const RelationExtractor *m_relationExtractor;  // pointer to the singleton
 	
 	//std::vector<int> m_nonObjNodeIds;  // ids for relation/attribute node
-	std::vector<DBMetaModel*> m_metaModelList;
+	std::vector<SSGModelInstance> m_modelInstances;
 	int m_modelNum;
 
 	std::map<QString, int> m_catStringToLabelIDMap;
@@ -11,9 +11,48 @@ SemanticGraph::~SemanticGraph()
 {
 }
 
+SSGNodeType SemanticGraph::parseNodeType(const QString &nType)
+{
+	for (int t = 0; t < SSGNodeType::UnknownNode; t++)
+	{
+		if (nType == SSGNodeTypeStrings[t])
+		{
+			return (SSGNodeType)t;
+		}
+	}
+
+	// older graphs, e.g. group_attribute
+	if (nType.contains("group")) return SSGNodeType::GroupRel;
+	if (nType.contains("relation")) return SSGNodeType::PairRel;
+	if (nType.contains("attribute")) return SSGNodeType::Attribute;
+
+	return SSGNodeType::UnknownNode;
+}
+
+int SemanticGraph::internName(const QString &name)
+{
+	auto iter = m_nameIds.find(name);
+	if (iter != m_nameIds.end())
+	{
+		return iter.value();
+	}
+
+	int nameId = m_nameList.size();
+	m_nameList.push_back(name);
+	m_nameIds.insert(name, nameId);
+
+	return nameId;
+}
+
 void SemanticGraph::addNode(const QString &nType, const QString &nName)
 {
-	SemNode newNode = SemNode(nType, nName, m_nodeNum);
+	SSGNodeType typeId = parseNodeType(nType);
+	int nameId = internName(nName);
+
+	// known types share the constant strings, names share the interned copy
+	QString typeString = (typeId == SSGNodeType::UnknownNode) ? nType : SSGNodeTypeStrings[typeId];
+
+	SemNode newNode = SemNode(typeId, typeString, nameId, m_nameList[nameId], m_nodeNum);
 	m_nodes.push_back(newNode);
 
 	m_nodeNum++;
@@ -25,53 +64,64 @@ void SemanticGraph::addEdge(int s, int t)
 
 	m_edges.push_back(newEdge);
 
-	// update node edge list
-	m_nodes[s].outEdgeNodeList.push_back(t);
-	m_nodes[t].inEdgeNodeList.push_back(s);
-
 	m_edgeNum++;
 }
 
 void SemanticGraph::parseNodeNeighbors()
 {
+	// edges are only appended, so the counts tell whether the adjacency is current
+	if (m_inOffsets.size() == m_nodeNum + 1 && m_inNodeIds.size() == m_edgeNum)
+	{
+		return;
+	}
+
+	m_inOffsets.assign(m_nodeNum + 1, 0);
+	m_outOffsets.assign(m_nodeNum + 1, 0);
+
+	for (int i = 0; i < m_edgeNum; i++)
+	{
+		m_inOffsets[m_edges[i].targetNodeId + 1]++;
+		m_outOffsets[m_edges[i].sourceNodeId + 1]++;
+	}
+
 	for (int i = 0; i < m_nodeNum; i++)
 	{
-		SemNode& sgNode = m_nodes[i];
+		m_inOffsets[i + 1] += m_inOffsets[i];
+		m_outOffsets[i + 1] += m_outOffsets[i];
+	}
 
-		if (sgNode.nodeType == "object")
-		{
-			sgNode.nodeLabels.clear();
-
-			for (int ai = 0; ai < sgNode.inEdgeNodeList.size(); ai++)
-			{
-				int attNodeId = sgNode.inEdgeNodeList[ai];  // id of attribute node in tsg
-				SemNode &attNode = this->m_nodes[attNodeId];
-
-				if (attNode.nodeType.contains("attribute"))
-				{
-					sgNode.nodeLabels.push_back(attNodeId);
-				}
-			}
-		}
+	// fill in edge order, so neighbor order is the same as the order edges were added
+	m_inNodeIds.resize(m_edgeNum);
+	m_outNodeIds.resize(m_edgeNum);
+
+	std::vector<int> inPos(m_inOffsets.begin(), m_inOffsets.end() - 1);
+	std::vector<int> outPos(m_outOffsets.begin(), m_outOffsets.end() - 1);
+
+	for (int i = 0; i < m_edgeNum; i++)
+	{
+		const SemEdge &e = m_edges[i];
+		m_inNodeIds[inPos[e.targetNodeId]++] = e.sourceNodeId;
+		m_outNodeIds[outPos[e.sourceNodeId]++] = e.targetNodeId;
+	}
+}
+
+void SemanticGraph::getNodeLabels(int nodeId, std::vector<int> &labelNodeIds) const
+{
+	labelNodeIds.clear();
+
+	if (!m_nodes[nodeId].isObject())
+	{
+		return;
+	}
+
+	SemNodeList inNodeList = inNodes(nodeId);
+	for (int ai = 0; ai < inNodeList.size(); ai++)
+	{
+		int attNodeId = inNodeList[ai];  // id of attribute node in tsg
 
-		if (sgNode.nodeType.contains("relation") || sgNode.nodeType.contains("group_attribute"))
+		if (m_nodes[attNodeId].isAttribute())
 		{
-			sgNode.activeNodeList.clear();
-			sgNode.anchorNodeList.clear();
-
-			// edge dir: (active, relation), (relation, reference)
-
-			for (int ai = 0; ai < sgNode.inEdgeNodeList.size(); ai++)
-			{
-				int inNodeId = sgNode.inEdgeNodeList[ai];
-				sgNode.activeNodeList.push_back(inNodeId);
-			}
-
-			for (int ai = 0; ai < sgNode.outEdgeNodeList.size(); ai++)
-			{
-				int outNodeId = sgNode.outEdgeNodeList[ai];
-				sgNode.anchorNodeList.push_back(outNodeId);
-			}
+			labelNodeIds.push_back(attNodeId);
 		}
 	}
 }
@@ -1,35 +1,60 @@
 #pragma once
 
 #include "../common/utilities/utility.h"
+#include <QHash>
+
+const QString SSGNodeTypeStrings[] = { "object", "attribute", "pair_relation", "group_relation", "group_relation_anno"};
+
+enum SSGNodeType
+{
+	Object=0,
+	Attribute,
+	PairRel,
+	GroupRel,
+	GroupRelAnno,
+	UnknownNode
+};
+
+// read-only view of a node's neighbors in the graph's adjacency arrays
+// valid until nodes or edges are added and the adjacency is rebuilt
+class SemNodeList
+{
+public:
+	SemNodeList() : m_begin(NULL), m_end(NULL) {};
+	SemNodeList(const int *b, const int *e) : m_begin(b), m_end(e) {};
+
+	int size() const { return m_end - m_begin; };
+	bool empty() const { return m_begin == m_end; };
+	int operator[](int i) const { return m_begin[i]; };
+	const int* begin() const { return m_begin; };
+	const int* end() const { return m_end; };
+
+private:
+	const int *m_begin, *m_end;
+};
 
 class SemNode{
 public:
-	SemNode(const QString &t, const QString &n, int id) { nodeType = t; nodeName = n; nodeId = id; };
+	SemNode(SSGNodeType type, const QString &t, int nameId, const QString &n, int id) { typeId = type; nodeType = t; nodeNameId = nameId; nodeName = n; nodeId = id; };
 	~SemNode() {};
 
-	// node types: e.g., object, per_obj_attribute, pairwise_relation, group_relation, group_relation_anno, 
+	bool isObject() const { return typeId == SSGNodeType::Object; };
+	bool isAttribute() const { return typeId == SSGNodeType::Attribute; };
+	bool isPairRelation() const { return typeId == SSGNodeType::PairRel; };
+	bool isGroupRelation() const { return typeId == SSGNodeType::GroupRel || typeId == SSGNodeType::GroupRelAnno; };
+	bool isRelation() const { return isPairRelation() || isGroupRelation(); };
+
+	SSGNodeType typeId;
+	int nodeNameId;  // id in the graph's name list, equal ids mean equal names within one graph
+
+	// string form of type and name, shares data with the graph's name list
+	// node types: e.g., object, per_obj_attribute, pairwise_relation, group_relation, group_relation_anno,
 	QString nodeType;
 
 	// model category name, relationship name or attribute name, e.g. chair, support, messy
 	QString nodeName;
 
 	int nodeId;
-
-	// node id of the other end of in edge
-	// for object node: saves the non-object node (relations, attributes) id to the object node, e.g. table <-- wood,  chair <-- support
-	// for relation/attribute node: saves passive object id to relation/attribute node, e.g. support <-- table
-	std::vector<int> inEdgeNodeList;
-
-	// node id of the other end of out edge
-	// for relation/attribute node: from relation/attribute node to object, e.g. messy --> book, messy --> utensils
-	// for object: from passive object to relation/attribute node, e.g. table --> support
-	std::vector<int> outEdgeNodeList;
-
-	// parsed from in and out edge node list
-	std::vector<int> nodeLabels;  // idx of per-object attribute node, valid for "object" node
-	std::vector<int> activeNodeList; // idx of active object node, valid for "relation" node
-	std::vector<int> anchorNodeList; // idx of anchor object node, valid for "relation" node
-
 };
 
 // directed edge, from source to target
@@ -49,12 +74,41 @@ public:
 	~SemanticGraph();
 
 	void addNode(const QString &nType, const QString &nName);
-	void addEdge(int s, int t); // after adding edge, parseNodeNeighbors must be called to update the neighbor list
-	void parseNodeNeighbors();  // parse in and out node list to node labels, active and anchor node list
+	void addEdge(int s, int t); // after adding edges, parseNodeNeighbors must be called to update the neighbor lists
+	void parseNodeNeighbors();  // build the in and out adjacency of all nodes from the edge list, no-op if it is up to date
+
+	static SSGNodeType parseNodeType(const QString &nType);
+
+	// node id of the other end of in edge
+	// for object node: the non-object nodes (relations, attributes) to the object node, e.g. table <-- wood,  chair <-- support
+	// for relation/attribute node: active objects to the relation/attribute node, e.g. support <-- table
+	SemNodeList inNodes(int nodeId) const { return SemNodeList(m_inNodeIds.data() + m_inOffsets[nodeId], m_inNodeIds.data() + m_inOffsets[nodeId + 1]); };
+
+	// node id of the other end of out edge
+	// for relation/attribute node: from relation/attribute node to anchor object, e.g. messy --> book, messy --> utensils
+	// for object: from passive object to relation/attribute node, e.g. table --> support
+	SemNodeList outNodes(int nodeId) const { return SemNodeList(m_outNodeIds.data() + m_outOffsets[nodeId], m_outNodeIds.data() + m_outOffsets[nodeId + 1]); };
+
+	// edge dir: (active, relation), (relation, anchor)
+	SemNodeList activeNodes(int nodeId) const { return inNodes(nodeId); };  // valid for relation node
+	SemNodeList anchorNodes(int nodeId) const { return outNodes(nodeId); };  // valid for relation node
+	void getNodeLabels(int nodeId, std::vector<int> &labelNodeIds) const;  // per-object attribute nodes, valid for object node
+
+	int getNameNum() const { return m_nameList.size(); };
+	const QString& getName(int nameId) const { return m_nameList[nameId]; };
 
 public:
 	int m_nodeNum, m_edgeNum;
 	std::vector<SemNode> m_nodes;
 	std::vector<SemEdge> m_edges;
-};
 
+private:
+	int internName(const QString &name);
+
+	std::vector<QString> m_nameList;
+	QHash<QString, int> m_nameIds;
+
+	// compressed rows of neighbor ids, neighbors of node i are in [offsets[i], offsets[i+1]) in edge order
+	std::vector<int> m_inOffsets, m_inNodeIds;
+	std::vector<int> m_outOffsets, m_outNodeIds;
+};
@@ -1,6 +1,8 @@
 #include "text2scene_mode.h"
 #include "ModePluginDockWidget.h"
 
+#include <QMouseEvent>
+
 #include "../scene_lab/scene_lab.h"
 #include "../common/geometry/Scene.h"
 
@@ -58,6 +60,36 @@ void text2scene_mode::decorate()
 	}
 }
 
+// shift + left click picks the model under the cursor and selects the OBB face the ray hits
+bool text2scene_mode::mousePressEvent(QMouseEvent *event)
+{
+	if (m_decorateScene == NULL || event->button() != Qt::LeftButton || !(event->modifiers() & Qt::ShiftModifier))
+	{
+		return false;
+	}
+
+	qglviewer::Vec vecOrig, vecDir;
+	drawArea()->camera()->convertClickToLine(event->pos(), vecOrig, vecDir);
+
+	MathLib::Vector3 orig(vecOrig[0], vecOrig[1], vecOrig[2]);
+	MathLib::Vector3 dir(vecDir[0], vecDir[1], vecDir[2]);
+
+	CScenePicker::Hit hit;
+	if (!m_decorateScene->pickModelByRay(orig, dir, hit))
+	{
+		return true;
+	}
+
+	CModel *pickedModel = m_decorateScene->getModel(hit.modelId);
+	pickedModel->selectOBBFace(orig, dir);
+
+	std::cout << "Text2Scene: picked model " << hit.modelId << " " << pickedModel->getNameStr().toStdString()
+		<< ", face " << hit.faceId << " at (" << hit.point[0] << ", " << hit.point[1] << ", " << hit.point[2] << ")\n";
+
+	drawArea()->updateGL();
+	return true;
+}
+
 void text2scene_mode::showSceneLab(bool isShow)
 {
 	if (isShow)
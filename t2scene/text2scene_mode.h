@@ -25,6 +25,8 @@ public:
 	void destory();
 	void decorate();
 
+	bool mousePressEvent(QMouseEvent *event);
+
 	void setDecorateScene(CScene *s) { m_decorateScene = s; };
 	Starlab::DrawArea* getDrawArea() { return drawArea(); };
 
@@ -4,6 +4,8 @@ CONFIG += ordered
 SUBDIRS += common
 SUBDIRS += scene_lab
 SUBDIRS += t2scene
+SUBDIRS += scene_lab_cli
 
 scene_lab.depends = common
-t2scene.depends = common scene_lab
\ No newline at end of file
+t2scene.depends = common scene_lab
+scene_lab_cli.depends = common scene_lab
\ No newline at end of file